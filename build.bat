@@ -15,6 +15,11 @@ if /i "%1"=="release" (
 	set ConfigLinkerOptions=/opt:noref /debug /libpath:external/directxtex/debug
 )
 
+rem 'build profile' or 'build release profile' compiles in the expression profiler.
+set ProfileDefines=
+if /i "%1"=="profile" set ProfileDefines=/DRLF_EXPRESSION_PROFILER=1
+if /i "%2"=="profile" set ProfileDefines=/DRLF_EXPRESSION_PROFILER=1
+
 if %GfxApi% == D3D12 (
 	set PrebuildFile=prebuilt\win32_d3d12_prebuild.obj
 	set CompileFile=source\win32_d3d12_main.cpp
@@ -23,7 +28,7 @@ if %GfxApi% == D3D12 (
 	set CompileFile=source\win32_d3d11_main.cpp
 )
 
-set CommonCompilerDefines=/D_CRT_SECURE_NO_WARNINGS /D%GfxApi%
+set CommonCompilerDefines=/D_CRT_SECURE_NO_WARNINGS /D%GfxApi% %ProfileDefines%
 
 set CommonCompilerFlags=%ConfigCompilerOptions% /nologo /fp:fast /Gm- /GR- /EHsc /WX /W4 /FC /Z7 %CommonCompilerDefines% /I%ExternalPath% /I%ExternalPath%/imgui /Fo%BuildFolder%\
 set CommonLinkerFlags=%ConfigLinkerOptions% /incremental:no /subsystem:windows %GfxApi%.lib d3dcompiler.lib dxguid.lib dxgi.lib directxtex.lib ole32.lib %PrebuildFile%
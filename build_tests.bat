@@ -0,0 +1,38 @@
+@echo off
+
+call project.bat
+
+set BuildFolder=built
+set ExternalPath=external
+set TestsExe=%ProjectName%_tests.exe
+
+if /i "%1"=="release" (
+	set Config=release
+	set ConfigCompilerOptions=/MT /O2 /Oi /Oy /GL /wd4189 /wd4702
+	set ConfigLinkerOptions=/opt:ref
+) else (
+	set Config=debug
+	set ConfigCompilerOptions=/MTd /Od
+	set ConfigLinkerOptions=/opt:noref /debug
+)
+
+rem The tests only need the rlf core, which they build against the null backend.
+set CommonCompilerDefines=/D_CRT_SECURE_NO_WARNINGS
+
+set CommonCompilerFlags=%ConfigCompilerOptions% /nologo /fp:fast /Gm- /GR- /EHsc /WX /W4 /FC /Z7 %CommonCompilerDefines% /I%ExternalPath% /Fo%BuildFolder%\
+set CommonLinkerFlags=%ConfigLinkerOptions% /incremental:no /subsystem:console
+
+if not exist %BuildFolder%\ mkdir %BuildFolder%
+echo Compiling (msvc): %TestsExe%, Config: %Config%
+
+cl.exe %CommonCompilerFlags% source\tests_main.cpp /Fe%BuildFolder%/%TestsExe% /link %CommonLinkerFlags%
+
+rem The tests don't run against either D3D backend, so compile both builds
+rem without linking them, which at least keeps the interpreters building at /W4 /WX.
+set GfxCompilerFlags=%ConfigCompilerOptions% /nologo /fp:fast /Gm- /GR- /EHsc /WX /W4 /FC /D_CRT_SECURE_NO_WARNINGS /I%ExternalPath% /I%ExternalPath%/imgui /c
+
+echo Compiling (msvc): D3D11 build, compile only
+cl.exe %GfxCompilerFlags% /DD3D11 /Fo%BuildFolder%\d3d11_compile_check.obj source\win32_d3d11_main.cpp
+
+echo Compiling (msvc): D3D12 build, compile only
+cl.exe %GfxCompilerFlags% /DD3D12 /Fo%BuildFolder%\d3d12_compile_check.obj source\win32_d3d12_main.cpp
@@ -0,0 +1,5 @@
+@echo off
+
+call project.bat
+
+built\%ProjectName%_tests.exe %*
@@ -90,3 +90,4 @@ do { 												\
 			MB_OK);									\
 	}												\
 } while (0);										\
+
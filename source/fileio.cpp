@@ -1,6 +1,8 @@
 
 namespace fileio {
 
+#if defined(_WIN32)
+
 void MakeDirectory(const char* directory)
 {
 	BOOL success = ::CreateDirectory(directory, nullptr);
@@ -36,6 +38,13 @@ HANDLE CreateFileTryNew(const char* fileName, u32 desiredAccess)
 	return handle;
 }
 
+HANDLE CreateFileTryOverwrite(const char* fileName, u32 desiredAccess)
+{
+	// Failure is left to the caller, e.g. the file is in use or read-only.
+	return ::CreateFileA(fileName, desiredAccess, 0, nullptr, 
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+}
+
 HANDLE OpenFileAlways(const char* fileName, u32 desiredAccess)
 {
 	HANDLE handle = ::CreateFileA(fileName, desiredAccess, 0, nullptr, 
@@ -77,6 +86,14 @@ u32 GetFileSize(HANDLE file)
 	return large.LowPart;
 }
 
+u64 GetFileWriteTime(HANDLE file)
+{
+	FILETIME writeTime;
+	BOOL success = ::GetFileTime(file, nullptr, nullptr, &writeTime);
+	Assert(success, "Failed to get file time, error=%d", GetLastError());
+	return ((u64)writeTime.dwHighDateTime << 32) | writeTime.dwLowDateTime;
+}
+
 void WriteFile(HANDLE file, const void* payload, u32 payloadSize)
 {
 	DWORD bytesWritten;
@@ -113,6 +130,24 @@ void ResetFilePointer(HANDLE file)
 		GetLastError());
 }
 
+void* MapFileCopyOnWrite(HANDLE file)
+{
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0,
+		nullptr);
+	if (mapping == nullptr)
+		return nullptr;
+	void* view = ::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	// The view keeps the mapping alive.
+	CloseHandle(mapping);
+	return view;
+}
+
+void UnmapFile(void* view)
+{
+	BOOL success = ::UnmapViewOfFile(view);
+	Assert(success, "Failed to unmap file, error=%d", GetLastError());
+}
+
 void GetCurrentDirectory(char* outDirectoryBuffer, u32 bufferSize)
 {
 	DWORD copiedBytes = ::GetCurrentDirectory(bufferSize, outDirectoryBuffer);
@@ -134,4 +169,160 @@ void GetModuleFileName(HMODULE module, char* outFileNameBuffer, u32 bufferSize)
 	}
 }
 
+#else
+
+// File handles are descriptors, see posix.h.
+static int Fd(HANDLE file)
+{
+	return (int)(intptr_t)file;
+}
+
+static HANDLE OpenFd(const char* fileName, u32 desiredAccess, int flags)
+{
+	bool read = (desiredAccess & GENERIC_READ) != 0;
+	bool write = (desiredAccess & GENERIC_WRITE) != 0;
+	flags |= read && write ? O_RDWR : (write ? O_WRONLY : O_RDONLY);
+	int fd = ::open(fileName, flags, 0644);
+	return fd < 0 ? INVALID_HANDLE_VALUE : (HANDLE)(intptr_t)fd;
+}
+
+void MakeDirectory(const char* directory)
+{
+	int result = ::mkdir(directory, 0755);
+	Assert(result == 0 || errno == EEXIST, "failed to create directory %s, error=%d",
+		directory, errno);
+}
+
+HANDLE CreateFileOverwrite(const char* fileName, u32 desiredAccess)
+{
+	HANDLE handle = OpenFd(fileName, desiredAccess, O_CREAT | O_TRUNC);
+	Assert(handle != INVALID_HANDLE_VALUE, "Failed to create file %s, error=%d",
+		fileName, errno);
+	return handle;
+}
+
+HANDLE CreateFileTryNew(const char* fileName, u32 desiredAccess)
+{
+	HANDLE handle = OpenFd(fileName, desiredAccess, O_CREAT | O_EXCL);
+	Assert(handle != INVALID_HANDLE_VALUE || errno == EEXIST,
+		"Creating new file %s failed unexpectedly, error=%d", fileName, errno);
+	return handle;
+}
+
+HANDLE CreateFileTryOverwrite(const char* fileName, u32 desiredAccess)
+{
+	return OpenFd(fileName, desiredAccess, O_CREAT | O_TRUNC);
+}
+
+HANDLE OpenFileAlways(const char* fileName, u32 desiredAccess)
+{
+	HANDLE handle = OpenFd(fileName, desiredAccess, 0);
+	Assert(handle != INVALID_HANDLE_VALUE, "Failed to open existing file %s, error=%d",
+		fileName, errno);
+	return handle;
+}
+
+HANDLE OpenFileOptional(const char* fileName, u32 desiredAccess)
+{
+	HANDLE handle = OpenFd(fileName, desiredAccess, 0);
+	Assert(handle != INVALID_HANDLE_VALUE || errno == ENOENT || errno == ENOTDIR,
+		"Opening file %s failed unexpectedly, error=%d", fileName, errno);
+	return handle;
+}
+
+void DeleteFile(const char* fileName)
+{
+	int result = ::unlink(fileName);
+	Assert(result == 0 || errno == ENOENT, "Failed to delete %s, error=%d",
+		fileName, errno);
+}
+
+u32 GetFileSize(HANDLE file)
+{
+	struct stat st;
+	int result = ::fstat(Fd(file), &st);
+	Assert(result == 0, "Failed to get file size, error=%d", errno);
+	Assert(st.st_size < UINT_MAX, "File is too large, not supported");
+	return (u32)st.st_size;
+}
+
+u64 GetFileWriteTime(HANDLE file)
+{
+	struct stat st;
+	int result = ::fstat(Fd(file), &st);
+	Assert(result == 0, "Failed to get file time, error=%d", errno);
+	return (u64)st.st_mtim.tv_sec * 1000000000 + (u64)st.st_mtim.tv_nsec;
+}
+
+void WriteFile(HANDLE file, const void* payload, u32 payloadSize)
+{
+	ssize_t bytesWritten = ::write(Fd(file), payload, payloadSize);
+	Assert(bytesWritten >= 0, "Failed to write file");
+	Assert((u32)bytesWritten == payloadSize, "Failed to write full amount");
+}
+
+void ReadFile(HANDLE file, void* readBuffer, u32 bytesToRead)
+{
+	ssize_t bytesRead = ::read(Fd(file), readBuffer, bytesToRead);
+	Assert(bytesRead >= 0, "Failed to read file, error=%d", errno);
+	Assert((u32)bytesRead == bytesToRead, "Didn't read full file");
+}
+
+void ReadFileAtOffset(HANDLE file, void* readBuffer, u32 readOffset, u32 bytesToRead)
+{
+	ssize_t bytesRead = ::pread(Fd(file), readBuffer, bytesToRead, readOffset);
+	Assert(bytesRead >= 0, "Failed to read file, error=%d", errno);
+	Assert((u32)bytesRead == bytesToRead, "Didn't read full file");
+}
+
+void ResetFilePointer(HANDLE file)
+{
+	off_t result = ::lseek(Fd(file), 0, SEEK_SET);
+	Assert(result == 0, "Failed to set file pointer, error=%d", errno);
+}
+
+// munmap needs the size of the view, which is kept in front of it. The view
+//	then starts a page in, and the file at the page after.
+void* MapFileCopyOnWrite(HANDLE file)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t size = GetFileSize(file);
+	u8* base = (u8*)::mmap(nullptr, pageSize + size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+		return nullptr;
+	if (size > 0 && ::mmap(base + pageSize, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_FIXED, Fd(file), 0) == MAP_FAILED)
+	{
+		::munmap(base, pageSize + size);
+		return nullptr;
+	}
+	*(size_t*)base = pageSize + size;
+	return base + pageSize;
+}
+
+void UnmapFile(void* view)
+{
+	u8* base = (u8*)view - sysconf(_SC_PAGESIZE);
+	int result = ::munmap(base, *(size_t*)base);
+	Assert(result == 0, "Failed to unmap file, error=%d", errno);
+}
+
+void GetCurrentDirectory(char* outDirectoryBuffer, u32 bufferSize)
+{
+	char* result = ::getcwd(outDirectoryBuffer, bufferSize);
+	Assert(result, "Failed to get current directory, error=%d", errno);
+}
+
+// There are no modules to ask about, it's always the executable.
+void GetModuleFileName(HMODULE, char* outFileNameBuffer, u32 bufferSize)
+{
+	ssize_t copiedSize = ::readlink("/proc/self/exe", outFileNameBuffer, bufferSize);
+	Assert(copiedSize > 0, "Error: failed to get module path. \n");
+	Assert((u32)copiedSize < bufferSize, "Error: buffer too short for module path. \n");
+	outFileNameBuffer[min((u32)copiedSize, bufferSize - 1)] = '\0';
+}
+
+#endif
+
 } // namespace fileio
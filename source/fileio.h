@@ -5,12 +5,14 @@ void MakeDirectory(const char* directory);
 
 HANDLE CreateFileOverwrite(const char* fileName, u32 desiredAccess);
 HANDLE CreateFileTryNew(const char* fileName, u32 desiredAccess);
+HANDLE CreateFileTryOverwrite(const char* fileName, u32 desiredAccess);
 HANDLE OpenFileAlways(const char* fileName, u32 desiredAccess);
 HANDLE OpenFileOptional(const char* fileName, u32 desiredAccess);
 
 void DeleteFile(const char* fileName);
 
 u32 GetFileSize(HANDLE file);
+u64 GetFileWriteTime(HANDLE file);
 
 void WriteFile(HANDLE file, const void* payload, u32 payloadSize);
 void ReadFile(HANDLE file, void* outBuffer, u32 bytesToRead);
@@ -18,6 +20,11 @@ void ReadFileAtOffset(HANDLE file, void* outBuffer, u32 readOffset, u32 bytesToR
 
 void ResetFilePointer(HANDLE file);
 
+// Maps the whole file, writes go to private copies of the pages. Returns 
+//	nullptr on failure. The file handle may be closed once mapped.
+void* MapFileCopyOnWrite(HANDLE file);
+void UnmapFile(void* view);
+
 void GetCurrentDirectory(char* outDirectoryBuffer, u32 bufferSize);
 void GetModuleFileName(HMODULE module, char* outFileNameBuffer, u32 bufferSize);
 
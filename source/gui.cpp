@@ -100,5 +100,91 @@ void DisplayShaderPasses(rlf::RenderDescription* rd)
 	}
 }
 
+void DisplayMemoryStats(const char* const* names, const rlf::alloc::Stats* stats,
+	u32 count)
+{
+	ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | 
+		ImGuiTableFlags_Resizable;
+	if (!ImGui::BeginTable("MemoryStats", 7, flags))
+		return;
+	ImGui::TableSetupColumn("Allocator");
+	ImGui::TableSetupColumn("Used KB");
+	ImGui::TableSetupColumn("Peak KB");
+	ImGui::TableSetupColumn("Committed KB");
+	ImGui::TableSetupColumn("Reserved KB");
+	ImGui::TableSetupColumn("Wasted KB");
+	ImGui::TableSetupColumn("Blocks");
+	ImGui::TableHeadersRow();
+	for (u32 i = 0 ; i < count ; ++i)
+	{
+		const rlf::alloc::Stats& st = stats[i];
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(names[i]);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", st.UsedSize / 1024.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", st.PeakSize / 1024.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", st.CommittedSize / 1024.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", st.ReservedSize / 1024.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", st.WastedSize / 1024.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", st.BlockCount);
+	}
+	ImGui::EndTable();
+}
+
+#if RLF_EXPRESSION_PROFILER
+void DisplayExpressionProfile(const rlf::ast::ExpressionProfile& prof, 
+	const rlf::SourceMap& sm)
+{
+	double ticksPerUs = rlf::ast::ProfileTicksPerSecond(prof) / 1000000.0;
+	if (ticksPerUs <= 0)
+		return;
+	ImGui::Text("%u frames, %u expressions", prof.Frames, (u32)prof.Samples.size());
+
+	ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | 
+		ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+	if (!ImGui::BeginTable("ExpressionProfile", 6, flags, ImVec2(0, 300)))
+		return;
+	ImGui::TableSetupScrollFreeze(0, 1);
+	ImGui::TableSetupColumn("Location");
+	ImGui::TableSetupColumn("Evaluated");
+	ImGui::TableSetupColumn("Cached");
+	ImGui::TableSetupColumn("Failed");
+	ImGui::TableSetupColumn("Total us");
+	ImGui::TableSetupColumn("Average us");
+	ImGui::TableHeadersRow();
+	for (const rlf::ast::ExpressionSamples* samples : rlf::ast::SortSamples(prof))
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		rlf::SourceLocation loc;
+		if (rlf::FindSourceLocation(sm, samples->Location, &loc))
+			ImGui::Text("%u,%u", loc.Line, loc.Column);
+		else
+			ImGui::TextUnformatted("?");
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("%s", 
+				rlf::FormatSourceLocation(sm, samples->Location).c_str());
+		double total = (double)samples->Ticks / ticksPerUs;
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", samples->Evaluations);
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", samples->CacheHits);
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", samples->Failures);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", total);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", samples->Evaluations ? total / samples->Evaluations : 0);
+	}
+	ImGui::EndTable();
+}
+#endif
+
 
 }
\ No newline at end of file
@@ -2,5 +2,12 @@
 namespace gui {
 
 	void DisplayShaderPasses(rlf::RenderDescription* rd);
+	// A row for each allocator.
+	void DisplayMemoryStats(const char* const* names, const rlf::alloc::Stats* stats,
+		u32 count);
+#if RLF_EXPRESSION_PROFILER
+	void DisplayExpressionProfile(const rlf::ast::ExpressionProfile& prof, 
+		const rlf::SourceMap& sm);
+#endif
 
 }
\ No newline at end of file
@@ -8,48 +8,9 @@ const int LAYOUT_VERSION = 1;
 void LoadRlf(State* s);
 void UnloadRlf(State* s);
 void ReportError(State* s, const std::string& message);
-
-std::string RlfFileLocation(const char* buffer_start, u32 buffer_size, 
-	const char* filename, const char* location)
-{
-	Assert(filename, "File must be provided.");
-	if (!location)
-		return "";
-	u32 line = 1;
-	u32 chr = 0;
-	const char* lineStart = buffer_start;
-	for (const char* b = buffer_start; b < location ; ++b)
-	{
-		if (*b == '\n')
-		{
-			lineStart = b+1;
-			++line;
-			chr = 0;
-		}
-		else if (*b == '\t')
-			chr += 4;
-		else
-			++chr;
-	}
-
-	const char* lineEnd = lineStart;
-	while (lineEnd < buffer_start + buffer_size && *lineEnd != '\n')
-		++lineEnd;
-
-	char buf[512];
-	sprintf_s(buf, 512, "%s(%u,%u):\n%.*s \n", filename, line, chr, (u32)(lineEnd-lineStart),
-		lineStart);
-	std::string str = buf;
-	if (chr + 2 < 512)
-	{
-		for (u32 i = 0 ; i < chr ; ++i)
-			buf[i] = ' ';
-		buf[chr] = '^';
-		buf[chr+1] = '\0';
-		str += buf;
-	}
-	return str;
-}
+#if RLF_EXPRESSION_PROFILER
+void SaveProfile(State* s, const char* extension, const std::string& contents);
+#endif
 
 void LoadRlf(State* s)
 {
@@ -85,15 +46,38 @@ void LoadRlf(State* s)
 
 	CloseHandle(rlf);
 
+	rlf::AddSourceFile(s->RlfSources, filename, s->RlfFile, s->RlfFileSize);
+
 	Assert(s->CurrentRenderDesc == nullptr, "leaking data");
 	rlf::ErrorState es = {};
-	s->CurrentRenderDesc = rlf::ParseBuffer(s->RlfFile, s->RlfFileSize, dirPath.c_str(), &es);
+	std::string saveWarning;
 
-	if (es.Success == false)
+	// foo.rlf is compiled to foo.rlfc, which skips parsing until the rlf or 
+	//	anything it imports changes.
+	std::string compiledPath = filePath + "c";
+	s->CurrentRenderDesc = rlf::LoadCompiled(compiledPath.c_str(), s->RlfFile, 
+		s->RlfFileSize, dirPath.c_str());
+
+	if (!s->CurrentRenderDesc)
 	{
-		ReportError(s, std::string("Failed to parse RLF:\n") + es.Info.Message +
-			"\n" + RlfFileLocation(s->RlfFile, s->RlfFileSize, filename, es.Info.Location));
-		return;
+		s->CurrentRenderDesc = rlf::ParseBuffer(s->RlfFile, s->RlfFileSize, 
+			dirPath.c_str(), s->RlfParseCache, &es);
+
+		if (es.Success == false)
+		{
+			ReportError(s, std::string("Failed to parse RLF:\n") + es.Info.Message +
+				"\n" + rlf::FormatSourceLocation(s->RlfSources, es.Info.Location));
+			return;
+		}
+
+		// Not fatal, but without it every load parses, so say so.
+		rlf::ErrorState saveEs = {};
+		if (!rlf::SaveCompiled(compiledPath.c_str(), s->CurrentRenderDesc, 
+			s->RlfFile, s->RlfFileSize, dirPath.c_str(), &saveEs))
+		{
+			saveWarning = std::string("Couldn't save ") + compiledPath + 
+				", loads will parse the rlf:\n" + saveEs.Info.Message;
+		}
 	}
 
 	es = {};
@@ -103,13 +87,20 @@ void LoadRlf(State* s)
 	if (es.Success == false)
 	{
 		ReportError(s, std::string("Failed to create RLF scene:\n") +
-			es.Info.Message + "\n" + RlfFileLocation(s->RlfFile, s->RlfFileSize, 
-				filename, es.Info.Location));
+			es.Info.Message + "\n" + rlf::FormatSourceLocation(s->RlfSources, 
+				es.Info.Location));
 		return;
 	}
 
 	s->RlfCompileWarning = es.Warning;
 	s->RlfCompileWarningMessage = es.Info.Message;
+	if (!saveWarning.empty())
+	{
+		if (s->RlfCompileWarning)
+			s->RlfCompileWarningMessage += "\n";
+		s->RlfCompileWarning = true;
+		s->RlfCompileWarningMessage += saveWarning;
+	}
 }
 
 void UnloadRlf(State* s)
@@ -122,6 +113,11 @@ void UnloadRlf(State* s)
 		rlf::ReleaseData(s->CurrentRenderDesc);
 		s->CurrentRenderDesc = nullptr;
 	}
+#if RLF_EXPRESSION_PROFILER
+	// It points into the sources which are about to be freed.
+	rlf::ast::ResetProfile(s->ExprProfile);
+#endif
+	rlf::ClearSourceMap(s->RlfSources);
 	if (s->RlfFile)
 	{
 		free(s->RlfFile);
@@ -136,6 +132,19 @@ void ReportError(State* s, const std::string& message)
 	UnloadRlf(s);
 }
 
+#if RLF_EXPRESSION_PROFILER
+// Written next to the rlf, as foo.rlf.profile.csv and so on.
+void SaveProfile(State* s, const char* extension, const std::string& contents)
+{
+	std::string path = std::string(s->Cfg.FilePath) + ".profile." + extension;
+	HANDLE file = fileio::CreateFileTryOverwrite(path.c_str(), GENERIC_WRITE);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	fileio::WriteFile(file, contents.c_str(), (u32)contents.size());
+	CloseHandle(file);
+}
+#endif
+
 void Initialize(State* s, const char* config_path)
 {
 	*s = {};
@@ -144,6 +153,9 @@ void Initialize(State* s, const char* config_path)
 	s->ConfigPath = config_path;
 
 	config::LoadConfig(config_path, &s->Cfg);
+
+	s->RlfParseCache = rlf::CreateParseCache();
+	rlf::InitFrameArena(&s->FrameScratch);
 }
 
 
@@ -152,6 +164,10 @@ void Shutdown(State* s)
 	config::SaveConfig(s->ConfigPath.c_str(), &s->Cfg);
 
 	UnloadRlf(s);
+
+	rlf::DestroyParseCache(s->RlfParseCache);
+	s->RlfParseCache = nullptr;
+	rlf::ReleaseFrameArena(&s->FrameScratch);
 }
 
 bool DoUpdate(State* s)
@@ -162,7 +178,7 @@ bool DoUpdate(State* s)
 		ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey",
 			"Choose File", ".rlf", ".");
 
-	bool TuneablesChanged = false;
+	s->ChangedTuneables.clear();
 	bool ResetLayout = false;
 
 	if (ImGui::BeginMainMenuBar())
@@ -287,6 +303,13 @@ bool DoUpdate(State* s)
 			ImGui::PopTextWrapPos();
 			ImGui::PopStyleColor();
 		}
+		if (s->RlfCompileSuccess && s->CurrentRenderDesc)
+		{
+			const rlf::ExpressionStats& stats = s->CurrentRenderDesc->ExprStats;
+			ImGui::Text("Expressions: %u, %u nodes, %u folded, %u shared subtrees, "
+				"%u evaluations saved", stats.Expressions, stats.Nodes, stats.FoldedNodes,
+				stats.SharedSubtrees, stats.SavedEvaluations);
+		}
 	}
 	ImGui::End();
 
@@ -297,6 +320,42 @@ bool DoUpdate(State* s)
 			if (s->RlfCompileSuccess)
 			{
 				gui::DisplayShaderPasses(s->CurrentRenderDesc);
+				if (ImGui::CollapsingHeader("Memory"))
+				{
+					// A description loaded from a .rlfc lives in its file
+					//	mapping instead of its alloc.
+					const char* names[] = { "Description", "Parse scratch", 
+						"Constant buffers", "Frame scratch" };
+					rlf::alloc::Stats stats[] = {
+						rlf::alloc::GetStats(&s->CurrentRenderDesc->Alloc),
+						s->CurrentRenderDesc->ScratchStats,
+						rlf::alloc::GetStats(&s->CurrentRenderDesc->ConstantPool),
+						s->LastFrameStats,
+					};
+					gui::DisplayMemoryStats(names, stats, (u32)ARRAYSIZE(stats));
+				}
+#if RLF_EXPRESSION_PROFILER
+				if (ImGui::CollapsingHeader("Expression Profile"))
+				{
+					rlf::ast::ExpressionProfile& prof = s->ExprProfile;
+					// Disabling keeps what was collected, so it can still be saved.
+					if (ImGui::Checkbox("Enabled", &s->ProfileExpressions) &&
+						s->ProfileExpressions)
+						rlf::ast::ResetProfile(prof);
+					ImGui::SameLine();
+					if (ImGui::Button("Reset"))
+						rlf::ast::ResetProfile(prof);
+					ImGui::SameLine();
+					if (ImGui::Button("Save CSV"))
+						SaveProfile(s, "csv", 
+							rlf::ast::FormatProfileCsv(prof, s->RlfSources));
+					ImGui::SameLine();
+					if (ImGui::Button("Save JSON"))
+						SaveProfile(s, "json", 
+							rlf::ast::FormatProfileJson(prof, s->RlfSources));
+					gui::DisplayExpressionProfile(prof, s->RlfSources);
+				}
+#endif
 			}
 		}
 		ImGui::End();
@@ -333,6 +392,10 @@ bool DoUpdate(State* s)
 			ImGui::Text("DisplaySize = %u / %u", s->DisplaySize.x, s->DisplaySize.y);
 			if (s->RlfCompileSuccess)
 			{
+				const rlf::ast::EvaluationCounters& ev = s->LastEvalCounters;
+				ImGui::Text("Evaluated last frame: %u expressions, %u nodes (%u cached)",
+					ev.Expressions, ev.Nodes, ev.Cached);
+
 				ImGui::Text("Tuneables:");
 				for (rlf::Tuneable* tune : s->CurrentRenderDesc->Tuneables)
 				{
@@ -360,7 +423,8 @@ bool DoUpdate(State* s)
 					}
 					else
 						Unimplemented();
-					TuneablesChanged |= ch;
+					if (ch)
+						s->ChangedTuneables.push_back(tune);
 				}
 			}
 		}
@@ -369,7 +433,7 @@ bool DoUpdate(State* s)
 
 	u32 changed = 0;
 	changed |= (s->DisplaySize != s->PrevDisplaySize) ? rlf::ast::VariesBy_DisplaySize : 0;
-	changed |= TuneablesChanged ? rlf::ast::VariesBy_Tuneable : 0;
+	changed |= s->ChangedTuneables.size() > 0 ? rlf::ast::VariesBy_Tuneable : 0;
 	changed |= s->LastTime != s->Time ? rlf::ast::VariesBy_Time : 0;
 	s->ChangedThisFrameFlags = changed;
 
@@ -383,8 +447,18 @@ bool DoUpdate(State* s)
 	ctx.EvCtx.DisplaySize = s->DisplaySize;
 	ctx.EvCtx.Time = s->Time;
 	ctx.EvCtx.ChangedThisFrameFlags = changed;
+	ctx.EvCtx.ChangedTuneables = { (u32)s->ChangedTuneables.size(), s->ChangedTuneables.data() };
+	ctx.EvCtx.Counters = &s->EvalCounters;
+	ctx.FrameAlloc = rlf::GetFrameAlloc(&s->FrameScratch);
+#if RLF_EXPRESSION_PROFILER
+	ctx.EvCtx.Profile = s->ProfileExpressions ? &s->ExprProfile : nullptr;
+#endif
+	if (s->RlfCompileSuccess)
+		rlf::MarkChanged(s->CurrentRenderDesc, ctx.EvCtx);
 
-	if (s->RlfCompileSuccess && (changed & VariesByForTexture) != 0)
+	// Tuneables which only end up in shader constants don't resize anything.
+	if (s->RlfCompileSuccess && (changed & VariesByForTexture) != 0 &&
+		rlf::ResourcesDependOnChanges(s->CurrentRenderDesc, ctx.EvCtx))
 	{
 		if (s->OnBeforeUnload)
 			s->OnBeforeUnload(s);
@@ -395,8 +469,7 @@ bool DoUpdate(State* s)
 		if (!ies.Success)
 		{
 			ReportError(s, std::string("Error resizing textures:\n") + ies.Info.Message + 
-				"\n" + RlfFileLocation(s->RlfFile, s->RlfFileSize, 
-					s->Cfg.FilePath, ies.Info.Location));
+				"\n" + rlf::FormatSourceLocation(s->RlfSources, ies.Info.Location));
 		}
 	}
 
@@ -404,6 +477,8 @@ bool DoUpdate(State* s)
 	{
 		s->FirstLoad = false;
 		s->Time = 0;
+		// They belong to the description being unloaded.
+		s->ChangedTuneables.clear();
 		UnloadRlf(s);
 		LoadRlf(s);
 	}
@@ -436,27 +511,42 @@ void DoRender(State* s)
 		exctx.EvCtx.DisplaySize = s->DisplaySize;
 		exctx.EvCtx.Time = s->Time;
 		exctx.EvCtx.ChangedThisFrameFlags = s->ChangedThisFrameFlags;
+		exctx.EvCtx.ChangedTuneables = { (u32)s->ChangedTuneables.size(), 
+			s->ChangedTuneables.data() };
+		exctx.EvCtx.Counters = &s->EvalCounters;
+		exctx.FrameAlloc = rlf::GetFrameAlloc(&s->FrameScratch);
+#if RLF_EXPRESSION_PROFILER
+		exctx.EvCtx.Profile = s->ProfileExpressions ? &s->ExprProfile : nullptr;
+#endif
 
 		rlf::ErrorState es = {};
 		rlf::Execute(&exctx, s->CurrentRenderDesc, &es);
 		if (!es.Success)
 		{
 			ReportError(s, "RLF execution error: \n" + es.Info.Message +
-				"\n" + RlfFileLocation(s->RlfFile, s->RlfFileSize, 
-					s->Cfg.FilePath, es.Info.Location));
+				"\n" + rlf::FormatSourceLocation(s->RlfSources, es.Info.Location));
 		}
 	}
 }
 
 void PostFrame(State* s)
 {
+	s->LastEvalCounters = s->EvalCounters;
+	s->EvalCounters = {};
+#if RLF_EXPRESSION_PROFILER
+	if (s->ProfileExpressions)
+		s->ExprProfile.Frames++;
+#endif
 	s->LastTime = s->Time;
 	s->Time = max(0, s->Time + s->Speed * ImGui::GetIO().DeltaTime);
 
 	s->RlfValidationErrorMessage = "Validation error:\n";
-	s->RlfValidationError = s->CheckD3DValidation(s->GfxCtx, s->RlfValidationErrorMessage);
+	s->RlfValidationError = s->CheckD3DValidation(s->GfxCtx, 
+		rlf::GetFrameAlloc(&s->FrameScratch), s->RlfValidationErrorMessage);
 
 	s->PrevDisplaySize = s->DisplaySize;
+	s->LastFrameStats = rlf::alloc::GetStats(rlf::GetFrameAlloc(&s->FrameScratch));
+	rlf::AdvanceFrameArena(&s->FrameScratch);
 }
 
 
@@ -4,6 +4,7 @@ namespace main {
 	struct State {
 		char* RlfFile = nullptr;
 		u32 RlfFileSize = 0;
+		rlf::SourceMap RlfSources;
 		bool RlfCompileSuccess = false;
 		std::string RlfCompileErrorMessage;
 		bool RlfCompileWarning = false;
@@ -20,6 +21,7 @@ namespace main {
 		uint2 PrevDisplaySize;
 
 		rlf::RenderDescription* CurrentRenderDesc;
+		rlf::ParseCache* RlfParseCache;
 
 		ImVec4 ClearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 		float Time = 0;
@@ -32,9 +34,25 @@ namespace main {
 		bool ShowEventsWindow = true;
 
 		u32 ChangedThisFrameFlags = 0;
+		// Moved in the Parameters window this frame.
+		std::vector<rlf::Tuneable*> ChangedTuneables;
+		// Summed up over the frame, the last complete one is displayed.
+		rlf::ast::EvaluationCounters EvalCounters = {};
+		rlf::ast::EvaluationCounters LastEvalCounters = {};
+		// Moved on to the next frame in PostFrame.
+		rlf::FrameArena FrameScratch = {};
+		// Of the frame allocator, before it was moved on from.
+		rlf::alloc::Stats LastFrameStats = {};
+#if RLF_EXPRESSION_PROFILER
+		// Evaluations are only profiled while it's enabled in the Event Viewer.
+		bool ProfileExpressions = false;
+		rlf::ast::ExpressionProfile ExprProfile;
+#endif
 
 		ImTextureID (*RetrieveDisplayTextureID)(State*);
-		bool (*CheckD3DValidation)(gfx::Context* ctx, std::string& outMessage);
+		// Messages are read into frameAlloc.
+		bool (*CheckD3DValidation)(gfx::Context* ctx, rlf::alloc::LinAlloc* frameAlloc,
+			std::string& outMessage);
 		void (*OnBeforeUnload)(State*);
 
 		gfx::Context* GfxCtx;
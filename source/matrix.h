@@ -183,3 +183,14 @@ float4x4 projection(float fovv, float aspect, float zn, float zf)
 		0.f,		0.f,	1,			0.f);
 	return m;
 }
+
+//https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixortholh
+float4x4 orthographic(float width, float height, float zn, float zf)
+{
+	float4x4 m = float4x4(
+		2.f/width,	0.f,		0.f,			0.f,
+		0.f,		2.f/height,	0.f,			0.f,
+		0.f,		0.f,		1.f/(zf-zn),	-zn/(zf-zn),
+		0.f,		0.f,		0.f,			1.f);
+	return m;
+}
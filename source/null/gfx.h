@@ -0,0 +1,27 @@
+namespace gfx {
+
+	// Nothing is created, Execute appends a line per command to Log instead.
+	struct Context {
+		std::string					Log;
+	};
+
+	typedef void* RasterizerState;
+	typedef void* DepthStencilState;
+	typedef void* BlendState;
+	typedef void* ShaderReflection;
+	typedef void* ComputeShader;
+	typedef void* VertexShader;
+	typedef void* InputLayout;
+	typedef void* PixelShader;
+	typedef void* Buffer;
+	typedef void* ConstantBuffer;
+	typedef void* Texture;
+	typedef void* SamplerState;
+	typedef void* ShaderResourceView;
+	typedef void* UnorderedAccessView;
+	typedef void* RenderTargetView;
+	typedef void* DepthStencilView;
+
+	struct DispatchData {};
+	struct DrawData {};
+}
@@ -0,0 +1,118 @@
+// What the rlf core uses of windows.h, for building it elsewhere. Included in
+//	place of windows.h, only by the tests for now.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <float.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <x86intrin.h>
+
+// min and max are macros like in windows.h, which the standard library
+//	doesn't expect, so whatever of it is used goes in before them.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifndef max
+#define max(a,b) (((a) > (b)) ? (a) : (b))
+#endif
+#ifndef min
+#define min(a,b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define ZeroMemory(dest, size) memset((dest), 0, (size))
+
+// Only used for MSVC's warning pragmas.
+#define __pragma(x)
+
+inline int vsprintf_s(char* buf, size_t size, const char* format, va_list args)
+{
+	return vsnprintf(buf, size, format, args);
+}
+template <size_t N>
+inline int vsprintf_s(char (&buf)[N], const char* format, va_list args)
+{
+	return vsnprintf(buf, N, format, args);
+}
+inline int sprintf_s(char* buf, size_t size, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(buf, size, format, args);
+	va_end(args);
+	return written;
+}
+template <size_t N>
+inline int sprintf_s(char (&buf)[N], const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(buf, N, format, args);
+	va_end(args);
+	return written;
+}
+
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+
+// Asserts print and exit without a debugger to break into.
+inline bool IsDebuggerPresent() { return false; }
+inline void OutputDebugString(const char* str) { fputs(str, stderr); }
+inline void DebugBreak() {}
+
+#define MB_OK 0
+#define MB_ICONERROR 0
+inline int MessageBoxA(void*, const char* text, const char* caption, unsigned)
+{
+	fprintf(stderr, "%s: %s\n", caption, text);
+	return 0;
+}
+
+// A file is its descriptor.
+typedef void* HANDLE;
+typedef void* HMODULE;
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+inline void CloseHandle(HANDLE file) { close((int)(intptr_t)file); }
+
+union LARGE_INTEGER
+{
+	struct
+	{
+		unsigned int LowPart;
+		int HighPart;
+	};
+	long long QuadPart;
+};
+inline bool QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+	counter->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	return true;
+}
+inline bool QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = 1000000000;
+	return true;
+}
@@ -1,74 +1,384 @@
-
 namespace rlf {
 namespace alloc {
 
 
+// The first block's reservation, later ones double it. Address space is cheap,
+//	only what's committed takes up memory.
+constexpr u32 FirstReserveSize = 64 * 1024 * 1024;
+constexpr u32 MaxReserveSize = 1u << 31;
+// Committed at once when a block is created, then doubled each time it fills.
+constexpr u32 FirstCommitSize = 64 * 1024;
+
 struct BlockHeader
 {
 	u8* PrevBlock;
-	u32 NumPages;
+	u32 ReserveSize;
+	// The start of the block up to here can be written to.
+	u32 CommitSize;
+	// Set when the block is retired, until then it's the allocator's NextOffset.
+	u32 UsedSize;
 };
 
-void Init(LinAlloc* Alloc)
+// ----- PLATFORM -----
+
+#if defined(_WIN32)
+
+u32 QueryPageSize()
 {
-	Assert(Alloc->CurrentBlock == nullptr, "Alloc misuse.");
 	SYSTEM_INFO SysInfo;
 	GetSystemInfo(&SysInfo);
+	return SysInfo.dwPageSize;
+}
+
+u8* ReserveMemory(u32 Size)
+{
+	return (u8*)VirtualAlloc(nullptr, Size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool CommitMemory(u8* Address, u32 Size)
+{
+	return VirtualAlloc(Address, Size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void ReleaseMemory(u8* Address, u32)
+{
+	VirtualFree(Address, 0, MEM_RELEASE);
+}
+
+#else
+
+} // namespace alloc
+} // namespace rlf
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rlf {
+namespace alloc {
+
+u32 QueryPageSize()
+{
+	return (u32)sysconf(_SC_PAGESIZE);
+}
+
+// Reserved pages can't be touched until they're committed, like on Windows.
+u8* ReserveMemory(u32 Size)
+{
+	void* Address = mmap(nullptr, Size, PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return Address == MAP_FAILED ? nullptr : (u8*)Address;
+}
+
+bool CommitMemory(u8* Address, u32 Size)
+{
+	return mprotect(Address, Size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void ReleaseMemory(u8* Address, u32 Size)
+{
+	munmap(Address, Size);
+}
+
+#endif
+
+// ----- ALLOCATION -----
+
+u32 AlignUp(u32 Value, u32 Alignment)
+{
+	return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
+void Init(LinAlloc* Alloc)
+{
+	Assert(Alloc->CurrentBlock == nullptr, "Alloc misuse.");
 	Alloc->CurrentBlock = nullptr;
-	Alloc->NextOffset = 0xffffffff;
-	Alloc->PageSize = SysInfo.dwPageSize;
+	Alloc->NextOffset = 0;
+	Alloc->LastOffset = 0;
+	Alloc->PageSize = QueryPageSize();
+	Alloc->RetiredSize = 0;
+	Alloc->PeakSize = 0;
+}
+
+// Called before anything which lowers the bytes in use.
+void UpdatePeak(LinAlloc* Alloc)
+{
+	Alloc->PeakSize = max(Alloc->PeakSize, Alloc->RetiredSize + Alloc->NextOffset);
+}
+
+// Commits the current block up to at least End, which is within its
+//	reservation.
+void CommitTo(LinAlloc* Alloc, u32 End)
+{
+	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	if (End <= Header->CommitSize)
+		return;
+	// The reservation is a multiple of the page size, so rounding up stays
+	//	within it.
+	u64 NewCommit = max((u64)End, (u64)Header->CommitSize * 2);
+	u32 CommitSize = AlignUp((u32)min(NewCommit, (u64)Header->ReserveSize), 
+		Alloc->PageSize);
+	bool Committed = CommitMemory(Alloc->CurrentBlock + Header->CommitSize,
+		CommitSize - Header->CommitSize);
+	Assert(Committed, "Failed to commit memory.");
+	Header->CommitSize = CommitSize;
 }
 
-void* Allocate(LinAlloc* Alloc, u32 AllocSize)
+// Retires the current block and starts one with room for Size bytes aligned
+//	to Alignment.
+void NewBlock(LinAlloc* Alloc, u32 Size, u32 Alignment)
+{
+	BlockHeader* LastHeader = (BlockHeader*)Alloc->CurrentBlock;
+	u64 Needed = (u64)AlignUp((u32)sizeof(BlockHeader), Alignment) + Size;
+	u64 ReserveSize = LastHeader ? (u64)LastHeader->ReserveSize * 2 : FirstReserveSize;
+	ReserveSize = max(ReserveSize, Needed);
+	ReserveSize = min(ReserveSize, max((u64)MaxReserveSize, Needed));
+	Assert(ReserveSize <= U32_MAX - Alloc->PageSize, "Allocation too large.");
+	u32 Reserve = AlignUp((u32)ReserveSize, Alloc->PageSize);
+
+	u8* Base = ReserveMemory(Reserve);
+	Assert(Base != nullptr, "Failed to reserve memory.");
+	u32 FirstCommit = AlignUp((u32)max((u64)FirstCommitSize, Needed), Alloc->PageSize);
+	bool Committed = CommitMemory(Base, min(FirstCommit, Reserve));
+	Assert(Committed, "Failed to commit memory.");
+
+	if (LastHeader)
+	{
+		LastHeader->UsedSize = Alloc->NextOffset;
+		Alloc->RetiredSize += Alloc->NextOffset;
+	}
+	BlockHeader* Header = (BlockHeader*)Base;
+	Header->PrevBlock = Alloc->CurrentBlock;
+	Header->ReserveSize = Reserve;
+	Header->CommitSize = min(FirstCommit, Reserve);
+	Header->UsedSize = 0;
+	Alloc->CurrentBlock = Base;
+	Alloc->NextOffset = (u32)sizeof(BlockHeader);
+	Alloc->LastOffset = (u32)sizeof(BlockHeader);
+}
+
+void* Allocate(LinAlloc* Alloc, u32 AllocSize, u32 Alignment)
 {
 	Assert(AllocSize > 0, "Invalid allocation.");
+	Assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0 &&
+		Alignment <= Alloc->PageSize, "Invalid alignment.");
 	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
-	if (Alloc->CurrentBlock != nullptr && 
-		(Header->NumPages*Alloc->PageSize - Alloc->NextOffset >= AllocSize)) 
+	u64 Offset = Header ? AlignUp(Alloc->NextOffset, Alignment) : 0;
+	if (Header == nullptr || Offset + AllocSize > Header->ReserveSize)
 	{
-		void* Address = Alloc->CurrentBlock + Alloc->NextOffset;
-		Alloc->NextOffset += AllocSize;
-		return Address;
+		NewBlock(Alloc, AllocSize, Alignment);
+		Offset = AlignUp(Alloc->NextOffset, Alignment);
 	}
-	u8* LastBlock = Alloc->CurrentBlock;
-	u32 TotalSize = AllocSize + sizeof(BlockHeader);
-	// Round up to next multiple of PageSize
-	u32 NumPages = ((TotalSize - 1) / Alloc->PageSize) + 1;
-	Alloc->CurrentBlock = (u8*)VirtualAlloc(
-		nullptr, 
-		Alloc->PageSize * NumPages,
-		MEM_COMMIT,
-		PAGE_READWRITE
-	);
-	Header = (BlockHeader*)Alloc->CurrentBlock;
-	Header->PrevBlock = LastBlock;
-	Header->NumPages = NumPages;
-	Alloc->NextOffset = sizeof(BlockHeader) + AllocSize;
-	return Alloc->CurrentBlock + sizeof(BlockHeader);
-}
-
-void* Allocate(LinAlloc* Alloc, size_t AllocSize)
+	CommitTo(Alloc, (u32)Offset + AllocSize);
+	Alloc->LastOffset = (u32)Offset;
+	Alloc->NextOffset = (u32)Offset + AllocSize;
+	return Alloc->CurrentBlock + Offset;
+}
+
+void* Allocate(LinAlloc* Alloc, size_t AllocSize, u32 Alignment)
 {
 	Assert(AllocSize < U32_MAX, "Allocation too large.");
-	return Allocate(Alloc, (u32)AllocSize);
+	return Allocate(Alloc, (u32)AllocSize, Alignment);
 }
 
+bool ResizeInPlace(LinAlloc* Alloc, void* Data, u32 NewSize)
+{
+	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	if (Data == nullptr || Header == nullptr ||
+		(u8*)Data != Alloc->CurrentBlock + Alloc->LastOffset ||
+		(u64)Alloc->LastOffset + NewSize > Header->ReserveSize)
+		return false;
+	UpdatePeak(Alloc);
+	CommitTo(Alloc, Alloc->LastOffset + NewSize);
+	Alloc->NextOffset = Alloc->LastOffset + NewSize;
+	return true;
+}
+
+void* Resize(LinAlloc* Alloc, void* Data, u32 OldSize, u32 NewSize, u32 Alignment)
+{
+	Assert(NewSize > 0, "Invalid allocation.");
+	if (ResizeInPlace(Alloc, Data, NewSize))
+		return Data;
+	void* NewData = Allocate(Alloc, NewSize, Alignment);
+	if (Data != nullptr)
+		memcpy(NewData, Data, min(OldSize, NewSize));
+	return NewData;
+}
+
+void* GrowStorage(LinAlloc* Alloc, void* Data, u32 Count, u32,
+	u32 NewCapacity, u32 ElementSize, u32 Alignment)
+{
+	Assert((u64)NewCapacity * ElementSize < U32_MAX, "Allocation too large.");
+	u32 NewSize = NewCapacity * ElementSize;
+	if (ResizeInPlace(Alloc, Data, NewSize))
+		return Data;
+	void* NewData = Allocate(Alloc, NewSize, Alignment);
+	if (Count > 0)
+		memcpy(NewData, Data, Count * ElementSize);
+	return NewData;
+}
 
 void FreeAll(LinAlloc* Alloc)
 {
+	UpdatePeak(Alloc);
+	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	while (Header) {
+		u8* ReleaseAddress = (u8*)Header;
+		u32 ReleaseSize = Header->ReserveSize;
+		Header = (BlockHeader*)Header->PrevBlock;
+		ReleaseMemory(ReleaseAddress, ReleaseSize);
+	}
+	Alloc->CurrentBlock = nullptr;
+	Alloc->NextOffset = 0;
+	Alloc->LastOffset = 0;
+	Alloc->RetiredSize = 0;
+}
+
+void Reset(LinAlloc* Alloc)
+{
+	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	if (Header == nullptr)
+		return;
+	UpdatePeak(Alloc);
+	BlockHeader* Prev = (BlockHeader*)Header->PrevBlock;
+	while (Prev) {
+		u8* ReleaseAddress = (u8*)Prev;
+		u32 ReleaseSize = Prev->ReserveSize;
+		Prev = (BlockHeader*)Prev->PrevBlock;
+		ReleaseMemory(ReleaseAddress, ReleaseSize);
+	}
+	Header->PrevBlock = nullptr;
+	Alloc->NextOffset = (u32)sizeof(BlockHeader);
+	Alloc->LastOffset = (u32)sizeof(BlockHeader);
+	Alloc->RetiredSize = 0;
+}
+
+Marker Mark(const LinAlloc* Alloc)
+{
+	return { Alloc->CurrentBlock, Alloc->NextOffset, Alloc->LastOffset };
+}
+
+void Rollback(LinAlloc* Alloc, Marker M)
+{
+	UpdatePeak(Alloc);
+	while (Alloc->CurrentBlock != M.Block) {
+		BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+		Assert(Header, "Mark isn't from this allocator or was already rolled back.");
+		BlockHeader* Prev = (BlockHeader*)Header->PrevBlock;
+		// A mark taken before anything was allocated keeps the first block,
+		//	otherwise work marked and rolled back over and over on an empty
+		//	allocator reserves and commits it again every time.
+		if (Prev == nullptr && M.Block == nullptr) {
+			M = { Alloc->CurrentBlock, (u32)sizeof(BlockHeader), (u32)sizeof(BlockHeader) };
+			break;
+		}
+		ReleaseMemory((u8*)Header, Header->ReserveSize);
+		Alloc->CurrentBlock = (u8*)Prev;
+		if (Prev) {
+			Alloc->RetiredSize -= Prev->UsedSize;
+			Alloc->NextOffset = Prev->UsedSize;
+			Prev->UsedSize = 0;
+		}
+	}
+	Assert(M.NextOffset <= Alloc->NextOffset || M.Block == nullptr,
+		"Marks rolled back out of order.");
+	Alloc->NextOffset = M.NextOffset;
+	Alloc->LastOffset = M.LastOffset;
+}
+
+Stats GetStats(const LinAlloc* Alloc)
+{
+	Stats S = {};
+	S.UsedSize = Alloc->RetiredSize + Alloc->NextOffset;
+	S.PeakSize = max(Alloc->PeakSize, S.UsedSize);
+	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	while (Header) {
+		S.CommittedSize += Header->CommitSize;
+		S.ReservedSize += Header->ReserveSize;
+		if (S.BlockCount > 0)
+			S.WastedSize += Header->CommitSize - Header->UsedSize;
+		++S.BlockCount;
+		Header = (BlockHeader*)Header->PrevBlock;
+	}
+	return S;
+}
+
+void GetBlocks(const LinAlloc* Alloc, std::vector<Block>& OutBlocks)
+{
+	OutBlocks.clear();
 	BlockHeader* Header = (BlockHeader*)Alloc->CurrentBlock;
+	u32 UsedSize = Alloc->NextOffset;
 	while (Header) {
-		void* ReleaseAddress = Header;
-		u32 ReleaseSize = Alloc->PageSize * Header->NumPages;
+		OutBlocks.push_back({ (u8*)Header, UsedSize });
 		Header = (BlockHeader*)Header->PrevBlock;
-		VirtualFree(
-			ReleaseAddress,
-			ReleaseSize,
-			MEM_RELEASE
-		);
+		if (Header)
+			UsedSize = Header->UsedSize;
+	}
+}
+
+// ----- POOL -----
+
+u32 PoolClass(u32 Size)
+{
+	Assert(Size > 0 && Size <= PoolMaxSize, "Invalid pool block size.");
+	if (Size <= PoolLinearMax)
+		return (Size - 1) / PoolGranularity;
+	u32 Class = PoolLinearMax / PoolGranularity;
+	for (u32 ClassSize = PoolLinearMax * 2 ; ClassSize < Size ; ClassSize *= 2)
+		++Class;
+	return Class;
+}
+
+u32 PoolClassSize(u32 Class)
+{
+	constexpr u32 LinearClasses = PoolLinearMax / PoolGranularity;
+	return Class < LinearClasses ? (Class + 1) * PoolGranularity :
+		PoolLinearMax << (Class - LinearClasses + 1);
+}
+
+static_assert(PoolLinearMax % PoolGranularity == 0 && 
+	PoolMaxSize == PoolLinearMax << (PoolClassCount - PoolLinearMax / PoolGranularity),
+	"The last pool class must hold PoolMaxSize.");
+
+void Init(Pool* P)
+{
+	Init(&P->Slabs);
+	for (u8*& FreeList : P->FreeLists)
+		FreeList = nullptr;
+}
+
+void* Allocate(Pool* P, u32 Size)
+{
+	u32 Class = PoolClass(Size);
+	u8* Block = P->FreeLists[Class];
+	if (Block)
+	{
+		P->FreeLists[Class] = *(u8**)Block;
+		return Block;
 	}
+	return Allocate(&P->Slabs, PoolClassSize(Class), PoolGranularity);
 }
 
+void Free(Pool* P, void* Data, u32 Size)
+{
+	if (Data == nullptr)
+		return;
+	u32 Class = PoolClass(Size);
+	*(u8**)Data = P->FreeLists[Class];
+	P->FreeLists[Class] = (u8*)Data;
+}
+
+void FreeAll(Pool* P)
+{
+	FreeAll(&P->Slabs);
+	for (u8*& FreeList : P->FreeLists)
+		FreeList = nullptr;
+}
+
+// Blocks on the free lists count as used, they're still cut from the slabs.
+Stats GetStats(const Pool* P)
+{
+	return GetStats(&P->Slabs);
+}
 
 } // namespace alloc
 } // namespace rlf
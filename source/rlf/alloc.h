@@ -3,34 +3,168 @@ namespace rlf {
 namespace alloc {
 
 
+// Untyped allocations are aligned for anything up to a SIMD register, typed
+//	ones for their type.
+constexpr u32 DefaultAlignment = 16;
+
+// Allocations are bumped out of a block of reserved address space, which is
+//	committed in growing chunks as it fills up. A block that runs out of space
+//	is followed by one reserving twice as much, so there are only ever a few.
 struct LinAlloc {
 	u8* CurrentBlock;
 	u32 NextOffset;
+	// Of the most recent allocation in CurrentBlock, which can be resized in 
+	//	place.
+	u32 LastOffset;
 	u32 PageSize;
+	// Bytes in use in the blocks before CurrentBlock, including their headers.
+	u64 RetiredSize;
+	// The most bytes in use at once, brought up to date whenever usage drops.
+	u64 PeakSize;
 };
 
 void Init(LinAlloc* Alloc);
-void* Allocate(LinAlloc* Alloc, u32 AllocSize);
-void* Allocate(LinAlloc* Alloc, size_t AllocSize);
+// Alignment must be a power of two, no larger than a page.
+void* Allocate(LinAlloc* Alloc, u32 AllocSize, u32 Alignment = DefaultAlignment);
+void* Allocate(LinAlloc* Alloc, size_t AllocSize, u32 Alignment = DefaultAlignment);
+// Grows or shrinks the most recent allocation in place if it has room to,
+//	otherwise moves the data to a new allocation.
+void* Resize(LinAlloc* Alloc, void* Data, u32 OldSize, u32 NewSize, 
+	u32 Alignment = DefaultAlignment);
 void FreeAll(LinAlloc* Alloc);
+// Frees every allocation but keeps the newest block and the memory committed
+//	to it, so an allocator reset each frame settles on one block which it never
+//	has to reserve or commit to again.
+void Reset(LinAlloc* Alloc);
+
+// Where an allocator was, so temporary work can share it and be rolled back.
+//	Marks are rolled back in the reverse order they were taken, and whatever
+//	was allocated before a mark mustn't grow while it's held.
+struct Marker
+{
+	u8* Block;
+	u32 NextOffset;
+	u32 LastOffset;
+};
+Marker Mark(const LinAlloc* Alloc);
+// Frees everything allocated since M was taken, along with any blocks started
+//	since. Rolling back a mark taken before anything was allocated keeps the
+//	first block, as Reset keeps one.
+void Rollback(LinAlloc* Alloc, Marker M);
+
+// Sizes include block headers and the padding for alignment.
+struct Stats
+{
+	u64 UsedSize;
+	u64 CommittedSize;
+	u64 ReservedSize;
+	u32 BlockCount;
+	// Committed at the end of older blocks, which were retired without using it.
+	u64 WastedSize;
+	u64 PeakSize;
+};
+Stats GetStats(const LinAlloc* Alloc);
+
+struct Block
+{
+	u8* Base;
+	// Bytes which may be in use, including the block header.
+	u32 Size;
+};
+// Newest block first.
+void GetBlocks(const LinAlloc* Alloc, std::vector<Block>& OutBlocks);
+
 
+// Blocks which are allocated and freed one at a time. Sizes are rounded up to
+//	a class, multiples of PoolGranularity up to PoolLinearMax and powers of two
+//	after. Blocks are cut from slabs in the order they're first allocated, so
+//	objects set up together sit next to each other, and freed ones go on a
+//	free list for their class.
+constexpr u32 PoolGranularity = 64;
+constexpr u32 PoolLinearMax = 1024;
+constexpr u32 PoolMaxSize = 64 * 1024;
+constexpr u32 PoolClassCount = 22;
+
+struct Pool
+{
+	LinAlloc Slabs;
+	// Linked through their first bytes.
+	u8* FreeLists[PoolClassCount];
+};
+
+void Init(Pool* P);
+// Aligned to PoolGranularity, so blocks don't share cache lines.
+void* Allocate(Pool* P, u32 Size);
+// Size is the one the block was allocated with.
+void Free(Pool* P, void* Data, u32 Size);
+void FreeAll(Pool* P);
+Stats GetStats(const Pool* P);
+
+
+// Types as large as a SIMD register get its alignment even when they're only
+//	made of floats, so they can be read with aligned vector loads.
+template <typename T>
+constexpr u32 AlignmentOf()
+{
+	return sizeof(T) >= DefaultAlignment && alignof(T) < DefaultAlignment ?
+		DefaultAlignment : (u32)alignof(T);
+}
 
 template <typename T>
 T* Allocate(LinAlloc* Alloc)
 {
-	return (T*)Allocate(Alloc, sizeof(T));
+	return (T*)Allocate(Alloc, (u32)sizeof(T), AlignmentOf<T>());
 }
 
+// Growable array for collecting items whose final count isn't known up front,
+//	before copying them to an Array with MakeCopy. Storage left behind when 
+//	the list grows isn't reused, so lists belong in a scratch LinAlloc which 
+//	is freed once they've been copied out. Zero-initialize for an empty list.
 template <typename T>
-Array<T> MakeCopy(LinAlloc* Alloc, std::vector<T> Source)
+struct List
+{
+	u32 Count;
+	u32 Capacity;
+	T* Data;
+
+	T& operator[](size_t index) { Assert(index < Count, "invalid"); return Data[index]; }
+	T* begin() { return Data; }
+	T* end() { return Data+Count; }
+};
+
+// Returns storage for NewCapacity elements starting with the Count elements at
+//	Data. Grows in place when Data is the most recent allocation.
+void* GrowStorage(LinAlloc* Alloc, void* Data, u32 Count, u32 Capacity, 
+	u32 NewCapacity, u32 ElementSize, u32 Alignment);
+
+template <typename T>
+void Reserve(LinAlloc* Alloc, List<T>* Dest, u32 Capacity)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "List items are moved with memcpy.");
+	if (Capacity <= Dest->Capacity)
+		return;
+	Dest->Data = (T*)GrowStorage(Alloc, Dest->Data, Dest->Count, Dest->Capacity, 
+		Capacity, sizeof(T), AlignmentOf<T>());
+	Dest->Capacity = Capacity;
+}
+
+template <typename T>
+void PushBack(LinAlloc* Alloc, List<T>* Dest, const T& Value)
+{
+	if (Dest->Count == Dest->Capacity)
+		Reserve(Alloc, Dest, Dest->Capacity < 8 ? 8 : Dest->Capacity * 2);
+	Dest->Data[Dest->Count++] = Value;
+}
+
+template <typename T>
+Array<T> MakeCopy(LinAlloc* Alloc, const T* Source, u32 Count)
 {
 	Array<T> Dest;
-	Assert(Source.size() < U32_MAX, "array too big");
-	Dest.Count = (u32)Source.size();
-	if (Source.size() > 0)
+	Dest.Count = Count;
+	if (Count > 0)
 	{
-		Dest.Data = (T*)Allocate(Alloc, Dest.Count * sizeof(T));
-		memcpy(Dest.Data, Source.data(), Dest.Count * sizeof(T));
+		Dest.Data = (T*)Allocate(Alloc, Count * (u32)sizeof(T), AlignmentOf<T>());
+		memcpy(Dest.Data, Source, Count * sizeof(T));
 	}
 	else
 	{
@@ -40,6 +174,19 @@ Array<T> MakeCopy(LinAlloc* Alloc, std::vector<T> Source)
 	return Dest;
 }
 
+template <typename T>
+Array<T> MakeCopy(LinAlloc* Alloc, const List<T>& Source)
+{
+	return MakeCopy(Alloc, Source.Data, Source.Count);
+}
+
+template <typename T>
+Array<T> MakeCopy(LinAlloc* Alloc, const std::vector<T>& Source)
+{
+	Assert(Source.size() < U32_MAX, "array too big");
+	return MakeCopy(Alloc, Source.data(), (u32)Source.size());
+}
+
 
 }
 }
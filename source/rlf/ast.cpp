@@ -3,37 +3,80 @@ namespace rlf {
 namespace ast {
 
 
-#define NODE_TYPE_ENTRY(type, eval_func, dep_func) \
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) \
 	static_assert(offsetof(type, Common) == 0, \
 		"Common must be first member of AST nodes for pointer casting to work.");
 NODE_TYPE_TUPLE
 #undef NODE_TYPE_ENTRY
 
 
-void Evaluate(const Node* node, const EvaluationContext& ec, Result& res);
+void Evaluate(const Node* node, const EvaluationContext& ec, Result& res,
+	EvaluationError& err);
 
-void Evaluate(const EvaluationContext& ec, Expression& expr, Result& res, 
-	ErrorState& es)
+bool Evaluate(const EvaluationContext& ec, Expression& expr, Result& res, 
+	EvaluationError& err)
 {
-	es.Success = true;
-
-	if ((expr.Dep.VariesByFlags & ec.ChangedThisFrameFlags) == 0 && expr.CacheValid)
+	if (expr.CacheValid)
 	{
 		res = expr.CachedResult;
-		return;
+		if (ec.Counters)
+			ec.Counters->Cached++;
+#if RLF_EXPRESSION_PROFILER
+		if (ec.Profile)
+			RecordCacheHit(*ec.Profile, expr);
+#endif
+		return true;
 	}
 
-	try {
-		Evaluate(expr.TopNode, ec, res);
-	}
-	catch (ErrorInfo ae)
+#if RLF_EXPRESSION_PROFILER
+	u64 start = ec.Profile ? ReadProfileTicks() : 0;
+#endif
+	err = {};
+	if (expr.Code)
+		Execute(*expr.Code, ec, res, err);
+	else
+		Evaluate(expr.TopNode, ec, res, err);
+	bool success = err.Code == EvaluationErrorCode::None;
+#if RLF_EXPRESSION_PROFILER
+	if (ec.Profile)
+		RecordEvaluation(*ec.Profile, expr, ReadProfileTicks() - start, success);
+#endif
+
+	if (ec.Counters)
 	{
-		es.Success = false;
-		es.Info = ae;
+		ec.Counters->Expressions++;
+		ec.Counters->Nodes += expr.NodeCount;
 	}
-
+	// An error is reported again the next time it's evaluated.
 	expr.CachedResult = res;
-	expr.CacheValid = true;
+	expr.CacheValid = success;
+	return success;
+}
+
+ErrorInfo FormatError(const EvaluationError& err)
+{
+#define EVALUATION_ERROR_ENTRY(name, message) message,
+	static const char* Messages[] = 
+	{
+		EVALUATION_ERROR_TUPLE
+	};
+#undef EVALUATION_ERROR_ENTRY
+	ErrorInfo info;
+	info.Location = err.At ? err.At->Location : nullptr;
+	info.Message = Messages[(u32)err.Code];
+	return info;
+}
+
+// Evaluating carries on past an error with a made up value, only the first
+//	error is kept. Cheaper than checking after every node when they're this
+//	rare.
+void Fail(EvaluationError& err, EvaluationErrorCode code, const Node* n)
+{
+	if (err.Code == EvaluationErrorCode::None)
+	{
+		err.Code = code;
+		err.At = n;
+	}
 }
 
 void AstError(const Node* n, const char* str, ...)
@@ -59,16 +102,16 @@ do {												\
 
 
 
-void ExpectFmt(const Node* n, VariableFormat fmt, Result& res, const char* name)
+void ExpectFmt(const Node* n, VariableFormat fmt, const Node* arg, const char* name)
 {
-	AstAssert(n, res.Type.Fmt == fmt, "Expected %s to be type %s but got %s.",
-		name, TypeFmtToString(fmt), TypeFmtToString(res.Type.Fmt));
+	AstAssert(n, arg->ResultType.Fmt == fmt, "Expected %s to be type %s but got %s.",
+		name, TypeFmtToString(fmt), TypeFmtToString(arg->ResultType.Fmt));
 }
 
-void ExpectDim(const Node* n, u32 dim, Result& res, const char* name)
+void ExpectDim(const Node* n, u32 dim, const Node* arg, const char* name)
 {
-	AstAssert(n, res.Type.Dim == dim, "Expected %s to be size %u but got %u.",
-		name, dim, res.Type.Dim);
+	AstAssert(n, arg->ResultType.Dim == dim, "Expected %s to be size %u but got %u.",
+		name, dim, arg->ResultType.Dim);
 }
 
 VariableFormat DetermineResultFormat(VariableFormat f1, VariableFormat f2)
@@ -93,343 +136,317 @@ VariableType DetermineResultType(const Node* n, VariableType t1, VariableType t2
 	return t;
 }
 
-void Expand(Result& res)
+u32 ValueSize(VariableType type)
 {
-	Assert(res.Type.Fmt != VariableFormat::Float4x4, "Invalid type in expand");
-	if (res.Type.Dim == 1)
-	{
-		switch (res.Type.Fmt)
-		{
-		case VariableFormat::Bool:
-			res.Value.Bool4Val.w = res.Value.Bool4Val.z = res.Value.Bool4Val.y = 
-				res.Value.Bool4Val.x;
-			break;
-		case VariableFormat::Int:
-			res.Value.Int4Val.w = res.Value.Int4Val.z = res.Value.Int4Val.y = 
-				res.Value.Int4Val.x;
-			break;
-		case VariableFormat::Uint:
-			res.Value.Uint4Val.w = res.Value.Uint4Val.z = res.Value.Uint4Val.y = 
-				res.Value.Uint4Val.x;
-			break;
-		case VariableFormat::Float:
-			res.Value.Float4Val.w = res.Value.Float4Val.z = res.Value.Float4Val.y = 
-				res.Value.Float4Val.x;
-			break;
-		default:
-			Unimplemented();
-		}
-	}
+	if (type.Fmt == VariableFormat::Float4x4)
+		return sizeof(float4x4);
+	else if (type.Fmt == VariableFormat::Bool)
+		return type.Dim * sizeof(bool);
+	else
+		return type.Dim * 4;
 }
 
-void Convert(Result& res, VariableFormat fmt)
+// -----------------------------------------------------------------------------
+// ------------------------------ KERNELS --------------------------------------
+// -----------------------------------------------------------------------------
+// Operators and conversions specialized for the format and size of their
+//	operands, so evaluating one doesn't switch on either. TypeCheck picks them
+//	once the types are known. Nodes store an index into the tables rather than
+//	a pointer, so they can be saved in .rlfc files.
+
+// The lanes of a value, the vector types all start at the beginning of a
+//	Variable.
+template <typename T>
+T* Lanes(Variable& v) { return (T*)&v; }
+template <typename T>
+const T* Lanes(const Variable& v) { return (const T*)&v; }
+
+struct AddOp
 {
-	if (res.Type.Fmt == fmt)
-		return;
-	if (fmt == VariableFormat::Bool)
-	{
-		switch (res.Type.Fmt)
-		{
-		case VariableFormat::Int:
-			res.Value.Bool4Val.x = res.Value.Bool4Val.x ? 1 : 0;
-			res.Value.Bool4Val.y = res.Value.Bool4Val.y ? 1 : 0;
-			res.Value.Bool4Val.z = res.Value.Bool4Val.z ? 1 : 0;
-			res.Value.Bool4Val.w = res.Value.Bool4Val.w ? 1 : 0;
-			break;
-		case VariableFormat::Uint:
-			res.Value.Bool4Val.x = (i32)res.Value.Uint4Val.x;
-			res.Value.Bool4Val.y = (i32)res.Value.Uint4Val.y;
-			res.Value.Bool4Val.z = (i32)res.Value.Uint4Val.z;
-			res.Value.Bool4Val.w = (i32)res.Value.Uint4Val.w;
-			break;
-		case VariableFormat::Float:
-			res.Value.Bool4Val.x = (i32)res.Value.Float4Val.x;
-			res.Value.Bool4Val.y = (i32)res.Value.Float4Val.y;
-			res.Value.Bool4Val.z = (i32)res.Value.Float4Val.z;
-			res.Value.Bool4Val.w = (i32)res.Value.Float4Val.w;
-			break;
-		default:
-			Unimplemented();
-		}
-	}
-	else if (fmt == VariableFormat::Int)
-	{
-		switch (res.Type.Fmt)
-		{
-		case VariableFormat::Bool:
-			res.Value.Int4Val.x = res.Value.Bool4Val.x ? 1 : 0;
-			res.Value.Int4Val.y = res.Value.Bool4Val.y ? 1 : 0;
-			res.Value.Int4Val.z = res.Value.Bool4Val.z ? 1 : 0;
-			res.Value.Int4Val.w = res.Value.Bool4Val.w ? 1 : 0;
-			break;
-		case VariableFormat::Uint:
-			res.Value.Int4Val.x = (i32)res.Value.Uint4Val.x;
-			res.Value.Int4Val.y = (i32)res.Value.Uint4Val.y;
-			res.Value.Int4Val.z = (i32)res.Value.Uint4Val.z;
-			res.Value.Int4Val.w = (i32)res.Value.Uint4Val.w;
-			break;
-		case VariableFormat::Float:
-			res.Value.Int4Val.x = (i32)res.Value.Float4Val.x;
-			res.Value.Int4Val.y = (i32)res.Value.Float4Val.y;
-			res.Value.Int4Val.z = (i32)res.Value.Float4Val.z;
-			res.Value.Int4Val.w = (i32)res.Value.Float4Val.w;
-			break;
-		default:
-			Unimplemented();
-		}
-	}
-	else if (fmt == VariableFormat::Uint)
-	{
-		switch (res.Type.Fmt)
-		{
-		case VariableFormat::Bool:
-			res.Value.Uint4Val.x = res.Value.Bool4Val.x ? 1 : 0;
-			res.Value.Uint4Val.y = res.Value.Bool4Val.y ? 1 : 0;
-			res.Value.Uint4Val.z = res.Value.Bool4Val.z ? 1 : 0;
-			res.Value.Uint4Val.w = res.Value.Bool4Val.w ? 1 : 0;
-			break;
-		case VariableFormat::Int:
-			res.Value.Uint4Val.x = (u32)res.Value.Int4Val.x;
-			res.Value.Uint4Val.y = (u32)res.Value.Int4Val.y;
-			res.Value.Uint4Val.z = (u32)res.Value.Int4Val.z;
-			res.Value.Uint4Val.w = (u32)res.Value.Int4Val.w;
-			break;
-		case VariableFormat::Float:
-			res.Value.Uint4Val.x = (u32)res.Value.Float4Val.x;
-			res.Value.Uint4Val.y = (u32)res.Value.Float4Val.y;
-			res.Value.Uint4Val.z = (u32)res.Value.Float4Val.z;
-			res.Value.Uint4Val.w = (u32)res.Value.Float4Val.w;
-			break;
-		default:
-			Unimplemented();
-		}
-	}
-	else if (fmt == VariableFormat::Float)
+	template <typename T>
+	static T Apply(T a, T b) { return a + b; }
+};
+struct SubtractOp
+{
+	template <typename T>
+	static T Apply(T a, T b) { return a - b; }
+};
+struct MultiplyOp
+{
+	template <typename T>
+	static T Apply(T a, T b) { return a * b; }
+};
+
+typedef void (*BinaryKernel)(const Node*, const Variable&, const Variable&, Variable&,
+	EvaluationError&);
+
+template <typename Op, typename T, u32 Dim>
+void OperatorKernel(const Node*, const Variable& arg1, const Variable& arg2,
+	Variable& res, EvaluationError&)
+{
+	const T* a = Lanes<T>(arg1);
+	const T* b = Lanes<T>(arg2);
+	T* d = Lanes<T>(res);
+	for (u32 i = 0 ; i < Dim ; ++i)
+		d[i] = Op::Apply(a[i], b[i]);
+}
+
+template <typename T, u32 Dim>
+void DivideKernel(const Node* n, const Variable& arg1, const Variable& arg2,
+	Variable& res, EvaluationError& err)
+{
+	const T* a = Lanes<T>(arg1);
+	const T* b = Lanes<T>(arg2);
+	T* d = Lanes<T>(res);
+	for (u32 i = 0 ; i < Dim ; ++i)
 	{
-		switch (res.Type.Fmt)
+		if (b[i] == 0)
 		{
-		case VariableFormat::Bool:
-			res.Value.Float4Val.x = res.Value.Bool4Val.x ? 1.f : 0.f;
-			res.Value.Float4Val.y = res.Value.Bool4Val.y ? 1.f : 0.f;
-			res.Value.Float4Val.z = res.Value.Bool4Val.z ? 1.f : 0.f;
-			res.Value.Float4Val.w = res.Value.Bool4Val.w ? 1.f : 0.f;
-			break;
-		case VariableFormat::Int:
-			res.Value.Float4Val.x = (float)res.Value.Int4Val.x;
-			res.Value.Float4Val.y = (float)res.Value.Int4Val.y;
-			res.Value.Float4Val.z = (float)res.Value.Int4Val.z;
-			res.Value.Float4Val.w = (float)res.Value.Int4Val.w;
-			break;
-		case VariableFormat::Uint:
-			res.Value.Float4Val.x = (float)res.Value.Uint4Val.x;
-			res.Value.Float4Val.y = (float)res.Value.Uint4Val.y;
-			res.Value.Float4Val.z = (float)res.Value.Uint4Val.z;
-			res.Value.Float4Val.w = (float)res.Value.Uint4Val.w;
-			break;
-		default:
-			Unimplemented();
+			Fail(err, EvaluationErrorCode::DivideByZero, n);
+			continue;
 		}
+		d[i] = a[i] / b[i];
 	}
 }
 
-void OperatorAdd(const Node* n, const Result& arg1, const Result& arg2, Result& res)
+void MatrixMultiplyKernel(const Node*, const Variable& arg1, const Variable& arg2,
+	Variable& res, EvaluationError&)
 {
-	switch (res.Type.Fmt)
-	{
-	case VariableFormat::Float:
-		res.Value.Float4Val = arg1.Value.Float4Val + arg2.Value.Float4Val;
-		break;
-	case VariableFormat::Int:
-		res.Value.Int4Val = arg1.Value.Int4Val + arg2.Value.Int4Val;
-		break;
-	case VariableFormat::Uint:
-		res.Value.Uint4Val = arg1.Value.Uint4Val + arg2.Value.Uint4Val;
-		break;
-	case VariableFormat::Bool:
-		AstError(n, "Bool add has not been defined");
-		break;
-	default:
-		Unimplemented();
-	}
+	res.Float4x4Val = arg1.Float4x4Val * arg2.Float4x4Val;
 }
 
-void OperatorSubtract(const Node* n, const Result& arg1, const Result& arg2, Result& res)
+#define KERNEL_DIMS(kernel, ...) \
+	kernel<__VA_ARGS__, 1>, kernel<__VA_ARGS__, 2>, kernel<__VA_ARGS__, 3>, \
+	kernel<__VA_ARGS__, 4>,
+
+// By operator, then by format from Int to Float, then by size.
+const BinaryKernel BinaryKernels[] =
 {
-	switch (res.Type.Fmt)
-	{
-	case VariableFormat::Float:
-		res.Value.Float4Val = arg1.Value.Float4Val - arg2.Value.Float4Val;
-		break;
-	case VariableFormat::Int:
-		res.Value.Int4Val = arg1.Value.Int4Val - arg2.Value.Int4Val;
-		break;
-	case VariableFormat::Uint:
-		res.Value.Uint4Val = arg1.Value.Uint4Val - arg2.Value.Uint4Val;
-		break;
-	case VariableFormat::Bool:
-		AstError(n, "Bool subtract has not been defined");
-		break;
-	default:
-		Unimplemented();
-	}
+	KERNEL_DIMS(OperatorKernel, AddOp, i32)
+	KERNEL_DIMS(OperatorKernel, AddOp, u32)
+	KERNEL_DIMS(OperatorKernel, AddOp, float)
+	KERNEL_DIMS(OperatorKernel, SubtractOp, i32)
+	KERNEL_DIMS(OperatorKernel, SubtractOp, u32)
+	KERNEL_DIMS(OperatorKernel, SubtractOp, float)
+	KERNEL_DIMS(OperatorKernel, MultiplyOp, i32)
+	KERNEL_DIMS(OperatorKernel, MultiplyOp, u32)
+	KERNEL_DIMS(OperatorKernel, MultiplyOp, float)
+	KERNEL_DIMS(DivideKernel, i32)
+	KERNEL_DIMS(DivideKernel, u32)
+	KERNEL_DIMS(DivideKernel, float)
+	MatrixMultiplyKernel,
+};
+constexpr u32 MatrixMultiplyKernelIndex = ARRAYSIZE(BinaryKernels) - 1;
+
+u8 BinaryKernelIndex(BinaryOp::Type op, VariableType type)
+{
+	if (type.Fmt == VariableFormat::Float4x4)
+		return MatrixMultiplyKernelIndex;
+	Assert(type.Fmt != VariableFormat::Bool && type.Dim >= 1 && type.Dim <= 4,
+		"No kernel for type");
+	u32 fmt = (u32)type.Fmt - (u32)VariableFormat::Int;
+	return (u8)((((u32)op * 3 + fmt) * 4) + type.Dim - 1);
 }
 
-void OperatorMultiply(const Node* n, const Result& arg1, const Result& arg2, Result& res)
+// Casts, except that bools become 0 or 1 and only 0 becomes false.
+template <typename To, typename From>
+struct LaneConvert
 {
-	switch (res.Type.Fmt)
-	{
-	case VariableFormat::Float:
-		res.Value.Float4Val = arg1.Value.Float4Val * arg2.Value.Float4Val;
-		break;
-	case VariableFormat::Int:
-		res.Value.Int4Val = arg1.Value.Int4Val * arg2.Value.Int4Val;
-		break;
-	case VariableFormat::Uint:
-		res.Value.Uint4Val = arg1.Value.Uint4Val * arg2.Value.Uint4Val;
-		break;
-	case VariableFormat::Bool:
-		AstError(n, "Bool multiply has not been defined");
-		break;
-	default:
-		Unimplemented();
-	}
+	static To Apply(From v) { return (To)v; }
+};
+template <typename From>
+struct LaneConvert<bool, From>
+{
+	static bool Apply(From v) { return (i32)v != 0; }
+};
+template <typename To>
+struct LaneConvert<To, bool>
+{
+	static To Apply(bool v) { return v ? (To)1 : (To)0; }
+};
+template <>
+struct LaneConvert<bool, bool>
+{
+	static bool Apply(bool v) { return v; }
+};
+
+typedef void (*ConversionKernel)(Variable&);
+
+// Converts in place, Splat uses the first lane for all of them so a scalar can
+//	be used as a vector.
+template <typename To, typename From, u32 Dim, bool Splat>
+void ConvertKernel(Variable& v)
+{
+	const From* from = Lanes<From>(v);
+	From src[Dim];
+	for (u32 i = 0 ; i < Dim ; ++i)
+		src[i] = from[Splat ? 0 : i];
+	To* to = Lanes<To>(v);
+	for (u32 i = 0 ; i < Dim ; ++i)
+		to[i] = LaneConvert<To, From>::Apply(src[i]);
 }
 
-void OperatorDivide(const Node* n, const Result& arg1, const Result& arg2, Result& res)
+#define CONVERSION_DIMS(to, from) \
+	ConvertKernel<to, from, 1, false>, ConvertKernel<to, from, 1, true>, \
+	ConvertKernel<to, from, 2, false>, ConvertKernel<to, from, 2, true>, \
+	ConvertKernel<to, from, 3, false>, ConvertKernel<to, from, 3, true>, \
+	ConvertKernel<to, from, 4, false>, ConvertKernel<to, from, 4, true>,
+#define CONVERSIONS_TO(to) \
+	CONVERSION_DIMS(to, bool) CONVERSION_DIMS(to, i32) CONVERSION_DIMS(to, u32) \
+	CONVERSION_DIMS(to, float)
+
+// By the format converted to, then the one converted from, then by size and
+//	whether it splats.
+const ConversionKernel ConversionKernels[] =
 {
-	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
-	{
-		switch (res.Type.Fmt)
-		{
-		case VariableFormat::Int:
-			AstAssert(n, arg2.Value.Int4Val.m[i] != 0, "Divide by zero");
-			res.Value.Int4Val.m[i] = arg1.Value.Int4Val.m[i] / 
-				arg2.Value.Int4Val.m[i];
-			break;
-		case VariableFormat::Uint:
-			AstAssert(n, arg2.Value.Uint4Val.m[i] != 0, "Divide by zero");
-			res.Value.Uint4Val.m[i] = arg1.Value.Uint4Val.m[i] / 
-				arg2.Value.Uint4Val.m[i];
-			break;
-		case VariableFormat::Float:
-			AstAssert(n, arg2.Value.Float4Val.m[i] != 0.f, "Divide by zero");
-			res.Value.Float4Val.m[i] = arg1.Value.Float4Val.m[i] / 
-				arg2.Value.Float4Val.m[i];
-			break;
-		case VariableFormat::Bool:
-		default:
-			Unimplemented();
-		}
-	}
+	CONVERSIONS_TO(bool)
+	CONVERSIONS_TO(i32)
+	CONVERSIONS_TO(u32)
+	CONVERSIONS_TO(float)
+};
+
+#undef CONVERSIONS_TO
+#undef CONVERSION_DIMS
+#undef KERNEL_DIMS
+
+u8 ConversionKernelIndex(VariableType from, VariableType to)
+{
+	Assert(from.Fmt != VariableFormat::Float4x4 && to.Fmt != VariableFormat::Float4x4 &&
+		to.Dim >= 1 && to.Dim <= 4, "No kernel for conversion");
+	Assert(from.Dim == to.Dim || from.Dim == 1, "Invalid conversion");
+	u32 splat = from.Dim == 1 && to.Dim > 1 ? 1 : 0;
+	return (u8)((((u32)to.Fmt * 4 + (u32)from.Fmt) * 4 + to.Dim - 1) * 2 + splat);
+}
+
+void Convert(Result& res, VariableFormat fmt)
+{
+	if (res.Type.Fmt == fmt)
+		return;
+	ConversionKernels[ConversionKernelIndex(res.Type, { fmt, res.Type.Dim })](res.Value);
 }
 
 // -----------------------------------------------------------------------------
 // ------------------------------ NODE EVALS -----------------------------------
 // -----------------------------------------------------------------------------
-void UintLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res)
+void UintLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
 {
 	UintLiteral* node = (UintLiteral*)n;
 	res.Type = UintType;
 	res.Value.UintVal = node->Val;
 }
+void UintLiteral_TypeCheck(Node* n, alloc::LinAlloc*)
+{
+	n->ResultType = UintType;
+}
 
-void IntLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res)
+void IntLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
 {
 	IntLiteral* node = (IntLiteral*)n;
 	res.Type = IntType;
 	res.Value.IntVal = node->Val;
 }
+void IntLiteral_TypeCheck(Node* n, alloc::LinAlloc*)
+{
+	n->ResultType = IntType;
+}
 
-void FloatLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res)
+void FloatLiteral_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
 {
 	FloatLiteral* node = (FloatLiteral*)n;
 	res.Type = FloatType;
 	res.Value.FloatVal = node->Val;
 }
+void FloatLiteral_TypeCheck(Node* n, alloc::LinAlloc*)
+{
+	n->ResultType = FloatType;
+}
 
-void Subscript_Evaluate(const Node* n, const EvaluationContext& ec, Result& res)
+void Subscript_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
 	Subscript* node = (Subscript*)n;
 	Result subjectRes;
-	Evaluate(node->Subject, ec, subjectRes);
-	AstAssert(n, subjectRes.Type.Fmt != VariableFormat::Float4x4,
-		"Subscripts aren't usable on Matrix types");
-	res.Type.Fmt = subjectRes.Type.Fmt;
-	u32 dim = 0;
-	for (u32 i = 0 ; i < 4 ; ++i)
+	Evaluate(node->Subject, ec, subjectRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
 	{
-		if (node->Index[i] == 0)
-			break;
-		AstAssert(n, node->Index[i] <= subjectRes.Type.Dim, 
-			"Invalid subscript for this type");
-		Assert(node->Index[i] <= 4, "Invalid subscript");
 		u8* src = ((u8*)&subjectRes.Value) + 4*(node->Index[i]-1);
 		u8* dest = ((u8*)&res.Value) + 4*i;
 		memcpy(dest, src, 4);
-		++dim;
 	}
-	Assert(dim > 0, "There must've been at least one subscript element.");
-	res.Type.Dim = dim;
 }
 void Subscript_GetDependency(const Node* n, DependencyInfo& dep)
 {
 	Subscript* node = (Subscript*)n;	
 	GetDependency(node->Subject, dep);
 }
+void Subscript_TypeCheck(Node* n, alloc::LinAlloc* alloc)
+{
+	Subscript* node = (Subscript*)n;
+	TypeCheck(node->Subject, alloc);
+	VariableType subjectType = node->Subject->ResultType;
+	AstAssert(n, subjectType.Fmt != VariableFormat::Float4x4,
+		"Subscripts aren't usable on Matrix types");
+	u32 dim = 0;
+	for ( ; dim < 4 && node->Index[dim] != 0 ; ++dim)
+	{
+		AstAssert(n, node->Index[dim] <= subjectType.Dim, 
+			"Invalid subscript for this type");
+		Assert(node->Index[dim] <= 4, "Invalid subscript");
+	}
+	Assert(dim > 0, "There must've been at least one subscript element.");
+	n->ResultType.Fmt = subjectType.Fmt;
+	n->ResultType.Dim = dim;
+}
 
-void Group_Evaluate(const Node* n, const EvaluationContext& ec, Result& res)
+void Group_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
 	Group* node = (Group*)n;
-	Evaluate(node->Sub, ec, res);
+	Evaluate(node->Sub, ec, res, err);
 }
 void Group_GetDependency(const Node* n, DependencyInfo& dep)
 {
 	Group* node = (Group*)n;
 	GetDependency(node->Sub, dep);
 }
+void Group_TypeCheck(Node* n, alloc::LinAlloc* alloc)
+{
+	Group* node = (Group*)n;
+	TypeCheck(node->Sub, alloc);
+	n->ResultType = node->Sub->ResultType;
+}
+
+// Wraps node in a Conversion to type, unless it already is of that type.
+void ConvertTo(Node*& node, VariableType type, alloc::LinAlloc* alloc)
+{
+	if (node->ResultType == type)
+		return;
+	Assert(node->ResultType.Fmt != VariableFormat::Float4x4 && 
+		type.Fmt != VariableFormat::Float4x4, "Invalid conversion");
+	Assert(node->ResultType.Dim == type.Dim || node->ResultType.Dim == 1,
+		"Invalid conversion");
+	Conversion* conv = alloc::Allocate<Conversion>(alloc);
+	conv->Common.Location = node->Location;
+	conv->Common.Type = NodeType::Conversion;
+	conv->Common.ResultType = type;
+	conv->Sub = node;
+	conv->Kernel = ConversionKernelIndex(node->ResultType, type);
+	node = &conv->Common;
+}
 
-void BinaryOp_Evaluate(const Node* n, const EvaluationContext& ec, Result& outRes)
+void BinaryOp_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
 	BinaryOp* node = (BinaryOp*)n;
-	Result res, arg1Res, arg2Res;
-	Evaluate(node->LArg, ec, arg1Res);
-	Evaluate(node->RArg, ec, arg2Res);
-	if (arg1Res.Type.Fmt == VariableFormat::Float4x4 ||
-		arg2Res.Type.Fmt == VariableFormat::Float4x4)
-	{
-		AstAssert(n, node->Op == BinaryOp::Type::Multiply, "Matrices can only be multiplied");
-		AstAssert(n, arg1Res.Type.Fmt == VariableFormat::Float4x4 &&
-			arg2Res.Type.Fmt == VariableFormat::Float4x4, 
-			"Matrix types can only be multiplied with other Matrix types");
-		res.Type = Float4x4Type;
-		res.Value.Float4x4Val = arg1Res.Value.Float4x4Val * arg2Res.Value.Float4x4Val;
-	}
-	else
-	{
-		if (node->Op == BinaryOp::Type::Divide)
-		{
-			AstAssert(n, arg1Res.Type.Fmt != VariableFormat::Bool && 
-				arg2Res.Type.Fmt != VariableFormat::Bool,
-				"Bool types not supported in divides.");
-		}
-		VariableType outType = DetermineResultType(n, arg1Res.Type, arg2Res.Type);
-		Expand(arg1Res);
-		Expand(arg2Res);
-		Convert(arg1Res, outType.Fmt);
-		Convert(arg2Res, outType.Fmt);
-		res.Type = outType;
-		if (node->Op == BinaryOp::Type::Add)
-			OperatorAdd(n, arg1Res, arg2Res, res);
-		else if (node->Op == BinaryOp::Type::Subtract)
-			OperatorSubtract(n, arg1Res, arg2Res, res);
-		else if (node->Op == BinaryOp::Type::Multiply)
-			OperatorMultiply(n, arg1Res, arg2Res, res);
-		else if (node->Op == BinaryOp::Type::Divide)
-			OperatorDivide(n, arg1Res, arg2Res, res);
-		else
-			Unimplemented();
-	}
-	outRes = res;
+	Result arg1Res, arg2Res;
+	Evaluate(node->LArg, ec, arg1Res, err);
+	Evaluate(node->RArg, ec, arg2Res, err);
+	res.Type = n->ResultType;
+	BinaryKernels[node->Kernel](n, arg1Res.Value, arg2Res.Value, res.Value, err);
 }
 void BinaryOp_GetDependency(const Node* n, DependencyInfo& dep)
 {
@@ -437,30 +454,54 @@ void BinaryOp_GetDependency(const Node* n, DependencyInfo& dep)
 	GetDependency(node->LArg, dep);
 	GetDependency(node->RArg, dep);
 }
+void BinaryOp_TypeCheck(Node* n, alloc::LinAlloc* alloc)
+{
+	BinaryOp* node = (BinaryOp*)n;
+	TypeCheck(node->LArg, alloc);
+	TypeCheck(node->RArg, alloc);
+	VariableType t1 = node->LArg->ResultType;
+	VariableType t2 = node->RArg->ResultType;
+	if (t1.Fmt == VariableFormat::Float4x4 || t2.Fmt == VariableFormat::Float4x4)
+	{
+		AstAssert(n, node->Op == BinaryOp::Type::Multiply, "Matrices can only be multiplied");
+		AstAssert(n, t1.Fmt == VariableFormat::Float4x4 && t2.Fmt == VariableFormat::Float4x4, 
+			"Matrix types can only be multiplied with other Matrix types");
+		n->ResultType = Float4x4Type;
+		node->Kernel = BinaryKernelIndex(node->Op, Float4x4Type);
+		return;
+	}
+
+	if (node->Op == BinaryOp::Type::Divide)
+	{
+		AstAssert(n, t1.Fmt != VariableFormat::Bool && t2.Fmt != VariableFormat::Bool,
+			"Bool types not supported in divides.");
+	}
+	VariableType outType = DetermineResultType(n, t1, t2);
+	static const char* OpNames[] = { "add", "subtract", "multiply", "divide" };
+	AstAssert(n, outType.Fmt != VariableFormat::Bool, "Bool %s has not been defined",
+		OpNames[(u32)node->Op]);
+	ConvertTo(node->LArg, outType, alloc);
+	ConvertTo(node->RArg, outType, alloc);
+	n->ResultType = outType;
+	node->Kernel = BinaryKernelIndex(node->Op, outType);
+}
 
-void Join_Evaluate(const Node* n, const EvaluationContext& ec, Result& outRes)
+void Join_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
 	Join* j = (Join*)n;
-	Assert(j->Comps.Count > 0, "Invalid join");
-	Result res = {};
-	Evaluate(j->Comps[0], ec, res);
+	Evaluate(j->Comps[0], ec, res, err);
+	u32 dim = res.Type.Dim;
 	for (size_t i = 1 ; i < j->Comps.Count ; ++i)
 	{
 		Result jr;
-		Evaluate(j->Comps[i], ec, jr);
-		VariableFormat jf = DetermineResultFormat(res.Type.Fmt, jr.Type.Fmt);
-		u32 jd = res.Type.Dim + jr.Type.Dim;
-		AstAssert(n, jd <= 4, "Resulting vector of size %d is unsupported", jd);
-		Convert(res, jf);
-		Convert(jr, jf);
-		for (u32 k = res.Type.Dim, l = 0 ; k < jd ; ++k, ++l)
+		Evaluate(j->Comps[i], ec, jr, err);
+		for (u32 l = 0 ; l < jr.Type.Dim ; ++l, ++dim)
 		{
-			res.Value.Float4Val.m[k] = jr.Value.Float4Val.m[l];
+			res.Value.Float4Val.m[dim] = jr.Value.Float4Val.m[l];
 		}
-		res.Type.Fmt = jf;
-		res.Type.Dim = jd;
 	}
-	outRes = res;
+	res.Type = n->ResultType;
 }
 void Join_GetDependency(const Node* n, DependencyInfo& dep)
 {
@@ -468,8 +509,28 @@ void Join_GetDependency(const Node* n, DependencyInfo& dep)
 	for (Node* comp : j->Comps)
 		GetDependency(comp, dep);
 }
+void Join_TypeCheck(Node* n, alloc::LinAlloc* alloc)
+{
+	Join* j = (Join*)n;
+	Assert(j->Comps.Count > 0, "Invalid join");
+	for (Node*& comp : j->Comps)
+		TypeCheck(comp, alloc);
 
-void VariableRef_Evaluate(const Node* n, const EvaluationContext&, Result& res)
+	VariableType jt = j->Comps[0]->ResultType;
+	for (size_t i = 1 ; i < j->Comps.Count ; ++i)
+	{
+		VariableType ct = j->Comps[i]->ResultType;
+		jt.Fmt = DetermineResultFormat(jt.Fmt, ct.Fmt);
+		jt.Dim += ct.Dim;
+		AstAssert(n, jt.Dim <= 4, "Resulting vector of size %d is unsupported", jt.Dim);
+	}
+	for (Node*& comp : j->Comps)
+		ConvertTo(comp, { jt.Fmt, comp->ResultType.Dim }, alloc);
+	n->ResultType = jt;
+}
+
+void VariableRef_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
 {
 	VariableRef* vr = (VariableRef*)n;
 	if (vr->IsTuneable)
@@ -498,309 +559,120 @@ void VariableRef_GetDependency(const Node* n, DependencyInfo& dep)
 		dep.VariesByFlags |= cnst->Expr.Dep.VariesByFlags;
 	}
 }
+void VariableRef_TypeCheck(Node* n, alloc::LinAlloc*)
+{
+	VariableRef* vr = (VariableRef*)n;
+	if (vr->IsTuneable)
+		n->ResultType = ((Tuneable*)vr->M)->Type;
+	else
+		n->ResultType = ((rlf::Constant*)vr->M)->Type;
+}
+
+void Conversion_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
+{
+	Conversion* conv = (Conversion*)n;
+	Evaluate(conv->Sub, ec, res, err);
+	ConversionKernels[conv->Kernel](res.Value);
+	res.Type = n->ResultType;
+}
+void Conversion_GetDependency(const Node* n, DependencyInfo& dep)
+{
+	Conversion* conv = (Conversion*)n;
+	GetDependency(conv->Sub, dep);
+}
+
+void Folded_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
+{
+	Folded* node = (Folded*)n;
+	res.Type = n->ResultType;
+	res.Value = node->Val;
+}
 
 
 // -----------------------------------------------------------------------------
 // ------------------------------ FUNCTION EVALS -------------------------------
 // -----------------------------------------------------------------------------
-void EvaluateInt(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 1, "Int takes 1 param.");
-	Result resX;
-	Evaluate(args[0], ec, resX);
-	ExpectDim(n, 1, resX, "arg1");
-	Convert(resX, VariableFormat::Int);
-	res.Type = IntType;
-	res.Value.IntVal = resX.Value.IntVal;
-}
-
-void EvaluateInt2(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 2, "Int2 takes 2 params.");
-	Result resX, resY;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	Convert(resX, VariableFormat::Int);
-	Convert(resY, VariableFormat::Int);
-	res.Type = Int2Type;
-	res.Value.Int4Val.x = resX.Value.IntVal;
-	res.Value.Int4Val.y = resY.Value.IntVal;
-}
-
-void EvaluateInt3(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 3, "Int3 takes 3 params.");
-	Result resX, resY, resZ;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	Convert(resX, VariableFormat::Int);
-	Convert(resY, VariableFormat::Int);
-	Convert(resZ, VariableFormat::Int);
-	res.Type = Int3Type;
-	res.Value.Int4Val.x = resX.Value.IntVal;
-	res.Value.Int4Val.y = resY.Value.IntVal;
-	res.Value.Int4Val.z = resZ.Value.IntVal;
-}
-
-void EvaluateInt4(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 4, "Int4 takes 4 params.");
-	Result resX, resY, resZ, resW;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	Evaluate(args[3], ec, resW);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	ExpectDim(n, 1, resW, "arg4");
-	Convert(resX, VariableFormat::Int);
-	Convert(resY, VariableFormat::Int);
-	Convert(resZ, VariableFormat::Int);
-	Convert(resW, VariableFormat::Int);
-	res.Type = Int3Type;
-	res.Value.Int4Val.x = resX.Value.IntVal;
-	res.Value.Int4Val.y = resY.Value.IntVal;
-	res.Value.Int4Val.z = resZ.Value.IntVal;
-	res.Value.Int4Val.w = resW.Value.IntVal;
-}
-
-void EvaluateUint(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 1, "Uint takes 1 param.");
-	Result resX;
-	Evaluate(args[0], ec, resX);
-	ExpectDim(n, 1, resX, "arg1");
-	Convert(resX, VariableFormat::Uint);
-	res.Type = UintType;
-	res.Value.UintVal = resX.Value.UintVal;
-}
-
-void EvaluateUint2(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+// Arguments have been converted to the types the functions take by TypeCheck.
+void EvaluateConstructor(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
 {
-	AstAssert(n, args.Count == 2, "Uint2 takes 2 params.");
-	Result resX, resY;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	Convert(resX, VariableFormat::Uint);
-	Convert(resY, VariableFormat::Uint);
-	res.Type = Uint2Type;
-	res.Value.Uint4Val.x = resX.Value.UintVal;
-	res.Value.Uint4Val.y = resY.Value.UintVal;
-}
-
-void EvaluateUint3(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 3, "Uint3 takes 3 params.");
-	Result resX, resY, resZ;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	Convert(resX, VariableFormat::Uint);
-	Convert(resY, VariableFormat::Uint);
-	Convert(resZ, VariableFormat::Uint);
-	res.Type = Uint3Type;
-	res.Value.Uint4Val.x = resX.Value.UintVal;
-	res.Value.Uint4Val.y = resY.Value.UintVal;
-	res.Value.Uint4Val.z = resZ.Value.UintVal;
-}
-
-void EvaluateUint4(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 4, "Uint4 takes 4 params.");
-	Result resX, resY, resZ, resW;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	Evaluate(args[3], ec, resW);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	ExpectDim(n, 1, resW, "arg4");
-	Convert(resX, VariableFormat::Uint);
-	Convert(resY, VariableFormat::Uint);
-	Convert(resZ, VariableFormat::Uint);
-	Convert(resW, VariableFormat::Uint);
-	res.Type = Uint3Type;
-	res.Value.Uint4Val.x = resX.Value.UintVal;
-	res.Value.Uint4Val.y = resY.Value.UintVal;
-	res.Value.Uint4Val.z = resZ.Value.UintVal;
-	res.Value.Uint4Val.w = resW.Value.UintVal;
-}
-
-void EvaluateFloat(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 1, "Float takes 1 param.");
-	Result resX;
-	Evaluate(args[0], ec, resX);
-	ExpectDim(n, 1, resX, "arg1");
-	Convert(resX, VariableFormat::Float);
-	res.Type = FloatType;
-	res.Value.FloatVal = resX.Value.FloatVal;
-}
-
-void EvaluateFloat2(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 2, "Float2 takes 2 params.");
-	Result resX, resY;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	Convert(resX, VariableFormat::Float);
-	Convert(resY, VariableFormat::Float);
-	res.Type = Float2Type;
-	res.Value.Float2Val.x = resX.Value.FloatVal;
-	res.Value.Float2Val.y = resY.Value.FloatVal;
-}
-
-void EvaluateFloat3(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 3, "Float3 takes 3 params.");
-	Result resX, resY, resZ;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	Convert(resX, VariableFormat::Float);
-	Convert(resY, VariableFormat::Float);
-	Convert(resZ, VariableFormat::Float);
-	res.Type = Float3Type;
-	res.Value.Float3Val.x = resX.Value.FloatVal;
-	res.Value.Float3Val.y = resY.Value.FloatVal;
-	res.Value.Float3Val.z = resZ.Value.FloatVal;
-}
-
-void EvaluateFloat4(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 4, "Float4 takes 4 params.");
-	Result resX, resY, resZ, resW;
-	Evaluate(args[0], ec, resX);
-	Evaluate(args[1], ec, resY);
-	Evaluate(args[2], ec, resZ);
-	Evaluate(args[3], ec, resW);
-	ExpectDim(n, 1, resX, "arg1");
-	ExpectDim(n, 1, resY, "arg2");
-	ExpectDim(n, 1, resZ, "arg3");
-	ExpectDim(n, 1, resW, "arg4");
-	Convert(resX, VariableFormat::Float);
-	Convert(resY, VariableFormat::Float);
-	Convert(resZ, VariableFormat::Float);
-	Convert(resW, VariableFormat::Float);
-	res.Type = Float3Type;
-	res.Value.Float4Val.x = resX.Value.FloatVal;
-	res.Value.Float4Val.y = resY.Value.FloatVal;
-	res.Value.Float4Val.z = resZ.Value.FloatVal;
-	res.Value.Float4Val.w = resW.Value.FloatVal;
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < args.Count ; ++i)
+	{
+		Result argRes;
+		Evaluate(args[i], ec, argRes, err);
+		res.Value.Uint4Val.m[i] = argRes.Value.UintVal;
+	}
 }
 
-void EvaluateTime(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+void EvaluateTime(const Node*, const EvaluationContext& ec, Array<Node*>,
+	Result& res, EvaluationError&)
 {
-	AstAssert(n, args.Count == 0, "Time does not take a param");
 	res.Type = FloatType;
 	res.Value.FloatVal = ec.Time;
 }
 
-void EvaluateDisplaySize(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+void EvaluateDisplaySize(const Node*, const EvaluationContext& ec, Array<Node*>,
+	Result& res, EvaluationError&)
 {
-	AstAssert(n, args.Count == 0, "DisplaySize does not take a param");
 	res.Type = Uint2Type;
 	res.Value.Uint4Val.x = ec.DisplaySize.x;
 	res.Value.Uint4Val.y = ec.DisplaySize.y;
 }
 
 void EvaluateSin(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+	Result& res, EvaluationError& err)
 {
-	AstAssert(n, args.Count == 1, "Sin takes 1 param");
 	Result argRes;
-	Evaluate(args[0], ec, argRes);
-	Convert(argRes, VariableFormat::Float);
-	res.Type = argRes.Type;
-	for (u32 i = 0 ; i < argRes.Type.Dim ; ++i)
+	Evaluate(args[0], ec, argRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
 	{
 		res.Value.Float4Val.m[i] = sin(argRes.Value.Float4Val.m[i]);
 	}
 }
 
 void EvaluateCos(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+	Result& res, EvaluationError& err)
 {
-	AstAssert(n, args.Count == 1, "Cos takes 1 param");
 	Result argRes;
-	Evaluate(args[0], ec, argRes);
-	Convert(argRes, VariableFormat::Float);
-	res.Type = argRes.Type;
-	for (u32 i = 0 ; i < argRes.Type.Dim ; ++i)
+	Evaluate(args[0], ec, argRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
 	{
 		res.Value.Float4Val.m[i] = cos(argRes.Value.Float4Val.m[i]);
 	}
 }
 
 void EvaluateMin(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 2, "Min takes 2 params");
-	Result arg1Res;
-	Evaluate(args[0], ec, arg1Res);
-	AstAssert(n, arg1Res.Type != Float4x4Type, "Min does not accept matrices (arg1)");
-	Result arg2Res;
-	Evaluate(args[1], ec, arg2Res);
-	AstAssert(n, arg1Res.Type != Float4x4Type, "Min does not accept matrices (arg2)");
-
-	VariableType outType = DetermineResultType(n, arg1Res.Type, arg2Res.Type);
-	Expand(arg1Res);
-	Expand(arg2Res);
-	Convert(arg1Res, outType.Fmt);
-	Convert(arg2Res, outType.Fmt);
-	res.Type = outType;
-
-	if (outType.Fmt == VariableFormat::Bool) {
+	Result& res, EvaluationError& err)
+{
+	Result arg1Res, arg2Res;
+	Evaluate(args[0], ec, arg1Res, err);
+	Evaluate(args[1], ec, arg2Res, err);
+	res.Type = n->ResultType;
+
+	if (res.Type.Fmt == VariableFormat::Bool) {
 		res.Value.Bool4Val.x = arg1Res.Value.Bool4Val.x && arg2Res.Value.Bool4Val.x;
 		res.Value.Bool4Val.y = arg1Res.Value.Bool4Val.y && arg2Res.Value.Bool4Val.y;
 		res.Value.Bool4Val.z = arg1Res.Value.Bool4Val.z && arg2Res.Value.Bool4Val.z;
 		res.Value.Bool4Val.w = arg1Res.Value.Bool4Val.w && arg2Res.Value.Bool4Val.w;
 	}
-	else  if (outType.Fmt == VariableFormat::Int) {
+	else  if (res.Type.Fmt == VariableFormat::Int) {
 		res.Value.Int4Val.x = min(arg1Res.Value.Int4Val.x, arg2Res.Value.Int4Val.x);
 		res.Value.Int4Val.y = min(arg1Res.Value.Int4Val.y, arg2Res.Value.Int4Val.y);
 		res.Value.Int4Val.z = min(arg1Res.Value.Int4Val.z, arg2Res.Value.Int4Val.z);
 		res.Value.Int4Val.w = min(arg1Res.Value.Int4Val.w, arg2Res.Value.Int4Val.w);
 	}
-	else  if (outType.Fmt == VariableFormat::Uint) {
+	else  if (res.Type.Fmt == VariableFormat::Uint) {
 		res.Value.Uint4Val.x = min(arg1Res.Value.Uint4Val.x, arg2Res.Value.Uint4Val.x);
 		res.Value.Uint4Val.y = min(arg1Res.Value.Uint4Val.y, arg2Res.Value.Uint4Val.y);
 		res.Value.Uint4Val.z = min(arg1Res.Value.Uint4Val.z, arg2Res.Value.Uint4Val.z);
 		res.Value.Uint4Val.w = min(arg1Res.Value.Uint4Val.w, arg2Res.Value.Uint4Val.w);
 	}
-	else  if (outType.Fmt == VariableFormat::Float) {
+	else  if (res.Type.Fmt == VariableFormat::Float) {
 		res.Value.Float4Val.x = min(arg1Res.Value.Float4Val.x, arg2Res.Value.Float4Val.x);
 		res.Value.Float4Val.y = min(arg1Res.Value.Float4Val.y, arg2Res.Value.Float4Val.y);
 		res.Value.Float4Val.z = min(arg1Res.Value.Float4Val.z, arg2Res.Value.Float4Val.z);
@@ -811,42 +683,32 @@ void EvaluateMin(const Node* n, const EvaluationContext& ec, Array<Node*> args,
 }
 
 void EvaluateMax(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 2, "Max takes 2 params");
-	Result arg1Res;
-	Evaluate(args[0], ec, arg1Res);
-	AstAssert(n, arg1Res.Type != Float4x4Type, "Max does not accept matrices (arg1)");
-	Result arg2Res;
-	Evaluate(args[1], ec, arg2Res);
-	AstAssert(n, arg2Res.Type != Float4x4Type, "Max does not accept matrices (arg2)");
-
-	VariableType outType = DetermineResultType(n, arg1Res.Type, arg2Res.Type);
-	Expand(arg1Res);
-	Expand(arg2Res);
-	Convert(arg1Res, outType.Fmt);
-	Convert(arg2Res, outType.Fmt);
-	res.Type = outType;
-
-	if (outType.Fmt == VariableFormat::Bool) {
+	Result& res, EvaluationError& err)
+{
+	Result arg1Res, arg2Res;
+	Evaluate(args[0], ec, arg1Res, err);
+	Evaluate(args[1], ec, arg2Res, err);
+	res.Type = n->ResultType;
+
+	if (res.Type.Fmt == VariableFormat::Bool) {
 		res.Value.Bool4Val.x = arg1Res.Value.Bool4Val.x || arg2Res.Value.Bool4Val.x;
 		res.Value.Bool4Val.y = arg1Res.Value.Bool4Val.y || arg2Res.Value.Bool4Val.y;
 		res.Value.Bool4Val.z = arg1Res.Value.Bool4Val.z || arg2Res.Value.Bool4Val.z;
 		res.Value.Bool4Val.w = arg1Res.Value.Bool4Val.w || arg2Res.Value.Bool4Val.w;
 	}
-	else  if (outType.Fmt == VariableFormat::Int) {
+	else  if (res.Type.Fmt == VariableFormat::Int) {
 		res.Value.Int4Val.x = max(arg1Res.Value.Int4Val.x, arg2Res.Value.Int4Val.x);
 		res.Value.Int4Val.y = max(arg1Res.Value.Int4Val.y, arg2Res.Value.Int4Val.y);
 		res.Value.Int4Val.z = max(arg1Res.Value.Int4Val.z, arg2Res.Value.Int4Val.z);
 		res.Value.Int4Val.w = max(arg1Res.Value.Int4Val.w, arg2Res.Value.Int4Val.w);
 	}
-	else  if (outType.Fmt == VariableFormat::Uint) {
+	else  if (res.Type.Fmt == VariableFormat::Uint) {
 		res.Value.Uint4Val.x = max(arg1Res.Value.Uint4Val.x, arg2Res.Value.Uint4Val.x);
 		res.Value.Uint4Val.y = max(arg1Res.Value.Uint4Val.y, arg2Res.Value.Uint4Val.y);
 		res.Value.Uint4Val.z = max(arg1Res.Value.Uint4Val.z, arg2Res.Value.Uint4Val.z);
 		res.Value.Uint4Val.w = max(arg1Res.Value.Uint4Val.w, arg2Res.Value.Uint4Val.w);
 	}
-	else  if (outType.Fmt == VariableFormat::Float) {
+	else  if (res.Type.Fmt == VariableFormat::Float) {
 		res.Value.Float4Val.x = max(arg1Res.Value.Float4Val.x, arg2Res.Value.Float4Val.x);
 		res.Value.Float4Val.y = max(arg1Res.Value.Float4Val.y, arg2Res.Value.Float4Val.y);
 		res.Value.Float4Val.z = max(arg1Res.Value.Float4Val.z, arg2Res.Value.Float4Val.z);
@@ -856,52 +718,232 @@ void EvaluateMax(const Node* n, const EvaluationContext& ec, Array<Node*> args,
 		Unimplemented();
 }
 
-void EvaluateInverse(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+// Same as min(max(x, lo), hi).
+void EvaluateClamp(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result xRes, loRes, hiRes;
+	Evaluate(args[0], ec, xRes, err);
+	Evaluate(args[1], ec, loRes, err);
+	Evaluate(args[2], ec, hiRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+	{
+		if (res.Type.Fmt == VariableFormat::Int)
+			res.Value.Int4Val.m[i] = min(max(xRes.Value.Int4Val.m[i], 
+				loRes.Value.Int4Val.m[i]), hiRes.Value.Int4Val.m[i]);
+		else if (res.Type.Fmt == VariableFormat::Uint)
+			res.Value.Uint4Val.m[i] = min(max(xRes.Value.Uint4Val.m[i], 
+				loRes.Value.Uint4Val.m[i]), hiRes.Value.Uint4Val.m[i]);
+		else
+			res.Value.Float4Val.m[i] = min(max(xRes.Value.Float4Val.m[i], 
+				loRes.Value.Float4Val.m[i]), hiRes.Value.Float4Val.m[i]);
+	}
+}
+
+void EvaluateSaturate(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result argRes;
+	Evaluate(args[0], ec, argRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+		res.Value.Float4Val.m[i] = min(max(argRes.Value.Float4Val.m[i], 0.f), 1.f);
+}
+
+// a + (b - a) * t, like HLSL's lerp.
+void EvaluateLerp(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes, tRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	Evaluate(args[2], ec, tRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+	{
+		float a = aRes.Value.Float4Val.m[i];
+		res.Value.Float4Val.m[i] = a + (bRes.Value.Float4Val.m[i] - a) * 
+			tRes.Value.Float4Val.m[i];
+	}
+}
+
+// Summed in lane order, the bytecode does the same so the results match.
+float DotLanes(const float4& a, const float4& b, u32 dim)
+{
+	float sum = a.m[0] * b.m[0];
+	for (u32 i = 1 ; i < dim ; ++i)
+		sum += a.m[i] * b.m[i];
+	return sum;
+}
+
+void EvaluateDot(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	res.Type = FloatType;
+	res.Value.FloatVal = DotLanes(aRes.Value.Float4Val, bRes.Value.Float4Val, 
+		aRes.Type.Dim);
+}
+
+void EvaluateCross(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	res.Type = Float3Type;
+	res.Value.Float3Val = cross(aRes.Value.Float3Val, bRes.Value.Float3Val);
+}
+
+void EvaluateLength(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result argRes;
+	Evaluate(args[0], ec, argRes, err);
+	const float4& v = argRes.Value.Float4Val;
+	res.Type = FloatType;
+	res.Value.FloatVal = std::sqrt(DotLanes(v, v, argRes.Type.Dim));
+}
+
+void EvaluateNormalize(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result argRes;
+	Evaluate(args[0], ec, argRes, err);
+	const float4& v = argRes.Value.Float4Val;
+	float length = std::sqrt(DotLanes(v, v, argRes.Type.Dim));
+	res.Type = n->ResultType;
+	if (length == 0.f)
+	{
+		Fail(err, EvaluationErrorCode::NormalizeZero, n);
+		return;
+	}
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+		res.Value.Float4Val.m[i] = v.m[i] / length;
+}
+
+// The quotient rounded away from zero when the operands have the same sign, so
+//	DivRoundUp(count, groupSize) is enough groups to cover count.
+template <typename T>
+T DivRoundUpLane(T a, T b)
+{
+	T q = a / b;
+	if (a % b != 0 && (a < 0) == (b < 0))
+		++q;
+	return q;
+}
+
+void EvaluateDivRoundUp(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	res.Type = n->ResultType;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+	{
+		if (bRes.Value.Uint4Val.m[i] == 0)
+		{
+			Fail(err, EvaluationErrorCode::DivideByZero, n);
+			continue;
+		}
+		if (res.Type.Fmt == VariableFormat::Int)
+			res.Value.Int4Val.m[i] = DivRoundUpLane(aRes.Value.Int4Val.m[i],
+				bRes.Value.Int4Val.m[i]);
+		else
+			res.Value.Uint4Val.m[i] = DivRoundUpLane(aRes.Value.Uint4Val.m[i],
+				bRes.Value.Uint4Val.m[i]);
+	}
+}
+
+void EvaluateInverse(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
 {
-	AstAssert(n, args.Count == 1, "Inverse takes 1 param");
 	Result argRes;
-	Evaluate(args[0], ec, argRes);
-	ExpectFmt(n, VariableFormat::Float4x4, argRes, "arg1");
+	Evaluate(args[0], ec, argRes, err);
 	res.Type = Float4x4Type;
 	inverse(argRes.Value.Float4x4Val, res.Value.Float4x4Val);
 }
 
-void EvaluateLookAt(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
+void EvaluateTranspose(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result argRes;
+	Evaluate(args[0], ec, argRes, err);
+	res.Type = Float4x4Type;
+	res.Value.Float4x4Val = transposed(argRes.Value.Float4x4Val);
+}
+
+// A vector on the right is a column, on the left a row, like HLSL's mul.
+void EvaluateMul(const Node* n, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	res.Type = n->ResultType;
+	const Variable& a = aRes.Value;
+	const Variable& b = bRes.Value;
+	if (aRes.Type.Fmt != VariableFormat::Float4x4)
+	{
+		for (u32 j = 0 ; j < 4 ; ++j)
+		{
+			float4 column = { b.Float4x4Val.m[j][0], b.Float4x4Val.m[j][1], 
+				b.Float4x4Val.m[j][2], b.Float4x4Val.m[j][3] };
+			res.Value.Float4Val.m[j] = DotLanes(a.Float4Val, column, 4);
+		}
+	}
+	else if (bRes.Type.Fmt != VariableFormat::Float4x4)
+		res.Value.Float4Val = a.Float4x4Val * b.Float4Val;
+	else
+		res.Value.Float4x4Val = a.Float4x4Val * b.Float4x4Val;
+}
+
+void EvaluateLookAt(const Node*, const EvaluationContext& ec, Array<Node*> args,
+	Result& res, EvaluationError& err)
 {
-	AstAssert(n, args.Count == 2, "LookAt takes 2 params");
 	Result fromRes, toRes;
-	Evaluate(args[0], ec, fromRes);
-	Evaluate(args[1], ec, toRes);
-	ExpectDim(n, 3, fromRes, "arg1 (from)");
-	ExpectDim(n, 3, toRes, "arg2 (to)");
-	Convert(fromRes, VariableFormat::Float);
-	Convert(toRes, VariableFormat::Float);
+	Evaluate(args[0], ec, fromRes, err);
+	Evaluate(args[1], ec, toRes, err);
 	res.Type = Float4x4Type;
 	res.Value.Float4x4Val = lookAt(fromRes.Value.Float3Val, toRes.Value.Float3Val);
 }
 
+// Also the orthographic and reverse Z projections, which take the same four
+//	floats. Reverse Z swaps the planes, so depth goes from 1 at near to 0 at far.
+float4x4 ProjectionMatrix(FunctionType func, float a, float b, float zn, float zf)
+{
+	switch (func)
+	{
+	case FunctionType::Projection:
+		return projection(a, b, zn, zf);
+	case FunctionType::ProjectionReverseZ:
+		return projection(a, b, zf, zn);
+	case FunctionType::Orthographic:
+		return orthographic(a, b, zn, zf);
+	case FunctionType::OrthographicReverseZ:
+		return orthographic(a, b, zf, zn);
+	default:
+		Unimplemented();
+		return float4x4();
+	}
+}
+
 void EvaluateProjection(const Node* n, const EvaluationContext& ec, Array<Node*> args,
-	Result& res)
-{
-	AstAssert(n, args.Count == 4, "Projection takes 4 params");
-	Result fovRes, aspectRes, nearRes, farRes;
-	Evaluate(args[0], ec, fovRes);
-	Evaluate(args[1], ec, aspectRes);
-	Evaluate(args[2], ec, nearRes);
-	Evaluate(args[3], ec, farRes);
-	ExpectDim(n, 1, fovRes, "arg1 (fov)");
-	ExpectDim(n, 1, aspectRes, "arg2 (aspect)");
-	ExpectDim(n, 1, nearRes, "arg3 (znear)");
-	ExpectDim(n, 1, farRes, "arg4 (zfar)");
-	Convert(fovRes, VariableFormat::Float);
-	Convert(aspectRes, VariableFormat::Float);
-	Convert(nearRes, VariableFormat::Float);
-	Convert(farRes, VariableFormat::Float);
+	Result& res, EvaluationError& err)
+{
+	Result aRes, bRes, nearRes, farRes;
+	Evaluate(args[0], ec, aRes, err);
+	Evaluate(args[1], ec, bRes, err);
+	Evaluate(args[2], ec, nearRes, err);
+	Evaluate(args[3], ec, farRes, err);
 	res.Type = Float4x4Type;
-	res.Value.Float4x4Val = projection(fovRes.Value.FloatVal, aspectRes.Value.FloatVal, 
-		nearRes.Value.FloatVal, farRes.Value.FloatVal);
+	res.Value.Float4x4Val = ProjectionMatrix(((const Function*)n)->Func, 
+		aRes.Value.FloatVal, bRes.Value.FloatVal, nearRes.Value.FloatVal, 
+		farRes.Value.FloatVal);
 }
 
 
@@ -916,94 +958,286 @@ u32 LowerHash(const char* str)
 	return h; 
 }
 
-typedef void (*FunctionEvaluate)(const Node*, const EvaluationContext&, Array<Node*>,
-	Result&);
-struct FunctionInfo
+#define FUNCTION_ENTRY(name, eval_func, varies_by) #name,
+const char* FunctionNames[] = 
 {
-	FunctionEvaluate fn;
-	VariesBy vb;
-};
-std::unordered_map<u32, FunctionInfo> FuncMap = {
-	{ LowerHash("Int"), { EvaluateInt, VariesBy_None} },
-	{ LowerHash("Int2"), { EvaluateInt2, VariesBy_None} },
-	{ LowerHash("Int3"), { EvaluateInt3, VariesBy_None} },
-	{ LowerHash("Int4"), { EvaluateInt4, VariesBy_None} },
-	{ LowerHash("Uint"), { EvaluateUint, VariesBy_None} },
-	{ LowerHash("Uint2"), { EvaluateUint2, VariesBy_None} },
-	{ LowerHash("Uint3"), { EvaluateUint3, VariesBy_None} },
-	{ LowerHash("Uint4"), { EvaluateUint4, VariesBy_None} },
-	{ LowerHash("Float"), { EvaluateFloat, VariesBy_None} },
-	{ LowerHash("Float2"), { EvaluateFloat2, VariesBy_None} },
-	{ LowerHash("Float3"), { EvaluateFloat3, VariesBy_None} },
-	{ LowerHash("Float4"), { EvaluateFloat4, VariesBy_None} },
-	{ LowerHash("Time"), { EvaluateTime, VariesBy_Time} },
-	{ LowerHash("DisplaySize"), { EvaluateDisplaySize, VariesBy_DisplaySize} },
-	{ LowerHash("Sin"), { EvaluateSin, VariesBy_None} },
-	{ LowerHash("Cos"), { EvaluateCos, VariesBy_None} },
-	{ LowerHash("Min"), { EvaluateMin, VariesBy_None} },
-	{ LowerHash("Max"), { EvaluateMax, VariesBy_None} },
-	{ LowerHash("Inverse"), { EvaluateInverse, VariesBy_None} },
-	{ LowerHash("LookAt"), { EvaluateLookAt, VariesBy_None} },
-	{ LowerHash("Projection"), { EvaluateProjection, VariesBy_None} },
+	FUNCTION_TUPLE
 };
+#undef FUNCTION_ENTRY
 
-void Function_Evaluate(const Node* n, const EvaluationContext& ec, Result& res)
+void Function_Evaluate(const Node* n, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
+	typedef void (*FunctionEvaluate)(const Node*, const EvaluationContext&, Array<Node*>,
+		Result&, EvaluationError&);
+
+#define FUNCTION_ENTRY(name, eval_func, varies_by) eval_func,
+	static const FunctionEvaluate FunctionEvals[] = 
+	{
+		FUNCTION_TUPLE
+	};
+#undef FUNCTION_ENTRY
 	Function* f = (Function*)n;
-	u32 funcHash = LowerHash(f->Name);
-	AstAssert(n, FuncMap.count(funcHash) == 1, "No function named %s exists.",
-		f->Name);
-	FunctionEvaluate fi = FuncMap[funcHash].fn;
-	fi(n, ec, f->Args, res);
+	FunctionEvals[(u32)f->Func](n, ec, f->Args, res, err);
 }
 void Function_GetDependency(const Node* n, DependencyInfo& dep)
+{
+#define FUNCTION_ENTRY(name, eval_func, varies_by) varies_by,
+	static const VariesBy FunctionVariesBy[] = 
+	{
+		FUNCTION_TUPLE
+	};
+#undef FUNCTION_ENTRY
+	Function* f = (Function*)n;
+	dep.VariesByFlags |= FunctionVariesBy[(u32)f->Func];
+
+	for (Node* arg : f->Args)
+		GetDependency(arg, dep);
+}
+void Function_TypeCheck(Node* n, alloc::LinAlloc* alloc)
 {
 	Function* f = (Function*)n;
 	u32 funcHash = LowerHash(f->Name);
-	AstAssert(n, FuncMap.count(funcHash) == 1, "No function named %s exists.",
+	u32 func = 0;
+	while (func < (u32)FunctionType::Count && LowerHash(FunctionNames[func]) != funcHash)
+		++func;
+	AstAssert(n, func < (u32)FunctionType::Count, "No function named %s exists.", 
 		f->Name);
+	f->Func = (FunctionType)func;
+	const char* name = FunctionNames[func];
 
-	VariesBy vb = FuncMap[funcHash].vb;
-	dep.VariesByFlags |= vb;
+	Array<Node*>& args = f->Args;
+	for (Node*& arg : args)
+		TypeCheck(arg, alloc);
 
-	for (Node* arg : f->Args)
-		GetDependency(arg, dep);
+	static const char* ArgNames[] = { "arg1", "arg2", "arg3", "arg4" };
+	switch (f->Func)
+	{
+	case FunctionType::Int:
+	case FunctionType::Int2:
+	case FunctionType::Int3:
+	case FunctionType::Int4:
+	case FunctionType::Uint:
+	case FunctionType::Uint2:
+	case FunctionType::Uint3:
+	case FunctionType::Uint4:
+	case FunctionType::Float:
+	case FunctionType::Float2:
+	case FunctionType::Float3:
+	case FunctionType::Float4:
+	{
+		u32 ctor = func - (u32)FunctionType::Int;
+		VariableType type;
+		type.Fmt = ctor < 4 ? VariableFormat::Int :
+			ctor < 8 ? VariableFormat::Uint : VariableFormat::Float;
+		type.Dim = ctor % 4 + 1;
+		AstAssert(n, args.Count == type.Dim, "%s takes %u param%s.", name, type.Dim,
+			type.Dim == 1 ? "" : "s");
+		for (u32 i = 0 ; i < args.Count ; ++i)
+		{
+			ExpectDim(n, 1, args[i], ArgNames[i]);
+			ConvertTo(args[i], { type.Fmt, 1 }, alloc);
+		}
+		n->ResultType = type;
+		break;
+	}
+	case FunctionType::Time:
+	case FunctionType::DisplaySize:
+		AstAssert(n, args.Count == 0, "%s does not take a param", name);
+		n->ResultType = f->Func == FunctionType::Time ? FloatType : Uint2Type;
+		break;
+	case FunctionType::Sin:
+	case FunctionType::Cos:
+	{
+		AstAssert(n, args.Count == 1, "%s takes 1 param", name);
+		AstAssert(n, args[0]->ResultType != Float4x4Type, "%s does not accept matrices",
+			name);
+		VariableType type = { VariableFormat::Float, args[0]->ResultType.Dim };
+		ConvertTo(args[0], type, alloc);
+		n->ResultType = type;
+		break;
+	}
+	case FunctionType::Min:
+	case FunctionType::Max:
+	{
+		AstAssert(n, args.Count == 2, "%s takes 2 params", name);
+		AstAssert(n, args[0]->ResultType != Float4x4Type, 
+			"%s does not accept matrices (arg1)", name);
+		AstAssert(n, args[1]->ResultType != Float4x4Type, 
+			"%s does not accept matrices (arg2)", name);
+		VariableType type = DetermineResultType(n, args[0]->ResultType, 
+			args[1]->ResultType);
+		ConvertTo(args[0], type, alloc);
+		ConvertTo(args[1], type, alloc);
+		n->ResultType = type;
+		break;
+	}
+	case FunctionType::Clamp:
+	case FunctionType::Lerp:
+	{
+		AstAssert(n, args.Count == 3, "%s takes 3 params", name);
+		VariableType type = args[0]->ResultType;
+		for (u32 i = 0 ; i < 3 ; ++i)
+		{
+			AstAssert(n, args[i]->ResultType != Float4x4Type, 
+				"%s does not accept matrices (%s)", name, ArgNames[i]);
+			type = DetermineResultType(n, type, args[i]->ResultType);
+		}
+		if (f->Func == FunctionType::Lerp)
+			type.Fmt = VariableFormat::Float;
+		AstAssert(n, type.Fmt != VariableFormat::Bool, "%s does not accept bools", name);
+		for (u32 i = 0 ; i < 3 ; ++i)
+			ConvertTo(args[i], type, alloc);
+		n->ResultType = type;
+		break;
+	}
+	case FunctionType::Saturate:
+	case FunctionType::Length:
+	case FunctionType::Normalize:
+	{
+		AstAssert(n, args.Count == 1, "%s takes 1 param", name);
+		AstAssert(n, args[0]->ResultType != Float4x4Type, "%s does not accept matrices",
+			name);
+		VariableType type = { VariableFormat::Float, args[0]->ResultType.Dim };
+		ConvertTo(args[0], type, alloc);
+		n->ResultType = f->Func == FunctionType::Length ? FloatType : type;
+		break;
+	}
+	case FunctionType::Dot:
+	case FunctionType::Cross:
+	{
+		AstAssert(n, args.Count == 2, "%s takes 2 params", name);
+		u32 dim = f->Func == FunctionType::Cross ? 3 : args[0]->ResultType.Dim;
+		for (u32 i = 0 ; i < 2 ; ++i)
+		{
+			AstAssert(n, args[i]->ResultType != Float4x4Type, 
+				"%s does not accept matrices (%s)", name, ArgNames[i]);
+			ExpectDim(n, dim, args[i], ArgNames[i]);
+			ConvertTo(args[i], { VariableFormat::Float, dim }, alloc);
+		}
+		n->ResultType = f->Func == FunctionType::Cross ? Float3Type : FloatType;
+		break;
+	}
+	case FunctionType::DivRoundUp:
+	{
+		AstAssert(n, args.Count == 2, "DivRoundUp takes 2 params");
+		for (u32 i = 0 ; i < 2 ; ++i)
+		{
+			AstAssert(n, args[i]->ResultType != Float4x4Type, 
+				"DivRoundUp does not accept matrices (%s)", ArgNames[i]);
+		}
+		VariableType type = DetermineResultType(n, args[0]->ResultType, 
+			args[1]->ResultType);
+		AstAssert(n, type.Fmt == VariableFormat::Int || type.Fmt == VariableFormat::Uint,
+			"DivRoundUp only accepts int and uint types, not %s", 
+			TypeFmtToString(type.Fmt));
+		ConvertTo(args[0], type, alloc);
+		ConvertTo(args[1], type, alloc);
+		n->ResultType = type;
+		break;
+	}
+	case FunctionType::Inverse:
+	case FunctionType::Transpose:
+		AstAssert(n, args.Count == 1, "%s takes 1 param", name);
+		ExpectFmt(n, VariableFormat::Float4x4, args[0], "arg1");
+		n->ResultType = Float4x4Type;
+		break;
+	case FunctionType::Mul:
+	{
+		AstAssert(n, args.Count == 2, "Mul takes 2 params");
+		bool lhsMatrix = args[0]->ResultType == Float4x4Type;
+		bool rhsMatrix = args[1]->ResultType == Float4x4Type;
+		AstAssert(n, lhsMatrix || rhsMatrix, "Mul needs a matrix, use * for vectors");
+		for (u32 i = 0 ; i < 2 ; ++i)
+		{
+			if (args[i]->ResultType == Float4x4Type)
+				continue;
+			ExpectDim(n, 4, args[i], ArgNames[i]);
+			ConvertTo(args[i], Float4Type, alloc);
+		}
+		n->ResultType = lhsMatrix && rhsMatrix ? Float4x4Type : Float4Type;
+		break;
+	}
+	case FunctionType::LookAt:
+		AstAssert(n, args.Count == 2, "LookAt takes 2 params");
+		ExpectDim(n, 3, args[0], "arg1 (from)");
+		ExpectDim(n, 3, args[1], "arg2 (to)");
+		ConvertTo(args[0], Float3Type, alloc);
+		ConvertTo(args[1], Float3Type, alloc);
+		n->ResultType = Float4x4Type;
+		break;
+	case FunctionType::Projection:
+	case FunctionType::ProjectionReverseZ:
+	case FunctionType::Orthographic:
+	case FunctionType::OrthographicReverseZ:
+	{
+		AstAssert(n, args.Count == 4, "%s takes 4 params", name);
+		static const char* ProjectionArgNames[] = { "arg1 (fov)", "arg2 (aspect)", 
+			"arg3 (znear)", "arg4 (zfar)" };
+		static const char* OrthographicArgNames[] = { "arg1 (width)", "arg2 (height)", 
+			"arg3 (znear)", "arg4 (zfar)" };
+		bool ortho = f->Func == FunctionType::Orthographic || 
+			f->Func == FunctionType::OrthographicReverseZ;
+		for (u32 i = 0 ; i < 4 ; ++i)
+		{
+			ExpectDim(n, 1, args[i], ortho ? OrthographicArgNames[i] : 
+				ProjectionArgNames[i]);
+			ConvertTo(args[i], FloatType, alloc);
+		}
+		n->ResultType = Float4x4Type;
+		break;
+	}
+	default:
+		Unimplemented();
+	}
 }
 
 
-void SizeOf_Evaluate(const Node* n, const EvaluationContext&, Result& res)
+void SizeOf_Evaluate(const Node* n, const EvaluationContext&, Result& res,
+	EvaluationError&)
 {
 	SizeOf* sz = (SizeOf*)n;
 	res.Type = 	UintType; 
 	res.Value.UintVal = sz->Size;
 }
+void SizeOf_TypeCheck(Node* n, alloc::LinAlloc*)
+{
+	n->ResultType = UintType;
+}
 
 void None_GetDependency(const Node*, DependencyInfo&)
 {
 	// Intentionally add no dependency
 }
 
+void None_TypeCheck(Node*, alloc::LinAlloc*)
+{
+	// Only created after parsing the node, already typed
+}
+
 
-void Evaluate(const Node* node, const EvaluationContext& ec, Result& res)
+void Evaluate(const Node* node, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
 {
-	typedef void (*EvalFunc)(const Node*, const EvaluationContext&, Result&);
+	typedef void (*EvalFunc)(const Node*, const EvaluationContext&, Result&,
+		EvaluationError&);
 
-#define NODE_TYPE_ENTRY(type, eval_func, dep_func) eval_func,
-	static EvalFunc EvalFuncs[] = 
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) eval_func,
+	static const EvalFunc EvalFuncs[] = 
 	{
 		NODE_TYPE_TUPLE
 	};
 #undef NODE_TYPE_ENTRY
 	EvalFunc ef = EvalFuncs[(u32)node->Type];
-	ef(node, ec, res);
+	ef(node, ec, res, err);
 }
 
 void GetDependency(const Node* node, DependencyInfo& dep)
 {
 	typedef void (*DepFunc)(const Node*, DependencyInfo&);
 
-#define NODE_TYPE_ENTRY(type, eval_func, dep_func) dep_func,
-	static DepFunc DepFuncs[] = 
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) dep_func,
+	static const DepFunc DepFuncs[] = 
 	{
 		NODE_TYPE_TUPLE
 	};
@@ -1012,6 +1246,20 @@ void GetDependency(const Node* node, DependencyInfo& dep)
 	df(node, dep);
 }
 
+void TypeCheck(Node*& node, alloc::LinAlloc* alloc)
+{
+	typedef void (*CheckFunc)(Node*, alloc::LinAlloc*);
+
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) check_func,
+	static const CheckFunc CheckFuncs[] = 
+	{
+		NODE_TYPE_TUPLE
+	};
+#undef NODE_TYPE_ENTRY
+	CheckFunc cf = CheckFuncs[(u32)node->Type];
+	cf(node, alloc);
+}
+
 
 #undef AstAssert
 
@@ -1,13 +1,34 @@
 
 namespace rlf {
+
+struct Constant;
+struct Tuneable;
+
 namespace ast {
 
+struct ExpressionProfile;
+
+
+// Work done by evaluating expressions, summed up over a frame.
+struct EvaluationCounters
+{
+	u32 Expressions;
+	u32 Nodes;
+	// Expressions which were asked for but still cached.
+	u32 Cached;
+};
 
 struct EvaluationContext
 {
 	uint2 DisplaySize;
 	float Time;
 	u32 ChangedThisFrameFlags;
+	// Which tuneables VariesBy_Tuneable in ChangedThisFrameFlags stands for.
+	Array<Tuneable*> ChangedTuneables;
+	// Optional.
+	EvaluationCounters* Counters;
+	// Optional, only looked at if RLF_EXPRESSION_PROFILER is enabled.
+	ExpressionProfile* Profile;
 };
 
 struct Result
@@ -26,21 +47,28 @@ enum VariesBy
 struct DependencyInfo
 {
 	u32 VariesByFlags = VariesBy_None;
+	// Filled in by LinkExpressions. Tuneables are the ones read directly or
+	//	through other constants, Constants only the ones read directly: a chain
+	//	of constants would otherwise make each list as long as the chain.
+	Array<Tuneable*> Tuneables = {};
+	Array<Constant*> Constants = {};
 };
 
 #define NODE_TYPE_TUPLE \
-	NODE_TYPE_ENTRY(UintLiteral,		 UintLiteral_Evaluate, 		None_GetDependency) \
-	NODE_TYPE_ENTRY(IntLiteral,			 IntLiteral_Evaluate, 		None_GetDependency) \
-	NODE_TYPE_ENTRY(FloatLiteral,		 FloatLiteral_Evaluate, 	None_GetDependency) \
-	NODE_TYPE_ENTRY(Subscript,			 Subscript_Evaluate, 		Subscript_GetDependency) \
-	NODE_TYPE_ENTRY(Group,				 Group_Evaluate, 			Group_GetDependency) \
-	NODE_TYPE_ENTRY(BinaryOp,			 BinaryOp_Evaluate, 		BinaryOp_GetDependency) \
-	NODE_TYPE_ENTRY(Join,				 Join_Evaluate, 			Join_GetDependency) \
-	NODE_TYPE_ENTRY(VariableRef,		 VariableRef_Evaluate, 		VariableRef_GetDependency) \
-	NODE_TYPE_ENTRY(Function,			 Function_Evaluate, 		Function_GetDependency) \
-	NODE_TYPE_ENTRY(SizeOf,				 SizeOf_Evaluate, 			None_GetDependency) \
-
-#define NODE_TYPE_ENTRY(type, eval_func, dep_func) type,
+	NODE_TYPE_ENTRY(UintLiteral,	UintLiteral_Evaluate,	None_GetDependency,			UintLiteral_TypeCheck) \
+	NODE_TYPE_ENTRY(IntLiteral,		IntLiteral_Evaluate,	None_GetDependency,			IntLiteral_TypeCheck) \
+	NODE_TYPE_ENTRY(FloatLiteral,	FloatLiteral_Evaluate,	None_GetDependency,			FloatLiteral_TypeCheck) \
+	NODE_TYPE_ENTRY(Subscript,		Subscript_Evaluate,		Subscript_GetDependency,	Subscript_TypeCheck) \
+	NODE_TYPE_ENTRY(Group,			Group_Evaluate,			Group_GetDependency,		Group_TypeCheck) \
+	NODE_TYPE_ENTRY(BinaryOp,		BinaryOp_Evaluate,		BinaryOp_GetDependency,		BinaryOp_TypeCheck) \
+	NODE_TYPE_ENTRY(Join,			Join_Evaluate,			Join_GetDependency,			Join_TypeCheck) \
+	NODE_TYPE_ENTRY(VariableRef,	VariableRef_Evaluate,	VariableRef_GetDependency,	VariableRef_TypeCheck) \
+	NODE_TYPE_ENTRY(Function,		Function_Evaluate,		Function_GetDependency,		Function_TypeCheck) \
+	NODE_TYPE_ENTRY(SizeOf,			SizeOf_Evaluate,		None_GetDependency,			SizeOf_TypeCheck) \
+	NODE_TYPE_ENTRY(Conversion,		Conversion_Evaluate,	Conversion_GetDependency,	None_TypeCheck) \
+	NODE_TYPE_ENTRY(Folded,			Folded_Evaluate,		None_GetDependency,			None_TypeCheck) \
+
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) type,
 enum class NodeType
 {
 	NODE_TYPE_TUPLE
@@ -52,52 +80,136 @@ struct Node
 {
 	const char* Location;
 	NodeType Type;
+	// Set by TypeCheck.
+	VariableType ResultType;
+};
+
+#define FUNCTION_TUPLE \
+	FUNCTION_ENTRY(Int,			EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Int2,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Int3,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Int4,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Uint,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Uint2,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Uint3,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Uint4,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Float,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Float2,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Float3,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Float4,		EvaluateConstructor,	VariesBy_None) \
+	FUNCTION_ENTRY(Time,		EvaluateTime,			VariesBy_Time) \
+	FUNCTION_ENTRY(DisplaySize,	EvaluateDisplaySize,	VariesBy_DisplaySize) \
+	FUNCTION_ENTRY(Sin,			EvaluateSin,			VariesBy_None) \
+	FUNCTION_ENTRY(Cos,			EvaluateCos,			VariesBy_None) \
+	FUNCTION_ENTRY(Min,			EvaluateMin,			VariesBy_None) \
+	FUNCTION_ENTRY(Max,			EvaluateMax,			VariesBy_None) \
+	FUNCTION_ENTRY(Clamp,		EvaluateClamp,			VariesBy_None) \
+	FUNCTION_ENTRY(Saturate,	EvaluateSaturate,		VariesBy_None) \
+	FUNCTION_ENTRY(Lerp,		EvaluateLerp,			VariesBy_None) \
+	FUNCTION_ENTRY(Dot,			EvaluateDot,			VariesBy_None) \
+	FUNCTION_ENTRY(Cross,		EvaluateCross,			VariesBy_None) \
+	FUNCTION_ENTRY(Length,		EvaluateLength,			VariesBy_None) \
+	FUNCTION_ENTRY(Normalize,	EvaluateNormalize,		VariesBy_None) \
+	FUNCTION_ENTRY(DivRoundUp,	EvaluateDivRoundUp,		VariesBy_None) \
+	FUNCTION_ENTRY(Inverse,		EvaluateInverse,		VariesBy_None) \
+	FUNCTION_ENTRY(Transpose,	EvaluateTranspose,		VariesBy_None) \
+	FUNCTION_ENTRY(Mul,			EvaluateMul,			VariesBy_None) \
+	FUNCTION_ENTRY(LookAt,		EvaluateLookAt,			VariesBy_None) \
+	FUNCTION_ENTRY(Projection,	EvaluateProjection,		VariesBy_None) \
+	FUNCTION_ENTRY(ProjectionReverseZ,	EvaluateProjection,	VariesBy_None) \
+	FUNCTION_ENTRY(Orthographic,		EvaluateProjection,	VariesBy_None) \
+	FUNCTION_ENTRY(OrthographicReverseZ,	EvaluateProjection,	VariesBy_None) \
+
+#define FUNCTION_ENTRY(name, eval_func, varies_by) name,
+enum class FunctionType
+{
+	FUNCTION_TUPLE
+	Count
+};
+#undef FUNCTION_ENTRY
+
+struct Program;
+
+#define EVALUATION_ERROR_TUPLE \
+	EVALUATION_ERROR_ENTRY(None,			"No error") \
+	EVALUATION_ERROR_ENTRY(DivideByZero,	"Divide by zero") \
+	EVALUATION_ERROR_ENTRY(NormalizeZero,	"Normalize of a zero length vector") \
+
+#define EVALUATION_ERROR_ENTRY(name, message) name,
+enum class EvaluationErrorCode
+{
+	EVALUATION_ERROR_TUPLE
+};
+#undef EVALUATION_ERROR_ENTRY
+
+// Why an evaluation failed and the node it failed at. Nothing is formatted
+//	until the error is shown, see FormatError.
+struct EvaluationError
+{
+	EvaluationErrorCode Code = EvaluationErrorCode::None;
+	const Node* At = nullptr;
 };
 
 struct Expression 
 {
 	const Node* TopNode;
+	// Null if the expression couldn't be compiled, it's walked instead.
+	const Program* Code;
 
 	DependencyInfo Dep;
 	Result CachedResult;
+	// Cleared when anything the expression reads changes, by MarkChanged or
+	//	by a constant it reads getting a new value.
 	bool CacheValid;
+	// Evaluated each time the cache isn't valid, for the counters.
+	u32 NodeCount;
 
 	bool IsValid() const { return TopNode != 0; }
 	bool VariesByTime() const { return Dep.VariesByFlags & VariesBy_Time; }
 	bool Constant() const { return Dep.VariesByFlags == VariesBy_None; }
 };
 
-void Evaluate(const EvaluationContext& ec, Expression& expr, Result& res, 
-	ErrorState& es);
+// Returns false if evaluating failed, with the reason in err. Doesn't throw
+//	or allocate.
+bool Evaluate(const EvaluationContext& ec, Expression& expr, Result& res, 
+	EvaluationError& err);
+ErrorInfo FormatError(const EvaluationError& err);
 void GetDependency(const Node* node, DependencyInfo& dep);
+// Resolves functions, sets the ResultType of every node and wraps operands in
+//	Conversion nodes wherever an operation needs a different type. Throws on
+//	type errors, which evaluation no longer checks for.
+void TypeCheck(Node*& node, alloc::LinAlloc* alloc);
 
 void Convert(Result& res, VariableFormat fmt);
+// Bytes of a Variable which hold a value of type, evaluation leaves the rest
+//	undefined.
+u32 ValueSize(VariableType type);
 
 
 struct UintLiteral
 {
-	static constexpr NodeType NodeType = NodeType::UintLiteral;
+	static constexpr ast::NodeType NodeType = ast::NodeType::UintLiteral;
 	Node Common;
 	u32 Val;
 };
 
 struct IntLiteral
 {
-	static constexpr NodeType NodeType = NodeType::IntLiteral;
+	static constexpr ast::NodeType NodeType = ast::NodeType::IntLiteral;
 	Node Common;
 	i32 Val;
 };
 
 struct FloatLiteral
 {
-	static constexpr NodeType NodeType = NodeType::FloatLiteral;
+	static constexpr ast::NodeType NodeType = ast::NodeType::FloatLiteral;
 	Node Common;
 	float Val;
 };
 
 struct Subscript
 {
-	static constexpr NodeType NodeType = NodeType::Subscript;
+	static constexpr ast::NodeType NodeType = ast::NodeType::Subscript;
 	Node Common;
 	Node* Subject;
 	u8 Index[4];
@@ -105,14 +217,14 @@ struct Subscript
 
 struct Group
 {
-	static constexpr NodeType NodeType = NodeType::Group;
+	static constexpr ast::NodeType NodeType = ast::NodeType::Group;
 	Node Common;
 	Node* Sub;
 };
 
 struct BinaryOp
 {
-	static constexpr NodeType NodeType = NodeType::BinaryOp;
+	static constexpr ast::NodeType NodeType = ast::NodeType::BinaryOp;
 	Node Common;
 	enum class Type {
 		Add, Subtract, Multiply, Divide
@@ -120,18 +232,20 @@ struct BinaryOp
 	Node* LArg;
 	Node* RArg;
 	Type Op;
+	// Into the kernels for the operator and ResultType, set by TypeCheck.
+	u8 Kernel;
 };
 
 struct Join
 {
-	static constexpr NodeType NodeType = NodeType::Join;
+	static constexpr ast::NodeType NodeType = ast::NodeType::Join;
 	Node Common;
 	Array<Node*> Comps;
 };
 
 struct VariableRef
 {
-	static constexpr NodeType NodeType = NodeType::VariableRef;
+	static constexpr ast::NodeType NodeType = ast::NodeType::VariableRef;
 	Node Common;
 	bool IsTuneable;
 	void* M;
@@ -139,20 +253,41 @@ struct VariableRef
 
 struct Function
 {
-	static constexpr NodeType NodeType = NodeType::Function;
+	static constexpr ast::NodeType NodeType = ast::NodeType::Function;
 	Node Common;
 	const char* Name;
 	Array<Node*> Args;
+	FunctionType Func;
 };
 
 struct SizeOf
 {
-	static constexpr NodeType NodeType = NodeType::SizeOf;
+	static constexpr ast::NodeType NodeType = ast::NodeType::SizeOf;
 	Node Common;
 	const char* StructName;
 	u32 Size;
 };
 
+// Expands a scalar to the vector size and converts to the format of its
+//	ResultType.
+struct Conversion
+{
+	static constexpr ast::NodeType NodeType = ast::NodeType::Conversion;
+	Node Common;
+	Node* Sub;
+	// Into the kernels for the types of Sub and the conversion.
+	u8 Kernel;
+};
+
+// The value of a subtree which was evaluated while parsing, because nothing in
+//	it can change.
+struct Folded
+{
+	static constexpr ast::NodeType NodeType = ast::NodeType::Folded;
+	Node Common;
+	Variable Val;
+};
+
 
 }
 }
@@ -0,0 +1,1138 @@
+namespace rlf {
+namespace ast {
+
+
+// Enough for any expression seen so far, deeper ones keep being walked.
+constexpr u32 MaxRegisters = 64;
+
+struct Compiler
+{
+	alloc::LinAlloc* scratch;
+	alloc::List<Instruction> Code;
+	alloc::List<Register> Constants;
+	alloc::List<const Variable*> Variables;
+	alloc::List<const Node*> Nodes;
+};
+
+Instruction& Emit(Compiler& c, Opcode op, u32 dst, u32 a = 0, u32 b = 0)
+{
+	Instruction in = {};
+	in.Op = op;
+	in.Dst = (u8)dst;
+	in.A = (u8)a;
+	in.B = (u8)b;
+	in.Count = 4;
+	alloc::PushBack(c.scratch, &c.Code, in);
+	return c.Code[c.Code.Count-1];
+}
+
+template <typename T>
+bool AddEntry(Compiler& c, alloc::List<T>& list, const T& entry, u16& outIndex)
+{
+	if (list.Count > U16_MAX)
+		return false;
+	outIndex = (u16)list.Count;
+	alloc::PushBack(c.scratch, &list, entry);
+	return true;
+}
+
+u32 RegisterCount(VariableType type)
+{
+	return type.Fmt == VariableFormat::Float4x4 ? 4 : 1;
+}
+
+// Converts the first dim lanes of reg.
+void EmitConvert(Compiler& c, u32 reg, VariableFormat from, VariableFormat to, u32 dim)
+{
+	if (from == to)
+		return;
+	Opcode op = Opcode::Count;
+	if (to == VariableFormat::Float)
+		op = from == VariableFormat::Int ? Opcode::IntToFloat : Opcode::UintToFloat;
+	else if (to == VariableFormat::Int)
+		op = from == VariableFormat::Float ? Opcode::FloatToInt : Opcode::UintToInt;
+	else if (to == VariableFormat::Uint)
+		op = from == VariableFormat::Float ? Opcode::FloatToUint : Opcode::IntToUint;
+	Assert(op != Opcode::Count, "Invalid conversion");
+	Emit(c, op, reg, reg).Count = (u8)dim;
+}
+
+bool CompileNode(Compiler& c, const Node* n, u32 dst);
+
+// Arguments in registers dst and up, a matrix taking four.
+bool CompileArgs(Compiler& c, const Array<Node*>& args, u32 dst)
+{
+	for (u32 i = 0 ; i < args.Count ; ++i)
+	{
+		if (!CompileNode(c, args.Data[i], dst))
+			return false;
+		dst += RegisterCount(args.Data[i]->ResultType);
+	}
+	return true;
+}
+
+// For ops which can fail, so the error points at the function.
+bool EmitFailable(Compiler& c, Opcode op, const Function* f, u32 dst, u32 a, u32 b, 
+	u32 count)
+{
+	u16 index;
+	if (!AddEntry(c, c.Nodes, &f->Common, index))
+		return false;
+	Instruction& in = Emit(c, op, dst, a, b);
+	in.Count = (u8)count;
+	in.Index = index;
+	return true;
+}
+
+bool CompileFunction(Compiler& c, const Function* f, u32 dst)
+{
+	const Array<Node*>& args = f->Args;
+	if (!CompileArgs(c, args, dst))
+		return false;
+
+	VariableType type = f->Common.ResultType;
+	switch (f->Func)
+	{
+	case FunctionType::Int:
+	case FunctionType::Int2:
+	case FunctionType::Int3:
+	case FunctionType::Int4:
+	case FunctionType::Uint:
+	case FunctionType::Uint2:
+	case FunctionType::Uint3:
+	case FunctionType::Uint4:
+	case FunctionType::Float:
+	case FunctionType::Float2:
+	case FunctionType::Float3:
+	case FunctionType::Float4:
+		if (args.Count > 1)
+			Emit(c, Opcode::Gather, dst, dst).Count = (u8)args.Count;
+		break;
+	case FunctionType::Time:
+		Emit(c, Opcode::LoadTime, dst);
+		break;
+	case FunctionType::DisplaySize:
+		Emit(c, Opcode::LoadDisplaySize, dst);
+		break;
+	case FunctionType::Sin:
+		Emit(c, Opcode::Sin, dst, dst).Count = (u8)type.Dim;
+		break;
+	case FunctionType::Cos:
+		Emit(c, Opcode::Cos, dst, dst).Count = (u8)type.Dim;
+		break;
+	case FunctionType::Min:
+	case FunctionType::Max:
+	{
+		static const Opcode MinOps[] = { Opcode::MinInt, Opcode::MinUint, Opcode::MinFloat };
+		static const Opcode MaxOps[] = { Opcode::MaxInt, Opcode::MaxUint, Opcode::MaxFloat };
+		u32 fmtIndex = (u32)type.Fmt - (u32)VariableFormat::Int;
+		Emit(c, f->Func == FunctionType::Min ? MinOps[fmtIndex] : MaxOps[fmtIndex], dst, 
+			dst, dst+1).Count = (u8)type.Dim;
+		break;
+	}
+	// Clamp, Saturate and Lerp are made of the ops above, in the same order as
+	//	the tree walker does them.
+	case FunctionType::Clamp:
+	{
+		static const Opcode MinOps[] = { Opcode::MinInt, Opcode::MinUint, Opcode::MinFloat };
+		static const Opcode MaxOps[] = { Opcode::MaxInt, Opcode::MaxUint, Opcode::MaxFloat };
+		u32 fmtIndex = (u32)type.Fmt - (u32)VariableFormat::Int;
+		Emit(c, MaxOps[fmtIndex], dst, dst, dst+1).Count = (u8)type.Dim;
+		Emit(c, MinOps[fmtIndex], dst, dst, dst+2).Count = (u8)type.Dim;
+		break;
+	}
+	case FunctionType::Saturate:
+	{
+		Register zero = {};
+		Register one = {};
+		one.F = float4{ 1.f, 1.f, 1.f, 1.f };
+		u16 zeroIndex, oneIndex;
+		if (!AddEntry(c, c.Constants, zero, zeroIndex) ||
+			!AddEntry(c, c.Constants, one, oneIndex))
+			return false;
+		Emit(c, Opcode::LoadConst, dst+1).Index = zeroIndex;
+		Emit(c, Opcode::MaxFloat, dst, dst, dst+1).Count = (u8)type.Dim;
+		Emit(c, Opcode::LoadConst, dst+1).Index = oneIndex;
+		Emit(c, Opcode::MinFloat, dst, dst, dst+1).Count = (u8)type.Dim;
+		break;
+	}
+	case FunctionType::Lerp:
+		Emit(c, Opcode::SubtractFloat, dst+1, dst+1, dst).Count = (u8)type.Dim;
+		Emit(c, Opcode::MultiplyFloat, dst+1, dst+1, dst+2).Count = (u8)type.Dim;
+		Emit(c, Opcode::AddFloat, dst, dst, dst+1).Count = (u8)type.Dim;
+		break;
+	case FunctionType::Dot:
+		Emit(c, Opcode::Dot, dst, dst, dst+1).Count = (u8)args.Data[0]->ResultType.Dim;
+		break;
+	case FunctionType::Cross:
+		Emit(c, Opcode::Cross, dst, dst, dst+1).Count = 3;
+		break;
+	case FunctionType::Length:
+		Emit(c, Opcode::Length, dst, dst).Count = (u8)args.Data[0]->ResultType.Dim;
+		break;
+	case FunctionType::Normalize:
+		if (!EmitFailable(c, Opcode::Normalize, f, dst, dst, 0, type.Dim))
+			return false;
+		break;
+	case FunctionType::DivRoundUp:
+	{
+		Opcode op = type.Fmt == VariableFormat::Int ? Opcode::DivRoundUpInt : 
+			Opcode::DivRoundUpUint;
+		if (!EmitFailable(c, op, f, dst, dst, dst+1, type.Dim))
+			return false;
+		break;
+	}
+	case FunctionType::Inverse:
+		Emit(c, Opcode::Inverse, dst, dst);
+		break;
+	case FunctionType::Transpose:
+		Emit(c, Opcode::Transpose, dst, dst);
+		break;
+	case FunctionType::Mul:
+		// The arguments are packed, so a vector on the left is followed by the
+		//	matrix in the next register.
+		if (args.Data[0]->ResultType.Fmt != VariableFormat::Float4x4)
+			Emit(c, Opcode::VectorMatrix, dst, dst, dst+1);
+		else if (args.Data[1]->ResultType.Fmt != VariableFormat::Float4x4)
+			Emit(c, Opcode::MatrixVector, dst, dst, dst+4);
+		else
+			Emit(c, Opcode::MatrixMultiply, dst, dst, dst+4);
+		break;
+	case FunctionType::LookAt:
+		Emit(c, Opcode::LookAt, dst, dst, dst+1);
+		break;
+	case FunctionType::Projection:
+		Emit(c, Opcode::Projection, dst, dst);
+		break;
+	case FunctionType::ProjectionReverseZ:
+		Emit(c, Opcode::ProjectionReverseZ, dst, dst);
+		break;
+	case FunctionType::Orthographic:
+		Emit(c, Opcode::Orthographic, dst, dst);
+		break;
+	case FunctionType::OrthographicReverseZ:
+		Emit(c, Opcode::OrthographicReverseZ, dst, dst);
+		break;
+	default:
+		Unimplemented();
+	}
+	return true;
+}
+
+// Leaves the value of n in dst, and dst+1..dst+3 for matrices. Registers
+//	above dst are free for subexpressions.
+bool CompileNode(Compiler& c, const Node* n, u32 dst)
+{
+	// Bools are stored a byte per lane, which only the tree walker handles.
+	if (dst + 4 > MaxRegisters || n->ResultType.Fmt == VariableFormat::Bool)
+		return false;
+
+	VariableType type = n->ResultType;
+	switch (n->Type)
+	{
+	case NodeType::UintLiteral:
+	case NodeType::IntLiteral:
+	case NodeType::FloatLiteral:
+	{
+		Register r = {};
+		if (n->Type == NodeType::UintLiteral)
+			r.U.x = ((const UintLiteral*)n)->Val;
+		else if (n->Type == NodeType::IntLiteral)
+			r.I.x = ((const IntLiteral*)n)->Val;
+		else
+			r.F.x = ((const FloatLiteral*)n)->Val;
+		u16 index;
+		if (!AddEntry(c, c.Constants, r, index))
+			return false;
+		Emit(c, Opcode::LoadConst, dst).Index = index;
+		break;
+	}
+	case NodeType::Subscript:
+	{
+		const Subscript* sub = (const Subscript*)n;
+		if (!CompileNode(c, sub->Subject, dst))
+			return false;
+		u32 lanes = 0;
+		for (u32 i = 0 ; i < type.Dim ; ++i)
+			lanes |= (u32)(sub->Index[i] - 1) << (2*i);
+		Instruction& in = Emit(c, Opcode::Swizzle, dst, dst);
+		in.Count = (u8)type.Dim;
+		in.Index = (u16)lanes;
+		break;
+	}
+	case NodeType::Group:
+		if (!CompileNode(c, ((const Group*)n)->Sub, dst))
+			return false;
+		break;
+	case NodeType::BinaryOp:
+	{
+		const BinaryOp* bop = (const BinaryOp*)n;
+		if (!CompileNode(c, bop->LArg, dst) ||
+			!CompileNode(c, bop->RArg, dst + RegisterCount(bop->LArg->ResultType)))
+			return false;
+		if (type.Fmt == VariableFormat::Float4x4)
+		{
+			Emit(c, Opcode::MatrixMultiply, dst, dst, dst+4);
+			break;
+		}
+		static const Opcode Ops[4][3] = {
+			{ Opcode::AddInt, Opcode::AddUint, Opcode::AddFloat },
+			{ Opcode::SubtractInt, Opcode::SubtractUint, Opcode::SubtractFloat },
+			{ Opcode::MultiplyInt, Opcode::MultiplyUint, Opcode::MultiplyFloat },
+			{ Opcode::DivideInt, Opcode::DivideUint, Opcode::DivideFloat },
+		};
+		u32 fmtIndex = (u32)type.Fmt - (u32)VariableFormat::Int;
+		u16 index = 0;
+		if (bop->Op == BinaryOp::Type::Divide && !AddEntry(c, c.Nodes, n, index))
+			return false;
+		Instruction& in = Emit(c, Ops[(u32)bop->Op][fmtIndex], dst, dst, dst+1);
+		in.Count = (u8)type.Dim;
+		in.Index = index;
+		break;
+	}
+	case NodeType::Join:
+	{
+		const Join* j = (const Join*)n;
+		if (!CompileNode(c, j->Comps.Data[0], dst))
+			return false;
+		u32 lane = j->Comps.Data[0]->ResultType.Dim;
+		for (u32 i = 1 ; i < j->Comps.Count ; ++i)
+		{
+			const Node* comp = j->Comps.Data[i];
+			if (!CompileNode(c, comp, dst+1))
+				return false;
+			Instruction& in = Emit(c, Opcode::Insert, dst, dst+1);
+			in.Lane = (u8)lane;
+			in.Count = (u8)comp->ResultType.Dim;
+			lane += comp->ResultType.Dim;
+		}
+		break;
+	}
+	case NodeType::VariableRef:
+	{
+		const VariableRef* vr = (const VariableRef*)n;
+		const Variable* var = vr->IsTuneable ? &((const Tuneable*)vr->M)->Value :
+			&((const rlf::Constant*)vr->M)->Value;
+		u16 index;
+		if (!AddEntry(c, c.Variables, var, index))
+			return false;
+		Opcode op = type.Fmt == VariableFormat::Float4x4 ? Opcode::LoadMatrix :
+			Opcode::LoadVar;
+		Emit(c, op, dst).Index = index;
+		break;
+	}
+	case NodeType::Function:
+		if (!CompileFunction(c, (const Function*)n, dst))
+			return false;
+		break;
+	case NodeType::SizeOf:
+	{
+		// The size is only known once the shader has been reflected.
+		u16 index;
+		if (!AddEntry(c, c.Nodes, n, index))
+			return false;
+		Emit(c, Opcode::LoadSizeOf, dst).Index = index;
+		break;
+	}
+	case NodeType::Conversion:
+	{
+		const Conversion* conv = (const Conversion*)n;
+		VariableType from = conv->Sub->ResultType;
+		if (!CompileNode(c, conv->Sub, dst))
+			return false;
+		if (from.Dim == 1 && type.Dim > 1)
+			Emit(c, Opcode::Splat, dst, dst);
+		EmitConvert(c, dst, from.Fmt, type.Fmt, type.Dim);
+		break;
+	}
+	case NodeType::Folded:
+	{
+		// A matrix is loaded a row at a time.
+		const Folded* f = (const Folded*)n;
+		for (u32 i = 0 ; i < RegisterCount(type) ; ++i)
+		{
+			Register r;
+			memcpy(&r, (const u8*)&f->Val + i*sizeof(Register), sizeof(Register));
+			u16 index;
+			if (!AddEntry(c, c.Constants, r, index))
+				return false;
+			Emit(c, Opcode::LoadConst, dst+i).Index = index;
+		}
+		break;
+	}
+	default:
+		Unimplemented();
+	}
+	return true;
+}
+
+const Program* Compile(const Node* node, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch)
+{
+	Compiler c = {};
+	c.scratch = scratch;
+	if (!CompileNode(c, node, 0))
+		return nullptr;
+
+	Program* prog = alloc::Allocate<Program>(alloc);
+	prog->Code = alloc::MakeCopy(alloc, c.Code);
+	prog->Constants = alloc::MakeCopy(alloc, c.Constants);
+	prog->Variables = alloc::MakeCopy(alloc, c.Variables);
+	prog->Nodes = alloc::MakeCopy(alloc, c.Nodes);
+	prog->ResultType = node->ResultType;
+	return prog;
+}
+
+// Ops producing a matrix, which takes up the four registers from d.
+void ExecuteMatrix(Opcode op, const Register* a, const Register* b, Register* d)
+{
+	float4x4 m;
+	switch (op)
+	{
+	case Opcode::MatrixMultiply:
+	{
+		float4x4 lhs, rhs;
+		memcpy(&lhs, a, sizeof(float4x4));
+		memcpy(&rhs, b, sizeof(float4x4));
+		m = lhs * rhs;
+		break;
+	}
+	case Opcode::Inverse:
+	{
+		float4x4 src;
+		memcpy(&src, a, sizeof(float4x4));
+		inverse(src, m);
+		break;
+	}
+	case Opcode::LookAt:
+	{
+		float3 from = { a->F.x, a->F.y, a->F.z };
+		float3 to = { b->F.x, b->F.y, b->F.z };
+		m = lookAt(from, to);
+		break;
+	}
+	case Opcode::Transpose:
+	{
+		float4x4 src;
+		memcpy(&src, a, sizeof(float4x4));
+		m = transposed(src);
+		break;
+	}
+	case Opcode::Projection:
+		m = projection(a[0].F.x, a[1].F.x, a[2].F.x, a[3].F.x);
+		break;
+	case Opcode::ProjectionReverseZ:
+		m = projection(a[0].F.x, a[1].F.x, a[3].F.x, a[2].F.x);
+		break;
+	case Opcode::Orthographic:
+		m = orthographic(a[0].F.x, a[1].F.x, a[2].F.x, a[3].F.x);
+		break;
+	case Opcode::OrthographicReverseZ:
+		m = orthographic(a[0].F.x, a[1].F.x, a[3].F.x, a[2].F.x);
+		break;
+	default:
+		Unimplemented();
+	}
+	memcpy(d, &m, sizeof(float4x4));
+}
+
+bool Execute(const Program& prog, const EvaluationContext& ec, Result& res,
+	EvaluationError& err)
+{
+	Register regs[MaxRegisters];
+	const Register* constants = prog.Constants.Data;
+	const Variable* const* variables = prog.Variables.Data;
+	const Node* const* nodes = prog.Nodes.Data;
+
+	const Instruction* end = prog.Code.Data + prog.Code.Count;
+	for (const Instruction* in = prog.Code.Data ; in != end ; ++in)
+	{
+		Register& d = regs[in->Dst];
+		const Register& a = regs[in->A];
+		const Register& b = regs[in->B];
+		switch (in->Op)
+		{
+		case Opcode::LoadConst:
+			d = constants[in->Index];
+			break;
+		case Opcode::LoadVar:
+			memcpy(&d, variables[in->Index], sizeof(Register));
+			break;
+		case Opcode::LoadMatrix:
+			memcpy(&d, variables[in->Index], sizeof(float4x4));
+			break;
+		case Opcode::LoadSizeOf:
+			d.U.x = ((const SizeOf*)nodes[in->Index])->Size;
+			break;
+		case Opcode::LoadTime:
+			d.F.x = ec.Time;
+			break;
+		case Opcode::LoadDisplaySize:
+			d.U.x = ec.DisplaySize.x;
+			d.U.y = ec.DisplaySize.y;
+			break;
+		case Opcode::Splat:
+			d.U.w = d.U.z = d.U.y = d.U.x = a.U.x;
+			break;
+		case Opcode::Swizzle:
+		{
+			Register s = a;
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = s.U.m[(in->Index >> (2*i)) & 3];
+			break;
+		}
+		case Opcode::Insert:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[in->Lane + i] = a.U.m[i];
+			break;
+		case Opcode::Gather:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = regs[in->A + i].U.x;
+			break;
+		case Opcode::IntToFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = (float)a.I.m[i];
+			break;
+		case Opcode::UintToFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = (float)a.U.m[i];
+			break;
+		case Opcode::FloatToInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = (i32)a.F.m[i];
+			break;
+		case Opcode::UintToInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = (i32)a.U.m[i];
+			break;
+		case Opcode::FloatToUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = (u32)a.F.m[i];
+			break;
+		case Opcode::IntToUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = (u32)a.I.m[i];
+			break;
+		case Opcode::AddFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = a.F.m[i] + b.F.m[i];
+			break;
+		case Opcode::AddInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = a.I.m[i] + b.I.m[i];
+			break;
+		case Opcode::AddUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = a.U.m[i] + b.U.m[i];
+			break;
+		case Opcode::SubtractFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = a.F.m[i] - b.F.m[i];
+			break;
+		case Opcode::SubtractInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = a.I.m[i] - b.I.m[i];
+			break;
+		case Opcode::SubtractUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = a.U.m[i] - b.U.m[i];
+			break;
+		case Opcode::MultiplyFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = a.F.m[i] * b.F.m[i];
+			break;
+		case Opcode::MultiplyInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = a.I.m[i] * b.I.m[i];
+			break;
+		case Opcode::MultiplyUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = a.U.m[i] * b.U.m[i];
+			break;
+		case Opcode::DivideFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (b.F.m[i] == 0.f)
+				{
+					err.Code = EvaluationErrorCode::DivideByZero;
+					err.At = nodes[in->Index];
+					return false;
+				}
+				d.F.m[i] = a.F.m[i] / b.F.m[i];
+			}
+			break;
+		case Opcode::DivideInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (b.I.m[i] == 0)
+				{
+					err.Code = EvaluationErrorCode::DivideByZero;
+					err.At = nodes[in->Index];
+					return false;
+				}
+				d.I.m[i] = a.I.m[i] / b.I.m[i];
+			}
+			break;
+		case Opcode::DivideUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (b.U.m[i] == 0)
+				{
+					err.Code = EvaluationErrorCode::DivideByZero;
+					err.At = nodes[in->Index];
+					return false;
+				}
+				d.U.m[i] = a.U.m[i] / b.U.m[i];
+			}
+			break;
+		case Opcode::MinFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = min(a.F.m[i], b.F.m[i]);
+			break;
+		case Opcode::MinInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = min(a.I.m[i], b.I.m[i]);
+			break;
+		case Opcode::MinUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = min(a.U.m[i], b.U.m[i]);
+			break;
+		case Opcode::MaxFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = max(a.F.m[i], b.F.m[i]);
+			break;
+		case Opcode::MaxInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.I.m[i] = max(a.I.m[i], b.I.m[i]);
+			break;
+		case Opcode::MaxUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.U.m[i] = max(a.U.m[i], b.U.m[i]);
+			break;
+		case Opcode::Sin:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = sin(a.F.m[i]);
+			break;
+		case Opcode::Cos:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = cos(a.F.m[i]);
+			break;
+		case Opcode::Dot:
+			d.F.x = DotLanes(a.F, b.F, in->Count);
+			break;
+		case Opcode::Length:
+			d.F.x = std::sqrt(DotLanes(a.F, a.F, in->Count));
+			break;
+		case Opcode::Normalize:
+		{
+			float length = std::sqrt(DotLanes(a.F, a.F, in->Count));
+			if (length == 0.f)
+			{
+				err.Code = EvaluationErrorCode::NormalizeZero;
+				err.At = nodes[in->Index];
+				return false;
+			}
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.F.m[i] = a.F.m[i] / length;
+			break;
+		}
+		case Opcode::Cross:
+		{
+			float3 c = cross(float3{ a.F.x, a.F.y, a.F.z }, float3{ b.F.x, b.F.y, b.F.z });
+			d.F.x = c.x;
+			d.F.y = c.y;
+			d.F.z = c.z;
+			break;
+		}
+		case Opcode::DivRoundUpInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (b.I.m[i] == 0)
+				{
+					err.Code = EvaluationErrorCode::DivideByZero;
+					err.At = nodes[in->Index];
+					return false;
+				}
+				d.I.m[i] = DivRoundUpLane(a.I.m[i], b.I.m[i]);
+			}
+			break;
+		case Opcode::DivRoundUpUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (b.U.m[i] == 0)
+				{
+					err.Code = EvaluationErrorCode::DivideByZero;
+					err.At = nodes[in->Index];
+					return false;
+				}
+				d.U.m[i] = DivRoundUpLane(a.U.m[i], b.U.m[i]);
+			}
+			break;
+		case Opcode::MatrixVector:
+		{
+			float4x4 m;
+			memcpy(&m, &a, sizeof(float4x4));
+			d.F = m * b.F;
+			break;
+		}
+		case Opcode::VectorMatrix:
+		{
+			// Column j of the matrix is register B+j.
+			float4 v = a.F;
+			for (u32 j = 0 ; j < 4 ; ++j)
+				d.F.m[j] = DotLanes(v, regs[in->B + j].F, 4);
+			break;
+		}
+		case Opcode::MatrixMultiply:
+		case Opcode::Transpose:
+		case Opcode::Inverse:
+		case Opcode::LookAt:
+		case Opcode::Projection:
+		case Opcode::ProjectionReverseZ:
+		case Opcode::Orthographic:
+		case Opcode::OrthographicReverseZ:
+			ExecuteMatrix(in->Op, &a, &b, &d);
+			break;
+		default:
+			Unimplemented();
+		}
+	}
+
+	// Fixed size copies, a variable sized one costs more than a short program.
+	res.Type = prog.ResultType;
+	if (prog.ResultType.Fmt == VariableFormat::Float4x4)
+		memcpy(&res.Value, &regs[0], sizeof(float4x4));
+	else
+		memcpy(&res.Value, &regs[0], sizeof(Register));
+	return true;
+}
+
+
+static_assert(BatchWidth == 4, "A batch lane is one SSE element");
+
+// Component c of a register, for each of the programs in a batch. A lane of
+//	all of them is then a single SSE op.
+union BatchRegister
+{
+	__m128 V[4];
+	float F[4][BatchWidth];
+	i32 I[4][BatchWidth];
+	u32 U[4][BatchWidth];
+};
+
+__m128i AsInt(__m128 v) { return _mm_castps_si128(v); }
+__m128 AsFloat(__m128i v) { return _mm_castsi128_ps(v); }
+
+__m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// The low half of the product is the same for signed and unsigned. SSE2 only
+//	multiplies the even elements, the odd ones are shifted down for a second
+//	multiply.
+__m128i MultiplyLow(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+// Unsigned compares as signed ones with the sign bit flipped.
+__m128i CompareGreaterUint(__m128i a, __m128i b)
+{
+	__m128i bias = _mm_set1_epi32((i32)0x80000000);
+	return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+// One register from each program in a batch into d, and back. Copying them a
+//	component at a time stalls the vector loads which follow.
+void TransposeIn(const Register* const src[BatchWidth], BatchRegister& d)
+{
+	__m128 r0 = _mm_loadu_ps(src[0]->F.m);
+	__m128 r1 = _mm_loadu_ps(src[1]->F.m);
+	__m128 r2 = _mm_loadu_ps(src[2]->F.m);
+	__m128 r3 = _mm_loadu_ps(src[3]->F.m);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	d.V[0] = r0;
+	d.V[1] = r1;
+	d.V[2] = r2;
+	d.V[3] = r3;
+}
+
+void TransposeOut(const BatchRegister& src, Register* const d[BatchWidth])
+{
+	__m128 r0 = src.V[0], r1 = src.V[1], r2 = src.V[2], r3 = src.V[3];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(d[0]->F.m, r0);
+	_mm_storeu_ps(d[1]->F.m, r1);
+	_mm_storeu_ps(d[2]->F.m, r2);
+	_mm_storeu_ps(d[3]->F.m, r3);
+}
+
+bool ExecuteBatch(const Program* const* progs, u32 count, const EvaluationContext& ec,
+	Result* results)
+{
+	Assert(count > 0 && count <= BatchWidth, "Invalid batch");
+	// Lanes without a program repeat the last one, so they can't fail on their
+	//	own.
+	const Program* lanes[BatchWidth];
+	for (u32 l = 0 ; l < BatchWidth ; ++l)
+		lanes[l] = progs[min(l, count-1)];
+
+	BatchRegister regs[MaxRegisters];
+	const Program& code = *lanes[0];
+	const Instruction* end = code.Code.Data + code.Code.Count;
+	for (const Instruction* in = code.Code.Data ; in != end ; ++in)
+	{
+		BatchRegister& d = regs[in->Dst];
+		const BatchRegister& a = regs[in->A];
+		const BatchRegister& b = regs[in->B];
+		switch (in->Op)
+		{
+		case Opcode::LoadConst:
+		{
+			const Register* src[BatchWidth];
+			for (u32 l = 0 ; l < BatchWidth ; ++l)
+				src[l] = &lanes[l]->Constants.Data[in->Index];
+			TransposeIn(src, d);
+			break;
+		}
+		case Opcode::LoadVar:
+		case Opcode::LoadMatrix:
+		{
+			// Variables are laid out like registers, a matrix like four.
+			u32 regCount = in->Op == Opcode::LoadMatrix ? 4 : 1;
+			for (u32 r = 0 ; r < regCount ; ++r)
+			{
+				const Register* src[BatchWidth];
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+					src[l] = (const Register*)lanes[l]->Variables.Data[in->Index] + r;
+				TransposeIn(src, (&d)[r]);
+			}
+			break;
+		}
+		case Opcode::LoadSizeOf:
+			for (u32 l = 0 ; l < BatchWidth ; ++l)
+				d.U[0][l] = ((const SizeOf*)lanes[l]->Nodes.Data[in->Index])->Size;
+			break;
+		case Opcode::LoadTime:
+			d.V[0] = _mm_set1_ps(ec.Time);
+			break;
+		case Opcode::LoadDisplaySize:
+			d.V[0] = AsFloat(_mm_set1_epi32((i32)ec.DisplaySize.x));
+			d.V[1] = AsFloat(_mm_set1_epi32((i32)ec.DisplaySize.y));
+			break;
+		case Opcode::Splat:
+			d.V[3] = d.V[2] = d.V[1] = d.V[0] = a.V[0];
+			break;
+		case Opcode::Swizzle:
+		{
+			BatchRegister s = a;
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = s.V[(in->Index >> (2*i)) & 3];
+			break;
+		}
+		case Opcode::Insert:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[in->Lane + i] = a.V[i];
+			break;
+		case Opcode::Gather:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = regs[in->A + i].V[0];
+			break;
+		case Opcode::IntToFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_cvtepi32_ps(AsInt(a.V[i]));
+			break;
+		case Opcode::FloatToInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = AsFloat(_mm_cvttps_epi32(a.V[i]));
+			break;
+		case Opcode::UintToInt:
+		case Opcode::IntToUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = a.V[i];
+			break;
+		// No SSE2 instructions for these, they're done a lane at a time.
+		case Opcode::UintToFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+					d.F[i][l] = (float)a.U[i][l];
+			break;
+		case Opcode::FloatToUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+					d.U[i][l] = (u32)a.F[i][l];
+			break;
+		case Opcode::AddFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_add_ps(a.V[i], b.V[i]);
+			break;
+		case Opcode::AddInt:
+		case Opcode::AddUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = AsFloat(_mm_add_epi32(AsInt(a.V[i]), AsInt(b.V[i])));
+			break;
+		case Opcode::SubtractFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_sub_ps(a.V[i], b.V[i]);
+			break;
+		case Opcode::SubtractInt:
+		case Opcode::SubtractUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = AsFloat(_mm_sub_epi32(AsInt(a.V[i]), AsInt(b.V[i])));
+			break;
+		case Opcode::MultiplyFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_mul_ps(a.V[i], b.V[i]);
+			break;
+		case Opcode::MultiplyInt:
+		case Opcode::MultiplyUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = AsFloat(MultiplyLow(AsInt(a.V[i]), AsInt(b.V[i])));
+			break;
+		case Opcode::DivideFloat:
+		{
+			__m128 zero = _mm_setzero_ps();
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				if (_mm_movemask_ps(_mm_cmpeq_ps(b.V[i], zero)) != 0)
+					return false;
+				d.V[i] = _mm_div_ps(a.V[i], b.V[i]);
+			}
+			break;
+		}
+		case Opcode::DivideInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+				{
+					if (b.I[i][l] == 0)
+						return false;
+					d.I[i][l] = a.I[i][l] / b.I[i][l];
+				}
+			}
+			break;
+		case Opcode::DivideUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+				{
+					if (b.U[i][l] == 0)
+						return false;
+					d.U[i][l] = a.U[i][l] / b.U[i][l];
+				}
+			}
+			break;
+		// Same results as min and max, which pick b unless a compares less,
+		//	or greater.
+		case Opcode::MinFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_min_ps(a.V[i], b.V[i]);
+			break;
+		case Opcode::MaxFloat:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_max_ps(a.V[i], b.V[i]);
+			break;
+		case Opcode::MinInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				__m128i ai = AsInt(a.V[i]), bi = AsInt(b.V[i]);
+				d.V[i] = AsFloat(Select(_mm_cmplt_epi32(ai, bi), ai, bi));
+			}
+			break;
+		case Opcode::MaxInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				__m128i ai = AsInt(a.V[i]), bi = AsInt(b.V[i]);
+				d.V[i] = AsFloat(Select(_mm_cmpgt_epi32(ai, bi), ai, bi));
+			}
+			break;
+		case Opcode::MinUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				__m128i ai = AsInt(a.V[i]), bi = AsInt(b.V[i]);
+				d.V[i] = AsFloat(Select(CompareGreaterUint(bi, ai), ai, bi));
+			}
+			break;
+		case Opcode::MaxUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				__m128i ai = AsInt(a.V[i]), bi = AsInt(b.V[i]);
+				d.V[i] = AsFloat(Select(CompareGreaterUint(ai, bi), ai, bi));
+			}
+			break;
+		case Opcode::Sin:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+					d.F[i][l] = sin(a.F[i][l]);
+			break;
+		case Opcode::Cos:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+					d.F[i][l] = cos(a.F[i][l]);
+			break;
+		// Summed in lane order like DotLanes and float4x4's operator*, so the
+		//	results match Execute.
+		case Opcode::Dot:
+		case Opcode::Length:
+		{
+			const BatchRegister& rhs = in->Op == Opcode::Dot ? b : a;
+			__m128 sum = _mm_mul_ps(a.V[0], rhs.V[0]);
+			for (u32 i = 1 ; i < in->Count ; ++i)
+				sum = _mm_add_ps(sum, _mm_mul_ps(a.V[i], rhs.V[i]));
+			d.V[0] = in->Op == Opcode::Dot ? sum : _mm_sqrt_ps(sum);
+			break;
+		}
+		case Opcode::Normalize:
+		{
+			__m128 sum = _mm_mul_ps(a.V[0], a.V[0]);
+			for (u32 i = 1 ; i < in->Count ; ++i)
+				sum = _mm_add_ps(sum, _mm_mul_ps(a.V[i], a.V[i]));
+			__m128 length = _mm_sqrt_ps(sum);
+			if (_mm_movemask_ps(_mm_cmpeq_ps(length, _mm_setzero_ps())) != 0)
+				return false;
+			for (u32 i = 0 ; i < in->Count ; ++i)
+				d.V[i] = _mm_div_ps(a.V[i], length);
+			break;
+		}
+		case Opcode::Cross:
+		{
+			__m128 x = _mm_sub_ps(_mm_mul_ps(a.V[1], b.V[2]), _mm_mul_ps(a.V[2], b.V[1]));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(a.V[2], b.V[0]), _mm_mul_ps(a.V[0], b.V[2]));
+			__m128 z = _mm_sub_ps(_mm_mul_ps(a.V[0], b.V[1]), _mm_mul_ps(a.V[1], b.V[0]));
+			d.V[0] = x;
+			d.V[1] = y;
+			d.V[2] = z;
+			break;
+		}
+		case Opcode::DivRoundUpInt:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+				{
+					if (b.I[i][l] == 0)
+						return false;
+					d.I[i][l] = DivRoundUpLane(a.I[i][l], b.I[i][l]);
+				}
+			}
+			break;
+		case Opcode::DivRoundUpUint:
+			for (u32 i = 0 ; i < in->Count ; ++i)
+			{
+				for (u32 l = 0 ; l < BatchWidth ; ++l)
+				{
+					if (b.U[i][l] == 0)
+						return false;
+					d.U[i][l] = DivRoundUpLane(a.U[i][l], b.U[i][l]);
+				}
+			}
+			break;
+		case Opcode::MatrixVector:
+		{
+			// Row i of the matrix is lane i of registers A to A+3.
+			BatchRegister v;
+			for (u32 i = 0 ; i < 4 ; ++i)
+			{
+				__m128 sum = _mm_mul_ps((&a)[0].V[i], b.V[0]);
+				for (u32 k = 1 ; k < 4 ; ++k)
+					sum = _mm_add_ps(sum, _mm_mul_ps((&a)[k].V[i], b.V[k]));
+				v.V[i] = sum;
+			}
+			d = v;
+			break;
+		}
+		case Opcode::VectorMatrix:
+		{
+			BatchRegister v;
+			for (u32 j = 0 ; j < 4 ; ++j)
+			{
+				__m128 sum = _mm_mul_ps(a.V[0], (&b)[j].V[0]);
+				for (u32 k = 1 ; k < 4 ; ++k)
+					sum = _mm_add_ps(sum, _mm_mul_ps(a.V[k], (&b)[j].V[k]));
+				v.V[j] = sum;
+			}
+			d = v;
+			break;
+		}
+		case Opcode::MatrixMultiply:
+		{
+			// Column j, row i of the result, summed in the same order as
+			//	float4x4's operator* so the results match.
+			BatchRegister m[4];
+			for (u32 j = 0 ; j < 4 ; ++j)
+			{
+				for (u32 i = 0 ; i < 4 ; ++i)
+				{
+					__m128 sum = _mm_mul_ps((&a)[0].V[i], (&b)[j].V[0]);
+					for (u32 k = 1 ; k < 4 ; ++k)
+						sum = _mm_add_ps(sum, _mm_mul_ps((&a)[k].V[i], (&b)[j].V[k]));
+					m[j].V[i] = sum;
+				}
+			}
+			for (u32 j = 0 ; j < 4 ; ++j)
+				(&d)[j] = m[j];
+			break;
+		}
+		case Opcode::Transpose:
+		{
+			BatchRegister m[4];
+			for (u32 j = 0 ; j < 4 ; ++j)
+				for (u32 i = 0 ; i < 4 ; ++i)
+					m[j].V[i] = (&a)[i].V[j];
+			for (u32 j = 0 ; j < 4 ; ++j)
+				(&d)[j] = m[j];
+			break;
+		}
+		case Opcode::Inverse:
+		case Opcode::LookAt:
+		case Opcode::Projection:
+		case Opcode::ProjectionReverseZ:
+		case Opcode::Orthographic:
+		case Opcode::OrthographicReverseZ:
+		{
+			Register ra[BatchWidth][4], rb[BatchWidth][4], rd[BatchWidth][4];
+			for (u32 r = 0 ; r < 4 ; ++r)
+			{
+				Register* outA[BatchWidth] = { &ra[0][r], &ra[1][r], &ra[2][r], &ra[3][r] };
+				Register* outB[BatchWidth] = { &rb[0][r], &rb[1][r], &rb[2][r], &rb[3][r] };
+				TransposeOut((&a)[r], outA);
+				TransposeOut((&b)[r], outB);
+			}
+			for (u32 l = 0 ; l < BatchWidth ; ++l)
+				ExecuteMatrix(in->Op, ra[l], rb[l], rd[l]);
+			for (u32 r = 0 ; r < 4 ; ++r)
+			{
+				const Register* src[BatchWidth] = { &rd[0][r], &rd[1][r], &rd[2][r], &rd[3][r] };
+				TransposeIn(src, (&d)[r]);
+			}
+			break;
+		}
+		default:
+			Unimplemented();
+		}
+	}
+
+	// Padding lanes are written to a scratch result.
+	Result unused;
+	Register* out[BatchWidth];
+	for (u32 l = 0 ; l < BatchWidth ; ++l)
+	{
+		Result& res = l < count ? results[l] : unused;
+		res.Type = code.ResultType;
+		out[l] = (Register*)&res.Value;
+	}
+	for (u32 r = 0 ; r < RegisterCount(code.ResultType) ; ++r)
+	{
+		Register* dst[BatchWidth];
+		for (u32 l = 0 ; l < BatchWidth ; ++l)
+			dst[l] = out[l] + r;
+		TransposeOut(regs[r], dst);
+	}
+	return true;
+}
+
+} // namespace ast
+} // namespace rlf
@@ -0,0 +1,126 @@
+
+namespace rlf {
+namespace ast {
+
+// Expressions are lowered to linear code over a small register file once
+//	parsing has finished. Every register is 16 bytes, a matrix takes up four
+//	in a row. The code is generated from the type checked tree, so it only
+//	moves and combines lanes. Dividing by zero and normalizing a zero length
+//	vector are the only ways it can fail.
+//	Expressions involving bools aren't compiled and keep being walked.
+
+#define OPCODE_TUPLE \
+	OPCODE_ENTRY(LoadConst) \
+	OPCODE_ENTRY(LoadVar) \
+	OPCODE_ENTRY(LoadMatrix) \
+	OPCODE_ENTRY(LoadSizeOf) \
+	OPCODE_ENTRY(LoadTime) \
+	OPCODE_ENTRY(LoadDisplaySize) \
+	OPCODE_ENTRY(Splat) \
+	OPCODE_ENTRY(Swizzle) \
+	OPCODE_ENTRY(Insert) \
+	OPCODE_ENTRY(Gather) \
+	OPCODE_ENTRY(IntToFloat) \
+	OPCODE_ENTRY(UintToFloat) \
+	OPCODE_ENTRY(FloatToInt) \
+	OPCODE_ENTRY(UintToInt) \
+	OPCODE_ENTRY(FloatToUint) \
+	OPCODE_ENTRY(IntToUint) \
+	OPCODE_ENTRY(AddFloat) \
+	OPCODE_ENTRY(AddInt) \
+	OPCODE_ENTRY(AddUint) \
+	OPCODE_ENTRY(SubtractFloat) \
+	OPCODE_ENTRY(SubtractInt) \
+	OPCODE_ENTRY(SubtractUint) \
+	OPCODE_ENTRY(MultiplyFloat) \
+	OPCODE_ENTRY(MultiplyInt) \
+	OPCODE_ENTRY(MultiplyUint) \
+	OPCODE_ENTRY(DivideFloat) \
+	OPCODE_ENTRY(DivideInt) \
+	OPCODE_ENTRY(DivideUint) \
+	OPCODE_ENTRY(MinFloat) \
+	OPCODE_ENTRY(MinInt) \
+	OPCODE_ENTRY(MinUint) \
+	OPCODE_ENTRY(MaxFloat) \
+	OPCODE_ENTRY(MaxInt) \
+	OPCODE_ENTRY(MaxUint) \
+	OPCODE_ENTRY(Sin) \
+	OPCODE_ENTRY(Cos) \
+	OPCODE_ENTRY(Dot) \
+	OPCODE_ENTRY(Length) \
+	OPCODE_ENTRY(Normalize) \
+	OPCODE_ENTRY(Cross) \
+	OPCODE_ENTRY(DivRoundUpInt) \
+	OPCODE_ENTRY(DivRoundUpUint) \
+	OPCODE_ENTRY(MatrixVector) \
+	OPCODE_ENTRY(VectorMatrix) \
+	OPCODE_ENTRY(MatrixMultiply) \
+	OPCODE_ENTRY(Transpose) \
+	OPCODE_ENTRY(Inverse) \
+	OPCODE_ENTRY(LookAt) \
+	OPCODE_ENTRY(Projection) \
+	OPCODE_ENTRY(ProjectionReverseZ) \
+	OPCODE_ENTRY(Orthographic) \
+	OPCODE_ENTRY(OrthographicReverseZ) \
+
+#define OPCODE_ENTRY(name) name,
+enum class Opcode : u8
+{
+	OPCODE_TUPLE
+	Count
+};
+#undef OPCODE_ENTRY
+
+union Register
+{
+	float4 F;
+	int4 I;
+	uint4 U;
+};
+
+struct Instruction
+{
+	Opcode Op;
+	u8 Dst;
+	u8 A;
+	u8 B;
+	// Lanes in use. Lanes past the type's size are never read, so they're
+	//	left alone rather than computed from whatever they hold.
+	u8 Count;
+	// First lane written by Insert.
+	u8 Lane;
+	// Into the program's constants, variables or nodes, depending on the op.
+	//	Swizzle keeps its source lanes here, two bits each.
+	u16 Index;
+};
+
+struct Program
+{
+	Array<Instruction> Code;
+	Array<Register> Constants;
+	Array<const Variable*> Variables;
+	// SizeOf nodes, whose size is filled in after parsing, and the nodes which
+	//	can fail, for reporting the error.
+	Array<const Node*> Nodes;
+	// The result is left in register 0.
+	VariableType ResultType;
+};
+
+// Returns nullptr if the expression can't be compiled.
+const Program* Compile(const Node* node, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch);
+// Returns false at the first instruction which fails, see ast::Evaluate.
+bool Execute(const Program& prog, const EvaluationContext& ec, Result& res,
+	EvaluationError& err);
+
+// Programs with the same code run together, one per SSE lane.
+constexpr u32 BatchWidth = 4;
+
+// Runs count programs whose code is the same, at most BatchWidth. Returns false
+//	if any of them fails, running them on their own with Execute reports the
+//	error.
+bool ExecuteBatch(const Program* const* progs, u32 count, const EvaluationContext& ec,
+	Result* results);
+
+}
+}
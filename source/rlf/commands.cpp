@@ -0,0 +1,474 @@
+namespace rlf {
+
+#define COMMAND_ENTRY(name) #name,
+const char* CommandTypeNames[(u32)CommandType::Count] =
+{
+	COMMAND_TUPLE
+};
+#undef COMMAND_ENTRY
+
+
+// -----------------------------------------------------------------------------
+// ------------------------------- LOWERING ------------------------------------
+// -----------------------------------------------------------------------------
+void LowerConstants(alloc::LinAlloc* scratch, alloc::List<Command>& cmds,
+	ShaderStage stage, Array<SetConstant> sets, Array<ConstantBuffer> buffers)
+{
+	if (buffers.Count == 0)
+		return;
+	Command cmd = {};
+	cmd.Type = CommandType::UpdateConstants;
+	cmd.Constants.Sets = sets;
+	cmd.Constants.Buffers = buffers;
+	alloc::PushBack(scratch, &cmds, cmd);
+	for (ConstantBuffer& buf : buffers)
+	{
+		cmd = {};
+		cmd.Type = CommandType::SetConstantBuffer;
+		cmd.Slot.Stage = stage;
+		cmd.Slot.Slot = buf.Slot;
+		cmd.Slot.Buffer = &buf;
+		alloc::PushBack(scratch, &cmds, cmd);
+	}
+}
+
+void LowerBinds(alloc::LinAlloc* scratch, alloc::List<Command>& cmds,
+	ShaderStage stage, Array<Bind> binds)
+{
+	for (Bind& bind : binds)
+	{
+		Command cmd = {};
+		cmd.Slot.Stage = stage;
+		cmd.Slot.Slot = bind.BindIndex;
+		switch (bind.Type)
+		{
+		case BindType::View:
+			if (bind.IsOutput)
+			{
+				Assert(bind.ViewBind->Type == ViewType::UAV, "Invalid");
+				cmd.Type = CommandType::BindUAV;
+			}
+			else
+			{
+				Assert(bind.ViewBind->Type == ViewType::SRV, "Invalid");
+				cmd.Type = CommandType::BindSRV;
+			}
+			cmd.Slot.View = bind.ViewBind;
+			break;
+		case BindType::Sampler:
+			cmd.Type = CommandType::BindSampler;
+			cmd.Slot.Sampler = bind.SamplerBind;
+			break;
+		default:
+			Assert(false, "invalid type %d", bind.Type);
+		}
+		alloc::PushBack(scratch, &cmds, cmd);
+	}
+}
+
+void LowerDispatch(alloc::LinAlloc* scratch, alloc::List<Command>& cmds,
+	Dispatch* dc)
+{
+	Command cmd = {};
+	cmd.Type = CommandType::SetComputePipeline;
+	cmd.ComputePipeline = dc;
+	alloc::PushBack(scratch, &cmds, cmd);
+
+	LowerConstants(scratch, cmds, ShaderStage::Compute, dc->Constants, dc->CBs);
+	LowerBinds(scratch, cmds, ShaderStage::Compute, dc->Binds);
+
+	cmd = {};
+	if (dc->IndirectArgs)
+	{
+		cmd.Type = CommandType::DispatchIndirect;
+		cmd.Indirect.Args = dc->IndirectArgs;
+		cmd.Indirect.Offset = dc->IndirectArgsOffset;
+	}
+	else if (dc->ThreadPerPixel)
+	{
+		cmd.Type = CommandType::DispatchThreadPerPixel;
+		cmd.ThreadGroupSize = dc->Shader->ThreadGroupSize;
+	}
+	else
+	{
+		cmd.Type = CommandType::Dispatch;
+		cmd.Groups = dc->Groups.IsValid() ? &dc->Groups : nullptr;
+	}
+	alloc::PushBack(scratch, &cmds, cmd);
+}
+
+void LowerDraw(alloc::LinAlloc* scratch, alloc::List<Command>& cmds, Draw* draw)
+{
+	Command cmd = {};
+	cmd.Type = CommandType::SetGraphicsPipeline;
+	cmd.GraphicsPipeline = draw;
+	alloc::PushBack(scratch, &cmds, cmd);
+
+	LowerConstants(scratch, cmds, ShaderStage::Vertex, draw->VSConstants,
+		draw->VSCBs);
+	LowerConstants(scratch, cmds, ShaderStage::Pixel, draw->PSConstants,
+		draw->PSCBs);
+	LowerBinds(scratch, cmds, ShaderStage::Vertex, draw->VSBinds);
+	LowerBinds(scratch, cmds, ShaderStage::Pixel, draw->PSBinds);
+
+	for (View* view : draw->RenderTargets)
+	{
+		Assert(view->Type == ViewType::RTV, "Invalid");
+		Assert(view->ResourceType == ResourceType::Texture, "Invalid");
+	}
+	if (draw->DepthStencil)
+	{
+		Assert(draw->DepthStencil->Type == ViewType::DSV, "Invalid");
+		Assert(draw->DepthStencil->ResourceType == ResourceType::Texture, "Invalid");
+	}
+	cmd = {};
+	cmd.Type = CommandType::SetRenderTargets;
+	cmd.Targets.RenderTargets = draw->RenderTargets;
+	cmd.Targets.DepthStencil = draw->DepthStencil;
+	cmd.Targets.Viewports = draw->Viewports;
+	alloc::PushBack(scratch, &cmds, cmd);
+
+	if (draw->VertexBuffers.Count)
+	{
+		cmd = {};
+		cmd.Type = CommandType::SetVertexBuffers;
+		cmd.VertexBuffers = draw->VertexBuffers;
+		alloc::PushBack(scratch, &cmds, cmd);
+	}
+	if (draw->IndexBuffer)
+	{
+		cmd = {};
+		cmd.Type = CommandType::SetIndexBuffer;
+		cmd.IndexBuffer = draw->IndexBuffer;
+		alloc::PushBack(scratch, &cmds, cmd);
+	}
+
+	cmd = {};
+	if (draw->InstancedIndirectArgs)
+	{
+		cmd.Type = CommandType::DrawIndirect;
+		cmd.Indirect.Args = draw->InstancedIndirectArgs;
+		cmd.Indirect.Offset = draw->IndirectArgsOffset;
+	}
+	else if (draw->IndexedInstancedIndirectArgs)
+	{
+		cmd.Type = CommandType::DrawIndexedIndirect;
+		cmd.Indirect.Args = draw->IndexedInstancedIndirectArgs;
+		cmd.Indirect.Offset = draw->IndirectArgsOffset;
+	}
+	else
+	{
+		cmd.Type = draw->IndexBuffer ? CommandType::DrawIndexed : CommandType::Draw;
+		cmd.Draw.IndexBuffer = draw->IndexBuffer;
+		cmd.Draw.VertexCount = draw->VertexCount;
+		cmd.Draw.InstanceCount = max(draw->InstanceCount, 1u);
+	}
+	alloc::PushBack(scratch, &cmds, cmd);
+}
+
+Array<Command> LowerPasses(RenderDescription* rd, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch)
+{
+	alloc::Marker start = alloc::Mark(scratch);
+	alloc::List<Command> cmds = {};
+	for (Pass& pass : rd->Passes)
+	{
+		Command cmd = {};
+		switch (pass.Type)
+		{
+		case PassType::Dispatch:
+			LowerDispatch(scratch, cmds, pass.Dispatch);
+			break;
+		case PassType::Draw:
+			LowerDraw(scratch, cmds, pass.Draw);
+			break;
+		case PassType::ObjDraw:
+			for (Draw* draw : pass.ObjDraw->PerMeshDraws)
+				LowerDraw(scratch, cmds, draw);
+			break;
+		case PassType::ClearColor:
+			cmd.Type = CommandType::ClearColor;
+			cmd.Clear.Target = pass.ClearColor->Target;
+			cmd.Clear.Color = pass.ClearColor->Color;
+			alloc::PushBack(scratch, &cmds, cmd);
+			break;
+		case PassType::ClearDepth:
+			cmd.Type = CommandType::ClearDepth;
+			cmd.Clear.Target = pass.ClearDepth->Target;
+			cmd.Clear.Depth = pass.ClearDepth->Depth;
+			alloc::PushBack(scratch, &cmds, cmd);
+			break;
+		case PassType::ClearStencil:
+			cmd.Type = CommandType::ClearStencil;
+			cmd.Clear.Target = pass.ClearStencil->Target;
+			cmd.Clear.Stencil = pass.ClearStencil->Stencil;
+			alloc::PushBack(scratch, &cmds, cmd);
+			break;
+		case PassType::Resolve:
+			cmd.Type = CommandType::Resolve;
+			cmd.Resolve.Src = pass.Resolve->Src;
+			cmd.Resolve.Dst = pass.Resolve->Dst;
+			alloc::PushBack(scratch, &cmds, cmd);
+			break;
+		default:
+			Unimplemented();
+		}
+
+		cmd = {};
+		cmd.Type = CommandType::EndPass;
+		alloc::PushBack(scratch, &cmds, cmd);
+	}
+	Array<Command> lowered = alloc::MakeCopy(alloc, cmds);
+	alloc::Rollback(scratch, start);
+	return lowered;
+}
+
+
+// -----------------------------------------------------------------------------
+// ------------------------------ NULL BACKEND ---------------------------------
+// -----------------------------------------------------------------------------
+template <typename T>
+void AppendIndex(std::string& log, Array<T*> objects, const T* obj)
+{
+	char buf[16];
+	for (u32 i = 0 ; i < objects.Count ; ++i)
+	{
+		if (objects.Data[i] == obj)
+		{
+			sprintf_s(buf, 16, "%u", i);
+			log += buf;
+			return;
+		}
+	}
+	log += "?";
+}
+
+const char* StageNames[] = { "cs", "vs", "ps" };
+
+// What the buffer holds for set, as text rather than bytes so the logs of
+//	math libraries which round differently in the last bit still match.
+void AppendSetConstant(std::string& log, const SetConstant& set)
+{
+	char buf[32];
+	log += " ";
+	log += set.CB->Name;
+	log += ".";
+	log += set.VariableName;
+	log += "=";
+	const u8* data = set.CB->BackingMemory + set.Offset;
+	for (u32 i = 0 ; i < set.Type.Dim ; ++i)
+	{
+		if (i > 0)
+			log += ",";
+		switch (set.Type.Fmt)
+		{
+		case VariableFormat::Int:
+			sprintf_s(buf, 32, "%d", ((const i32*)data)[i]);
+			break;
+		case VariableFormat::Float:
+		case VariableFormat::Float4x4:
+			sprintf_s(buf, 32, "%g", ((const float*)data)[i]);
+			break;
+		default:
+			sprintf_s(buf, 32, "%u", ((const u32*)data)[i]);
+		}
+		log += buf;
+	}
+}
+
+void RecordCommands(ast::EvaluationContext& ec, RenderDescription* rd,
+	std::string& log)
+{
+	EvaluateConstants(ec, rd->Constants);
+	EvaluateSetConstantBatches(ec, rd);
+
+	char buf[256];
+	for (Command& cmd : rd->Commands)
+	{
+		log += CommandTypeNames[(u32)cmd.Type];
+		switch (cmd.Type)
+		{
+		case CommandType::SetComputePipeline:
+			log += " dispatch=";
+			AppendIndex(log, rd->Dispatches, cmd.ComputePipeline);
+			break;
+		case CommandType::SetGraphicsPipeline:
+			log += " draw=";
+			AppendIndex(log, rd->Draws, cmd.GraphicsPipeline);
+			break;
+		case CommandType::UpdateConstants:
+			EvaluateSetConstants(ec, cmd.Constants.Sets);
+			for (SetConstant& set : cmd.Constants.Sets)
+				AppendSetConstant(log, set);
+			break;
+		case CommandType::SetConstantBuffer:
+			sprintf_s(buf, 256, " %s b%u %s", StageNames[(u32)cmd.Slot.Stage],
+				cmd.Slot.Slot, cmd.Slot.Buffer->Name);
+			log += buf;
+			break;
+		case CommandType::BindSRV:
+		case CommandType::BindUAV:
+			sprintf_s(buf, 256, " %s %c%u view=", StageNames[(u32)cmd.Slot.Stage],
+				cmd.Type == CommandType::BindSRV ? 't' : 'u', cmd.Slot.Slot);
+			log += buf;
+			AppendIndex(log, rd->Views, cmd.Slot.View);
+			break;
+		case CommandType::BindSampler:
+			sprintf_s(buf, 256, " %s s%u sampler=", StageNames[(u32)cmd.Slot.Stage],
+				cmd.Slot.Slot);
+			log += buf;
+			AppendIndex(log, rd->Samplers, cmd.Slot.Sampler);
+			break;
+		case CommandType::SetRenderTargets:
+		{
+			// Same defaults as the backends.
+			float4 vp[8] = {};
+			u32 rtCount = 0;
+			log += " rtv=";
+			for (View* view : cmd.Targets.RenderTargets)
+			{
+				if (rtCount > 0)
+					log += ",";
+				AppendIndex(log, rd->Views, view);
+				vp[rtCount] = { 0, 0, (float)view->Texture->Size.x,
+					(float)view->Texture->Size.y };
+				++rtCount;
+			}
+			if (rtCount == 0)
+				log += "-";
+			log += " dsv=";
+			View* ds = cmd.Targets.DepthStencil;
+			if (ds)
+			{
+				AppendIndex(log, rd->Views, ds);
+				vp[0].z = (float)ds->Texture->Size.x;
+				vp[0].w = (float)ds->Texture->Size.y;
+			}
+			else
+				log += "-";
+			float2 depthRange[8] = {};
+			for (u32 i = 0 ; i < 8 ; ++i)
+				depthRange[i] = { 0.0f, 1.0f };
+			for (u32 i = 0 ; i < cmd.Targets.Viewports.Count ; ++i)
+			{
+				Viewport* v = cmd.Targets.Viewports[i];
+				ast::Result res;
+				if (v->TopLeft.IsValid()) {
+					EvaluateExpression(ec, v->TopLeft, res, Float2Type, "Viewport::TopLeft");
+					vp[i].x = res.Value.Float2Val.x;
+					vp[i].y = res.Value.Float2Val.y;
+				}
+				if (v->Size.IsValid()) {
+					EvaluateExpression(ec, v->Size, res, Float2Type, "Viewport::Size");
+					vp[i].z = res.Value.Float2Val.x;
+					vp[i].w = res.Value.Float2Val.y;
+				}
+				if (v->DepthRange.IsValid()) {
+					EvaluateExpression(ec, v->DepthRange, res, Float2Type,
+						"Viewport::DepthRange");
+					depthRange[i] = res.Value.Float2Val;
+				}
+			}
+			u32 vpCount = max(ds ? 1u : 0u, rtCount);
+			vpCount = max(vpCount, cmd.Targets.Viewports.Count);
+			for (u32 i = 0 ; i < vpCount ; ++i)
+			{
+				sprintf_s(buf, 256, " vp=%g,%g,%gx%g,%g-%g", vp[i].x, vp[i].y,
+					vp[i].z, vp[i].w, depthRange[i].x, depthRange[i].y);
+				log += buf;
+			}
+			break;
+		}
+		case CommandType::SetVertexBuffers:
+			log += " buffers=";
+			for (u32 i = 0 ; i < cmd.VertexBuffers.Count ; ++i)
+			{
+				if (i > 0)
+					log += ",";
+				AppendIndex(log, rd->Buffers, cmd.VertexBuffers[i]);
+			}
+			break;
+		case CommandType::SetIndexBuffer:
+			log += " buffer=";
+			AppendIndex(log, rd->Buffers, cmd.IndexBuffer);
+			log += cmd.IndexBuffer->ElementSize == 2 ? " r16" : " r32";
+			break;
+		case CommandType::Dispatch:
+		{
+			uint3 groups = {};
+			if (cmd.Groups)
+			{
+				ast::Result res;
+				EvaluateExpression(ec, *cmd.Groups, res, Uint3Type, "Dispatch::Groups");
+				groups = res.Value.Uint3Val;
+			}
+			sprintf_s(buf, 256, " %u,%u,%u", groups.x, groups.y, groups.z);
+			log += buf;
+			break;
+		}
+		case CommandType::DispatchThreadPerPixel:
+		{
+			Assert(ec.DisplaySize.x != 0 && ec.DisplaySize.y != 0,
+				"Invalid display size for execution");
+			uint3 tgs = cmd.ThreadGroupSize;
+			sprintf_s(buf, 256, " %u,%u,1", (ec.DisplaySize.x - 1) / tgs.x + 1,
+				(ec.DisplaySize.y - 1) / tgs.y + 1);
+			log += buf;
+			break;
+		}
+		case CommandType::DispatchIndirect:
+		case CommandType::DrawIndirect:
+		case CommandType::DrawIndexedIndirect:
+			log += " args=";
+			AppendIndex(log, rd->Buffers, cmd.Indirect.Args);
+			sprintf_s(buf, 256, " offset=%u", cmd.Indirect.Offset);
+			log += buf;
+			break;
+		case CommandType::Draw:
+			sprintf_s(buf, 256, " vertices=%u instances=%u", cmd.Draw.VertexCount,
+				cmd.Draw.InstanceCount);
+			log += buf;
+			break;
+		case CommandType::DrawIndexed:
+			sprintf_s(buf, 256, " indices=%u instances=%u",
+				cmd.Draw.IndexBuffer->ElementCount, cmd.Draw.InstanceCount);
+			log += buf;
+			break;
+		case CommandType::ClearColor:
+		{
+			float4& color = cmd.Clear.Color;
+			log += " rtv=";
+			AppendIndex(log, rd->Views, cmd.Clear.Target);
+			sprintf_s(buf, 256, " color=%g,%g,%g,%g", color.x, color.y, color.z,
+				color.w);
+			log += buf;
+			break;
+		}
+		case CommandType::ClearDepth:
+			log += " dsv=";
+			AppendIndex(log, rd->Views, cmd.Clear.Target);
+			sprintf_s(buf, 256, " depth=%g", cmd.Clear.Depth);
+			log += buf;
+			break;
+		case CommandType::ClearStencil:
+			log += " dsv=";
+			AppendIndex(log, rd->Views, cmd.Clear.Target);
+			sprintf_s(buf, 256, " stencil=%u", cmd.Clear.Stencil);
+			log += buf;
+			break;
+		case CommandType::Resolve:
+			log += " src=";
+			AppendIndex(log, rd->Textures, cmd.Resolve.Src);
+			log += " dst=";
+			AppendIndex(log, rd->Textures, cmd.Resolve.Dst);
+			break;
+		case CommandType::EndPass:
+			break;
+		default:
+			Unimplemented();
+		}
+		log += "\n";
+	}
+}
+
+}
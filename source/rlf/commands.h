@@ -0,0 +1,166 @@
+namespace rlf {
+
+struct RenderDescription;
+struct Dispatch;
+struct Draw;
+struct View;
+struct Sampler;
+struct Buffer;
+struct Texture;
+struct Viewport;
+struct ConstantBuffer;
+struct SetConstant;
+
+// Passes are lowered to a flat stream of commands by InitD3D, which the
+//	backends replay in order instead of walking the passes every frame.
+//	Everything that can't change once the description is initialized is
+//	decided while lowering: which kind of draw or dispatch it is, which stage
+//	and slot each bind goes to and where each pass ends. Commands point at the
+//	objects they use rather than at their gfx state, which is recreated when
+//	textures are resized, so sizes and expressions are still read at replay.
+
+#define COMMAND_TUPLE \
+	COMMAND_ENTRY(SetComputePipeline) \
+	COMMAND_ENTRY(SetGraphicsPipeline) \
+	COMMAND_ENTRY(UpdateConstants) \
+	COMMAND_ENTRY(SetConstantBuffer) \
+	COMMAND_ENTRY(BindSRV) \
+	COMMAND_ENTRY(BindUAV) \
+	COMMAND_ENTRY(BindSampler) \
+	COMMAND_ENTRY(SetRenderTargets) \
+	COMMAND_ENTRY(SetVertexBuffers) \
+	COMMAND_ENTRY(SetIndexBuffer) \
+	COMMAND_ENTRY(Dispatch) \
+	COMMAND_ENTRY(DispatchThreadPerPixel) \
+	COMMAND_ENTRY(DispatchIndirect) \
+	COMMAND_ENTRY(Draw) \
+	COMMAND_ENTRY(DrawIndexed) \
+	COMMAND_ENTRY(DrawIndirect) \
+	COMMAND_ENTRY(DrawIndexedIndirect) \
+	COMMAND_ENTRY(ClearColor) \
+	COMMAND_ENTRY(ClearDepth) \
+	COMMAND_ENTRY(ClearStencil) \
+	COMMAND_ENTRY(Resolve) \
+	COMMAND_ENTRY(EndPass) \
+
+#define COMMAND_ENTRY(name) name,
+enum class CommandType : u8
+{
+	COMMAND_TUPLE
+	Count
+};
+#undef COMMAND_ENTRY
+
+enum class ShaderStage : u8
+{
+	Compute,
+	Vertex,
+	Pixel,
+};
+
+// SetConstantBuffer and the binds. Constant buffers keep their own slot.
+struct SlotCommand
+{
+	ShaderStage Stage;
+	u32 Slot;
+	union {
+		rlf::View* View;
+		rlf::Sampler* Sampler;
+		ConstantBuffer* Buffer;
+	};
+};
+
+// Evaluates the invalidated SetConstants and uploads the buffers they write.
+struct ConstantsCommand
+{
+	Array<SetConstant> Sets;
+	Array<ConstantBuffer> Buffers;
+};
+
+// Viewports default to the size of the targets, Viewports override them in
+//	order.
+struct TargetsCommand
+{
+	Array<View*> RenderTargets;
+	View* DepthStencil;
+	Array<Viewport*> Viewports;
+};
+
+// Draw has no index buffer, DrawIndexed reads its index count from it.
+//	InstanceCount is at least 1.
+struct DrawCommand
+{
+	Buffer* IndexBuffer;
+	u32 VertexCount;
+	u32 InstanceCount;
+};
+
+// Indirect draws and dispatches, with the signature of the pipeline set last.
+struct IndirectCommand
+{
+	Buffer* Args;
+	u32 Offset;
+};
+
+struct ClearCommand
+{
+	View* Target;
+	float4 Color;
+	float Depth;
+	u8 Stencil;
+};
+
+struct ResolveCommand
+{
+	Texture* Src;
+	Texture* Dst;
+};
+
+struct Command
+{
+	CommandType Type;
+	union {
+		// SetComputePipeline
+		Dispatch* ComputePipeline;
+		// SetGraphicsPipeline
+		rlf::Draw* GraphicsPipeline;
+		// UpdateConstants
+		ConstantsCommand Constants;
+		// SetConstantBuffer, BindSRV, BindUAV, BindSampler
+		SlotCommand Slot;
+		// SetRenderTargets
+		TargetsCommand Targets;
+		// SetVertexBuffers
+		Array<Buffer*> VertexBuffers;
+		// SetIndexBuffer
+		Buffer* IndexBuffer;
+		// Dispatch, with no groups if the expression isn't valid.
+		ast::Expression* Groups;
+		// DispatchThreadPerPixel
+		uint3 ThreadGroupSize;
+		// Draw, DrawIndexed
+		rlf::DrawCommand Draw;
+		// DispatchIndirect, DrawIndirect, DrawIndexedIndirect
+		IndirectCommand Indirect;
+		// ClearColor, ClearDepth, ClearStencil
+		ClearCommand Clear;
+		// Resolve
+		ResolveCommand Resolve;
+	};
+};
+
+extern const char* CommandTypeNames[(u32)CommandType::Count];
+
+// Lowers rd->Passes into commands allocated from alloc. EndPass follows every
+//	pass, the backends reset their state there.
+Array<Command> LowerPasses(RenderDescription* rd, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch);
+
+// The null backend: replays rd->Commands like a backend would, evaluating
+//	constants and everything else read at replay, but appends a line per
+//	command to log instead of calling into a graphics API. Objects are named
+//	by their index in rd. Throws the same errors as Execute.
+void RecordCommands(ast::EvaluationContext& ec, RenderDescription* rd,
+	std::string& log);
+
+}
@@ -325,8 +325,12 @@ ID3DBlob* CommonCompileShader(CommonShader* common, const char* dirPath, const c
 		shader::ParseBuffer(shaderBuffer, shaderSize, structSizes, &es);
 		if (!es.Success)
 		{
+			SourceMap sm;
+			AddSourceFile(sm, path, shaderBuffer, shaderSize);
+			std::string message = "Failed to parse shader:\n" + es.Info.Message + "\n" +
+				FormatSourceLocation(sm, es.Info.Location);
 			free(shaderBuffer);
-			InitError("Failed to parse shader:\n%s", es.Info.Message.c_str());
+			InitErrorEx(message.c_str());
 		}
 		for (ast::SizeOf* request : it->second)
 		{
@@ -688,7 +692,7 @@ void PrepareConstants(
 		cb.Name[len] = '\0';
 
 		cb.Size = bd.Size;
-		cb.BackingMemory = (u8*)malloc(bd.Size);
+		cb.BackingMemory = (u8*)alloc::Allocate(&rd->ConstantPool, bd.Size);
 
 		for (u32 j = 0 ; j < bd.Variables ; ++j)
 		{
@@ -955,6 +959,10 @@ void InitMain(
 	ast::EvaluationContext evCtx;
 	evCtx.DisplaySize = displaySize;
 	evCtx.Time = 0;
+	evCtx.ChangedThisFrameFlags = 0;
+	evCtx.ChangedTuneables = {};
+	evCtx.Counters = nullptr;
+	evCtx.Profile = nullptr;
 
 	// Size expressions may depend on constants so we need to evaluate them first
 	EvaluateConstants(evCtx, rd->Constants);
@@ -1153,7 +1161,6 @@ void ReleaseD3D(
 		for (ConstantBuffer& cb : dc->CBs)
 		{
 			SafeRelease(cb.GfxState);
-			free(cb.BackingMemory);
 		}
 	}
 
@@ -1163,14 +1170,13 @@ void ReleaseD3D(
 		for (ConstantBuffer& cb : d->VSCBs)
 		{
 			SafeRelease(cb.GfxState);
-			free(cb.BackingMemory);
 		}
 		for (ConstantBuffer& cb : d->PSCBs)
 		{
 			SafeRelease(cb.GfxState);
-			free(cb.BackingMemory);
 		}
 	}
+	alloc::FreeAll(&rd->ConstantPool);
 }
 
 void HandleTextureParametersChanged(
@@ -1190,7 +1196,7 @@ void HandleTextureParametersChanged(
 			// DDS textures are always sized based on the file. 
 			if (tex->FromFile)
 				continue;
-			if ((tex->SizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+			if (!DependsOnChanges(tex->SizeExpr, ec->EvCtx))
 				continue;
 			
 			ast::Result res;
@@ -1213,8 +1219,8 @@ void HandleTextureParametersChanged(
 			if (!buf->ElementSizeExpr.IsValid() && !buf->ElementCountExpr.IsValid())
 				continue;
 
-			if ((buf->ElementSizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0 &&
-				(buf->ElementCountExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+			if (!DependsOnChanges(buf->ElementSizeExpr, ec->EvCtx) &&
+				!DependsOnChanges(buf->ElementCountExpr, ec->EvCtx))
 				continue;
 			
 			ast::Result res;
@@ -1243,7 +1249,7 @@ void HandleTextureParametersChanged(
 				// DDS textures are always sized based on the file. 
 				if (tex->FromFile)
 					continue;
-				if ((tex->SizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+				if (!DependsOnChanges(tex->SizeExpr, ec->EvCtx))
 					continue;
 			}
 			else if (view->ResourceType == ResourceType::Buffer)
@@ -1253,8 +1259,8 @@ void HandleTextureParametersChanged(
 				if (!buf->ElementSizeExpr.IsValid() && !buf->ElementCountExpr.IsValid())
 					continue;
 
-				if ((buf->ElementSizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0 &&
-					(buf->ElementCountExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+				if (!DependsOnChanges(buf->ElementSizeExpr, ec->EvCtx) &&
+					!DependsOnChanges(buf->ElementCountExpr, ec->EvCtx))
 					continue;
 			}
 			else
@@ -1311,26 +1317,11 @@ do {											\
 	}											\
 } while (0);									\
 
-void ExecuteSetConstants(ExecuteContext* ec, Array<SetConstant> sets, 
-	Array<ConstantBuffer> buffers)
+void ExecuteSetConstants(ExecuteContext* ec, ConstantsCommand& cmd)
 {
 	ID3D11DeviceContext* ctx = ec->GfxCtx->DeviceContext;
-	for (SetConstant& set : sets)
-	{
-		ast::Result res;
-		EvaluateExpression(ec->EvCtx, set.Value, res, set.Type, set.VariableName);
-		u32 typeSize = res.Type.Dim * 4;
-		Assert(set.Size == typeSize, 
-			"SetConstant %s does not match size, expected=%u got=%u",
-			set.VariableName, set.Size, typeSize);
-		if (res.Type.Fmt == VariableFormat::Bool)
-			for (u32 i = 0 ; i < res.Type.Dim ; ++i)
-				*(((u32*)(set.CB->BackingMemory+set.Offset)) + i) = 
-					res.Value.Bool4Val.m[i] ? 1 : 0;
-		else
-			memcpy(set.CB->BackingMemory+set.Offset, &res.Value, typeSize);
-	}
-	for (ConstantBuffer& buf : buffers)
+	EvaluateSetConstants(ec->EvCtx, cmd.Sets);
+	for (ConstantBuffer& buf : cmd.Buffers)
 	{
 		D3D11_MAPPED_SUBRESOURCE mapped_resource;
 		HRESULT hr = ctx->Map(buf.GfxState, 0, D3D11_MAP_WRITE_DISCARD, 
@@ -1341,152 +1332,26 @@ void ExecuteSetConstants(ExecuteContext* ec, Array<SetConstant> sets,
 	}
 }
 
-void ExecuteDispatch(
-	Dispatch* dc,
-	ExecuteContext* ec)
+// UAVs used by a draw are bound together with its render targets, so they're
+//	collected from its binds until then.
+struct DrawUAVs
 {
-	ID3D11DeviceContext* ctx = ec->GfxCtx->DeviceContext;
-	UINT initialCount = (UINT)-1;
-	ctx->CSSetShader(dc->Shader->GfxState, nullptr, 0);
-	ExecuteSetConstants(ec, dc->Constants, dc->CBs);
-	for (const ConstantBuffer& buf : dc->CBs)
-	{
-		ctx->CSSetConstantBuffers(buf.Slot, 1, &buf.GfxState);
-	}
-	for (Bind& bind : dc->Binds)
-	{
-		switch (bind.Type)
-		{
-		case BindType::View:
-			if (bind.IsOutput)
-			{
-				Assert(bind.ViewBind->Type == ViewType::UAV, "Invalid");
-				ctx->CSSetUnorderedAccessViews(bind.BindIndex, 1, 
-					&bind.ViewBind->UAVGfxState, &initialCount);
-			}
-			else
-			{
-				Assert(bind.ViewBind->Type == ViewType::SRV, "Invalid");
-				ctx->CSSetShaderResources(bind.BindIndex, 1, 
-					&bind.ViewBind->SRVGfxState);
-			}
-			break;
-		case BindType::Sampler:
-			ctx->CSSetSamplers(bind.BindIndex, 1, &bind.SamplerBind->GfxState);
-			break;
-		default:
-			Assert(false, "invalid type %d", bind.Type);
-		}
-	}
-	if (dc->IndirectArgs)
-	{
-		ctx->DispatchIndirect(dc->IndirectArgs->GfxState, dc->IndirectArgsOffset);
-	}
-	else
-	{
-		uint3 groups = {};
-		if (dc->ThreadPerPixel)
-		{
-			Assert(ec->EvCtx.DisplaySize.x != 0 && ec->EvCtx.DisplaySize.y != 0,
-				"Invalid display size for execution");
-			uint3 tgs = dc->Shader->ThreadGroupSize;
-			groups.x = (u32)((ec->EvCtx.DisplaySize.x - 1) / tgs.x) + 1;
-			groups.y = (u32)((ec->EvCtx.DisplaySize.y - 1) / tgs.y) + 1;
-			groups.z = 1;
-		}
-		else if (dc->Groups.IsValid())
-		{
-			ast::Result res;
-			EvaluateExpression(ec->EvCtx, dc->Groups, res, Uint3Type, "Dispatch::Groups");
-			groups = res.Value.Uint3Val;
-		}
-
-		ctx->Dispatch(groups.x, groups.y, groups.z);
-	}
-}
-
-void ExecuteDraw(
-	Draw* draw,
+	ID3D11UnorderedAccessView* Views[D3D11_PS_CS_UAV_REGISTER_COUNT];
+	u32 Min;
+	u32 Max;
+};
+
+void ExecuteSetRenderTargets(
+	TargetsCommand& cmd,
+	DrawUAVs& uavs,
 	ExecuteContext* ec)
 {
 	ID3D11DeviceContext* ctx = ec->GfxCtx->DeviceContext;
-	ctx->VSSetShader(draw->VShader->GfxState, nullptr, 0);
-	ctx->IASetInputLayout(draw->VShader->LayoutGfxState);
-	ctx->PSSetShader(draw->PShader ? draw->PShader->GfxState : nullptr, nullptr, 0);
-	ExecuteSetConstants(ec, draw->VSConstants, draw->VSCBs);
-	ExecuteSetConstants(ec, draw->PSConstants, draw->PSCBs);
-	for (const ConstantBuffer& buf : draw->VSCBs)
-	{
-		ctx->VSSetConstantBuffers(buf.Slot, 1, &buf.GfxState);
-	}
-	for (const ConstantBuffer& buf : draw->PSCBs)
-	{
-		ctx->PSSetConstantBuffers(buf.Slot, 1, &buf.GfxState);
-	}
-	ID3D11UnorderedAccessView *uavs[D3D11_PS_CS_UAV_REGISTER_COUNT] = {};
-	u32 uav_min = 0xffffffff;
-	u32 uav_max = 0;
-	for (Bind& bind : draw->VSBinds)
-	{
-		switch (bind.Type)
-		{
-		case BindType::View:
-		{
-			if (bind.IsOutput)
-			{
-				Assert(bind.ViewBind->Type == ViewType::UAV, "Invalid");
-				uav_min = min(uav_min, bind.BindIndex);
-				uav_max = max(uav_max, bind.BindIndex);
-				uavs[bind.BindIndex] = bind.ViewBind->UAVGfxState;
-			}
-			else
-			{
-				Assert(bind.ViewBind->Type == ViewType::SRV, "Invalid");
-				ctx->VSSetShaderResources(bind.BindIndex, 1, &bind.ViewBind->SRVGfxState);
-			}
-			break;
-		}
-		case BindType::Sampler:
-			ctx->VSSetSamplers(bind.BindIndex, 1, &bind.SamplerBind->GfxState);
-			break;
-		default:
-			Assert(false, "unhandled type %d", bind.Type);
-		}
-	}
-	for (Bind& bind : draw->PSBinds)
-	{
-		switch (bind.Type)
-		{
-		case BindType::View:
-		{
-			if (bind.IsOutput)
-			{
-				Assert(bind.ViewBind->Type == ViewType::UAV, "Invalid");
-				uav_min = min(uav_min, bind.BindIndex);
-				uav_max = max(uav_max, bind.BindIndex);
-				uavs[bind.BindIndex] = bind.ViewBind->UAVGfxState;
-			}
-			else
-			{
-				Assert(bind.ViewBind->Type == ViewType::SRV, "Invalid");
-				ctx->PSSetShaderResources(bind.BindIndex, 1, &bind.ViewBind->SRVGfxState);
-			}
-			break;
-		}
-		case BindType::Sampler:
-			ctx->PSSetSamplers(bind.BindIndex, 1, &bind.SamplerBind->GfxState);
-			break;
-		default:
-			Assert(false, "unhandled type %d", bind.Type);
-		}
-	}
 	ID3D11RenderTargetView* rtViews[8] = {};
 	D3D11_VIEWPORT vp[8] = {};
 	u32 rtCount = 0;
-	for (View* view : draw->RenderTargets)
+	for (View* view : cmd.RenderTargets)
 	{
-		Assert(view->Type == ViewType::RTV, "Invalid");
-		Assert(view->ResourceType == ResourceType::Texture, "Invalid");
 		rtViews[rtCount] = view->RTVGfxState;
 		vp[rtCount].Width = (float)view->Texture->Size.x;
 		vp[rtCount].Height = (float)view->Texture->Size.y;
@@ -1496,20 +1361,18 @@ void ExecuteDraw(
 		++rtCount;
 	}
 	ID3D11DepthStencilView* dsView = nullptr;
-	if (draw->DepthStencil)
+	if (cmd.DepthStencil)
 	{
-		View* view = draw->DepthStencil;
-		Assert(view->Type == ViewType::DSV, "Invalid");
-		Assert(view->ResourceType == ResourceType::Texture, "Invalid");
+		View* view = cmd.DepthStencil;
 		dsView = view->DSVGfxState;
 		vp[0].Width = (float)view->Texture->Size.x;
 		vp[0].Height = (float)view->Texture->Size.y;
 		vp[0].MinDepth = 0.0f;
 		vp[0].MaxDepth = 1.0f;
 	}
-	for (u32 i = 0 ; i < draw->Viewports.Count ; ++i)
+	for (u32 i = 0 ; i < cmd.Viewports.Count ; ++i)
 	{
-		Viewport* v = draw->Viewports[i];
+		Viewport* v = cmd.Viewports[i];
 		ast::Result res;
 		if (v->TopLeft.IsValid()) {
 			EvaluateExpression(ec->EvCtx, v->TopLeft, res, Float2Type, "Viewport::TopLeft");
@@ -1527,54 +1390,15 @@ void ExecuteDraw(
 			vp[i].MaxDepth = res.Value.Float2Val.y;
 		}
 	}
-	ExecuteAssert(uav_min >= rtCount, 
+	ExecuteAssert(uavs.Min >= rtCount, 
 		"Shader has %d render targets, UAVs must be bound at index %d or greater "
-		"but one is bound at index %d", rtCount, rtCount, uav_min);
-	if (uav_min != 0xffffffff)
+		"but one is bound at index %d", rtCount, rtCount, uavs.Min);
+	if (uavs.Min != 0xffffffff)
 		ctx->OMSetRenderTargetsAndUnorderedAccessViews(rtCount, rtViews, dsView, 
-			uav_min, uav_max-uav_min+1, uavs+uav_min, nullptr);
+			uavs.Min, uavs.Max-uavs.Min+1, uavs.Views+uavs.Min, nullptr);
 	else
 		ctx->OMSetRenderTargets(rtCount, rtViews, dsView);
 	ctx->RSSetViewports(8, vp);
-	ctx->IASetPrimitiveTopology(RlfToD3d(draw->Topology));
-	ctx->RSSetState(draw->RState ? draw->RState->GfxState : DefaultRasterizerState);
-	ctx->OMSetDepthStencilState(draw->DSState ? draw->DSState->GfxState : nullptr,
-		draw->StencilRef);
-	ctx->OMSetBlendState(draw->BlendGfxState, nullptr, 0xffffffff);
-	if (draw->VertexBuffers.Count)
-	{
-		ID3D11Buffer* bufs[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
-		u32 elementSizes[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
-		u32 offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
-		for (u32 i = 0 ; i < draw->VertexBuffers.Count ; ++i)
-		{
-			Buffer* vb = draw->VertexBuffers[i];
-			bufs[i] = vb->GfxState;
-			elementSizes[i] = vb->ElementSize;
-			offsets[i] = 0;
-		}
-		ctx->IASetVertexBuffers(0, (u32)draw->VertexBuffers.Count, bufs, elementSizes, 
-			offsets);
-	}
-	Buffer* ib = draw->IndexBuffer;
-	if (ib)
-		ctx->IASetIndexBuffer(ib->GfxState, ib->ElementSize == 2 ? 
-			DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
-
-	if (draw->InstancedIndirectArgs)
-		ctx->DrawInstancedIndirect(draw->InstancedIndirectArgs->GfxState,
-			draw->IndirectArgsOffset);
-	else if (draw->IndexedInstancedIndirectArgs)
-		ctx->DrawIndexedInstancedIndirect(draw->IndexedInstancedIndirectArgs->GfxState,
-			draw->IndirectArgsOffset);
-	else if (ib && draw->InstanceCount > 0)
-		ctx->DrawIndexedInstanced(ib->ElementCount, draw->InstanceCount, 0, 0, 0);
-	else if (ib)
-		ctx->DrawIndexed(ib->ElementCount, 0, 0);
-	else if (draw->InstanceCount > 0)
-		ctx->DrawInstanced(draw->VertexCount, draw->InstanceCount, 0, 0);
-	else
-		ctx->Draw(draw->VertexCount, 0);
 }
 
 void _Execute(
@@ -1584,63 +1408,178 @@ void _Execute(
 	ID3D11DeviceContext* ctx = ec->GfxCtx->DeviceContext;
 
 	EvaluateConstants(ec->EvCtx, rd->Constants);
+	EvaluateSetConstantBatches(ec->EvCtx, rd);
 
 	// Clear state so we aren't polluted by previous program drawing or previous 
 	//	execution. 
 	ctx->ClearState();
 
-	for (Pass pass : rd->Passes)
+	UINT initialCount = (UINT)-1;
+	DrawUAVs uavs = {};
+	for (Command& cmd : rd->Commands)
 	{
-		if (pass.Type == PassType::Dispatch)
+		switch (cmd.Type)
 		{
-			ExecuteDispatch(pass.Dispatch, ec);
-		}
-		else if (pass.Type == PassType::Draw)
+		case CommandType::SetComputePipeline:
+			ctx->CSSetShader(cmd.ComputePipeline->Shader->GfxState, nullptr, 0);
+			break;
+		case CommandType::SetGraphicsPipeline:
 		{
-			ExecuteDraw(pass.Draw, ec);
+			Draw* draw = cmd.GraphicsPipeline;
+			ctx->VSSetShader(draw->VShader->GfxState, nullptr, 0);
+			ctx->IASetInputLayout(draw->VShader->LayoutGfxState);
+			ctx->PSSetShader(draw->PShader ? draw->PShader->GfxState : nullptr, nullptr, 0);
+			ctx->IASetPrimitiveTopology(RlfToD3d(draw->Topology));
+			ctx->RSSetState(draw->RState ? draw->RState->GfxState : DefaultRasterizerState);
+			ctx->OMSetDepthStencilState(draw->DSState ? draw->DSState->GfxState : nullptr,
+				draw->StencilRef);
+			ctx->OMSetBlendState(draw->BlendGfxState, nullptr, 0xffffffff);
+			uavs = {};
+			uavs.Min = 0xffffffff;
+			break;
 		}
-		else if (pass.Type == PassType::ClearColor)
+		case CommandType::UpdateConstants:
+			ExecuteSetConstants(ec, cmd.Constants);
+			break;
+		case CommandType::SetConstantBuffer:
 		{
-			float4& color = pass.ClearColor->Color;
-			const float clear_color[4] =
-			{
-				color.x, color.y, color.z, color.w
-			};
-			ctx->ClearRenderTargetView(pass.ClearColor->Target->RTVGfxState, 
-				clear_color);
+			ID3D11Buffer* buf = cmd.Slot.Buffer->GfxState;
+			if (cmd.Slot.Stage == ShaderStage::Compute)
+				ctx->CSSetConstantBuffers(cmd.Slot.Slot, 1, &buf);
+			else if (cmd.Slot.Stage == ShaderStage::Vertex)
+				ctx->VSSetConstantBuffers(cmd.Slot.Slot, 1, &buf);
+			else
+				ctx->PSSetConstantBuffers(cmd.Slot.Slot, 1, &buf);
+			break;
 		}
-		else if (pass.Type == PassType::ClearDepth)
+		case CommandType::BindSRV:
 		{
-			ctx->ClearDepthStencilView(pass.ClearDepth->Target->DSVGfxState, 
-				D3D11_CLEAR_DEPTH, pass.ClearDepth->Depth, 0);
+			ID3D11ShaderResourceView* srv = cmd.Slot.View->SRVGfxState;
+			if (cmd.Slot.Stage == ShaderStage::Compute)
+				ctx->CSSetShaderResources(cmd.Slot.Slot, 1, &srv);
+			else if (cmd.Slot.Stage == ShaderStage::Vertex)
+				ctx->VSSetShaderResources(cmd.Slot.Slot, 1, &srv);
+			else
+				ctx->PSSetShaderResources(cmd.Slot.Slot, 1, &srv);
+			break;
 		}
-		else if (pass.Type == PassType::ClearStencil)
+		case CommandType::BindUAV:
+			if (cmd.Slot.Stage == ShaderStage::Compute)
+				ctx->CSSetUnorderedAccessViews(cmd.Slot.Slot, 1, 
+					&cmd.Slot.View->UAVGfxState, &initialCount);
+			else
+			{
+				uavs.Min = min(uavs.Min, cmd.Slot.Slot);
+				uavs.Max = max(uavs.Max, cmd.Slot.Slot);
+				uavs.Views[cmd.Slot.Slot] = cmd.Slot.View->UAVGfxState;
+			}
+			break;
+		case CommandType::BindSampler:
 		{
-			ctx->ClearDepthStencilView(pass.ClearStencil->Target->DSVGfxState, 
-				D3D11_CLEAR_STENCIL, 0.f, pass.ClearStencil->Stencil);
+			ID3D11SamplerState* sampler = cmd.Slot.Sampler->GfxState;
+			if (cmd.Slot.Stage == ShaderStage::Compute)
+				ctx->CSSetSamplers(cmd.Slot.Slot, 1, &sampler);
+			else if (cmd.Slot.Stage == ShaderStage::Vertex)
+				ctx->VSSetSamplers(cmd.Slot.Slot, 1, &sampler);
+			else
+				ctx->PSSetSamplers(cmd.Slot.Slot, 1, &sampler);
+			break;
 		}
-		else if (pass.Type == PassType::Resolve)
+		case CommandType::SetRenderTargets:
+			ExecuteSetRenderTargets(cmd.Targets, uavs, ec);
+			break;
+		case CommandType::SetVertexBuffers:
 		{
-			ctx->ResolveSubresource(pass.Resolve->Dst->GfxState, 0, 
-				pass.Resolve->Src->GfxState, 0, 
-				D3DTextureFormat[(u32)pass.Resolve->Dst->Format]);
+			ID3D11Buffer* bufs[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+			u32 elementSizes[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+			u32 offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+			for (u32 i = 0 ; i < cmd.VertexBuffers.Count ; ++i)
+			{
+				Buffer* vb = cmd.VertexBuffers[i];
+				bufs[i] = vb->GfxState;
+				elementSizes[i] = vb->ElementSize;
+				offsets[i] = 0;
+			}
+			ctx->IASetVertexBuffers(0, cmd.VertexBuffers.Count, bufs, elementSizes, 
+				offsets);
+			break;
 		}
-		else if (pass.Type == PassType::ObjDraw)
+		case CommandType::SetIndexBuffer:
+			ctx->IASetIndexBuffer(cmd.IndexBuffer->GfxState, 
+				cmd.IndexBuffer->ElementSize == 2 ? 
+				DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+			break;
+		case CommandType::Dispatch:
 		{
-			for (Draw* draw : pass.ObjDraw->PerMeshDraws)
+			uint3 groups = {};
+			if (cmd.Groups)
 			{
-				ExecuteDraw(draw, ec);
+				ast::Result res;
+				EvaluateExpression(ec->EvCtx, *cmd.Groups, res, Uint3Type, 
+					"Dispatch::Groups");
+				groups = res.Value.Uint3Val;
 			}
+			ctx->Dispatch(groups.x, groups.y, groups.z);
+			break;
 		}
-		else
+		case CommandType::DispatchThreadPerPixel:
+		{
+			Assert(ec->EvCtx.DisplaySize.x != 0 && ec->EvCtx.DisplaySize.y != 0,
+				"Invalid display size for execution");
+			uint3 tgs = cmd.ThreadGroupSize;
+			ctx->Dispatch((ec->EvCtx.DisplaySize.x - 1) / tgs.x + 1,
+				(ec->EvCtx.DisplaySize.y - 1) / tgs.y + 1, 1);
+			break;
+		}
+		case CommandType::DispatchIndirect:
+			ctx->DispatchIndirect(cmd.Indirect.Args->GfxState, cmd.Indirect.Offset);
+			break;
+		case CommandType::Draw:
+			ctx->DrawInstanced(cmd.Draw.VertexCount, cmd.Draw.InstanceCount, 0, 0);
+			break;
+		case CommandType::DrawIndexed:
+			ctx->DrawIndexedInstanced(cmd.Draw.IndexBuffer->ElementCount, 
+				cmd.Draw.InstanceCount, 0, 0, 0);
+			break;
+		case CommandType::DrawIndirect:
+			ctx->DrawInstancedIndirect(cmd.Indirect.Args->GfxState, cmd.Indirect.Offset);
+			break;
+		case CommandType::DrawIndexedIndirect:
+			ctx->DrawIndexedInstancedIndirect(cmd.Indirect.Args->GfxState,
+				cmd.Indirect.Offset);
+			break;
+		case CommandType::ClearColor:
 		{
+			float4& color = cmd.Clear.Color;
+			const float clear_color[4] =
+			{
+				color.x, color.y, color.z, color.w
+			};
+			ctx->ClearRenderTargetView(cmd.Clear.Target->RTVGfxState, clear_color);
+			break;
+		}
+		case CommandType::ClearDepth:
+			ctx->ClearDepthStencilView(cmd.Clear.Target->DSVGfxState, 
+				D3D11_CLEAR_DEPTH, cmd.Clear.Depth, 0);
+			break;
+		case CommandType::ClearStencil:
+			ctx->ClearDepthStencilView(cmd.Clear.Target->DSVGfxState, 
+				D3D11_CLEAR_STENCIL, 0.f, cmd.Clear.Stencil);
+			break;
+		case CommandType::Resolve:
+			ctx->ResolveSubresource(cmd.Resolve.Dst->GfxState, 0, 
+				cmd.Resolve.Src->GfxState, 0, 
+				D3DTextureFormat[(u32)cmd.Resolve.Dst->Format]);
+			break;
+		case CommandType::EndPass:
+			// Clear state after execution so we don't pollute the rest of program 
+			//	drawing. 
+			ctx->ClearState();
+			break;
+		default:
 			Unimplemented();
 		}
-
-		// Clear state after execution so we don't pollute the rest of program drawing. 
-		ctx->ClearState();
 	}
-
 }
 
 #undef ExecuteAssert
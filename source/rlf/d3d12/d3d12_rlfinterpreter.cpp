@@ -315,8 +315,12 @@ ID3DBlob* CommonCompileShader(CommonShader* common, const char* dirPath, const c
 		shader::ParseBuffer(shaderBuffer, shaderSize, structSizes, &es);
 		if (!es.Success)
 		{
+			SourceMap sm;
+			AddSourceFile(sm, path, shaderBuffer, shaderSize);
+			std::string message = "Failed to parse shader:\n" + es.Info.Message + "\n" +
+				FormatSourceLocation(sm, es.Info.Location);
 			free(shaderBuffer);
-			InitError("Failed to parse shader:\n%s", es.Info.Message.c_str());
+			InitErrorEx(message.c_str());
 		}
 		for (ast::SizeOf* request : it->second)
 		{
@@ -1277,7 +1281,7 @@ void PrepareConstants(
 		cb.Name[len] = '\0';
 
 		cb.Size = bd.Size;
-		cb.BackingMemory = (u8*)malloc(bd.Size);
+		cb.BackingMemory = (u8*)alloc::Allocate(&rd->ConstantPool, bd.Size);
 
 		for (u32 j = 0 ; j < bd.Variables ; ++j)
 		{
@@ -1566,6 +1570,9 @@ void InitMain(
 	evCtx.DisplaySize = displaySize;
 	evCtx.Time = 0;
 	evCtx.ChangedThisFrameFlags = 0;
+	evCtx.ChangedTuneables = {};
+	evCtx.Counters = nullptr;
+	evCtx.Profile = nullptr;
 
 	// Size expressions may depend on constants so we need to evaluate them first
 	EvaluateConstants(evCtx, rd->Constants);
@@ -1892,7 +1899,6 @@ void ReleaseD3D(
 				cb.GfxState.Resource[frame]->Unmap(0, nullptr);
 				SafeRelease(cb.GfxState.Resource[frame]);
 			}
-			free(cb.BackingMemory);
 		}
 		for (ConstantBuffer& cb : d->PSCBs)
 		{
@@ -1901,7 +1907,6 @@ void ReleaseD3D(
 				cb.GfxState.Resource[frame]->Unmap(0, nullptr);
 				SafeRelease(cb.GfxState.Resource[frame]);
 			}
-			free(cb.BackingMemory);
 		}
 	}
 
@@ -1915,7 +1920,6 @@ void ReleaseD3D(
 				cb.GfxState.Resource[frame]->Unmap(0, nullptr);
 				SafeRelease(cb.GfxState.Resource[frame]);
 			}
-			free(cb.BackingMemory);
 		}
 	}
 
@@ -1928,6 +1932,7 @@ void ReleaseD3D(
 	{
 		SafeRelease(tex->GfxState.Resource);
 	}
+	alloc::FreeAll(&rd->ConstantPool);
 }
 
 void HandleTextureParametersChanged(
@@ -1949,7 +1954,7 @@ void HandleTextureParametersChanged(
 			// DDS textures are always sized based on the file. 
 			if (tex->FromFile)
 				continue;
-			if ((tex->SizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+			if (!DependsOnChanges(tex->SizeExpr, ec->EvCtx))
 				continue;
 			
 			ast::Result res;
@@ -1972,8 +1977,8 @@ void HandleTextureParametersChanged(
 			if (!buf->ElementSizeExpr.IsValid() && !buf->ElementCountExpr.IsValid())
 				continue;
 
-			if ((buf->ElementSizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0 &&
-				(buf->ElementCountExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+			if (!DependsOnChanges(buf->ElementSizeExpr, ec->EvCtx) &&
+				!DependsOnChanges(buf->ElementCountExpr, ec->EvCtx))
 				continue;
 			
 			ast::Result res;
@@ -2002,7 +2007,7 @@ void HandleTextureParametersChanged(
 				// DDS textures are always sized based on the file. 
 				if (tex->FromFile)
 					continue;
-				if ((tex->SizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+				if (!DependsOnChanges(tex->SizeExpr, ec->EvCtx))
 					continue;
 			}
 			else if (view->ResourceType == ResourceType::Buffer)
@@ -2012,8 +2017,8 @@ void HandleTextureParametersChanged(
 				if (!buf->ElementSizeExpr.IsValid() && !buf->ElementCountExpr.IsValid())
 					continue;
 
-				if ((buf->ElementSizeExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0 &&
-					(buf->ElementCountExpr.Dep.VariesByFlags & ec->EvCtx.ChangedThisFrameFlags) == 0)
+				if (!DependsOnChanges(buf->ElementSizeExpr, ec->EvCtx) &&
+					!DependsOnChanges(buf->ElementCountExpr, ec->EvCtx))
 					continue;
 			}
 			else
@@ -2085,79 +2090,97 @@ do {											\
 	}											\
 } while (0);									\
 
-void ExecuteSetConstants(ExecuteContext* ec, Array<SetConstant> sets, 
-	Array<ConstantBuffer> buffers)
+void ExecuteSetConstants(ExecuteContext* ec, ConstantsCommand& cmd)
 {
 	gfx::Context* ctx = ec->GfxCtx;
-	for (SetConstant& set : sets)
-	{
-		ast::Result res;
-		EvaluateExpression(ec->EvCtx, set.Value, res, set.Type, set.VariableName);
-		u32 typeSize = res.Type.Dim * 4;
-		Assert(set.Size == typeSize, 
-			"SetConstant %s does not match size, expected=%u got=%u",
-			set.VariableName, set.Size, typeSize);
-		if (res.Type.Fmt == VariableFormat::Bool)
-			for (u32 i = 0 ; i < res.Type.Dim ; ++i)
-				*(((u32*)(set.CB->BackingMemory+set.Offset)) + i) = 
-					res.Value.Bool4Val.m[i] ? 1 : 0;
-		else
-			memcpy(set.CB->BackingMemory+set.Offset, &res.Value, typeSize);
-	}
-	for (ConstantBuffer& buf : buffers)
+	EvaluateSetConstants(ec->EvCtx, cmd.Sets);
+	for (ConstantBuffer& buf : cmd.Buffers)
 	{
 		u32 frame = ctx->FrameIndex % gfx::Context::NUM_FRAMES_IN_FLIGHT;
 		memcpy(buf.GfxState.MappedMem[frame], buf.BackingMemory, buf.Size);
 	}
 }
 
-void TransitionBinds(gfx::Context* ctx, Array<Bind> binds)
+// Transitions wanted by the commands since the last one which uses the
+//	resources, which issues them with one ResourceBarrier call. The lists are
+//	in the frame allocator and reused by every batch in the frame.
+struct BarrierBatch
 {
-	for (const Bind& bind : binds)
+	alloc::List<D3D12_RESOURCE_BARRIER> Barriers;
+	// The tracked state of each resource, which isn't updated until the
+	//	barrier is issued, so an error part way through a batch leaves it right.
+	alloc::List<D3D12_RESOURCE_STATES*> States;
+};
+
+void QueueTransition(ExecuteContext* ec, BarrierBatch& batch, ID3D12Resource* resource,
+	D3D12_RESOURCE_STATES* current, D3D12_RESOURCE_STATES state)
+{
+	// A resource moved more than once in a batch only needs to go from where
+	//	it started to where it ends up.
+	for (u32 i = 0 ; i < batch.Barriers.Count ; ++i)
 	{
-		switch(bind.Type)
+		D3D12_RESOURCE_TRANSITION_BARRIER& transition = batch.Barriers[i].Transition;
+		if (transition.pResource == resource)
 		{
-		case BindType::View:
-			if (bind.IsOutput)
-			{
-				Assert(bind.ViewBind->Type == ViewType::UAV, "mismatched view");
-				if (bind.ViewBind->ResourceType == ResourceType::Buffer)
-					TransitionResource(ctx, &bind.ViewBind->Buffer->GfxState,
-						D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-				else if (bind.ViewBind->ResourceType == ResourceType::Texture)
-					TransitionResource(ctx, &bind.ViewBind->Texture->GfxState,
-						D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			}
-			else
-			{
-				Assert(bind.ViewBind->Type == ViewType::SRV, "mismatched view");
-				if (bind.ViewBind->ResourceType == ResourceType::Buffer)
-					TransitionResource(ctx, &bind.ViewBind->Buffer->GfxState,
-						D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | 
-						D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-				else if (bind.ViewBind->ResourceType == ResourceType::Texture)
-					TransitionResource(ctx, &bind.ViewBind->Texture->GfxState,
-						D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | 
-						D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			}
-			break;
-		case BindType::Sampler:
-			break;
-		default:
-			Unimplemented();
+			transition.StateAfter = state;
+			return;
 		}
 	}
+	if (*current == state)
+		return;
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	barrier.Transition.pResource   = resource;
+	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	barrier.Transition.StateBefore = *current;
+	barrier.Transition.StateAfter  = state;
+	alloc::PushBack(ec->FrameAlloc, &batch.Barriers, barrier);
+	alloc::PushBack(ec->FrameAlloc, &batch.States, current);
+}
+
+void QueueTransition(ExecuteContext* ec, BarrierBatch& batch, gfx::Texture* tex,
+	D3D12_RESOURCE_STATES state)
+{
+	QueueTransition(ec, batch, tex->Resource, &tex->State, state);
+}
+
+void QueueTransition(ExecuteContext* ec, BarrierBatch& batch, gfx::Buffer* buf,
+	D3D12_RESOURCE_STATES state)
+{
+	QueueTransition(ec, batch, buf->Resource, &buf->State, state);
+}
+
+void FlushBarriers(ExecuteContext* ec, BarrierBatch& batch)
+{
+	u32 count = 0;
+	for (u32 i = 0 ; i < batch.Barriers.Count ; ++i)
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER& transition = batch.Barriers[i].Transition;
+		*batch.States[i] = transition.StateAfter;
+		if (transition.StateBefore != transition.StateAfter)
+			batch.Barriers[count++] = batch.Barriers[i];
+	}
+	if (count > 0)
+		ec->GfxCtx->CommandList->ResourceBarrier(count, batch.Barriers.Data);
+	batch.Barriers.Count = 0;
+	batch.States.Count = 0;
 }
 
-void ExecuteDispatch(
+void TransitionView(ExecuteContext* ec, BarrierBatch& batch, View* view,
+	D3D12_RESOURCE_STATES state)
+{
+	if (view->ResourceType == ResourceType::Buffer)
+		QueueTransition(ec, batch, &view->Buffer->GfxState, state);
+	else if (view->ResourceType == ResourceType::Texture)
+		QueueTransition(ec, batch, &view->Texture->GfxState, state);
+}
+
+void ExecuteSetComputePipeline(
 	Dispatch* dc,
 	ExecuteContext* ec)
 {
 	gfx::ComputeShader* cs = &dc->Shader->GfxState;
-	ExecuteSetConstants(ec, dc->Constants, dc->CBs);
-
-	TransitionBinds(ec->GfxCtx, dc->Binds);
-
 	u32 frame = ec->GfxCtx->FrameIndex % gfx::Context::NUM_FRAMES_IN_FLIGHT;
 
 	ID3D12GraphicsCommandList* cl = ec->GfxCtx->CommandList;
@@ -2176,48 +2199,13 @@ void ExecuteDispatch(
 			&ec->GfxCtx->SamplerHeap, dc->GfxState.Table.SamplerDescTableStart[frame]);
 		cl->SetComputeRootDescriptorTable(table_index++, sampler_table_handle);
 	}
-
-	if (dc->IndirectArgs)
-	{
-		TransitionResource(ec->GfxCtx, &dc->IndirectArgs->GfxState,
-						D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		cl->ExecuteIndirect(dc->GfxState.CommandSig, 1, dc->IndirectArgs->GfxState.Resource, 
-			dc->IndirectArgsOffset, nullptr, 0);
-	}
-	else
-	{
-		uint3 groups = {};
-		if (dc->ThreadPerPixel)
-		{
-			Assert(ec->EvCtx.DisplaySize.x != 0 && ec->EvCtx.DisplaySize.y != 0,
-				"Invalid display size for execution");
-			uint3 tgs = dc->Shader->ThreadGroupSize;
-			groups.x = (u32)((ec->EvCtx.DisplaySize.x - 1) / tgs.x) + 1;
-			groups.y = (u32)((ec->EvCtx.DisplaySize.y - 1) / tgs.y) + 1;
-			groups.z = 1;
-		}
-		else if (dc->Groups.IsValid())
-		{
-			ast::Result res;
-			EvaluateExpression(ec->EvCtx, dc->Groups, res, Uint3Type, "Dispatch::Groups");
-			groups = res.Value.Uint3Val;
-		}
-
-		cl->Dispatch(groups.x, groups.y, groups.z);
-	}
 }
 
-void ExecuteDraw(
+void ExecuteSetGraphicsPipeline(
 	Draw* draw,
 	ExecuteContext* ec)
 {
 	ID3D12GraphicsCommandList* cl = ec->GfxCtx->CommandList;
-	ExecuteSetConstants(ec, draw->VSConstants, draw->VSCBs);
-	ExecuteSetConstants(ec, draw->PSConstants, draw->PSCBs);
-
-	TransitionBinds(ec->GfxCtx, draw->VSBinds);
-	TransitionBinds(ec->GfxCtx, draw->PSBinds);
-
 	u32 frame = ec->GfxCtx->FrameIndex % gfx::Context::NUM_FRAMES_IN_FLIGHT;
 
 	cl->SetGraphicsRootSignature(draw->GfxState.RootSig);
@@ -2255,13 +2243,21 @@ void ExecuteDraw(
 		}
 	}
 
+	cl->IASetPrimitiveTopology(RlfToD3d_Topo(draw->Topology));
+	cl->OMSetStencilRef(draw->StencilRef);
+}
+
+void ExecuteSetRenderTargets(
+	TargetsCommand& cmd,
+	ExecuteContext* ec,
+	BarrierBatch& batch)
+{
+	ID3D12GraphicsCommandList* cl = ec->GfxCtx->CommandList;
 	D3D12_CPU_DESCRIPTOR_HANDLE rtViews[8] = {};
 	D3D12_VIEWPORT vp[8] = {};
 	u32 rtCount = 0;
-	for (View* view : draw->RenderTargets)
+	for (View* view : cmd.RenderTargets)
 	{
-		Assert(view->Type == ViewType::RTV, "Invalid");
-		Assert(view->ResourceType == ResourceType::Texture, "Invalid");
 		rtViews[rtCount] = view->RTVGfxState;
 		vp[rtCount].Width = (float)view->Texture->Size.x;
 		vp[rtCount].Height = (float)view->Texture->Size.y;
@@ -2270,15 +2266,12 @@ void ExecuteDraw(
 		vp[rtCount].TopLeftX = vp[rtCount].TopLeftY = 0;
 		++rtCount;
 
-		gfx::Texture* resource = &view->Texture->GfxState;;
-		TransitionResource(ec->GfxCtx, resource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		QueueTransition(ec, batch, &view->Texture->GfxState, D3D12_RESOURCE_STATE_RENDER_TARGET);
 	}
 	D3D12_CPU_DESCRIPTOR_HANDLE dsView = {};
-	if (draw->DepthStencil)
+	if (cmd.DepthStencil)
 	{
-		View* view = draw->DepthStencil;
-		Assert(view->Type == ViewType::DSV, "Invalid");
-		Assert(view->ResourceType == ResourceType::Texture, "Invalid");
+		View* view = cmd.DepthStencil;
 		dsView = view->DSVGfxState;
 		vp[0].Width = (float)view->Texture->Size.x;
 		vp[0].Height = (float)view->Texture->Size.y;
@@ -2286,12 +2279,11 @@ void ExecuteDraw(
 		vp[0].MaxDepth = 1.0f;
 
 		// TODO: read-only state should be set based on usage
-		gfx::Texture* resource = &view->Texture->GfxState;
-		TransitionResource(ec->GfxCtx, resource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		QueueTransition(ec, batch, &view->Texture->GfxState, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 	}
-	for (u32 i = 0 ; i < draw->Viewports.Count ; ++i)
+	for (u32 i = 0 ; i < cmd.Viewports.Count ; ++i)
 	{
-		Viewport* v = draw->Viewports[i];
+		Viewport* v = cmd.Viewports[i];
 		ast::Result res;
 		if (v->TopLeft.IsValid()) {
 			EvaluateExpression(ec->EvCtx, v->TopLeft, res, Float2Type, "Viewport::TopLeft");
@@ -2309,7 +2301,7 @@ void ExecuteDraw(
 			vp[i].MaxDepth = res.Value.Float2Val.y;
 		}
 	}
-	u32 vpCount = draw->DepthStencil ? 1 : 0;
+	u32 vpCount = cmd.DepthStencil ? 1 : 0;
 	vpCount = max(vpCount, rtCount);
 	D3D12_RECT sr[8] = {};
 	for (u32 i = 0 ; i < vpCount ; ++i)
@@ -2320,64 +2312,9 @@ void ExecuteDraw(
 		sr[i].bottom = (u32)(vp[i].TopLeftY + vp[i].Height);
 	}
 	cl->OMSetRenderTargets(rtCount, rtViews, false, 
-		draw->DepthStencil ? &dsView : nullptr);
+		cmd.DepthStencil ? &dsView : nullptr);
 	cl->RSSetViewports(vpCount, vp);
 	cl->RSSetScissorRects(vpCount, sr);
-	cl->IASetPrimitiveTopology(RlfToD3d_Topo(draw->Topology));
-	cl->OMSetStencilRef(draw->StencilRef);
-	if (draw->VertexBuffers.Count)
-	{
-		D3D12_VERTEX_BUFFER_VIEW vbv[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
-		for (u32 i = 0 ; i < draw->VertexBuffers.Count ; ++i)
-		{
-			Buffer* vb = draw->VertexBuffers[i];
-			TransitionResource(ec->GfxCtx, &vb->GfxState, 
-				D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-
-			vbv[i].BufferLocation = vb->GfxState.Resource->GetGPUVirtualAddress();
-			vbv[i].SizeInBytes = vb->ElementCount * vb->ElementSize;
-			vbv[i].StrideInBytes = vb->ElementSize;
-		}
-
-		cl->IASetVertexBuffers(0, draw->VertexBuffers.Count, &vbv[0]);
-	}
-	Buffer* ib = draw->IndexBuffer;
-	if (ib)
-	{
-		TransitionResource(ec->GfxCtx, &ib->GfxState, 
-			D3D12_RESOURCE_STATE_INDEX_BUFFER);
-
-		D3D12_INDEX_BUFFER_VIEW ibv = {};
-		ibv.BufferLocation = ib->GfxState.Resource->GetGPUVirtualAddress();
-		ibv.SizeInBytes = ib->ElementCount * ib->ElementSize;
-		ibv.Format = ib->ElementSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
-		cl->IASetIndexBuffer(&ibv);
-	}
-
-	if (draw->InstancedIndirectArgs)
-	{
-		TransitionResource(ec->GfxCtx, &draw->InstancedIndirectArgs->GfxState,
-			D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		cl->ExecuteIndirect(draw->GfxState.CommandSig, 1, 
-			draw->InstancedIndirectArgs->GfxState.Resource, 
-			draw->IndirectArgsOffset, nullptr, 0);
-	}
-	else if (draw->IndexedInstancedIndirectArgs)
-	{
-		TransitionResource(ec->GfxCtx, &draw->IndexedInstancedIndirectArgs->GfxState,
-			D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-		cl->ExecuteIndirect(draw->GfxState.CommandSig, 1, 
-			draw->IndexedInstancedIndirectArgs->GfxState.Resource, 
-			draw->IndirectArgsOffset, nullptr, 0);
-	}
-	else if (ib && draw->InstanceCount > 0)
-		cl->DrawIndexedInstanced(ib->ElementCount, draw->InstanceCount, 0, 0, 0);
-	else if (ib)
-		cl->DrawIndexedInstanced(ib->ElementCount, 1, 0, 0, 0);
-	else if (draw->InstanceCount > 0)
-		cl->DrawInstanced(draw->VertexCount, draw->InstanceCount, 0, 0);
-	else
-		cl->DrawInstanced(draw->VertexCount, 1, 0, 0);
 }
 
 void _Execute(
@@ -2385,79 +2322,171 @@ void _Execute(
 	RenderDescription* rd)
 {
 	gfx::Context* ctx = ec->GfxCtx;
+	ID3D12GraphicsCommandList* cl = ctx->CommandList;
 
 	EvaluateConstants(ec->EvCtx, rd->Constants);
+	EvaluateSetConstantBatches(ec->EvCtx, rd);
 
 	// Clear state so we aren't polluted by previous program drawing or previous 
 	//	execution. 
-	ctx->CommandList->ClearState(nullptr);
+	cl->ClearState(nullptr);
 	ID3D12DescriptorHeap* ShaderDescriptorHeaps[2] = {
 		ctx->CbvSrvUavHeap.Object, ctx->SamplerHeap.Object
 	};
-	ctx->CommandList->SetDescriptorHeaps(2, ShaderDescriptorHeaps);
-
+	cl->SetDescriptorHeaps(2, ShaderDescriptorHeaps);
 
-	for (Pass pass : rd->Passes)
+	// Of the pipeline set last, for indirect arguments.
+	ID3D12CommandSignature* commandSig = nullptr;
+	BarrierBatch batch = {};
+	for (Command& cmd : rd->Commands)
 	{
-		if (pass.Type == PassType::Dispatch)
+		switch (cmd.Type)
+		{
+		case CommandType::SetComputePipeline:
+			ExecuteSetComputePipeline(cmd.ComputePipeline, ec);
+			commandSig = cmd.ComputePipeline->GfxState.CommandSig;
+			break;
+		case CommandType::SetGraphicsPipeline:
+			ExecuteSetGraphicsPipeline(cmd.GraphicsPipeline, ec);
+			commandSig = cmd.GraphicsPipeline->GfxState.CommandSig;
+			break;
+		case CommandType::UpdateConstants:
+			ExecuteSetConstants(ec, cmd.Constants);
+			break;
+		case CommandType::SetConstantBuffer:
+		case CommandType::BindSampler:
+			// Already in the descriptor tables of the pipeline.
+			break;
+		case CommandType::BindSRV:
+			TransitionView(ec, batch, cmd.Slot.View, 
+				D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | 
+				D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			break;
+		case CommandType::BindUAV:
+			TransitionView(ec, batch, cmd.Slot.View, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			break;
+		case CommandType::SetRenderTargets:
+			ExecuteSetRenderTargets(cmd.Targets, ec, batch);
+			break;
+		case CommandType::SetVertexBuffers:
 		{
-			ExecuteDispatch(pass.Dispatch, ec);
+			D3D12_VERTEX_BUFFER_VIEW vbv[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+			for (u32 i = 0 ; i < cmd.VertexBuffers.Count ; ++i)
+			{
+				Buffer* vb = cmd.VertexBuffers[i];
+				QueueTransition(ec, batch, &vb->GfxState, 
+					D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+
+				vbv[i].BufferLocation = vb->GfxState.Resource->GetGPUVirtualAddress();
+				vbv[i].SizeInBytes = vb->ElementCount * vb->ElementSize;
+				vbv[i].StrideInBytes = vb->ElementSize;
+			}
+			cl->IASetVertexBuffers(0, cmd.VertexBuffers.Count, &vbv[0]);
+			break;
 		}
-		else if (pass.Type == PassType::Draw)
+		case CommandType::SetIndexBuffer:
 		{
-			ExecuteDraw(pass.Draw, ec);
+			Buffer* ib = cmd.IndexBuffer;
+			QueueTransition(ec, batch, &ib->GfxState, 
+				D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
+			D3D12_INDEX_BUFFER_VIEW ibv = {};
+			ibv.BufferLocation = ib->GfxState.Resource->GetGPUVirtualAddress();
+			ibv.SizeInBytes = ib->ElementCount * ib->ElementSize;
+			ibv.Format = ib->ElementSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+			cl->IASetIndexBuffer(&ibv);
+			break;
 		}
-		else if (pass.Type == PassType::ClearColor)
+		case CommandType::Dispatch:
 		{
-			TransitionResource(ctx, &pass.ClearColor->Target->Texture->GfxState,
+			uint3 groups = {};
+			if (cmd.Groups)
+			{
+				ast::Result res;
+				EvaluateExpression(ec->EvCtx, *cmd.Groups, res, Uint3Type, 
+					"Dispatch::Groups");
+				groups = res.Value.Uint3Val;
+			}
+			FlushBarriers(ec, batch);
+			cl->Dispatch(groups.x, groups.y, groups.z);
+			break;
+		}
+		case CommandType::DispatchThreadPerPixel:
+		{
+			Assert(ec->EvCtx.DisplaySize.x != 0 && ec->EvCtx.DisplaySize.y != 0,
+				"Invalid display size for execution");
+			uint3 tgs = cmd.ThreadGroupSize;
+			FlushBarriers(ec, batch);
+			cl->Dispatch((ec->EvCtx.DisplaySize.x - 1) / tgs.x + 1,
+				(ec->EvCtx.DisplaySize.y - 1) / tgs.y + 1, 1);
+			break;
+		}
+		case CommandType::DispatchIndirect:
+		case CommandType::DrawIndirect:
+		case CommandType::DrawIndexedIndirect:
+			QueueTransition(ec, batch, &cmd.Indirect.Args->GfxState,
+				D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+			FlushBarriers(ec, batch);
+			cl->ExecuteIndirect(commandSig, 1, cmd.Indirect.Args->GfxState.Resource, 
+				cmd.Indirect.Offset, nullptr, 0);
+			break;
+		case CommandType::Draw:
+			FlushBarriers(ec, batch);
+			cl->DrawInstanced(cmd.Draw.VertexCount, cmd.Draw.InstanceCount, 0, 0);
+			break;
+		case CommandType::DrawIndexed:
+			FlushBarriers(ec, batch);
+			cl->DrawIndexedInstanced(cmd.Draw.IndexBuffer->ElementCount, 
+				cmd.Draw.InstanceCount, 0, 0, 0);
+			break;
+		case CommandType::ClearColor:
+		{
+			QueueTransition(ec, batch, &cmd.Clear.Target->Texture->GfxState,
 				D3D12_RESOURCE_STATE_RENDER_TARGET);
-			float4& color = pass.ClearColor->Color;
+			FlushBarriers(ec, batch);
+			float4& color = cmd.Clear.Color;
 			const float clear_color[4] =
 			{
 				color.x, color.y, color.z, color.w
 			};
-			ctx->CommandList->ClearRenderTargetView(pass.ClearColor->Target->RTVGfxState, 
-				clear_color, 0, nullptr);
+			cl->ClearRenderTargetView(cmd.Clear.Target->RTVGfxState, clear_color, 
+				0, nullptr);
+			break;
 		}
-		else if (pass.Type == PassType::ClearDepth)
-		{
-			TransitionResource(ctx, &pass.ClearDepth->Target->Texture->GfxState,
+		case CommandType::ClearDepth:
+			QueueTransition(ec, batch, &cmd.Clear.Target->Texture->GfxState,
 				D3D12_RESOURCE_STATE_DEPTH_WRITE);
-			ctx->CommandList->ClearDepthStencilView(pass.ClearDepth->Target->DSVGfxState, 
-				D3D12_CLEAR_FLAG_DEPTH, pass.ClearDepth->Depth, 0, 0, nullptr);
-		}
-		else if (pass.Type == PassType::ClearStencil)
-		{
-			TransitionResource(ctx, &pass.ClearStencil->Target->Texture->GfxState,
+			FlushBarriers(ec, batch);
+			cl->ClearDepthStencilView(cmd.Clear.Target->DSVGfxState, 
+				D3D12_CLEAR_FLAG_DEPTH, cmd.Clear.Depth, 0, 0, nullptr);
+			break;
+		case CommandType::ClearStencil:
+			QueueTransition(ec, batch, &cmd.Clear.Target->Texture->GfxState,
 				D3D12_RESOURCE_STATE_DEPTH_WRITE);
-			ctx->CommandList->ClearDepthStencilView(pass.ClearStencil->Target->DSVGfxState, 
-				D3D12_CLEAR_FLAG_STENCIL, 0.f, pass.ClearStencil->Stencil, 0, nullptr);
-		}
-		else if (pass.Type == PassType::Resolve)
-		{
-			TransitionResource(ctx, &pass.Resolve->Src->GfxState,
+			FlushBarriers(ec, batch);
+			cl->ClearDepthStencilView(cmd.Clear.Target->DSVGfxState, 
+				D3D12_CLEAR_FLAG_STENCIL, 0.f, cmd.Clear.Stencil, 0, nullptr);
+			break;
+		case CommandType::Resolve:
+			QueueTransition(ec, batch, &cmd.Resolve.Src->GfxState,
 				D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
-			TransitionResource(ctx, &pass.Resolve->Dst->GfxState,
+			QueueTransition(ec, batch, &cmd.Resolve.Dst->GfxState,
 				D3D12_RESOURCE_STATE_RESOLVE_DEST);
-			ctx->CommandList->ResolveSubresource(pass.Resolve->Dst->GfxState.Resource, 0, 
-				pass.Resolve->Src->GfxState.Resource, 0, 
-				D3DTextureFormat[(u32)pass.Resolve->Dst->Format]);
-		}
-		else if (pass.Type == PassType::ObjDraw)
-		{
-			for (Draw* draw : pass.ObjDraw->PerMeshDraws)
-			{
-				ExecuteDraw(draw, ec);
-			}
-		}
-		else
-		{
+			FlushBarriers(ec, batch);
+			cl->ResolveSubresource(cmd.Resolve.Dst->GfxState.Resource, 0, 
+				cmd.Resolve.Src->GfxState.Resource, 0, 
+				D3DTextureFormat[(u32)cmd.Resolve.Dst->Format]);
+			break;
+		case CommandType::EndPass:
+			// Clear state after execution so we don't pollute the rest of program 
+			//	drawing. 
+			FlushBarriers(ec, batch);
+			cl->ClearState(nullptr);
+			cl->SetDescriptorHeaps(2, ShaderDescriptorHeaps);
+			break;
+		default:
 			Unimplemented();
 		}
-
-		// Clear state after execution so we don't pollute the rest of program drawing. 
-		ctx->CommandList->ClearState(nullptr);
-		ctx->CommandList->SetDescriptorHeaps(2, ShaderDescriptorHeaps);
 	}
 }
 
@@ -0,0 +1,18 @@
+
+namespace rlf
+{
+
+// Shared by the D3D backends, the rest of rlf doesn't know about DXGI or
+//	DirectXTex.
+
+#define RLF_TEXTUREFORMAT_ENTRY(name) DXGI_FORMAT_##name,
+static DXGI_FORMAT D3DTextureFormat[] = {
+	DXGI_FORMAT_UNKNOWN,
+	RLF_TEXTUREFORMAT_TUPLE
+};
+#undef RLF_TEXTUREFORMAT_ENTRY
+
+void GenerateTextureResource(const char* texMem, u32 memSize, const char* ext, 
+	DirectX::ScratchImage* out);
+
+} // namespace rlf
@@ -0,0 +1,758 @@
+// SSE2 is part of the x64 baseline, AVX2 is only used when the compiler has
+//	been told it can assume it (/arch:AVX2, -mavx2).
+#if defined(__AVX2__)
+	#define RLF_LEXER_AVX2 1
+#else
+	#define RLF_LEXER_AVX2 0
+#endif
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define RLF_LEXER_SSE2 1
+#else
+	#define RLF_LEXER_SSE2 0
+#endif
+
+namespace rlf
+{
+
+void TokenizerError(const char* loc, const char* str, ...)
+{
+	char buf[512];
+	va_list ptr;
+	va_start(ptr,str);
+	vsprintf_s(buf,512,str,ptr);
+	va_end(ptr);
+
+	ErrorInfo pe = {};
+	pe.Location = loc;
+	pe.Message = buf;
+
+	throw pe;
+}
+
+#define TokenizerAssert(expression, loc, message, ...) 	\
+do {													\
+	if (!(expression)) {								\
+		TokenizerError(loc, message, ##__VA_ARGS__);	\
+	}													\
+} while (0);											\
+
+// ----- INTERNING -----
+u32 HashRange(const char* str, u32 len)
+{
+	u32 h = 5381;
+	unsigned const char* us = (unsigned const char *) str;
+	for (u32 i = 0 ; i < len ; ++i)
+		h = ((h << 5) + h) + us[i];
+	return h;
+}
+
+void InternTableInit(InternTable& it, alloc::LinAlloc* alloc)
+{
+	it.Alloc = alloc;
+	it.SlotCount = 1024;
+	it.Slots = (u32*)alloc::Allocate(alloc, it.SlotCount * sizeof(u32));
+	memset(it.Slots, 0, it.SlotCount * sizeof(u32));
+	it.EntryCount = 0;
+	it.EntryCapacity = it.SlotCount / 2;
+	it.Entries = (InternEntry*)alloc::Allocate(alloc,
+		it.EntryCapacity * sizeof(InternEntry));
+}
+
+void InternTableGrow(InternTable& it)
+{
+	// Old arrays are left behind in the arena, the growth is geometric so the
+	//	waste is bounded by the final size.
+	u32 slotCount = it.SlotCount * 2;
+	u32* slots = (u32*)alloc::Allocate(it.Alloc, slotCount * sizeof(u32));
+	memset(slots, 0, slotCount * sizeof(u32));
+	for (u32 i = 0 ; i < it.EntryCount ; ++i)
+	{
+		u32 slot = it.Entries[i].Hash & (slotCount - 1);
+		while (slots[slot] != 0)
+			slot = (slot + 1) & (slotCount - 1);
+		slots[slot] = i + 1;
+	}
+	InternEntry* entries = (InternEntry*)alloc::Allocate(it.Alloc,
+		slotCount / 2 * sizeof(InternEntry));
+	memcpy(entries, it.Entries, it.EntryCount * sizeof(InternEntry));
+
+	it.Slots = slots;
+	it.SlotCount = slotCount;
+	it.Entries = entries;
+	it.EntryCapacity = slotCount / 2;
+}
+
+u32 Intern(InternTable& it, const char* str, u32 len)
+{
+	u32 hash = HashRange(str, len);
+	u32 mask = it.SlotCount - 1;
+	u32 slot = hash & mask;
+	while (it.Slots[slot] != 0)
+	{
+		InternEntry& entry = it.Entries[it.Slots[slot] - 1];
+		if (entry.Hash == hash && entry.Length == len &&
+			memcmp(entry.String, str, len) == 0)
+		{
+			return it.Slots[slot] - 1;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	if (it.EntryCount == it.EntryCapacity)
+	{
+		InternTableGrow(it);
+		return Intern(it, str, len);
+	}
+
+	char* copy = (char*)alloc::Allocate(it.Alloc, len + 1, 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+
+	u32 id = it.EntryCount++;
+	InternEntry& entry = it.Entries[id];
+	entry.Hash = hash;
+	entry.Length = len;
+	entry.String = copy;
+	entry.Persistent = nullptr;
+	it.Slots[slot] = id + 1;
+	return id;
+}
+
+// ----- CHARACTER CLASSES -----
+// Each class tests a single char, and a full vector at a time where SIMD is
+//	available. The vector variants return a byte mask with 0xff in every lane
+//	that is in the class.
+u32 CountTrailingZeros(u32 v)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, v);
+	return index;
+#else
+	return __builtin_ctz(v);
+#endif
+}
+
+bool InRange(char c, char lo, char hi)
+{
+	return (u8)(c - lo) <= (u8)(hi - lo);
+}
+
+#if RLF_LEXER_SSE2
+__m128i InRange(__m128i c, char lo, char hi)
+{
+	__m128i t = _mm_sub_epi8(c, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8((char)(hi - lo))), t);
+}
+#endif
+#if RLF_LEXER_AVX2
+__m256i InRange(__m256i c, char lo, char hi)
+{
+	__m256i t = _mm256_sub_epi8(c, _mm256_set1_epi8(lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8((char)(hi - lo))), t);
+}
+#endif
+
+struct SpaceClass
+{
+	// Matches isspace in the C locale: ' ' and '\t' through '\r'
+	bool Test(char c) const { return c == ' ' || InRange(c, '\t', '\r'); }
+#if RLF_LEXER_SSE2
+	__m128i Test(__m128i c) const {
+		return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+			InRange(c, '\t', '\r'));
+	}
+#endif
+#if RLF_LEXER_AVX2
+	__m256i Test(__m256i c) const {
+		return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+			InRange(c, '\t', '\r'));
+	}
+#endif
+};
+
+struct IdentifierClass
+{
+	// Letters are folded to lower case by setting bit 5, which maps nothing
+	//	else into 'a'-'z'.
+	bool Test(char c) const {
+		return InRange((char)(c | 0x20), 'a', 'z') || InRange(c, '0', '9') || c == '_';
+	}
+#if RLF_LEXER_SSE2
+	__m128i Test(__m128i c) const {
+		__m128i alpha = InRange(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+		__m128i digit = InRange(c, '0', '9');
+		__m128i under = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+		return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+	}
+#endif
+#if RLF_LEXER_AVX2
+	__m256i Test(__m256i c) const {
+		__m256i alpha = InRange(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+		__m256i digit = InRange(c, '0', '9');
+		__m256i under = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+		return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+	}
+#endif
+};
+
+struct DigitClass
+{
+	bool Test(char c) const { return InRange(c, '0', '9'); }
+#if RLF_LEXER_SSE2
+	__m128i Test(__m128i c) const { return InRange(c, '0', '9'); }
+#endif
+#if RLF_LEXER_AVX2
+	__m256i Test(__m256i c) const { return InRange(c, '0', '9'); }
+#endif
+};
+
+struct NotCharClass
+{
+	char C;
+	bool Test(char c) const { return c != C; }
+#if RLF_LEXER_SSE2
+	__m128i Test(__m128i c) const {
+		return _mm_andnot_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(C)),
+			_mm_set1_epi8(-1));
+	}
+#endif
+#if RLF_LEXER_AVX2
+	__m256i Test(__m256i c) const {
+		return _mm256_andnot_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(C)),
+			_mm256_set1_epi8(-1));
+	}
+#endif
+};
+
+template <typename Class>
+const char* ScanWhile(const char* next, const char* end, Class cls)
+{
+	// Most runs between tokens are empty, don't pay for a vector load then.
+	if (next < end && !cls.Test(*next))
+		return next;
+#if RLF_LEXER_AVX2
+	while (end - next >= 32)
+	{
+		__m256i c = _mm256_loadu_si256((const __m256i*)next);
+		u32 outside = ~(u32)_mm256_movemask_epi8(cls.Test(c));
+		if (outside != 0)
+			return next + CountTrailingZeros(outside);
+		next += 32;
+	}
+#endif
+#if RLF_LEXER_SSE2
+	while (end - next >= 16)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i*)next);
+		u32 outside = ~(u32)_mm_movemask_epi8(cls.Test(c)) & 0xffff;
+		if (outside != 0)
+			return next + CountTrailingZeros(outside);
+		next += 16;
+	}
+#endif
+	while (next < end && cls.Test(*next))
+		++next;
+	return next;
+}
+
+// ----- SCANNING -----
+const char* SkipWhitespace(const char* next, const char* end)
+{
+	for (;;)
+	{
+		next = ScanWhile(next, end, SpaceClass());
+		if (next + 1 < end && next[0] == '/')
+		{
+			if (next[1] == '/')
+			{
+				next = FindChar(next + 2, end, '\n');
+				continue;
+			}
+			else if (next[1] == '*')
+			{
+				const char* commentStart = next;
+				next += 2;
+				for (;;)
+				{
+					next = FindChar(next, end, '*');
+					TokenizerAssert(next + 1 < end, commentStart,
+						"Closing of comment block was not found before end of file");
+					if (next[1] == '/')
+						break;
+					++next;
+				}
+				next += 2;
+				continue;
+			}
+		}
+		return next;
+	}
+}
+
+const char* ScanIdentifier(const char* next, const char* end)
+{
+	return ScanWhile(next, end, IdentifierClass());
+}
+
+const char* ScanDigits(const char* next, const char* end)
+{
+	return ScanWhile(next, end, DigitClass());
+}
+
+const char* FindChar(const char* next, const char* end, char c)
+{
+	NotCharClass cls;
+	cls.C = c;
+	return ScanWhile(next, end, cls);
+}
+
+// ----- NUMBERS -----
+// Integers are decimal, 0x hex or 0b binary and have to fit in 32 bits. Floats
+//	are decimal with a fraction and/or an exponent (1.5, 2., 1e-3, 2.5E+4). The
+//	HLSL suffixes are accepted on both (u/l on integers, f/h/l on floats).
+//	Floats are converted with a single rounding, giving the same double as
+//	strtod: the common short literals are handled by Clinger's fast path, and
+//	anything it can't do exactly is handed to strtod itself.
+const u32 MaxMantissaDigits = 19; // any 19 digit decimal fits in a u64
+
+const double ExactPowersOfTen[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+u32 DigitValue(char c)
+{
+	if (InRange(c, '0', '9'))
+		return c - '0';
+	c = (char)(c | 0x20);
+	if (InRange(c, 'a', 'f'))
+		return c - 'a' + 10;
+	return 16;
+}
+
+// Appends a run of decimal digits to mantissa. Past MaxMantissaDigits the
+//	mantissa wraps, callers count the digits and take the slow path then.
+const char* AccumulateDigits(const char* next, const char* end, u64& mantissa)
+{
+	u64 m = mantissa;
+	for ( ; next < end && InRange(*next, '0', '9') ; ++next)
+		m = m * 10 + (*next - '0');
+	mantissa = m;
+	return next;
+}
+
+// /fp:fast would allow the division to become a multiply by an inexact
+//	reciprocal, which breaks the single rounding the fast path relies on.
+#pragma float_control(precise, on, push)
+bool FastPathToDouble(u64 mantissa, i32 exp10, double& out)
+{
+	const u64 MaxExactMantissa = 1ull << 53;
+	if (mantissa > MaxExactMantissa || exp10 < -22)
+		return false;
+	if (exp10 < 0)
+	{
+		out = (double)mantissa / ExactPowersOfTen[-exp10];
+		return true;
+	}
+	// Exponents past the table can still be exact if the extra powers of ten
+	//	fit into the mantissa, e.g. 1e30 = 1e8 * 1e22.
+	for ( ; exp10 > 22 ; --exp10)
+	{
+		mantissa *= 10;
+		if (mantissa > MaxExactMantissa)
+			return false;
+	}
+	out = (double)mantissa * ExactPowersOfTen[exp10];
+	return true;
+}
+#pragma float_control(pop)
+
+double StringToDouble(const char* start, const char* end)
+{
+	// strtod needs a terminated string, and the literal can sit right at the
+	//	end of the buffer, so copy it out.
+	size_t len = end - start;
+	char buf[128];
+	if (len < sizeof(buf))
+	{
+		memcpy(buf, start, len);
+		buf[len] = '\0';
+		return strtod(buf, nullptr);
+	}
+	std::string copy(start, len);
+	return strtod(copy.c_str(), nullptr);
+}
+
+const char* ScanNumber(const char* next, const char* end, Token& token)
+{
+	const char* start = next;
+	token.Type = TokenType::IntegerLiteral;
+
+	u32 radix = 10;
+	if (end - next >= 2 && next[0] == '0')
+	{
+		char prefix = (char)(next[1] | 0x20);
+		radix = (prefix == 'x') ? 16 : (prefix == 'b') ? 2 : 10;
+	}
+	if (radix != 10)
+	{
+		next += 2;
+		const char* digitsStart = next;
+		u64 val = 0;
+		for ( ; next < end ; ++next)
+		{
+			u32 digit = DigitValue(*next);
+			if (digit >= radix)
+				break;
+			val = val * radix + digit;
+			TokenizerAssert(val <= UINT_MAX, start,
+				"Integer literal does not fit in 32 bits");
+		}
+		TokenizerAssert(next > digitsStart, start,
+			"Expected digits after %.2s prefix", start);
+		token.IntegerLiteral = (u32)val;
+		if (next < end && (*next == 'u' || *next == 'U' || *next == 'l' || *next == 'L'))
+			++next;
+		return next;
+	}
+
+	u64 mantissa = 0;
+	bool isFloat = false;
+	i32 exp10 = 0;
+	const char* digitsStart = next;
+	next = AccumulateDigits(next, end, mantissa);
+	size_t digitCount = next - digitsStart;
+
+	if (next < end && *next == '.')
+	{
+		isFloat = true;
+		const char* fractionStart = ++next;
+		next = AccumulateDigits(next, end, mantissa);
+		exp10 = -(i32)(next - fractionStart);
+		digitCount += next - fractionStart;
+	}
+	bool truncated = digitCount > MaxMantissaDigits;
+
+	// Only take the 'e' if an exponent actually follows, so that something
+	//	like 2em still lexes as an integer and an identifier.
+	if (next < end && (char)(*next | 0x20) == 'e')
+	{
+		const char* exp = next + 1;
+		bool negative = false;
+		if (exp < end && (*exp == '+' || *exp == '-'))
+		{
+			negative = (*exp == '-');
+			++exp;
+		}
+		if (exp < end && InRange(*exp, '0', '9'))
+		{
+			isFloat = true;
+			i32 expVal = 0;
+			for ( ; exp < end && InRange(*exp, '0', '9') ; ++exp)
+			{
+				// Anything this large is an overflow or zero either way.
+				if (expVal < 100000)
+					expVal = expVal * 10 + (*exp - '0');
+			}
+			exp10 += negative ? -expVal : expVal;
+			next = exp;
+		}
+	}
+
+	if (!isFloat)
+	{
+		TokenizerAssert(!truncated && mantissa <= UINT_MAX, start,
+			"Integer literal does not fit in 32 bits");
+		token.IntegerLiteral = (u32)mantissa;
+		if (next < end && (*next == 'u' || *next == 'U' || *next == 'l' || *next == 'L'))
+			++next;
+		return next;
+	}
+
+	token.Type = TokenType::FloatLiteral;
+	if (mantissa == 0 && !truncated)
+		token.FloatLiteral = 0.0;
+	else if (truncated || !FastPathToDouble(mantissa, exp10, token.FloatLiteral))
+		token.FloatLiteral = StringToDouble(start, next);
+	if (next < end && (*next == 'f' || *next == 'F' || *next == 'h' || *next == 'H' ||
+		*next == 'l' || *next == 'L'))
+	{
+		++next;
+	}
+	return next;
+}
+
+// ----- TOKENIZER -----
+void TokenizerStateInit(TokenizerState& ts)
+{
+	ts.tokens.clear();
+	ts.alloc = {};
+	alloc::Init(&ts.alloc);
+	InternTableInit(ts.strings, &ts.alloc);
+
+	TokenType* fcLUT = ts.fcLUT;
+	for (u32 fc = 0 ; fc < 256 ; ++fc)
+		fcLUT[fc] = TokenType::Invalid;
+	fcLUT['('] = TokenType::LParen;
+	fcLUT[')'] = TokenType::RParen;
+	fcLUT['{'] = TokenType::LBrace;
+	fcLUT['}'] = TokenType::RBrace;
+	fcLUT['['] = TokenType::LBracket;
+	fcLUT[']'] = TokenType::RBracket;
+	fcLUT[','] = TokenType::Comma;
+	fcLUT['='] = TokenType::Equals;
+	fcLUT['+'] = TokenType::Plus;
+	fcLUT['-'] = TokenType::Minus;
+	fcLUT[';'] = TokenType::Semicolon;
+	fcLUT['.'] = TokenType::Period;
+	fcLUT['/'] = TokenType::ForwardSlash;
+	fcLUT['*'] = TokenType::Asterisk;
+	fcLUT['"'] = TokenType::String;
+	for (u32 fc = 0 ; fc < 128 ; ++fc)
+	{
+		if (isalpha(fc))
+			fcLUT[fc] = TokenType::Identifier;
+		else if (isdigit(fc))
+			fcLUT[fc] = TokenType::IntegerLiteral;
+	}
+	fcLUT['_'] = TokenType::Identifier;
+}
+
+void TokenizerStateRelease(TokenizerState& ts)
+{
+	alloc::FreeAll(&ts.alloc);
+}
+
+const char* LexToken(const char* next, const char* end, TokenizerState& ts)
+{
+	char firstChar = *next;
+
+	TokenType tok = ts.fcLUT[(u8)firstChar];
+
+	Token token;
+	token.Location = next;
+
+	switch (tok)
+	{
+	case TokenType::LParen:
+	case TokenType::RParen:
+	case TokenType::LBrace:
+	case TokenType::RBrace:
+	case TokenType::LBracket:
+	case TokenType::RBracket:
+	case TokenType::LessThan:
+	case TokenType::GreaterThan:
+	case TokenType::Comma:
+	case TokenType::Equals:
+	case TokenType::Plus:
+	case TokenType::Minus:
+	case TokenType::Colon:
+	case TokenType::Semicolon:
+	case TokenType::At:
+	case TokenType::Period:
+	case TokenType::ForwardSlash:
+	case TokenType::Asterisk:
+	case TokenType::HashMark:
+	case TokenType::Percent:
+		++next;
+		break;
+	case TokenType::IntegerLiteral:
+		next = ScanNumber(next, end, token);
+		tok = token.Type;
+		break;
+	case TokenType::Identifier:
+	{
+		// identifiers have to start with a letter, but can contain numbers
+		const char* id_begin = next;
+		const char* id_end = ScanIdentifier(next, end);
+		next = id_end;
+		token.Id = Intern(ts.strings, id_begin, (u32)(id_end - id_begin));
+		token.String = ts.strings.Entries[token.Id].String;
+		break;
+	}
+	case TokenType::String:
+	{
+		++next; // skip over opening quotes
+		const char* str_begin = next;
+		next = FindChar(next, end, '"');
+		TokenizerAssert(next < end, next, "End-of-buffer before closing parenthesis.");
+		const char* str_end = next;
+		++next; // pass the closing quotes
+		token.Id = Intern(ts.strings, str_begin, (u32)(str_end - str_begin));
+		token.String = ts.strings.Entries[token.Id].String;
+		break;
+	}
+	case TokenType::Invalid:
+	default:
+		TokenizerError(next, "unexpected character when parsing token: %c", firstChar);
+		break;
+	}
+
+	token.Type = tok;
+	ts.tokens.push_back(token);
+
+	return SkipWhitespace(next, end);
+}
+
+void Tokenize(const char* start, const char* end, TokenizerState& ts)
+{
+	const char* next = SkipWhitespace(start, end);
+	while (next < end)
+		next = LexToken(next, end, ts);
+	Assert(next == end, "Internal inconsistency, passed the end of the buffer");
+}
+
+// ----- RETOKENIZING -----
+// Past the end of a token the lexer looks at no more than this many bytes
+//	(the 'e', sign and first digit of a number's exponent).
+const size_t MaxLookahead = 3;
+
+size_t CommonPrefix(const char* a, const char* b, size_t size)
+{
+	const size_t BlockSize = 64;
+	size_t n = 0;
+	while (n + BlockSize <= size && memcmp(a + n, b + n, BlockSize) == 0)
+		n += BlockSize;
+	while (n < size && a[n] == b[n])
+		++n;
+	return n;
+}
+
+size_t CommonSuffix(const char* aEnd, const char* bEnd, size_t size)
+{
+	const size_t BlockSize = 64;
+	size_t n = 0;
+	while (n + BlockSize <= size &&
+		memcmp(aEnd - n - BlockSize, bEnd - n - BlockSize, BlockSize) == 0)
+	{
+		n += BlockSize;
+	}
+	while (n < size && aEnd[-1 - (ptrdiff_t)n] == bEnd[-1 - (ptrdiff_t)n])
+		++n;
+	return n;
+}
+
+// Returns the index of the first token at or after offset.
+size_t LowerBoundToken(const std::vector<Token>& tokens, const char* base,
+	size_t offset)
+{
+	size_t lo = 0;
+	size_t hi = tokens.size();
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if ((size_t)(tokens[mid].Location - base) < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void Retokenize(const char* oldStart, const char* oldEnd, const char* start,
+	const char* end, TokenizerState& ts)
+{
+	size_t oldSize = oldEnd - oldStart;
+	size_t newSize = end - start;
+	size_t maxCommon = min(oldSize, newSize);
+	size_t prefix = CommonPrefix(oldStart, start, maxCommon);
+	size_t suffix = CommonSuffix(oldEnd, end, maxCommon - prefix);
+
+	std::vector<Token> old;
+	old.swap(ts.tokens);
+	ts.tokens.reserve(old.size());
+
+	// Lexing is stateless at the start of a token, and nothing past a token's
+	//	end is looked at beyond MaxLookahead bytes. Every token which is followed
+	//	by one starting at least that far ahead of the first change comes out
+	//	the same, lexing resumes at the last token which starts that early.
+	size_t keep = LowerBoundToken(old, oldStart, prefix + 1 > MaxLookahead ?
+		prefix + 1 - MaxLookahead : 0);
+	if (keep > 0)
+		--keep;
+	for (size_t i = 0 ; i < keep ; ++i)
+	{
+		Token token = old[i];
+		token.Location = start + (token.Location - oldStart);
+		ts.tokens.push_back(token);
+	}
+	const char* next = (keep > 0) ? start + (old[keep].Location - oldStart) :
+		SkipWhitespace(start, end);
+
+	// Once the new stream reaches the start of an old token inside the
+	//	unchanged suffix, everything from there on is the same as before.
+	ptrdiff_t shift = (ptrdiff_t)newSize - (ptrdiff_t)oldSize;
+	size_t suffixStart = newSize - suffix;
+	size_t sync = LowerBoundToken(old, oldStart, oldSize - suffix);
+	while (next < end)
+	{
+		size_t offset = next - start;
+		if (offset >= suffixStart)
+		{
+			size_t oldOffset = (size_t)((ptrdiff_t)offset - shift);
+			while (sync < old.size() && (size_t)(old[sync].Location - oldStart) < oldOffset)
+				++sync;
+			if (sync < old.size() && (size_t)(old[sync].Location - oldStart) == oldOffset)
+				break;
+		}
+		next = LexToken(next, end, ts);
+	}
+	if (next < end)
+	{
+		for (size_t i = sync ; i < old.size() ; ++i)
+		{
+			Token token = old[i];
+			token.Location = start + (token.Location - oldStart) + shift;
+			ts.tokens.push_back(token);
+		}
+	}
+	else
+		Assert(next == end, "Internal inconsistency, passed the end of the buffer");
+}
+
+// ----- COMPACTING -----
+// Retokenizing keeps adding the strings of edited tokens to the intern table,
+//	and never takes out the ones which no token uses anymore. Once those are
+//	the majority the live strings are interned again into a fresh arena, so a
+//	long editing session doesn't grow the table without bound.
+void CompactStrings(TokenizerState& ts)
+{
+	std::vector<bool> live(ts.strings.EntryCount, false);
+	u32 liveCount = 0;
+	for (const Token& token : ts.tokens)
+	{
+		if ((token.Type == TokenType::Identifier || token.Type == TokenType::String) &&
+			!live[token.Id])
+		{
+			live[token.Id] = true;
+			++liveCount;
+		}
+	}
+	if (liveCount * 2 >= ts.strings.EntryCount)
+		return;
+
+	alloc::LinAlloc old = ts.alloc;
+	InternTable oldStrings = ts.strings;
+	ts.alloc = {};
+	alloc::Init(&ts.alloc);
+	InternTableInit(ts.strings, &ts.alloc);
+	for (Token& token : ts.tokens)
+	{
+		if (token.Type != TokenType::Identifier && token.Type != TokenType::String)
+			continue;
+		const InternEntry& entry = oldStrings.Entries[token.Id];
+		token.Id = Intern(ts.strings, entry.String, entry.Length);
+		token.String = ts.strings.Entries[token.Id].String;
+	}
+	Assert(ts.strings.EntryCount == liveCount, "Internal inconsistency, lost a string");
+	alloc::FreeAll(&old);
+}
+
+#undef TokenizerAssert
+
+} // namespace rlf
+
+#undef RLF_LEXER_AVX2
+#undef RLF_LEXER_SSE2
@@ -0,0 +1,123 @@
+namespace rlf
+{
+
+// Token set shared by the RLF and shader parsers. Each parser enables the
+//	punctuation it understands in its TokenizerState, anything else is reported
+//	as an unexpected character.
+#define RLF_TOKEN_TUPLE \
+	RLF_TOKEN_ENTRY(Invalid) \
+	RLF_TOKEN_ENTRY(LParen) \
+	RLF_TOKEN_ENTRY(RParen) \
+	RLF_TOKEN_ENTRY(LBrace) \
+	RLF_TOKEN_ENTRY(RBrace) \
+	RLF_TOKEN_ENTRY(LBracket) \
+	RLF_TOKEN_ENTRY(RBracket) \
+	RLF_TOKEN_ENTRY(LessThan) \
+	RLF_TOKEN_ENTRY(GreaterThan) \
+	RLF_TOKEN_ENTRY(Comma) \
+	RLF_TOKEN_ENTRY(Equals) \
+	RLF_TOKEN_ENTRY(Plus) \
+	RLF_TOKEN_ENTRY(Minus) \
+	RLF_TOKEN_ENTRY(Colon) \
+	RLF_TOKEN_ENTRY(Semicolon) \
+	RLF_TOKEN_ENTRY(At) \
+	RLF_TOKEN_ENTRY(Period) \
+	RLF_TOKEN_ENTRY(ForwardSlash) \
+	RLF_TOKEN_ENTRY(Asterisk) \
+	RLF_TOKEN_ENTRY(HashMark) \
+	RLF_TOKEN_ENTRY(Percent) \
+	RLF_TOKEN_ENTRY(IntegerLiteral) \
+	RLF_TOKEN_ENTRY(FloatLiteral) \
+	RLF_TOKEN_ENTRY(Identifier) \
+	RLF_TOKEN_ENTRY(String) \
+
+#define RLF_TOKEN_ENTRY(name) name,
+enum class TokenType
+{
+	RLF_TOKEN_TUPLE
+};
+#undef RLF_TOKEN_ENTRY
+
+#define RLF_TOKEN_ENTRY(name) #name,
+const char* TokenNames[] =
+{
+	RLF_TOKEN_TUPLE
+};
+#undef RLF_TOKEN_ENTRY
+
+#undef RLF_TOKEN_TUPLE
+
+struct Token
+{
+	TokenType Type;
+	u32 Id; // intern id, only valid for Identifier and String tokens
+	const char* Location;
+	union {
+		const char* String;
+		double FloatLiteral;
+		u32 IntegerLiteral;
+	};
+};
+
+// Identifier and string tokens are interned so that each distinct string is
+//	copied out of the source buffer exactly once, into the tokenizer's scratch
+//	arena. Tokens only carry the id of their entry. Strings which need to
+//	outlive parsing are copied again into the RenderDescription's arena on
+//	demand, and that copy is remembered on the entry so it is only made once.
+struct InternEntry {
+	u32 Hash;
+	u32 Length;
+	const char* String;
+	const char* Persistent;
+};
+
+struct InternTable {
+	u32* Slots; // entry id + 1, zero marks an empty slot
+	u32 SlotCount;
+	InternEntry* Entries;
+	u32 EntryCount;
+	u32 EntryCapacity;
+	alloc::LinAlloc* Alloc;
+};
+
+struct TokenizerState {
+	std::vector<Token> tokens;
+	InternTable strings;
+	alloc::LinAlloc alloc;
+	TokenType fcLUT[256];
+};
+
+u32 Intern(InternTable& it, const char* str, u32 len);
+
+void TokenizerStateInit(TokenizerState& ts);
+void TokenizerStateRelease(TokenizerState& ts);
+
+// Character scanning, each returns the first position at or after next which
+//	does not belong to the scanned run (or end).
+const char* SkipWhitespace(const char* next, const char* end);
+const char* ScanIdentifier(const char* next, const char* end);
+const char* ScanDigits(const char* next, const char* end);
+const char* FindChar(const char* next, const char* end, char c);
+
+// Scans an integer or float literal starting at next into token, setting its
+//	type and value.
+const char* ScanNumber(const char* next, const char* end, Token& token);
+
+// Lexes the token at next and the whitespace after it, returning the start of
+//	the following token.
+const char* LexToken(const char* next, const char* end, TokenizerState& ts);
+
+void Tokenize(const char* start, const char* end, TokenizerState& ts);
+
+// Brings ts.tokens, lexed from the buffer [oldStart, oldEnd), up to date with
+//	the edited buffer [start, end). Only the span between the common prefix and
+//	suffix of the two buffers is lexed again, tokens on either side of it are
+//	kept and moved over to the new buffer.
+void Retokenize(const char* oldStart, const char* oldEnd, const char* start,
+	const char* end, TokenizerState& ts);
+
+// Drops the interned strings which no token in ts.tokens refers to anymore,
+//	when they make up most of the table. Token ids change when it does.
+void CompactStrings(TokenizerState& ts);
+
+} // namespace rlf
@@ -0,0 +1,177 @@
+
+namespace rlf
+{
+
+// A backend without a device, for running the rlf core where there's no D3D.
+//	Nothing is created and there are no shaders to reflect, so what reflection
+//	would say is made up: constant buffers hold the SetConstants one after
+//	another in the order they're set, and binds take slots in their order.
+//	Execute records the commands to the context's log, see RecordCommands.
+
+// -----------------------------------------------------------------------------
+// ------------------------------ INITIALIZATION -------------------------------
+// -----------------------------------------------------------------------------
+void PrepareConstants(
+	RenderDescription* rd,
+	ast::EvaluationContext& ec,
+	Array<ConstantBuffer>& cbs,
+	Array<SetConstant>& sets,
+	const char* name,
+	u32 slot)
+{
+	cbs = {};
+	if (sets.Count == 0)
+		return;
+	ConstantBuffer* cb = alloc::Allocate<ConstantBuffer>(&rd->Alloc);
+	*cb = {};
+	strcpy(cb->Name, name);
+	cb->Slot = slot;
+	for (SetConstant& set : sets)
+	{
+		ast::Result res;
+		EvaluateExpression(ec, set.Value, res);
+		set.Value.CacheValid = false;
+		set.Type = res.Type;
+		set.Size = set.Type.Dim * 4;
+		set.Offset = cb->Size;
+		set.CB = cb;
+		cb->Size += set.Size;
+	}
+	cb->Size = max((cb->Size + 15) & ~15u, 16u);
+	cb->BackingMemory = (u8*)alloc::Allocate(&rd->ConstantPool, cb->Size);
+	memset(cb->BackingMemory, 0, cb->Size);
+	cbs = { 1, cb };
+}
+
+// Without reflection to say which views are written, Auto views are UAVs when
+//	their target is named like one.
+void PrepareBinds(Array<Bind>& binds)
+{
+	u32 slot = 0;
+	for (Bind& bind : binds)
+	{
+		bind.BindIndex = slot++;
+		if (bind.Type != BindType::View)
+			continue;
+		if (bind.ViewBind->Type == ViewType::Auto)
+		{
+			bool output = strstr(bind.BindTarget, "Out") || strstr(bind.BindTarget, "out") ||
+				strstr(bind.BindTarget, "RW");
+			bind.ViewBind->Type = output ? ViewType::UAV : ViewType::SRV;
+		}
+		bind.IsOutput = bind.ViewBind->Type == ViewType::UAV;
+	}
+}
+
+void EvaluateResourceSizes(
+	RenderDescription* rd,
+	ast::EvaluationContext& ec,
+	bool onlyChanged)
+{
+	for (Texture* tex : rd->Textures)
+	{
+		if (!tex->SizeExpr.IsValid())
+			continue;
+		if (onlyChanged && !DependsOnChanges(tex->SizeExpr, ec))
+			continue;
+		ast::Result res;
+		EvaluateExpression(ec, tex->SizeExpr, res, Uint2Type, "Texture::Size");
+		tex->Size = res.Value.Uint2Val;
+	}
+	for (Buffer* buf : rd->Buffers)
+	{
+		ast::Result res;
+		if (buf->ElementCountExpr.IsValid() &&
+			(!onlyChanged || DependsOnChanges(buf->ElementCountExpr, ec)))
+		{
+			EvaluateExpression(ec, buf->ElementCountExpr, res, UintType, "Buffer::ElementCount");
+			buf->ElementCount = res.Value.UintVal;
+		}
+		if (buf->ElementSizeExpr.IsValid() &&
+			(!onlyChanged || DependsOnChanges(buf->ElementSizeExpr, ec)))
+		{
+			EvaluateExpression(ec, buf->ElementSizeExpr, res, UintType, "Buffer::ElementSize");
+			buf->ElementSize = res.Value.UintVal;
+		}
+	}
+}
+
+void InitMain(
+	gfx::Context* ctx,
+	RenderDescription* rd,
+	uint2 displaySize,
+	const char*,
+	ErrorState*)
+{
+	ctx->Log.clear();
+
+	ast::EvaluationContext evCtx = {};
+	evCtx.DisplaySize = displaySize;
+
+	// Size expressions may depend on constants so we need to evaluate them first
+	EvaluateConstants(evCtx, rd->Constants);
+	EvaluateResourceSizes(rd, evCtx, false);
+
+	for (ComputeShader* cs : rd->CShaders)
+	{
+		if (cs->ThreadGroupSize.x == 0)
+			cs->ThreadGroupSize = { 8, 8, 1 };
+	}
+	for (Dispatch* dc : rd->Dispatches)
+	{
+		PrepareConstants(rd, evCtx, dc->CBs, dc->Constants, "cs_cb", 0);
+		PrepareBinds(dc->Binds);
+	}
+	auto initDraw = [&](Draw* draw) {
+		PrepareConstants(rd, evCtx, draw->VSCBs, draw->VSConstants, "vs_cb", 0);
+		PrepareConstants(rd, evCtx, draw->PSCBs, draw->PSConstants, "ps_cb", 1);
+		PrepareBinds(draw->VSBinds);
+		PrepareBinds(draw->PSBinds);
+	};
+	for (Draw* draw : rd->Draws)
+		initDraw(draw);
+	for (ObjDraw* obj : rd->ObjDraws)
+	{
+		for (Draw* draw : obj->PerMeshDraws)
+			initDraw(draw);
+	}
+}
+
+void ReleaseD3D(
+	gfx::Context*,
+	RenderDescription* rd)
+{
+	alloc::FreeAll(&rd->ConstantPool);
+}
+
+void HandleTextureParametersChanged(
+	RenderDescription* rd,
+	ExecuteContext* ec,
+	ErrorState* errorState)
+{
+	errorState->Success = true;
+	errorState->Warning = false;
+	try {
+		// Size expressions may depend on constants so we need to evaluate them first
+		EvaluateConstants(ec->EvCtx, rd->Constants);
+		EvaluateResourceSizes(rd, ec->EvCtx, true);
+	}
+	catch (ErrorInfo ie)
+	{
+		errorState->Success = false;
+		errorState->Info = ie;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ EXECUTION ------------------------------------
+// -----------------------------------------------------------------------------
+void _Execute(
+	ExecuteContext* ec,
+	RenderDescription* rd)
+{
+	ec->GfxCtx->Log.clear();
+	RecordCommands(ec->EvCtx, rd, ec->GfxCtx->Log);
+}
+
+} // namespace rlf
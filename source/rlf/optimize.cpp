@@ -0,0 +1,675 @@
+namespace rlf {
+namespace ast {
+
+
+// Calls f with a reference to every child of n, so it can replace them.
+template <typename F>
+void ForEachChild(Node* n, F&& f)
+{
+	switch (n->Type)
+	{
+	case NodeType::Subscript:
+		f(((Subscript*)n)->Subject);
+		break;
+	case NodeType::Group:
+		f(((Group*)n)->Sub);
+		break;
+	case NodeType::BinaryOp:
+	{
+		BinaryOp* bop = (BinaryOp*)n;
+		f(bop->LArg);
+		f(bop->RArg);
+		break;
+	}
+	case NodeType::Join:
+		for (Node*& comp : ((Join*)n)->Comps)
+			f(comp);
+		break;
+	case NodeType::Function:
+		for (Node*& arg : ((Function*)n)->Args)
+			f(arg);
+		break;
+	case NodeType::Conversion:
+		f(((Conversion*)n)->Sub);
+		break;
+	default:
+		break;
+	}
+}
+
+#define FUNCTION_ENTRY(name, eval_func, varies_by) varies_by,
+static const VariesBy FunctionVariesBy[] =
+{
+	FUNCTION_TUPLE
+};
+#undef FUNCTION_ENTRY
+
+u32 CountNodes(Node* n)
+{
+	u32 count = 1;
+	ForEachChild(n, [&count](Node*& c) { count += CountNodes(c); });
+	return count;
+}
+
+bool IsLiteral(const Node* n)
+{
+	return n->Type == NodeType::UintLiteral || n->Type == NodeType::IntLiteral ||
+		n->Type == NodeType::FloatLiteral || n->Type == NodeType::Folded;
+}
+
+Node* MakeFolded(const Node* n, const Variable& val, alloc::LinAlloc* alloc)
+{
+	Folded* f = alloc::Allocate<Folded>(alloc);
+	f->Common.Location = n->Location;
+	f->Common.Type = NodeType::Folded;
+	f->Common.ResultType = n->ResultType;
+	ZeroMemory(&f->Val, sizeof(f->Val));
+	memcpy(&f->Val, &val, ValueSize(n->ResultType));
+	return &f->Common;
+}
+
+// A reference to a constant whose expression has been folded is replaced by
+//	its value, converted the same way it is when the constant is evaluated.
+bool FoldVariableRef(Node*& n, alloc::LinAlloc* alloc)
+{
+	VariableRef* vr = (VariableRef*)n;
+	if (vr->IsTuneable)
+		return false;
+	rlf::Constant* cnst = (rlf::Constant*)vr->M;
+	const Node* top = cnst->Expr.TopNode;
+	if (top->Type != NodeType::Folded)
+		return false;
+	// Mismatches are reported when the constant is evaluated, keep doing so.
+	VariableType expect = cnst->Type;
+	VariableType actual = top->ResultType;
+	if (((expect.Fmt == VariableFormat::Float4x4 || actual.Fmt == VariableFormat::Float4x4) &&
+		expect.Fmt != actual.Fmt) || expect.Dim != actual.Dim)
+		return false;
+	Result res;
+	res.Type = actual;
+	res.Value = ((const Folded*)top)->Val;
+	Convert(res, expect.Fmt);
+	n = MakeFolded(n, res.Value, alloc);
+	return true;
+}
+
+void FoldNode(Node*& n, alloc::LinAlloc* alloc, u32& removed)
+{
+	if (IsLiteral(n))
+		return;
+	EvaluationContext ec = {};
+	Result res;
+	EvaluationError err;
+	Evaluate(n, ec, res, err);
+	if (err.Code != EvaluationErrorCode::None)
+		return;
+	removed += CountNodes(n) - 1;
+	n = MakeFolded(n, res.Value, alloc);
+}
+
+// Returns whether n can be folded. The parent folds it along with itself if
+//	it can, otherwise it folds the children which can on their own.
+bool FoldRecurse(Node*& n, alloc::LinAlloc* alloc, u32& removed)
+{
+	switch (n->Type)
+	{
+	case NodeType::UintLiteral:
+	case NodeType::IntLiteral:
+	case NodeType::FloatLiteral:
+	case NodeType::Folded:
+		return true;
+	case NodeType::VariableRef:
+		return FoldVariableRef(n, alloc);
+	case NodeType::SizeOf:
+		// Only known once the shader has been reflected.
+		return false;
+	case NodeType::Function:
+		if (FunctionVariesBy[(u32)((Function*)n)->Func] != VariesBy_None)
+			return false;
+		break;
+	default:
+		break;
+	}
+
+	// Nodes have at most four children, the type check makes sure of it.
+	Node** foldable[4];
+	u32 foldableCount = 0;
+	u32 childCount = 0;
+	ForEachChild(n, [&](Node*& c) {
+		Assert(childCount < 4, "Too many children");
+		++childCount;
+		if (FoldRecurse(c, alloc, removed))
+			foldable[foldableCount++] = &c;
+	});
+	if (foldableCount == childCount)
+		return true;
+	for (u32 i = 0 ; i < foldableCount ; ++i)
+		FoldNode(*foldable[i], alloc, removed);
+	return false;
+}
+
+u32 Fold(Node*& node, alloc::LinAlloc* alloc)
+{
+	u32 removed = 0;
+	if (FoldRecurse(node, alloc, removed))
+		FoldNode(node, alloc, removed);
+	return removed;
+}
+
+// Children are compared by address, so nodes have to be made unique from the
+//	leaves up for equal subtrees to be found.
+size_t HashNode(const Node* n)
+{
+	size_t h = (size_t)n->Type;
+	auto combine = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+	combine((size_t)n->ResultType.Fmt);
+	combine(n->ResultType.Dim);
+	switch (n->Type)
+	{
+	case NodeType::UintLiteral:
+		combine(((const UintLiteral*)n)->Val);
+		break;
+	case NodeType::IntLiteral:
+		combine((u32)((const IntLiteral*)n)->Val);
+		break;
+	case NodeType::FloatLiteral:
+	{
+		u32 bits;
+		memcpy(&bits, &((const FloatLiteral*)n)->Val, sizeof(bits));
+		combine(bits);
+		break;
+	}
+	case NodeType::Subscript:
+	{
+		const Subscript* sub = (const Subscript*)n;
+		u32 index;
+		memcpy(&index, sub->Index, sizeof(index));
+		combine(index);
+		break;
+	}
+	case NodeType::BinaryOp:
+		combine((size_t)((const BinaryOp*)n)->Op);
+		break;
+	case NodeType::VariableRef:
+		combine((size_t)((const VariableRef*)n)->M);
+		break;
+	case NodeType::Function:
+		combine((size_t)((const Function*)n)->Func);
+		break;
+	case NodeType::SizeOf:
+		// Each one is filled in by its own request.
+		combine((size_t)n);
+		break;
+	case NodeType::Folded:
+	{
+		const u8* bytes = (const u8*)&((const Folded*)n)->Val;
+		for (u32 i = 0 ; i < ValueSize(n->ResultType) ; ++i)
+			combine(bytes[i]);
+		break;
+	}
+	default:
+		break;
+	}
+	ForEachChild((Node*)n, [&combine](Node*& c) { combine((size_t)c); });
+	return h;
+}
+
+bool SameNode(const Node* a, const Node* b)
+{
+	if (a->Type != b->Type || a->ResultType != b->ResultType)
+		return false;
+	switch (a->Type)
+	{
+	case NodeType::UintLiteral:
+		return ((const UintLiteral*)a)->Val == ((const UintLiteral*)b)->Val;
+	case NodeType::IntLiteral:
+		return ((const IntLiteral*)a)->Val == ((const IntLiteral*)b)->Val;
+	case NodeType::FloatLiteral:
+		return memcmp(&((const FloatLiteral*)a)->Val, &((const FloatLiteral*)b)->Val,
+			sizeof(float)) == 0;
+	case NodeType::Subscript:
+	{
+		const Subscript* sa = (const Subscript*)a;
+		const Subscript* sb = (const Subscript*)b;
+		return sa->Subject == sb->Subject &&
+			memcmp(sa->Index, sb->Index, sizeof(sa->Index)) == 0;
+	}
+	case NodeType::Group:
+		return ((const Group*)a)->Sub == ((const Group*)b)->Sub;
+	case NodeType::BinaryOp:
+	{
+		const BinaryOp* ba = (const BinaryOp*)a;
+		const BinaryOp* bb = (const BinaryOp*)b;
+		return ba->Op == bb->Op && ba->LArg == bb->LArg && ba->RArg == bb->RArg;
+	}
+	case NodeType::Join:
+	{
+		const Join* ja = (const Join*)a;
+		const Join* jb = (const Join*)b;
+		return ja->Comps.Count == jb->Comps.Count && memcmp(ja->Comps.Data,
+			jb->Comps.Data, ja->Comps.Count * sizeof(Node*)) == 0;
+	}
+	case NodeType::VariableRef:
+	{
+		const VariableRef* va = (const VariableRef*)a;
+		const VariableRef* vb = (const VariableRef*)b;
+		return va->IsTuneable == vb->IsTuneable && va->M == vb->M;
+	}
+	case NodeType::Function:
+	{
+		const Function* fa = (const Function*)a;
+		const Function* fb = (const Function*)b;
+		return fa->Func == fb->Func && fa->Args.Count == fb->Args.Count &&
+			memcmp(fa->Args.Data, fb->Args.Data, fa->Args.Count * sizeof(Node*)) == 0;
+	}
+	case NodeType::SizeOf:
+		return a == b;
+	case NodeType::Conversion:
+		return ((const Conversion*)a)->Sub == ((const Conversion*)b)->Sub;
+	case NodeType::Folded:
+		return memcmp(&((const Folded*)a)->Val, &((const Folded*)b)->Val,
+			ValueSize(a->ResultType)) == 0;
+	default:
+		Unimplemented();
+		return false;
+	}
+}
+
+
+} // namespace ast
+
+struct NodeHash
+{
+	size_t operator()(const ast::Node* n) const { return ast::HashNode(n); }
+};
+struct NodeEqual
+{
+	bool operator()(const ast::Node* a, const ast::Node* b) const
+	{
+		return ast::SameNode(a, b);
+	}
+};
+
+struct SharedNode
+{
+	ast::Node* Node;
+	// Parents and expressions referring to the node.
+	u32 Refs;
+	// Nodes evaluated for each use, a shared child only counts as one.
+	u32 Cost;
+	// Set if the node has been moved into a hidden constant.
+	Constant* Hidden;
+	ast::Node* Ref;
+};
+
+struct ShareState
+{
+	// Unique nodes, children before their parents.
+	std::vector<SharedNode> Nodes;
+	std::unordered_map<const ast::Node*, u32> Index;
+	std::unordered_set<ast::Node*, NodeHash, NodeEqual> Unique;
+	// Every hidden constant has this name, which tells them apart.
+	const char* HiddenName;
+};
+
+// Groups only matter to the parser and are dropped on the way.
+void MakeUnique(ShareState& ss, ast::Node*& n)
+{
+	while (n->Type == ast::NodeType::Group)
+		n = ((ast::Group*)n)->Sub;
+	if (ss.Index.count(n))
+		return;
+	ast::ForEachChild(n, [&ss](ast::Node*& c) { MakeUnique(ss, c); });
+	auto it = ss.Unique.insert(n);
+	if (!it.second)
+	{
+		n = *it.first;
+		return;
+	}
+	ss.Index[n] = (u32)ss.Nodes.size();
+	SharedNode sn = {};
+	sn.Node = n;
+	ss.Nodes.push_back(sn);
+}
+
+SharedNode& Shared(ShareState& ss, const ast::Node* n)
+{
+	return ss.Nodes[ss.Index.at(n)];
+}
+
+ast::Node* MakeRef(Constant* cnst, const char* location, alloc::LinAlloc* alloc)
+{
+	ast::VariableRef* vr = alloc::Allocate<ast::VariableRef>(alloc);
+	vr->Common.Location = location;
+	vr->Common.Type = ast::NodeType::VariableRef;
+	vr->Common.ResultType = cnst->Type;
+	vr->IsTuneable = false;
+	vr->M = cnst;
+	return &vr->Common;
+}
+
+ast::Node* CopyNode(const ast::Node* n, const char* location, alloc::LinAlloc* alloc)
+{
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) sizeof(ast::type),
+	static const size_t NodeSizes[] =
+	{
+		NODE_TYPE_TUPLE
+	};
+#undef NODE_TYPE_ENTRY
+	size_t size = NodeSizes[(u32)n->Type];
+	ast::Node* copy = (ast::Node*)alloc::Allocate(alloc, size);
+	memcpy(copy, n, size);
+	copy->Location = location;
+	return copy;
+}
+
+// Places the hidden constants below n before their first user.
+void PlaceHidden(ShareState& ss, ast::Node* n, std::unordered_set<const ast::Node*>& seen,
+	alloc::LinAlloc* scratch, alloc::List<Constant*>& cnsts)
+{
+	if (!seen.insert(n).second)
+		return;
+	if (n->Type == ast::NodeType::VariableRef && !((ast::VariableRef*)n)->IsTuneable)
+	{
+		// Only placed once, the subtree of a hidden constant is only reachable
+		//	through it.
+		Constant* cnst = (Constant*)((ast::VariableRef*)n)->M;
+		if (cnst->Name == ss.HiddenName && !seen.count(cnst->Expr.TopNode))
+		{
+			PlaceHidden(ss, (ast::Node*)cnst->Expr.TopNode, seen, scratch, cnsts);
+			alloc::PushBack(scratch, &cnsts, cnst);
+		}
+		return;
+	}
+	ast::ForEachChild(n, [&](ast::Node*& c) { PlaceHidden(ss, c, seen, scratch, cnsts); });
+}
+
+// Copied draws can hold the same constants, every expression is only added
+//	once.
+void CollectExpressions(RenderDescription* rd, std::vector<ast::Expression*>& exprs)
+{
+	std::unordered_set<const void*> added;
+	auto add = [&](ast::Expression& expr) {
+		if (expr.IsValid() && added.insert(&expr).second)
+			exprs.push_back(&expr);
+	};
+	for (Constant* cnst : rd->Constants)
+		add(cnst->Expr);
+	for (Buffer* buf : rd->Buffers)
+	{
+		add(buf->ElementSizeExpr);
+		add(buf->ElementCountExpr);
+	}
+	for (Texture* tex : rd->Textures)
+		add(tex->SizeExpr);
+	for (Dispatch* dc : rd->Dispatches)
+	{
+		add(dc->Groups);
+		for (SetConstant& sc : dc->Constants)
+			add(sc.Value);
+	}
+	for (Draw* draw : rd->Draws)
+	{
+		for (SetConstant& sc : draw->VSConstants)
+			add(sc.Value);
+		for (SetConstant& sc : draw->PSConstants)
+			add(sc.Value);
+		for (Viewport* vp : draw->Viewports)
+		{
+			add(vp->TopLeft);
+			add(vp->Size);
+			add(vp->DepthRange);
+		}
+	}
+}
+
+void ShareExpressions(RenderDescription* rd, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch)
+{
+	std::vector<ast::Expression*> exprs;
+	CollectExpressions(rd, exprs);
+	u32 exprCount = (u32)exprs.size();
+
+	ShareState ss;
+	ss.HiddenName = nullptr;
+	std::vector<const char*> locations(exprCount);
+	for (u32 i = 0 ; i < exprCount ; ++i)
+	{
+		ast::Node* top = (ast::Node*)exprs[i]->TopNode;
+		locations[i] = top->Location;
+		MakeUnique(ss, top);
+		exprs[i]->TopNode = top;
+		Shared(ss, top).Refs++;
+	}
+	for (SharedNode& sn : ss.Nodes)
+	{
+		ast::ForEachChild(sn.Node, [&ss](ast::Node*& c) { Shared(ss, c).Refs++; });
+	}
+
+	// Evaluating a hidden constant costs its subtree once, and each use then
+	//	costs one node instead of the subtree.
+	u32 saved = 0;
+	u32 sharedCount = 0;
+	for (SharedNode& sn : ss.Nodes)
+	{
+		sn.Cost = 1;
+		ast::ForEachChild(sn.Node, [&ss, &sn](ast::Node*& c) {
+			const SharedNode& child = Shared(ss, c);
+			sn.Cost += child.Hidden ? 1 : child.Cost;
+		});
+		if (sn.Refs < 2 || (sn.Refs - 1) * sn.Cost <= sn.Refs)
+			continue;
+		saved += (sn.Refs - 1) * sn.Cost - sn.Refs;
+		++sharedCount;
+
+		if (!ss.HiddenName)
+		{
+			// In the arena, so it's saved along with the description.
+			static const char Name[] = "(shared)";
+			char* name = (char*)alloc::Allocate(alloc, sizeof(Name), 1);
+			memcpy(name, Name, sizeof(Name));
+			ss.HiddenName = name;
+		}
+		Constant* cnst = alloc::Allocate<Constant>(alloc);
+		cnst->Name = ss.HiddenName;
+		cnst->Type = sn.Node->ResultType;
+		cnst->Expr = {};
+		cnst->Expr.TopNode = sn.Node;
+		sn.Hidden = cnst;
+		sn.Ref = MakeRef(cnst, sn.Node->Location, alloc);
+	}
+
+	// Uses of hidden constants refer to them instead. Done in order, so the
+	//	dependencies of the hidden constants inside a subtree are known.
+	for (SharedNode& sn : ss.Nodes)
+	{
+		ast::ForEachChild(sn.Node, [&ss](ast::Node*& c) {
+			const SharedNode& child = Shared(ss, c);
+			if (child.Hidden)
+				c = child.Ref;
+		});
+		if (sn.Hidden)
+			ast::GetDependency(sn.Node, sn.Hidden->Expr.Dep);
+	}
+	// The top node's location is where an expression reports its value not
+	//	matching where it's used, keep those apart. Copying a SizeOf would
+	//	leave the copy without a size.
+	for (u32 i = 0 ; i < exprCount ; ++i)
+	{
+		ast::Expression& expr = *exprs[i];
+		const SharedNode& sn = Shared(ss, expr.TopNode);
+		if (sn.Hidden)
+			expr.TopNode = MakeRef(sn.Hidden, locations[i], alloc);
+		else if (expr.TopNode->Location != locations[i] &&
+			expr.TopNode->Type != ast::NodeType::SizeOf)
+			expr.TopNode = CopyNode(expr.TopNode, locations[i], alloc);
+	}
+
+	// Hidden constants go right before the first constant using them, the
+	//	rest after all constants.
+	if (sharedCount > 0)
+	{
+		alloc::Marker placing = alloc::Mark(scratch);
+		alloc::List<Constant*> cnsts = {};
+		std::unordered_set<const ast::Node*> seen;
+		for (Constant* cnst : rd->Constants)
+		{
+			PlaceHidden(ss, (ast::Node*)cnst->Expr.TopNode, seen, scratch, cnsts);
+			alloc::PushBack(scratch, &cnsts, cnst);
+		}
+		for (u32 i = 0 ; i < exprCount ; ++i)
+			PlaceHidden(ss, (ast::Node*)exprs[i]->TopNode, seen, scratch, cnsts);
+		rd->Constants = alloc::MakeCopy(alloc, cnsts);
+		alloc::Rollback(scratch, placing);
+	}
+
+	for (Constant* cnst : rd->Constants)
+	{
+		if (cnst->Name == ss.HiddenName)
+			exprs.push_back(&cnst->Expr);
+	}
+	// What compiling leaves in the scratch is done with once it's copied out.
+	for (ast::Expression* expr : exprs)
+	{
+		alloc::Marker compiling = alloc::Mark(scratch);
+		expr->Code = ast::Compile(expr->TopNode, alloc, scratch);
+		alloc::Rollback(scratch, compiling);
+	}
+
+	// Folding counts while parsing.
+	ExpressionStats& stats = rd->ExprStats;
+	stats.Expressions = exprCount;
+	stats.Nodes = (u32)ss.Nodes.size();
+	stats.SharedSubtrees = sharedCount;
+	stats.SavedEvaluations = stats.FoldedNodes + saved;
+}
+
+
+template <typename T>
+void AddUnique(std::vector<T*>& list, T* item)
+{
+	if (std::find(list.begin(), list.end(), item) == list.end())
+		list.push_back(item);
+}
+
+// What an expression reads, each input once.
+struct ExpressionInputs
+{
+	std::vector<Tuneable*> Tuneables;
+	std::vector<Constant*> Constants;
+	u32 VariesBy;
+};
+
+void LinkNode(ast::Expression* expr, ast::Node* n, ExpressionInputs& in)
+{
+	expr->NodeCount++;
+	if (n->Type == ast::NodeType::VariableRef)
+	{
+		ast::VariableRef* vr = (ast::VariableRef*)n;
+		if (vr->IsTuneable)
+			AddUnique(in.Tuneables, (Tuneable*)vr->M);
+		else
+			AddUnique(in.Constants, (Constant*)vr->M);
+	}
+	else if (n->Type == ast::NodeType::Function)
+		in.VariesBy |= ast::FunctionVariesBy[(u32)((ast::Function*)n)->Func];
+	ast::ForEachChild(n, [&](ast::Node*& c) { LinkNode(expr, c, in); });
+}
+
+void LinkExpressions(RenderDescription* rd, alloc::LinAlloc* alloc)
+{
+	// Constants come first and in evaluation order, so the constants an
+	//	expression reads have their own dependencies filled in already.
+	std::vector<ast::Expression*> exprs;
+	CollectExpressions(rd, exprs);
+
+	std::unordered_map<const void*, std::vector<ast::Expression*>> users;
+	std::vector<ast::Expression*> timeUsers;
+	std::vector<ast::Expression*> displaySizeUsers;
+	ExpressionInputs in;
+	std::vector<Tuneable*> tuneables;
+	for (ast::Expression* expr : exprs)
+	{
+		in.Tuneables.clear();
+		in.Constants.clear();
+		in.VariesBy = ast::VariesBy_None;
+		expr->NodeCount = 0;
+		LinkNode(expr, (ast::Node*)expr->TopNode, in);
+
+		tuneables = in.Tuneables;
+		for (Tuneable* tune : in.Tuneables)
+			users[tune].push_back(expr);
+		for (Constant* cnst : in.Constants)
+		{
+			users[cnst].push_back(expr);
+			for (Tuneable* tune : cnst->Expr.Dep.Tuneables)
+				AddUnique(tuneables, tune);
+		}
+		expr->Dep.Tuneables = alloc::MakeCopy(alloc, tuneables);
+		expr->Dep.Constants = alloc::MakeCopy(alloc, in.Constants);
+
+		if (in.VariesBy & ast::VariesBy_Time)
+			timeUsers.push_back(expr);
+		if (in.VariesBy & ast::VariesBy_DisplaySize)
+			displaySizeUsers.push_back(expr);
+	}
+
+	// Nothing was evaluated yet, every cache starts out invalid.
+	for (Constant* cnst : rd->Constants)
+		cnst->Users = alloc::MakeCopy(alloc, users[cnst]);
+	for (Tuneable* tune : rd->Tuneables)
+		tune->Users = alloc::MakeCopy(alloc, users[tune]);
+	rd->TimeUsers = alloc::MakeCopy(alloc, timeUsers);
+	rd->DisplaySizeUsers = alloc::MakeCopy(alloc, displaySizeUsers);
+}
+
+
+void BatchSetConstants(RenderDescription* rd, alloc::LinAlloc* alloc)
+{
+	std::vector<SetConstant*> sets;
+	std::unordered_set<const SetConstant*> added;
+	auto add = [&](Array<SetConstant> list) {
+		for (SetConstant& set : list)
+		{
+			if (set.Value.Code && added.insert(&set).second)
+				sets.push_back(&set);
+		}
+	};
+	for (Dispatch* dc : rd->Dispatches)
+		add(dc->Constants);
+	for (Draw* draw : rd->Draws)
+	{
+		add(draw->VSConstants);
+		add(draw->PSConstants);
+	}
+
+	// Instructions have no padding, so the code compares as bytes. The
+	//	result type is part of it.
+	std::unordered_map<std::string, std::vector<SetConstant*>> batches;
+	std::vector<const std::vector<SetConstant*>*> order;
+	for (SetConstant* set : sets)
+	{
+		const ast::Program* prog = set->Value.Code;
+		std::string key((const char*)prog->Code.Data, 
+			prog->Code.Count * sizeof(ast::Instruction));
+		key.append((const char*)&prog->ResultType, sizeof(prog->ResultType));
+		std::vector<SetConstant*>& batch = batches[key];
+		if (batch.empty())
+			order.push_back(&batch);
+		batch.push_back(set);
+	}
+
+	// A batch of one runs no faster than the program on its own.
+	std::vector<SetConstantBatch> result;
+	for (const std::vector<SetConstant*>* batch : order)
+	{
+		if (batch->size() < 2)
+			continue;
+		SetConstantBatch b;
+		b.Sets = alloc::MakeCopy(alloc, *batch);
+		result.push_back(b);
+	}
+	rd->SetConstantBatches = alloc::MakeCopy(alloc, result);
+}
+
+}
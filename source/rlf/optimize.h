@@ -0,0 +1,49 @@
+
+namespace rlf {
+
+struct RenderDescription;
+
+// What the expression passes below did to a description.
+struct ExpressionStats
+{
+	u32 Expressions;
+	// After optimizing, nodes shared by several expressions counted once.
+	u32 Nodes;
+	// Removed by folding subtrees to their value.
+	u32 FoldedNodes;
+	// Moved into a hidden constant because several expressions contain them.
+	u32 SharedSubtrees;
+	// Node evaluations no longer needed if every expression were evaluated
+	//	once, from folding and from sharing.
+	u32 SavedEvaluations;
+};
+
+namespace ast {
+
+// Replaces every subtree which can't vary, because it only involves literals
+//	and constants which have been folded themselves, with its value. Subtrees
+//	which fail to evaluate are kept, so they still report their error when the
+//	expression is evaluated. Returns the number of nodes removed.
+u32 Fold(Node*& node, alloc::LinAlloc* alloc);
+
+}
+
+// Merges identical subtrees across all expressions of rd. The ones that are
+//	worth evaluating only once are moved into hidden constants, which are
+//	placed in rd->Constants before their first use. Compiles every expression
+//	afterwards, so it has to run once parsing has finished.
+void ShareExpressions(RenderDescription* rd, alloc::LinAlloc* alloc,
+	alloc::LinAlloc* scratch);
+
+// Records which expressions read each constant and tuneable, Time() and
+//	DisplaySize(), so a change only invalidates those. Also fills in the
+//	tuneables and constants each expression depends on and counts its nodes.
+//	Has to run after ShareExpressions.
+void LinkExpressions(RenderDescription* rd, alloc::LinAlloc* alloc);
+
+// Groups the SetConstants of every draw and dispatch whose values compiled to
+//	the same code, with different constants and variables, so they can be
+//	evaluated together. Has to run after ShareExpressions.
+void BatchSetConstants(RenderDescription* rd, alloc::LinAlloc* alloc);
+
+}
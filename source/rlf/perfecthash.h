@@ -0,0 +1,162 @@
+namespace rlf {
+namespace phash {
+
+/******************************* Perfect hashing *******************************
+	Compile-time perfect hash tables for fixed string sets (keywords, format
+	names). Keys are hashed once with 64-bit FNV-1a, the low half picks a
+	bucket and the high half (forced odd) is the stride used to displace keys.
+	Buckets are placed largest first, searching for the smallest displacement
+	which puts every key of the bucket into a free slot:
+
+		slot = (f>>8 + Displacement[f & (BucketCount-1)] * g) & (SlotCount-1)
+
+	A lookup is then a hash, two table reads and one string compare, with no
+	probing and nothing built at runtime. Slot values are indices into the key
+	array, and index 0 is reserved for the "invalid" entry every key array in
+	rlf starts with, so a miss naturally resolves to it.
+*******************************************************************************/
+
+// The hashing below relies on unsigned wrap-around, which MSVC reports as
+//	integral constant overflow when it is evaluated at compile time.
+#pragma warning(push)
+#pragma warning(disable: 4307)
+
+constexpr char AsciiLower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+constexpr u64 Hash(const char* str, bool ignoreCase)
+{
+	u64 h = 14695981039346656037ull;
+	for (const char* c = str ; *c != '\0' ; ++c)
+	{
+		h ^= (u8)(ignoreCase ? AsciiLower(*c) : *c);
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+template <u32 SlotCount, u32 BucketCount>
+struct Table
+{
+	static_assert((SlotCount & (SlotCount-1)) == 0, "SlotCount must be a power of two");
+	static_assert((BucketCount & (BucketCount-1)) == 0, "BucketCount must be a power of two");
+	static_assert(SlotCount <= 0x10000, "Slot values are stored as u16");
+
+	u16 Slots[SlotCount] = {};
+	u16 Displacement[BucketCount] = {};
+	bool Valid = false;
+};
+
+// Returns the slot a hash lands in for a given bucket displacement.
+constexpr u32 SlotFor(u64 h, u32 displacement, u32 slotCount)
+{
+	u32 f = (u32)h;
+	u32 g = (u32)(h >> 32) | 1;
+	return ((f >> 8) + displacement * g) & (slotCount - 1);
+}
+
+// Builds the table for keys[1..N-1], keys[0] is the invalid entry. The result
+//	has Valid unset if no displacement could be found for some bucket, callers
+//	static_assert on it and should grow SlotCount if it ever trips.
+template <u32 SlotCount, u32 BucketCount, size_t N>
+constexpr Table<SlotCount, BucketCount> Build(const char* const (&keys)[N],
+	bool ignoreCase)
+{
+	static_assert(N - 1 <= SlotCount, "Not enough slots for the key set");
+	Table<SlotCount, BucketCount> table = {};
+
+	// Group the keys by bucket (counting sort) so placing a bucket only
+	//	touches its own keys.
+	u64 hashes[N] = {};
+	u32 bucketSize[BucketCount] = {};
+	u32 bucketStart[BucketCount + 1] = {};
+	u32 order[N] = {};
+	u32 maxBucketSize = 0;
+	for (u32 k = 1 ; k < N ; ++k)
+	{
+		hashes[k] = Hash(keys[k], ignoreCase);
+		u32 b = (u32)hashes[k] & (BucketCount - 1);
+		++bucketSize[b];
+		if (bucketSize[b] > maxBucketSize)
+			maxBucketSize = bucketSize[b];
+	}
+	for (u32 b = 0 ; b < BucketCount ; ++b)
+		bucketStart[b+1] = bucketStart[b] + bucketSize[b];
+	{
+		u32 fill[BucketCount] = {};
+		for (u32 k = 1 ; k < N ; ++k)
+		{
+			u32 b = (u32)hashes[k] & (BucketCount - 1);
+			order[bucketStart[b] + fill[b]++] = k;
+		}
+	}
+
+	for (u32 size = maxBucketSize ; size > 0 ; --size)
+	{
+		for (u32 b = 0 ; b < BucketCount ; ++b)
+		{
+			if (bucketSize[b] != size)
+				continue;
+			const u32* bucketKeys = order + bucketStart[b];
+			bool placed = false;
+			for (u32 d = 0 ; d < 0x10000 && !placed ; ++d)
+			{
+				// Tentatively place every key in the bucket, rolling back on
+				//	the first collision (with earlier buckets or each other).
+				u32 i = 0;
+				for ( ; i < size ; ++i)
+				{
+					u32 s = SlotFor(hashes[bucketKeys[i]], d, SlotCount);
+					if (table.Slots[s] != 0)
+						break;
+					table.Slots[s] = (u16)bucketKeys[i];
+				}
+				placed = (i == size);
+				if (placed)
+					table.Displacement[b] = (u16)d;
+				else
+				{
+					while (i-- > 0)
+						table.Slots[SlotFor(hashes[bucketKeys[i]], d, SlotCount)] = 0;
+				}
+			}
+			if (!placed)
+				return table;
+		}
+	}
+
+	table.Valid = true;
+	return table;
+}
+
+inline bool Equal(const char* a, const char* b, bool ignoreCase)
+{
+	if (ignoreCase)
+	{
+		while (*a != '\0' && AsciiLower(*a) == AsciiLower(*b))
+		{
+			++a;
+			++b;
+		}
+		return AsciiLower(*a) == AsciiLower(*b);
+	}
+	return strcmp(a, b) == 0;
+}
+
+// Returns the index of str in keys, or 0 if it is not one of them.
+template <u32 SlotCount, u32 BucketCount, size_t N>
+u32 Find(const Table<SlotCount, BucketCount>& table,
+	const char* const (&keys)[N], const char* str, bool ignoreCase)
+{
+	u64 h = Hash(str, ignoreCase);
+	u32 d = table.Displacement[(u32)h & (BucketCount - 1)];
+	u32 k = table.Slots[SlotFor(h, d, SlotCount)];
+	return Equal(keys[k], str, ignoreCase) ? k : 0;
+}
+
+#pragma warning(pop)
+
+} // namespace phash
+} // namespace rlf
@@ -0,0 +1,149 @@
+namespace rlf {
+namespace ast {
+
+
+void ResetProfile(ExpressionProfile& prof)
+{
+	prof.Samples.clear();
+	prof.Lookup.clear();
+	prof.Frames = 0;
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	prof.StartCounter = counter.QuadPart;
+	prof.StartTicks = ReadProfileTicks();
+}
+
+ExpressionSamples& FindSamples(ExpressionProfile& prof, const Expression& expr)
+{
+	const char* location = expr.TopNode->Location;
+	auto it = prof.Lookup.find(location);
+	if (it != prof.Lookup.end())
+		return prof.Samples[it->second];
+	prof.Lookup[location] = (u32)prof.Samples.size();
+	ExpressionSamples samples = {};
+	samples.Location = location;
+	samples.EvaluatedFrame = U32_MAX;
+	samples.HitFrame = U32_MAX;
+	prof.Samples.push_back(samples);
+	return prof.Samples.back();
+}
+
+void RecordEvaluation(ExpressionProfile& prof, const Expression& expr, u64 ticks,
+	bool success)
+{
+	ExpressionSamples& samples = FindSamples(prof, expr);
+	samples.Evaluations++;
+	samples.Failures += success ? 0 : 1;
+	samples.Ticks += ticks;
+	samples.EvaluatedFrame = prof.Frames;
+}
+
+void RecordCacheHit(ExpressionProfile& prof, const Expression& expr)
+{
+	ExpressionSamples& samples = FindSamples(prof, expr);
+	if (samples.EvaluatedFrame == prof.Frames || samples.HitFrame == prof.Frames)
+		return;
+	samples.CacheHits++;
+	samples.HitFrame = prof.Frames;
+}
+
+double ProfileTicksPerSecond(const ExpressionProfile& prof)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	u64 ticks = ReadProfileTicks() - prof.StartTicks;
+	i64 elapsed = counter.QuadPart - prof.StartCounter;
+	if (elapsed <= 0)
+		return 0;
+	return (double)ticks * (double)frequency.QuadPart / (double)elapsed;
+}
+
+std::vector<const ExpressionSamples*> SortSamples(const ExpressionProfile& prof)
+{
+	std::vector<const ExpressionSamples*> sorted;
+	sorted.reserve(prof.Samples.size());
+	for (const ExpressionSamples& samples : prof.Samples)
+		sorted.push_back(&samples);
+	std::sort(sorted.begin(), sorted.end(),
+		[](const ExpressionSamples* a, const ExpressionSamples* b) {
+			return a->Ticks > b->Ticks;
+		});
+	return sorted;
+}
+
+// Quoted, with the characters either format can't have in a string escaped.
+std::string QuoteString(const char* str, bool json)
+{
+	std::string quoted = "\"";
+	for (const char* c = str ; *c ; ++c)
+	{
+		if (*c == '"')
+			quoted += json ? "\\\"" : "\"\"";
+		else if (*c == '\\' && json)
+			quoted += "\\\\";
+		else
+			quoted += *c;
+	}
+	quoted += "\"";
+	return quoted;
+}
+
+std::string FormatProfile(const ExpressionProfile& prof, const SourceMap& sm, bool json)
+{
+	double ticksPerUs = ProfileTicksPerSecond(prof) / 1000000.0;
+	if (ticksPerUs <= 0)
+		ticksPerUs = 1;
+
+	char buf[256];
+	std::string str;
+	if (json)
+	{
+		sprintf_s(buf, 256, "{\n\t\"frames\": %u,\n\t\"expressions\": [", prof.Frames);
+		str = buf;
+	}
+	else
+		str = "file,line,column,evaluations,failures,cache_hits,total_us,average_us\n";
+
+	bool first = true;
+	for (const ExpressionSamples* samples : SortSamples(prof))
+	{
+		SourceLocation loc = {};
+		const char* file = "";
+		if (FindSourceLocation(sm, samples->Location, &loc))
+			file = sm.Files[loc.File].Name.c_str();
+		double total = (double)samples->Ticks / ticksPerUs;
+		double average = samples->Evaluations ? total / samples->Evaluations : 0;
+
+		// The file name goes in separately, it can be longer than buf.
+		if (json)
+			str += first ? "\n\t\t{ \"file\": " : ",\n\t\t{ \"file\": ";
+		str += QuoteString(file, json);
+		const char* format = json ?
+			", \"line\": %u, \"column\": %u, \"evaluations\": %u, \"failures\": %u, "
+			"\"cache_hits\": %u, \"total_us\": %.3f, \"average_us\": %.3f }" :
+			",%u,%u,%u,%u,%u,%.3f,%.3f\n";
+		sprintf_s(buf, 256, format, loc.Line, loc.Column, samples->Evaluations,
+			samples->Failures, samples->CacheHits, total, average);
+		str += buf;
+		first = false;
+	}
+
+	if (json)
+		str += "\n\t]\n}\n";
+	return str;
+}
+
+std::string FormatProfileCsv(const ExpressionProfile& prof, const SourceMap& sm)
+{
+	return FormatProfile(prof, sm, false);
+}
+
+std::string FormatProfileJson(const ExpressionProfile& prof, const SourceMap& sm)
+{
+	return FormatProfile(prof, sm, true);
+}
+
+
+}
+}
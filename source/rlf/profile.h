@@ -0,0 +1,64 @@
+
+// Compiled out unless the build defines this as 1, as 'build profile' does.
+//	Evaluation then doesn't look at EvaluationContext::Profile at all.
+#ifndef RLF_EXPRESSION_PROFILER
+	#define RLF_EXPRESSION_PROFILER 0
+#endif
+
+namespace rlf {
+namespace ast {
+
+// What happened to the expressions starting at one source location, summed up
+//	since the profile was last reset. Shared subtrees moved into hidden
+//	constants are profiled at the location of their first use.
+struct ExpressionSamples
+{
+	const char* Location;
+	// Evaluations which weren't cached, including the failed ones.
+	u32 Evaluations;
+	u32 Failures;
+	u32 CacheHits;
+	// Spent evaluating, in ticks of ReadProfileTicks.
+	u64 Ticks;
+	// Hits are counted once per frame, and not in frames it was evaluated in,
+	//	however many times the cached value is used.
+	u32 EvaluatedFrame;
+	u32 HitFrame;
+};
+
+// Collects ExpressionSamples while it's set as EvaluationContext::Profile.
+//	The locations point into the source buffers of the description, so it has
+//	to be reset before they're freed.
+struct ExpressionProfile
+{
+	std::vector<ExpressionSamples> Samples;
+	// Location to index into Samples.
+	std::unordered_map<const char*, u32> Lookup;
+	// Counted by the caller since the profile was reset.
+	u32 Frames;
+	// When it was last reset, to convert ticks to seconds.
+	u64 StartTicks;
+	i64 StartCounter;
+};
+
+inline u64 ReadProfileTicks() { return __rdtsc(); }
+
+void ResetProfile(ExpressionProfile& prof);
+// Both are called by the evaluation functions, ticks is the time spent on an
+//	evaluation which wasn't cached.
+void RecordEvaluation(ExpressionProfile& prof, const Expression& expr, u64 ticks,
+	bool success);
+void RecordCacheHit(ExpressionProfile& prof, const Expression& expr);
+// Measured against the performance counter over the time since the profile was
+//	reset, so it's only accurate once that isn't too short.
+double ProfileTicksPerSecond(const ExpressionProfile& prof);
+
+// Most expensive first.
+std::vector<const ExpressionSamples*> SortSamples(const ExpressionProfile& prof);
+// One line or object per location with its file, line and column, the counts and
+//	the total and average time in microseconds.
+std::string FormatProfileCsv(const ExpressionProfile& prof, const SourceMap& sm);
+std::string FormatProfileJson(const ExpressionProfile& prof, const SourceMap& sm);
+
+}
+}
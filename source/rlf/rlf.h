@@ -4,6 +4,9 @@
 #include "rlf/textureformat.h"
 #include "rlf/alloc.h"
 #include "rlf/ast.h"
+#include "rlf/bytecode.h"
+#include "rlf/optimize.h"
+#include "rlf/commands.h"
 
 // forward declares
 namespace rlf 
@@ -150,7 +153,7 @@ namespace rlf
 	struct RasterizerState 
 	{
 		bool Fill;
-		CullMode CullMode;
+		rlf::CullMode CullMode;
 		bool FrontCCW;
 		i32 DepthBias;
 		float SlopeScaledDepthBias;
@@ -182,6 +185,8 @@ namespace rlf
 	};
 	struct BlendState
 	{
+		// What D3D calls COLOR_WRITE_ENABLE_ALL.
+		constexpr static u8 WRITE_ENABLE_ALL = 15;
 		bool Enable;
 		Blend Src;
 		Blend Dest;
@@ -199,6 +204,8 @@ namespace rlf
 	};
 	struct InputElementDesc
 	{
+		// What D3D calls APPEND_ALIGNED_ELEMENT.
+		constexpr static u32 APPEND_ALIGNED = 0xffffffff;
 		char* SemanticName;
 		u32 SemanticIndex;
 		TextureFormat Format;
@@ -289,10 +296,10 @@ namespace rlf
 	struct View
 	{
 		ViewType Type;
-		ResourceType ResourceType;
+		rlf::ResourceType ResourceType;
 		union {
-			Buffer* Buffer;
-			Texture* Texture;
+			rlf::Buffer* Buffer;
+			rlf::Texture* Texture;
 		};
 		TextureFormat Format;
 		u32 NumElements;
@@ -338,6 +345,12 @@ namespace rlf
 		u32 Size;
 		VariableType Type;
 	};
+	// SetConstants whose values are compiled to the same code, which are
+	//	evaluated together by EvaluateSetConstantBatches.
+	struct SetConstantBatch
+	{
+		Array<SetConstant*> Sets;
+	};
 	struct Dispatch
 	{
 		ComputeShader* Shader;
@@ -352,7 +365,7 @@ namespace rlf
 	};
 	struct Draw
 	{
-		Topology Topology;
+		rlf::Topology Topology;
 		RasterizerState* RState;
 		DepthStencilState* DSState;
 		VertexShader* VShader;
@@ -407,13 +420,13 @@ namespace rlf
 		const char* Name;
 		PassType Type;
 		union {
-			Dispatch* Dispatch;
-			Draw* Draw;
-			ClearColor* ClearColor;
-			ClearDepth* ClearDepth;
-			ClearStencil* ClearStencil;
-			Resolve* Resolve;
-			ObjDraw* ObjDraw;
+			rlf::Dispatch* Dispatch;
+			rlf::Draw* Draw;
+			rlf::ClearColor* ClearColor;
+			rlf::ClearDepth* ClearDepth;
+			rlf::ClearStencil* ClearStencil;
+			rlf::Resolve* Resolve;
+			rlf::ObjDraw* ObjDraw;
 		};
 	};
 	struct Constant
@@ -422,6 +435,8 @@ namespace rlf
 		ast::Expression Expr;
 		VariableType Type;
 		Variable Value;
+		// Expressions which read Value, invalidated when it changes.
+		Array<ast::Expression*> Users;
 	};
 	struct Tuneable
 	{
@@ -430,6 +445,7 @@ namespace rlf
 		Variable Value;
 		Variable Min;
 		Variable Max;
+		Array<ast::Expression*> Users;
 	};
 	struct RenderDescription
 	{
@@ -447,13 +463,36 @@ namespace rlf
 		Array<View*> Views;
 		Array<RasterizerState*> RasterizerStates;
 		Array<DepthStencilState*> DepthStencilStates;
+		// In evaluation order, with the hidden constants ShareExpressions adds
+		//	placed before their first use.
 		Array<Constant*> Constants;
 		Array<Tuneable*> Tuneables;
 		Array<Texture*> Outputs;
+		// Expressions calling Time() and DisplaySize() themselves, see
+		//	MarkChanged.
+		Array<ast::Expression*> TimeUsers;
+		Array<ast::Expression*> DisplaySizeUsers;
+		Array<SetConstantBatch> SetConstantBatches;
+
+		// Files other than the rlf which were read while parsing, relative to 
+		//	the working directory.
+		Array<const char*> Dependencies;
+
+		ExpressionStats ExprStats;
+		// The parser's scratch alloc, as it was when parsing finished.
+		alloc::Stats ScratchStats;
 
 		// TODO: Move D3D data into separate struct
 		Array<gfx::ShaderResourceView> OutputViews;
+		// Backing memory of the constant buffers, from InitD3D until ReleaseD3D.
+		alloc::Pool ConstantPool;
+		// Passes lowered by InitD3D, see LowerPasses.
+		Array<Command> Commands;
 
 		alloc::LinAlloc Alloc;
+
+		// Set when the description was loaded from a .rlfc, everything parsed
+		//	then lives in this file mapping rather than in Alloc.
+		void* MappedFile;
 	};
 }
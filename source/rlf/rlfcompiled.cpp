@@ -0,0 +1,971 @@
+
+namespace rlf
+{
+
+namespace compiled
+{
+
+/*
+	File layout, all offsets are from the start of the file:
+		Header
+		Image: the arena blocks and the RenderDescription, copied verbatim
+			except that every pointer into them holds an offset into the image
+			and every expression location holds an offset into the source.
+		Pointer relocations: u32 image offsets of the pointers to fix up.
+		Location relocations: u32 image offsets of the locations to fix up.
+		Dependencies
+
+	Loading maps the file copy-on-write and adds the image and source base
+	addresses back in, only the pages holding pointers get copied.
+*/
+
+constexpr u32 Magic = 'R' | ('L' << 8) | ('F' << 16) | ('C' << 24);
+// Bump when the file layout changes. Changes to the serialized structs and to
+//	the enums generated from tuples are caught by LayoutHash.
+constexpr u32 Version = 3;
+// Keeps objects at the same alignment they had in the arena.
+constexpr u32 ImageAlignment = 16;
+static_assert(ImageAlignment >= alloc::DefaultAlignment, 
+	"Arena allocations would lose their alignment in the image.");
+
+struct Header
+{
+	u32 Magic;
+	u32 Version;
+	u32 LayoutHash;
+	u32 FileSize;
+	u64 SourceHash;
+	u32 SourceSize;
+	u32 ImageOffset;
+	u32 ImageSize;
+	u32 DescriptionOffset;		// within the image
+	u32 PointerCount;
+	u32 PointerOffset;
+	u32 LocationCount;
+	u32 LocationOffset;
+	u32 DependencyCount;
+	u32 DependencyOffset;
+};
+
+struct Dependency
+{
+	u64 WriteTime;
+	u32 Size;
+	u32 PathOffset;				// within the image
+};
+
+u64 HashBytes(const void* data, u32 size)
+{
+	// 64-bit FNV-1a
+	const u8* bytes = (const u8*)data;
+	u64 hash = 14695981039346656037ull;
+	for (u32 i = 0 ; i < size ; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// The image is mapped as it was saved, so a file is only current if every
+//	struct in it has the same size and offsets and every enum generated from a
+//	tuple the same values. Reordering the values of the other enums still
+//	needs a Version bump.
+u32 LayoutHash()
+{
+#define LAYOUT_SIZE(type) (u32)sizeof(type),
+#define LAYOUT_FIELD(type, field) (u32)offsetof(type, field),
+	const u32 layout[] = {
+		(u32)sizeof(void*),
+		LAYOUT_SIZE(VariableType) LAYOUT_FIELD(VariableType, Fmt)
+			LAYOUT_FIELD(VariableType, Dim)
+		LAYOUT_SIZE(Array<u8>) LAYOUT_FIELD(Array<u8>, Count)
+			LAYOUT_FIELD(Array<u8>, Data)
+		LAYOUT_SIZE(ExpressionStats) LAYOUT_FIELD(ExpressionStats, Expressions)
+			LAYOUT_FIELD(ExpressionStats, Nodes)
+			LAYOUT_FIELD(ExpressionStats, FoldedNodes)
+			LAYOUT_FIELD(ExpressionStats, SharedSubtrees)
+			LAYOUT_FIELD(ExpressionStats, SavedEvaluations)
+		LAYOUT_SIZE(alloc::Stats) LAYOUT_FIELD(alloc::Stats, UsedSize)
+			LAYOUT_FIELD(alloc::Stats, CommittedSize)
+			LAYOUT_FIELD(alloc::Stats, ReservedSize)
+			LAYOUT_FIELD(alloc::Stats, BlockCount) LAYOUT_FIELD(alloc::Stats, WastedSize)
+			LAYOUT_FIELD(alloc::Stats, PeakSize)
+		LAYOUT_SIZE(alloc::LinAlloc) LAYOUT_FIELD(alloc::LinAlloc, CurrentBlock)
+			LAYOUT_FIELD(alloc::LinAlloc, NextOffset)
+			LAYOUT_FIELD(alloc::LinAlloc, LastOffset)
+			LAYOUT_FIELD(alloc::LinAlloc, PageSize)
+			LAYOUT_FIELD(alloc::LinAlloc, RetiredSize)
+			LAYOUT_FIELD(alloc::LinAlloc, PeakSize)
+		LAYOUT_SIZE(alloc::Pool) LAYOUT_FIELD(alloc::Pool, Slabs)
+			LAYOUT_FIELD(alloc::Pool, FreeLists)
+		LAYOUT_SIZE(RenderDescription) LAYOUT_FIELD(RenderDescription, Passes)
+			LAYOUT_FIELD(RenderDescription, Dispatches)
+			LAYOUT_FIELD(RenderDescription, Draws)
+			LAYOUT_FIELD(RenderDescription, ObjDraws)
+			LAYOUT_FIELD(RenderDescription, CShaders)
+			LAYOUT_FIELD(RenderDescription, VShaders)
+			LAYOUT_FIELD(RenderDescription, PShaders)
+			LAYOUT_FIELD(RenderDescription, SizeOfRequests)
+			LAYOUT_FIELD(RenderDescription, Buffers)
+			LAYOUT_FIELD(RenderDescription, Textures)
+			LAYOUT_FIELD(RenderDescription, Samplers)
+			LAYOUT_FIELD(RenderDescription, Views)
+			LAYOUT_FIELD(RenderDescription, RasterizerStates)
+			LAYOUT_FIELD(RenderDescription, DepthStencilStates)
+			LAYOUT_FIELD(RenderDescription, Constants)
+			LAYOUT_FIELD(RenderDescription, Tuneables)
+			LAYOUT_FIELD(RenderDescription, Outputs)
+			LAYOUT_FIELD(RenderDescription, TimeUsers)
+			LAYOUT_FIELD(RenderDescription, DisplaySizeUsers)
+			LAYOUT_FIELD(RenderDescription, SetConstantBatches)
+			LAYOUT_FIELD(RenderDescription, Dependencies)
+			LAYOUT_FIELD(RenderDescription, ExprStats)
+			LAYOUT_FIELD(RenderDescription, ScratchStats)
+			LAYOUT_FIELD(RenderDescription, OutputViews)
+			LAYOUT_FIELD(RenderDescription, ConstantPool)
+			LAYOUT_FIELD(RenderDescription, Commands)
+			LAYOUT_FIELD(RenderDescription, Alloc)
+			LAYOUT_FIELD(RenderDescription, MappedFile)
+		LAYOUT_SIZE(Pass) LAYOUT_FIELD(Pass, Name) LAYOUT_FIELD(Pass, Type)
+			LAYOUT_FIELD(Pass, Dispatch) LAYOUT_FIELD(Pass, Draw)
+			LAYOUT_FIELD(Pass, ClearColor) LAYOUT_FIELD(Pass, ClearDepth)
+			LAYOUT_FIELD(Pass, ClearStencil) LAYOUT_FIELD(Pass, Resolve)
+			LAYOUT_FIELD(Pass, ObjDraw)
+		LAYOUT_SIZE(Dispatch) LAYOUT_FIELD(Dispatch, Shader)
+			LAYOUT_FIELD(Dispatch, ThreadPerPixel) LAYOUT_FIELD(Dispatch, Groups)
+			LAYOUT_FIELD(Dispatch, IndirectArgs)
+			LAYOUT_FIELD(Dispatch, IndirectArgsOffset) LAYOUT_FIELD(Dispatch, Binds)
+			LAYOUT_FIELD(Dispatch, Constants) LAYOUT_FIELD(Dispatch, CBs)
+			LAYOUT_FIELD(Dispatch, GfxState)
+		LAYOUT_SIZE(Draw) LAYOUT_FIELD(Draw, Topology) LAYOUT_FIELD(Draw, RState)
+			LAYOUT_FIELD(Draw, DSState) LAYOUT_FIELD(Draw, VShader)
+			LAYOUT_FIELD(Draw, PShader) LAYOUT_FIELD(Draw, VertexBuffers)
+			LAYOUT_FIELD(Draw, IndexBuffer) LAYOUT_FIELD(Draw, InstancedIndirectArgs)
+			LAYOUT_FIELD(Draw, IndexedInstancedIndirectArgs)
+			LAYOUT_FIELD(Draw, IndirectArgsOffset) LAYOUT_FIELD(Draw, VertexCount)
+			LAYOUT_FIELD(Draw, InstanceCount) LAYOUT_FIELD(Draw, StencilRef)
+			LAYOUT_FIELD(Draw, RenderTargets) LAYOUT_FIELD(Draw, DepthStencil)
+			LAYOUT_FIELD(Draw, Viewports) LAYOUT_FIELD(Draw, BlendStates)
+			LAYOUT_FIELD(Draw, VSBinds) LAYOUT_FIELD(Draw, PSBinds)
+			LAYOUT_FIELD(Draw, VSConstants) LAYOUT_FIELD(Draw, PSConstants)
+			LAYOUT_FIELD(Draw, VSCBs) LAYOUT_FIELD(Draw, PSCBs)
+			LAYOUT_FIELD(Draw, BlendGfxState) LAYOUT_FIELD(Draw, GfxState)
+		LAYOUT_SIZE(ObjDraw) LAYOUT_FIELD(ObjDraw, PerMeshDraws)
+		LAYOUT_SIZE(ClearColor) LAYOUT_FIELD(ClearColor, Target)
+			LAYOUT_FIELD(ClearColor, Color)
+		LAYOUT_SIZE(ClearDepth) LAYOUT_FIELD(ClearDepth, Target)
+			LAYOUT_FIELD(ClearDepth, Depth)
+		LAYOUT_SIZE(ClearStencil) LAYOUT_FIELD(ClearStencil, Target)
+			LAYOUT_FIELD(ClearStencil, Stencil)
+		LAYOUT_SIZE(Resolve) LAYOUT_FIELD(Resolve, Src) LAYOUT_FIELD(Resolve, Dst)
+		LAYOUT_SIZE(CommonShader) LAYOUT_FIELD(CommonShader, ShaderPath)
+			LAYOUT_FIELD(CommonShader, EntryPoint) LAYOUT_FIELD(CommonShader, Reflector)
+		LAYOUT_SIZE(ComputeShader) LAYOUT_FIELD(ComputeShader, Common)
+			LAYOUT_FIELD(ComputeShader, GfxState)
+			LAYOUT_FIELD(ComputeShader, ThreadGroupSize)
+		LAYOUT_SIZE(VertexShader) LAYOUT_FIELD(VertexShader, Common)
+			LAYOUT_FIELD(VertexShader, InputLayout) LAYOUT_FIELD(VertexShader, GfxState)
+			LAYOUT_FIELD(VertexShader, LayoutGfxState)
+		LAYOUT_SIZE(PixelShader) LAYOUT_FIELD(PixelShader, Common)
+			LAYOUT_FIELD(PixelShader, GfxState)
+		LAYOUT_SIZE(InputElementDesc) LAYOUT_FIELD(InputElementDesc, SemanticName)
+			LAYOUT_FIELD(InputElementDesc, SemanticIndex)
+			LAYOUT_FIELD(InputElementDesc, Format)
+			LAYOUT_FIELD(InputElementDesc, InputSlot)
+			LAYOUT_FIELD(InputElementDesc, AlignedByteOffset)
+			LAYOUT_FIELD(InputElementDesc, InputSlotClass)
+			LAYOUT_FIELD(InputElementDesc, InstanceDataStepRate)
+		LAYOUT_SIZE(SizeOfRequest) LAYOUT_FIELD(SizeOfRequest, Shader)
+			LAYOUT_FIELD(SizeOfRequest, Dest)
+		LAYOUT_SIZE(Buffer) LAYOUT_FIELD(Buffer, ElementSize)
+			LAYOUT_FIELD(Buffer, ElementSizeExpr) LAYOUT_FIELD(Buffer, ElementCount)
+			LAYOUT_FIELD(Buffer, ElementCountExpr) LAYOUT_FIELD(Buffer, InitToZero)
+			LAYOUT_FIELD(Buffer, InitData) LAYOUT_FIELD(Buffer, InitDataSize)
+			LAYOUT_FIELD(Buffer, Flags) LAYOUT_FIELD(Buffer, GfxState)
+		LAYOUT_SIZE(Texture) LAYOUT_FIELD(Texture, Size) LAYOUT_FIELD(Texture, SizeExpr)
+			LAYOUT_FIELD(Texture, Format) LAYOUT_FIELD(Texture, FromFile)
+			LAYOUT_FIELD(Texture, Flags) LAYOUT_FIELD(Texture, SampleCount)
+			LAYOUT_FIELD(Texture, GfxState)
+		LAYOUT_SIZE(Sampler) LAYOUT_FIELD(Sampler, Filter)
+			LAYOUT_FIELD(Sampler, AddressMode) LAYOUT_FIELD(Sampler, MipLODBias)
+			LAYOUT_FIELD(Sampler, MaxAnisotropy) LAYOUT_FIELD(Sampler, BorderColor)
+			LAYOUT_FIELD(Sampler, MinLOD) LAYOUT_FIELD(Sampler, MaxLOD)
+			LAYOUT_FIELD(Sampler, GfxState)
+		LAYOUT_SIZE(FilterMode) LAYOUT_FIELD(FilterMode, Min)
+			LAYOUT_FIELD(FilterMode, Mag) LAYOUT_FIELD(FilterMode, Mip)
+		LAYOUT_SIZE(AddressModeUVW) LAYOUT_FIELD(AddressModeUVW, U)
+			LAYOUT_FIELD(AddressModeUVW, V) LAYOUT_FIELD(AddressModeUVW, W)
+		LAYOUT_SIZE(View) LAYOUT_FIELD(View, Type) LAYOUT_FIELD(View, ResourceType)
+			LAYOUT_FIELD(View, Buffer) LAYOUT_FIELD(View, Texture)
+			LAYOUT_FIELD(View, Format) LAYOUT_FIELD(View, NumElements)
+			LAYOUT_FIELD(View, SRVGfxState) LAYOUT_FIELD(View, UAVGfxState)
+			LAYOUT_FIELD(View, RTVGfxState) LAYOUT_FIELD(View, DSVGfxState)
+		LAYOUT_SIZE(Viewport) LAYOUT_FIELD(Viewport, TopLeft) LAYOUT_FIELD(Viewport, Size)
+			LAYOUT_FIELD(Viewport, DepthRange)
+		LAYOUT_SIZE(BlendState) LAYOUT_FIELD(BlendState, Enable)
+			LAYOUT_FIELD(BlendState, Src) LAYOUT_FIELD(BlendState, Dest)
+			LAYOUT_FIELD(BlendState, Op) LAYOUT_FIELD(BlendState, SrcAlpha)
+			LAYOUT_FIELD(BlendState, DestAlpha) LAYOUT_FIELD(BlendState, OpAlpha)
+			LAYOUT_FIELD(BlendState, RenderTargetWriteMask)
+		LAYOUT_SIZE(RasterizerState) LAYOUT_FIELD(RasterizerState, Fill)
+			LAYOUT_FIELD(RasterizerState, CullMode)
+			LAYOUT_FIELD(RasterizerState, FrontCCW)
+			LAYOUT_FIELD(RasterizerState, DepthBias)
+			LAYOUT_FIELD(RasterizerState, SlopeScaledDepthBias)
+			LAYOUT_FIELD(RasterizerState, DepthBiasClamp)
+			LAYOUT_FIELD(RasterizerState, DepthClipEnable)
+			LAYOUT_FIELD(RasterizerState, ScissorEnable)
+			LAYOUT_FIELD(RasterizerState, MultisampleEnable)
+			LAYOUT_FIELD(RasterizerState, AntialiasedLineEnable)
+			LAYOUT_FIELD(RasterizerState, GfxState)
+		LAYOUT_SIZE(StencilOpDesc) LAYOUT_FIELD(StencilOpDesc, StencilFailOp)
+			LAYOUT_FIELD(StencilOpDesc, StencilDepthFailOp)
+			LAYOUT_FIELD(StencilOpDesc, StencilPassOp)
+			LAYOUT_FIELD(StencilOpDesc, StencilFunc)
+		LAYOUT_SIZE(DepthStencilState) LAYOUT_FIELD(DepthStencilState, DepthEnable)
+			LAYOUT_FIELD(DepthStencilState, DepthWrite)
+			LAYOUT_FIELD(DepthStencilState, DepthFunc)
+			LAYOUT_FIELD(DepthStencilState, StencilEnable)
+			LAYOUT_FIELD(DepthStencilState, StencilReadMask)
+			LAYOUT_FIELD(DepthStencilState, StencilWriteMask)
+			LAYOUT_FIELD(DepthStencilState, FrontFace)
+			LAYOUT_FIELD(DepthStencilState, BackFace)
+			LAYOUT_FIELD(DepthStencilState, GfxState)
+		LAYOUT_SIZE(Bind) LAYOUT_FIELD(Bind, BindTarget) LAYOUT_FIELD(Bind, Type)
+			LAYOUT_FIELD(Bind, SamplerBind) LAYOUT_FIELD(Bind, ViewBind)
+			LAYOUT_FIELD(Bind, IsOutput) LAYOUT_FIELD(Bind, BindIndex)
+		LAYOUT_SIZE(ConstantBuffer) LAYOUT_FIELD(ConstantBuffer, BackingMemory)
+			LAYOUT_FIELD(ConstantBuffer, GfxState) LAYOUT_FIELD(ConstantBuffer, Name)
+			LAYOUT_FIELD(ConstantBuffer, Slot) LAYOUT_FIELD(ConstantBuffer, Size)
+		LAYOUT_SIZE(SetConstant) LAYOUT_FIELD(SetConstant, VariableName)
+			LAYOUT_FIELD(SetConstant, Value) LAYOUT_FIELD(SetConstant, CB)
+			LAYOUT_FIELD(SetConstant, Offset) LAYOUT_FIELD(SetConstant, Size)
+			LAYOUT_FIELD(SetConstant, Type)
+		LAYOUT_SIZE(SetConstantBatch) LAYOUT_FIELD(SetConstantBatch, Sets)
+		LAYOUT_SIZE(Constant) LAYOUT_FIELD(Constant, Name) LAYOUT_FIELD(Constant, Expr)
+			LAYOUT_FIELD(Constant, Type) LAYOUT_FIELD(Constant, Value)
+			LAYOUT_FIELD(Constant, Users)
+		LAYOUT_SIZE(Tuneable) LAYOUT_FIELD(Tuneable, Name) LAYOUT_FIELD(Tuneable, Type)
+			LAYOUT_FIELD(Tuneable, Value) LAYOUT_FIELD(Tuneable, Min)
+			LAYOUT_FIELD(Tuneable, Max) LAYOUT_FIELD(Tuneable, Users)
+		LAYOUT_SIZE(ast::Node) LAYOUT_FIELD(ast::Node, Location)
+			LAYOUT_FIELD(ast::Node, Type) LAYOUT_FIELD(ast::Node, ResultType)
+		LAYOUT_SIZE(ast::Result) LAYOUT_FIELD(ast::Result, Type)
+			LAYOUT_FIELD(ast::Result, Value)
+		LAYOUT_SIZE(ast::DependencyInfo) LAYOUT_FIELD(ast::DependencyInfo, VariesByFlags)
+			LAYOUT_FIELD(ast::DependencyInfo, Tuneables)
+			LAYOUT_FIELD(ast::DependencyInfo, Constants)
+		LAYOUT_SIZE(ast::Expression) LAYOUT_FIELD(ast::Expression, TopNode)
+			LAYOUT_FIELD(ast::Expression, Code) LAYOUT_FIELD(ast::Expression, Dep)
+			LAYOUT_FIELD(ast::Expression, CachedResult)
+			LAYOUT_FIELD(ast::Expression, CacheValid)
+			LAYOUT_FIELD(ast::Expression, NodeCount)
+		LAYOUT_SIZE(ast::UintLiteral) LAYOUT_FIELD(ast::UintLiteral, Common)
+			LAYOUT_FIELD(ast::UintLiteral, Val)
+		LAYOUT_SIZE(ast::IntLiteral) LAYOUT_FIELD(ast::IntLiteral, Common)
+			LAYOUT_FIELD(ast::IntLiteral, Val)
+		LAYOUT_SIZE(ast::FloatLiteral) LAYOUT_FIELD(ast::FloatLiteral, Common)
+			LAYOUT_FIELD(ast::FloatLiteral, Val)
+		LAYOUT_SIZE(ast::Subscript) LAYOUT_FIELD(ast::Subscript, Common)
+			LAYOUT_FIELD(ast::Subscript, Subject) LAYOUT_FIELD(ast::Subscript, Index)
+		LAYOUT_SIZE(ast::Group) LAYOUT_FIELD(ast::Group, Common)
+			LAYOUT_FIELD(ast::Group, Sub)
+		LAYOUT_SIZE(ast::BinaryOp) LAYOUT_FIELD(ast::BinaryOp, Common)
+			LAYOUT_FIELD(ast::BinaryOp, LArg) LAYOUT_FIELD(ast::BinaryOp, RArg)
+			LAYOUT_FIELD(ast::BinaryOp, Op) LAYOUT_FIELD(ast::BinaryOp, Kernel)
+		LAYOUT_SIZE(ast::Join) LAYOUT_FIELD(ast::Join, Common)
+			LAYOUT_FIELD(ast::Join, Comps)
+		LAYOUT_SIZE(ast::VariableRef) LAYOUT_FIELD(ast::VariableRef, Common)
+			LAYOUT_FIELD(ast::VariableRef, IsTuneable) LAYOUT_FIELD(ast::VariableRef, M)
+		LAYOUT_SIZE(ast::Function) LAYOUT_FIELD(ast::Function, Common)
+			LAYOUT_FIELD(ast::Function, Name) LAYOUT_FIELD(ast::Function, Args)
+			LAYOUT_FIELD(ast::Function, Func)
+		LAYOUT_SIZE(ast::SizeOf) LAYOUT_FIELD(ast::SizeOf, Common)
+			LAYOUT_FIELD(ast::SizeOf, StructName) LAYOUT_FIELD(ast::SizeOf, Size)
+		LAYOUT_SIZE(ast::Conversion) LAYOUT_FIELD(ast::Conversion, Common)
+			LAYOUT_FIELD(ast::Conversion, Sub) LAYOUT_FIELD(ast::Conversion, Kernel)
+		LAYOUT_SIZE(ast::Folded) LAYOUT_FIELD(ast::Folded, Common)
+			LAYOUT_FIELD(ast::Folded, Val)
+		LAYOUT_SIZE(ast::Program) LAYOUT_FIELD(ast::Program, Code)
+			LAYOUT_FIELD(ast::Program, Constants) LAYOUT_FIELD(ast::Program, Variables)
+			LAYOUT_FIELD(ast::Program, Nodes) LAYOUT_FIELD(ast::Program, ResultType)
+		LAYOUT_SIZE(ast::Instruction) LAYOUT_FIELD(ast::Instruction, Op)
+			LAYOUT_FIELD(ast::Instruction, Dst) LAYOUT_FIELD(ast::Instruction, A)
+			LAYOUT_FIELD(ast::Instruction, B) LAYOUT_FIELD(ast::Instruction, Count)
+			LAYOUT_FIELD(ast::Instruction, Lane) LAYOUT_FIELD(ast::Instruction, Index)
+	};
+#undef LAYOUT_SIZE
+#undef LAYOUT_FIELD
+
+#define NODE_TYPE_ENTRY(type, eval_func, dep_func, check_func) #type ","
+#define FUNCTION_ENTRY(name, eval_func, varies_by) #name ","
+#define OPCODE_ENTRY(name) #name ","
+#define COMMAND_ENTRY(name) #name ","
+#define RLF_TEXTUREFORMAT_ENTRY(name) #name ","
+	const char enums[] =
+		NODE_TYPE_TUPLE ";"
+		FUNCTION_TUPLE ";"
+		OPCODE_TUPLE ";"
+		COMMAND_TUPLE ";"
+		RLF_TEXTUREFORMAT_TUPLE;
+#undef NODE_TYPE_ENTRY
+#undef FUNCTION_ENTRY
+#undef OPCODE_ENTRY
+#undef COMMAND_ENTRY
+#undef RLF_TEXTUREFORMAT_ENTRY
+
+	u64 hash = HashBytes(layout, sizeof(layout)) ^ HashBytes(enums, sizeof(enums)) * 31;
+	return (u32)(hash ^ (hash >> 32));
+}
+
+u32 AlignUp(u32 value, u32 alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// ----- SAVING -----
+
+struct Writer
+{
+	// Memory copied into the image, sorted by address.
+	struct Range
+	{
+		const u8* Base;
+		u32 Size;
+		u32 ImageOffset;
+	};
+	std::vector<Range> ranges;
+	std::vector<u8> image;
+
+	std::vector<u32> pointers;
+	std::vector<u32> locations;
+	// Arrays are shared between draws instantiated from a template, so a
+	//	pointer can be reached more than once.
+	std::unordered_set<u32> relocated;
+	std::unordered_set<const void*> visited;
+
+	const char* source;
+	u32 sourceSize;
+	bool valid;
+};
+
+bool FindImageOffset(const Writer& w, const void* address, u32* outOffset)
+{
+	const u8* a = (const u8*)address;
+	auto it = std::upper_bound(w.ranges.begin(), w.ranges.end(), a,
+		[](const u8* value, const Writer::Range& r) { return value < r.Base; });
+	if (it == w.ranges.begin())
+		return false;
+	--it;
+	if (a >= it->Base + it->Size)
+		return false;
+	*outOffset = it->ImageOffset + (u32)(a - it->Base);
+	return true;
+}
+
+// slot is the address of a pointer in the description, it's rewritten in the
+//	image copy.
+void RelocatePointer(Writer& w, const void* slot)
+{
+	const void* target;
+	memcpy(&target, slot, sizeof(target));
+	if (target == nullptr)
+		return;
+	u32 slotOffset;
+	u32 targetOffset;
+	if (!FindImageOffset(w, slot, &slotOffset) ||
+		!FindImageOffset(w, target, &targetOffset))
+	{
+		// Points outside of the arena, can't be saved.
+		w.valid = false;
+		return;
+	}
+	if (!w.relocated.insert(slotOffset).second)
+		return;
+	w.pointers.push_back(slotOffset);
+	uintptr_t value = targetOffset;
+	memcpy(&w.image[slotOffset], &value, sizeof(value));
+}
+
+void RelocateLocation(Writer& w, const char* const* slot)
+{
+	const char* location = *slot;
+	if (location == nullptr)
+		return;
+	u32 slotOffset;
+	if (location < w.source || location > w.source + w.sourceSize ||
+		!FindImageOffset(w, slot, &slotOffset))
+	{
+		w.valid = false;
+		return;
+	}
+	if (!w.relocated.insert(slotOffset).second)
+		return;
+	w.locations.push_back(slotOffset);
+	uintptr_t value = location - w.source;
+	memcpy(&w.image[slotOffset], &value, sizeof(value));
+}
+
+template <typename T>
+void VisitRef(Writer& w, T* const& ref)
+{
+	RelocatePointer(w, &ref);
+	if (ref && w.visited.insert(ref).second)
+		Visit(w, *ref);
+}
+
+template <typename T>
+void Visit(Writer& w, T* const& ref)
+{
+	VisitRef(w, ref);
+}
+
+template <typename T>
+void VisitArray(Writer& w, const Array<T>& arr)
+{
+	RelocatePointer(w, &arr.Data);
+	for (u32 i = 0 ; i < arr.Count ; ++i)
+		Visit(w, arr.Data[i]);
+}
+
+void Visit(Writer& w, const char* const& str)
+{
+	RelocatePointer(w, &str);
+}
+
+void Visit(Writer& w, const ast::Node& node)
+{
+	RelocateLocation(w, &node.Location);
+	switch (node.Type)
+	{
+	case ast::NodeType::UintLiteral:
+	case ast::NodeType::IntLiteral:
+	case ast::NodeType::FloatLiteral:
+	case ast::NodeType::Folded:
+		break;
+	case ast::NodeType::Subscript:
+		VisitRef(w, ((const ast::Subscript&)node).Subject);
+		break;
+	case ast::NodeType::Group:
+		VisitRef(w, ((const ast::Group&)node).Sub);
+		break;
+	case ast::NodeType::BinaryOp:
+	{
+		const ast::BinaryOp& bop = (const ast::BinaryOp&)node;
+		VisitRef(w, bop.LArg);
+		VisitRef(w, bop.RArg);
+		break;
+	}
+	case ast::NodeType::Join:
+		VisitArray(w, ((const ast::Join&)node).Comps);
+		break;
+	case ast::NodeType::VariableRef:
+		// Constants and tuneables are visited from the description.
+		RelocatePointer(w, &((const ast::VariableRef&)node).M);
+		break;
+	case ast::NodeType::Function:
+	{
+		const ast::Function& func = (const ast::Function&)node;
+		Visit(w, func.Name);
+		VisitArray(w, func.Args);
+		break;
+	}
+	case ast::NodeType::SizeOf:
+		Visit(w, ((const ast::SizeOf&)node).StructName);
+		break;
+	case ast::NodeType::Conversion:
+		VisitRef(w, ((const ast::Conversion&)node).Sub);
+		break;
+	default:
+		Unimplemented();
+	}
+}
+
+void Visit(Writer& w, const ast::SizeOf& sizeOf)
+{
+	Visit(w, sizeOf.Common);
+}
+
+void Visit(Writer& w, const ast::Program& prog)
+{
+	RelocatePointer(w, &prog.Code.Data);
+	RelocatePointer(w, &prog.Constants.Data);
+	RelocatePointer(w, &prog.Variables.Data);
+	for (u32 i = 0 ; i < prog.Variables.Count ; ++i)
+		RelocatePointer(w, &prog.Variables.Data[i]);
+	VisitArray(w, prog.Nodes);
+}
+
+void Visit(Writer& w, const ast::Expression& expr)
+{
+	VisitRef(w, expr.TopNode);
+	VisitRef(w, expr.Code);
+	VisitArray(w, expr.Dep.Tuneables);
+	VisitArray(w, expr.Dep.Constants);
+}
+
+void Visit(Writer&, const RasterizerState&) {}
+void Visit(Writer&, const DepthStencilState&) {}
+void Visit(Writer&, const BlendState&) {}
+void Visit(Writer&, const Sampler&) {}
+
+void Visit(Writer& w, const InputElementDesc& desc)
+{
+	RelocatePointer(w, &desc.SemanticName);
+}
+
+void Visit(Writer& w, const CommonShader& common)
+{
+	Visit(w, common.ShaderPath);
+	Visit(w, common.EntryPoint);
+}
+
+void Visit(Writer& w, const ComputeShader& cs)
+{
+	Visit(w, cs.Common);
+}
+
+void Visit(Writer& w, const VertexShader& vs)
+{
+	Visit(w, vs.Common);
+	VisitArray(w, vs.InputLayout);
+}
+
+void Visit(Writer& w, const PixelShader& ps)
+{
+	Visit(w, ps.Common);
+}
+
+void Visit(Writer& w, const SizeOfRequest& req)
+{
+	// The shader is visited from the description, Shader points at its
+	//	CommonShader member.
+	RelocatePointer(w, &req.Shader);
+	VisitRef(w, req.Dest);
+}
+
+void Visit(Writer& w, const Buffer& buf)
+{
+	Visit(w, buf.ElementSizeExpr);
+	Visit(w, buf.ElementCountExpr);
+	RelocatePointer(w, &buf.InitData);
+}
+
+void Visit(Writer& w, const Texture& tex)
+{
+	Visit(w, tex.SizeExpr);
+	Visit(w, tex.FromFile);
+}
+
+void Visit(Writer& w, const View& view)
+{
+	if (view.ResourceType == ResourceType::Buffer)
+		VisitRef(w, view.Buffer);
+	else
+		VisitRef(w, view.Texture);
+}
+
+void Visit(Writer& w, const Viewport& vp)
+{
+	Visit(w, vp.TopLeft);
+	Visit(w, vp.Size);
+	Visit(w, vp.DepthRange);
+}
+
+void Visit(Writer& w, const Bind& bind)
+{
+	Visit(w, bind.BindTarget);
+	if (bind.Type == BindType::Sampler)
+		VisitRef(w, bind.SamplerBind);
+	else
+		VisitRef(w, bind.ViewBind);
+}
+
+void Visit(Writer& w, const ConstantBuffer& cb)
+{
+	RelocatePointer(w, &cb.BackingMemory);
+}
+
+void Visit(Writer& w, const SetConstant& sc)
+{
+	Visit(w, sc.VariableName);
+	Visit(w, sc.Value);
+	RelocatePointer(w, &sc.CB);
+}
+
+void Visit(Writer& w, const SetConstantBatch& batch)
+{
+	VisitArray(w, batch.Sets);
+}
+
+void Visit(Writer& w, const Dispatch& dc)
+{
+	VisitRef(w, dc.Shader);
+	Visit(w, dc.Groups);
+	VisitRef(w, dc.IndirectArgs);
+	VisitArray(w, dc.Binds);
+	VisitArray(w, dc.Constants);
+	VisitArray(w, dc.CBs);
+}
+
+void Visit(Writer& w, const Draw& draw)
+{
+	VisitRef(w, draw.RState);
+	VisitRef(w, draw.DSState);
+	VisitRef(w, draw.VShader);
+	VisitRef(w, draw.PShader);
+	VisitArray(w, draw.VertexBuffers);
+	VisitRef(w, draw.IndexBuffer);
+	VisitRef(w, draw.InstancedIndirectArgs);
+	VisitRef(w, draw.IndexedInstancedIndirectArgs);
+	VisitArray(w, draw.RenderTargets);
+	VisitRef(w, draw.DepthStencil);
+	VisitArray(w, draw.Viewports);
+	VisitArray(w, draw.BlendStates);
+	VisitArray(w, draw.VSBinds);
+	VisitArray(w, draw.PSBinds);
+	VisitArray(w, draw.VSConstants);
+	VisitArray(w, draw.PSConstants);
+	VisitArray(w, draw.VSCBs);
+	VisitArray(w, draw.PSCBs);
+}
+
+void Visit(Writer& w, const ClearColor& clear)
+{
+	VisitRef(w, clear.Target);
+}
+
+void Visit(Writer& w, const ClearDepth& clear)
+{
+	VisitRef(w, clear.Target);
+}
+
+void Visit(Writer& w, const ClearStencil& clear)
+{
+	VisitRef(w, clear.Target);
+}
+
+void Visit(Writer& w, const Resolve& resolve)
+{
+	VisitRef(w, resolve.Src);
+	VisitRef(w, resolve.Dst);
+}
+
+void Visit(Writer& w, const ObjDraw& objDraw)
+{
+	VisitArray(w, objDraw.PerMeshDraws);
+}
+
+void Visit(Writer& w, const Pass& pass)
+{
+	Visit(w, pass.Name);
+	switch (pass.Type)
+	{
+	case PassType::Dispatch:
+		VisitRef(w, pass.Dispatch);
+		break;
+	case PassType::Draw:
+		VisitRef(w, pass.Draw);
+		break;
+	case PassType::ClearColor:
+		VisitRef(w, pass.ClearColor);
+		break;
+	case PassType::ClearDepth:
+		VisitRef(w, pass.ClearDepth);
+		break;
+	case PassType::ClearStencil:
+		VisitRef(w, pass.ClearStencil);
+		break;
+	case PassType::Resolve:
+		VisitRef(w, pass.Resolve);
+		break;
+	case PassType::ObjDraw:
+		VisitRef(w, pass.ObjDraw);
+		break;
+	default:
+		Unimplemented();
+	}
+}
+
+// The expressions are visited from whatever holds them.
+void RelocateUsers(Writer& w, const Array<ast::Expression*>& users)
+{
+	RelocatePointer(w, &users.Data);
+	for (u32 i = 0 ; i < users.Count ; ++i)
+		RelocatePointer(w, &users.Data[i]);
+}
+
+void Visit(Writer& w, const Constant& cnst)
+{
+	Visit(w, cnst.Name);
+	Visit(w, cnst.Expr);
+	RelocateUsers(w, cnst.Users);
+}
+
+void Visit(Writer& w, const Tuneable& tune)
+{
+	Visit(w, tune.Name);
+	RelocateUsers(w, tune.Users);
+}
+
+void Visit(Writer& w, const RenderDescription& rd)
+{
+	VisitArray(w, rd.Passes);
+	VisitArray(w, rd.Dispatches);
+	VisitArray(w, rd.Draws);
+	VisitArray(w, rd.ObjDraws);
+	VisitArray(w, rd.CShaders);
+	VisitArray(w, rd.VShaders);
+	VisitArray(w, rd.PShaders);
+	VisitArray(w, rd.SizeOfRequests);
+	VisitArray(w, rd.Buffers);
+	VisitArray(w, rd.Textures);
+	VisitArray(w, rd.Samplers);
+	VisitArray(w, rd.Views);
+	VisitArray(w, rd.RasterizerStates);
+	VisitArray(w, rd.DepthStencilStates);
+	VisitArray(w, rd.Constants);
+	VisitArray(w, rd.Tuneables);
+	VisitArray(w, rd.Outputs);
+	RelocateUsers(w, rd.TimeUsers);
+	RelocateUsers(w, rd.DisplaySizeUsers);
+	VisitArray(w, rd.SetConstantBatches);
+	VisitArray(w, rd.Dependencies);
+	// Only created by InitD3D.
+	if (rd.OutputViews.Count > 0 || rd.Commands.Count > 0)
+		w.valid = false;
+}
+
+void AddRange(Writer& w, const void* base, u32 size)
+{
+	u32 offset = AlignUp((u32)w.image.size(), ImageAlignment);
+	w.ranges.push_back({ (const u8*)base, size, offset });
+	w.image.resize(offset + size);
+	memcpy(&w.image[offset], base, size);
+}
+
+// ----- LOADING -----
+
+bool DependenciesCurrent(const Header& header, const u8* view,
+	const char* workingDir)
+{
+	const Dependency* deps = (const Dependency*)(view + header.DependencyOffset);
+	const char* image = (const char*)view + header.ImageOffset;
+	for (u32 i = 0 ; i < header.DependencyCount ; ++i)
+	{
+		const Dependency& dep = deps[i];
+		if (dep.PathOffset >= header.ImageSize ||
+			!memchr(image + dep.PathOffset, '\0', header.ImageSize - dep.PathOffset))
+			return false;
+
+		std::string path = workingDir;
+		path += image + dep.PathOffset;
+		HANDLE file = fileio::OpenFileOptional(path.c_str(), GENERIC_READ);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		bool current = fileio::GetFileSize(file) == dep.Size &&
+			fileio::GetFileWriteTime(file) == dep.WriteTime;
+		CloseHandle(file);
+		if (!current)
+			return false;
+	}
+	return true;
+}
+
+bool SectionInFile(u32 offset, u32 count, u32 elementSize, u32 fileSize)
+{
+	return (u64)offset + (u64)count * elementSize <= fileSize;
+}
+
+bool HeaderCurrent(const Header& header, u32 fileSize, const char* source,
+	u32 sourceSize)
+{
+	return header.Magic == Magic &&
+		header.Version == Version &&
+		header.LayoutHash == LayoutHash() &&
+		header.FileSize == fileSize &&
+		SectionInFile(header.ImageOffset, header.ImageSize, 1, fileSize) &&
+		SectionInFile(header.PointerOffset, header.PointerCount, sizeof(u32),
+			fileSize) &&
+		SectionInFile(header.LocationOffset, header.LocationCount, sizeof(u32),
+			fileSize) &&
+		SectionInFile(header.DependencyOffset, header.DependencyCount,
+			sizeof(Dependency), fileSize) &&
+		(u64)header.DescriptionOffset + sizeof(RenderDescription) <=
+			header.ImageSize &&
+		header.SourceSize == sourceSize &&
+		header.SourceHash == HashBytes(source, sourceSize);
+}
+
+// Adds base to each offset stored at the image offsets in relocs.
+bool ApplyRelocations(u8* image, u32 imageSize, const u32* relocs, u32 count,
+	uintptr_t base, u32 targetSize)
+{
+	for (u32 i = 0 ; i < count ; ++i)
+	{
+		if ((u64)relocs[i] + sizeof(uintptr_t) > imageSize)
+			return false;
+		uintptr_t value;
+		memcpy(&value, image + relocs[i], sizeof(value));
+		if (value > targetSize)
+			return false;
+		value += base;
+		memcpy(image + relocs[i], &value, sizeof(value));
+	}
+	return true;
+}
+
+} // namespace compiled
+
+bool SaveCompiled(
+	const char* path,
+	const RenderDescription* rd,
+	const char* source,
+	u32 sourceSize,
+	const char* workingDir,
+	ErrorState* errorState)
+{
+	using namespace compiled;
+
+	Assert(rd->MappedFile == nullptr, "Description is already compiled.");
+
+	Writer w;
+	w.source = source;
+	w.sourceSize = sourceSize;
+	w.valid = true;
+
+	std::vector<alloc::Block> blocks;
+	alloc::GetBlocks(&rd->Alloc, blocks);
+	for (const alloc::Block& block : blocks)
+		AddRange(w, block.Base, block.Size);
+	AddRange(w, rd, sizeof(RenderDescription));
+	u32 descriptionOffset = w.ranges.back().ImageOffset;
+
+	// The loaded description gets a fresh allocator for whatever InitD3D
+	//	allocates.
+	RenderDescription* imageRd = (RenderDescription*)&w.image[descriptionOffset];
+	ZeroMemory(&imageRd->Alloc, sizeof(imageRd->Alloc));
+
+	std::sort(w.ranges.begin(), w.ranges.end(),
+		[](const Writer::Range& l, const Writer::Range& r) { return l.Base < r.Base; });
+
+	Visit(w, *rd);
+	if (!w.valid)
+	{
+		errorState->Success = false;
+		errorState->Info.Message = "The description points outside of its arena, "
+			"or was already passed to InitD3D.";
+		return false;
+	}
+
+	std::vector<Dependency> deps;
+	for (u32 i = 0 ; i < rd->Dependencies.Count ; ++i)
+	{
+		const char* depPath = rd->Dependencies.Data[i];
+		std::string fullPath = workingDir;
+		fullPath += depPath;
+		HANDLE file = fileio::OpenFileOptional(fullPath.c_str(), GENERIC_READ);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			errorState->Success = false;
+			errorState->Info.Message = "Couldn't open dependency " + fullPath;
+			return false;
+		}
+		Dependency dep;
+		dep.WriteTime = fileio::GetFileWriteTime(file);
+		dep.Size = fileio::GetFileSize(file);
+		bool found = FindImageOffset(w, depPath, &dep.PathOffset);
+		Assert(found, "Dependency path isn't in the arena.");
+		deps.push_back(dep);
+		CloseHandle(file);
+	}
+
+	Header header = {};
+	header.Magic = Magic;
+	header.Version = Version;
+	header.LayoutHash = LayoutHash();
+	header.SourceHash = HashBytes(source, sourceSize);
+	header.SourceSize = sourceSize;
+	header.ImageOffset = AlignUp((u32)sizeof(Header), ImageAlignment);
+	header.ImageSize = (u32)w.image.size();
+	header.DescriptionOffset = descriptionOffset;
+	header.PointerCount = (u32)w.pointers.size();
+	header.PointerOffset = AlignUp(header.ImageOffset + header.ImageSize,
+		(u32)sizeof(u32));
+	header.LocationCount = (u32)w.locations.size();
+	header.LocationOffset = header.PointerOffset +
+		header.PointerCount * (u32)sizeof(u32);
+	header.DependencyCount = (u32)deps.size();
+	header.DependencyOffset = AlignUp(header.LocationOffset +
+		header.LocationCount * (u32)sizeof(u32), (u32)sizeof(u64));
+	header.FileSize = header.DependencyOffset +
+		header.DependencyCount * (u32)sizeof(Dependency);
+
+	std::vector<u8> file(header.FileSize, 0);
+	memcpy(&file[0], &header, sizeof(header));
+	memcpy(&file[header.ImageOffset], w.image.data(), header.ImageSize);
+	if (header.PointerCount > 0)
+		memcpy(&file[header.PointerOffset], w.pointers.data(),
+			header.PointerCount * sizeof(u32));
+	if (header.LocationCount > 0)
+		memcpy(&file[header.LocationOffset], w.locations.data(),
+			header.LocationCount * sizeof(u32));
+	if (header.DependencyCount > 0)
+		memcpy(&file[header.DependencyOffset], deps.data(),
+			header.DependencyCount * sizeof(Dependency));
+
+	HANDLE handle = fileio::CreateFileTryOverwrite(path, GENERIC_WRITE);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		errorState->Success = false;
+		errorState->Info.Message = std::string("Couldn't create ") + path;
+		return false;
+	}
+	fileio::WriteFile(handle, file.data(), header.FileSize);
+	CloseHandle(handle);
+	return true;
+}
+
+RenderDescription* LoadCompiled(
+	const char* path,
+	const char* source,
+	u32 sourceSize,
+	const char* workingDir)
+{
+	using namespace compiled;
+
+	HANDLE file = fileio::OpenFileOptional(path, GENERIC_READ);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	u32 fileSize = fileio::GetFileSize(file);
+	u8* view = nullptr;
+	if (fileSize >= sizeof(Header))
+		view = (u8*)fileio::MapFileCopyOnWrite(file);
+	CloseHandle(file);
+	if (view == nullptr)
+		return nullptr;
+
+	const Header& header = *(const Header*)view;
+	u8* image = view + header.ImageOffset;
+	bool loaded = HeaderCurrent(header, fileSize, source, sourceSize) &&
+		DependenciesCurrent(header, view, workingDir) &&
+		ApplyRelocations(image, header.ImageSize,
+			(const u32*)(view + header.PointerOffset), header.PointerCount,
+			(uintptr_t)image, header.ImageSize) &&
+		ApplyRelocations(image, header.ImageSize,
+			(const u32*)(view + header.LocationOffset), header.LocationCount,
+			(uintptr_t)source, sourceSize);
+	if (!loaded)
+	{
+		fileio::UnmapFile(view);
+		return nullptr;
+	}
+
+	RenderDescription* rd = (RenderDescription*)(image + header.DescriptionOffset);
+	rd->MappedFile = view;
+	alloc::Init(&rd->Alloc);
+	return rd;
+}
+
+} // namespace rlf
@@ -0,0 +1,27 @@
+
+namespace rlf
+{
+	// A .rlfc holds a parsed RenderDescription as it was laid out in the arena,
+	//	with pointers stored as offsets. As long as the rlf and the files it
+	//	read haven't changed it can be mapped back in instead of re-parsing.
+
+	// Must be called on a freshly parsed description, before InitD3D. Returns
+	//	false if nothing was written, with the reason in errorState.
+	bool SaveCompiled(
+		const char* path,
+		const RenderDescription* rd,
+		const char* source,
+		u32 sourceSize,
+		const char* workingDir,
+		ErrorState* errorState);
+
+	// Returns nullptr when there's no compiled file or it's stale: built from
+	//	different source or dependencies, or by a different version of the
+	//	parser. Expression locations point into source, which must outlive the
+	//	description. Release the result with ReleaseData as usual.
+	RenderDescription* LoadCompiled(
+		const char* path,
+		const char* source,
+		u32 sourceSize,
+		const char* workingDir);
+}
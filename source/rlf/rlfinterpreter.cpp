@@ -25,22 +25,20 @@ do {												\
 
 void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::Result& res)
 {
-	ErrorState es;
-	ast::Evaluate(ec, expr, res, es);
-	if (!es.Success)
+	ast::EvaluationError err;
+	if (!ast::Evaluate(ec, expr, res, err))
 	{
-		ErrorInfo ee;
-		ee.Location = es.Info.Location;
-		ee.Message = "AST evaluation error: " + es.Info.Message;
+		ErrorInfo ee = ast::FormatError(err);
+		ee.Message = "AST evaluation error: " + ee.Message;
 		throw ee;
 	}
 }
 
-void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::Result& res, 
-	VariableType expect, const char* name)
+// Checks the result of expr can be used as expect, and converts it.
+void ConvertResult(const ast::Expression& expr, ast::Result& res, VariableType expect,
+	const char* name)
 {
 	const ast::Node* ast = expr.TopNode;
-	EvaluateExpression(ec, expr, res);
 	EvaluateAstAssert(ast,  (expect.Fmt != VariableFormat::Float4x4 && 
 		res.Type.Fmt != VariableFormat::Float4x4) || expect.Fmt == res.Type.Fmt,
 		"%s expected type (%s) is not compatible with actual type (%s)",
@@ -51,90 +49,216 @@ void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::
 	Convert(res, expect.Fmt);
 }
 
-void EvaluateConstants(ast::EvaluationContext& ec, Array<Constant*> cnsts)
+void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::Result& res, 
+	VariableType expect, const char* name)
 {
-	for (Constant* cnst : cnsts)
+	EvaluateExpression(ec, expr, res);
+	ConvertResult(expr, res, expect, name);
+}
+
+void WriteSetConstant(const SetConstant& set, const ast::Result& res)
+{
+	u32 typeSize = res.Type.Dim * 4;
+	Assert(set.Size == typeSize, 
+		"SetConstant %s does not match size, expected=%u got=%u",
+		set.VariableName, set.Size, typeSize);
+	if (res.Type.Fmt == VariableFormat::Bool)
+		for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+			*(((u32*)(set.CB->BackingMemory+set.Offset)) + i) = 
+				res.Value.Bool4Val.m[i] ? 1 : 0;
+	else
+		memcpy(set.CB->BackingMemory+set.Offset, &res.Value, typeSize);
+}
+
+void EvaluateSetConstants(ast::EvaluationContext& ec, Array<SetConstant> sets)
+{
+	for (SetConstant& set : sets)
 	{
+		// The buffer still holds the value from when it was last evaluated.
+		if (set.Value.CacheValid)
+		{
+#if RLF_EXPRESSION_PROFILER
+			if (ec.Profile)
+				ast::RecordCacheHit(*ec.Profile, set.Value);
+#endif
+			continue;
+		}
 		ast::Result res;
-		EvaluateExpression(ec, cnst->Expr, res, cnst->Type, cnst->Name);
-		cnst->Value = res.Value;
+		EvaluateExpression(ec, set.Value, res, set.Type, set.VariableName);
+		WriteSetConstant(set, res);
 	}
 }
 
-bool IsCompressedFormat(DXGI_FORMAT fmt)
+void ExecuteSetConstantBatch(ast::EvaluationContext& ec, SetConstant** sets, u32 count)
 {
-	switch (fmt)
+	const ast::Program* progs[ast::BatchWidth];
+	for (u32 i = 0 ; i < count ; ++i)
+		progs[i] = sets[i]->Value.Code;
+	ast::Result results[ast::BatchWidth];
+#if RLF_EXPRESSION_PROFILER
+	u64 start = ec.Profile ? ast::ReadProfileTicks() : 0;
+#endif
+	// Left invalid on failure, EvaluateSetConstants reports the error.
+	if (!ast::ExecuteBatch(progs, count, ec, results))
+		return;
+#if RLF_EXPRESSION_PROFILER
+	// Each one gets an equal share of the batch.
+	u64 ticks = ec.Profile ? (ast::ReadProfileTicks() - start) / count : 0;
+#endif
+	for (u32 i = 0 ; i < count ; ++i)
 	{
-	case DXGI_FORMAT_BC1_TYPELESS:
-	case DXGI_FORMAT_BC1_UNORM:
-	case DXGI_FORMAT_BC1_UNORM_SRGB:
-	case DXGI_FORMAT_BC2_TYPELESS:
-	case DXGI_FORMAT_BC2_UNORM:
-	case DXGI_FORMAT_BC2_UNORM_SRGB:
-	case DXGI_FORMAT_BC3_TYPELESS:
-	case DXGI_FORMAT_BC3_UNORM:
-	case DXGI_FORMAT_BC3_UNORM_SRGB:
-	case DXGI_FORMAT_BC4_TYPELESS:
-	case DXGI_FORMAT_BC4_UNORM:
-	case DXGI_FORMAT_BC4_SNORM:
-	case DXGI_FORMAT_BC5_TYPELESS:
-	case DXGI_FORMAT_BC5_UNORM:
-	case DXGI_FORMAT_BC5_SNORM:
-	case DXGI_FORMAT_BC6H_TYPELESS:
-	case DXGI_FORMAT_BC6H_UF16:
-	case DXGI_FORMAT_BC6H_SF16:
-	case DXGI_FORMAT_BC7_TYPELESS:
-	case DXGI_FORMAT_BC7_UNORM:
-	case DXGI_FORMAT_BC7_UNORM_SRGB:
-		return true;
-	default:
-		return false;
+		SetConstant* set = sets[i];
+		ast::Expression& expr = set->Value;
+		expr.CachedResult = results[i];
+		if (ec.Counters)
+		{
+			ec.Counters->Expressions++;
+			ec.Counters->Nodes += expr.NodeCount;
+		}
+#if RLF_EXPRESSION_PROFILER
+		if (ec.Profile)
+			ast::RecordEvaluation(*ec.Profile, expr, ticks, true);
+#endif
+		ConvertResult(expr, results[i], set->Type, set->VariableName);
+		expr.CacheValid = true;
+		WriteSetConstant(*set, results[i]);
 	}
 }
 
-void GenerateTextureResource(const char* texMem, u32 memSize, const char* ext, 
-	DirectX::ScratchImage* out)
+void EvaluateSetConstantBatches(ast::EvaluationContext& ec, RenderDescription* rd)
 {
-	DirectX::TexMetadata origMeta = {};
-	DirectX::ScratchImage orig;
-	if (strcmp(ext, "dds") == 0)
-		DirectX::LoadFromDDSMemory(texMem, memSize, DirectX::DDS_FLAGS_NONE, 
-			&origMeta, orig);
-	else if (strcmp(ext, "tga") == 0)
-		DirectX::LoadFromTGAMemory(texMem, memSize, DirectX::TGA_FLAGS_NONE, 
-			&origMeta, orig);
-	else
-		InitError("Unsupported Texture::FromFile extension (%s)", ext);
+	// The sets of a batch are in the order of their draws, so taking a few
+	//	from each batch in turn goes through the draws once rather than once
+	//	per batch, which misses the cache on large scenes.
+	const u32 Stride = 4 * ast::BatchWidth;
+	u32 longest = 0;
+	for (SetConstantBatch& batch : rd->SetConstantBatches)
+		longest = max(longest, batch.Sets.Count);
+	for (u32 first = 0 ; first < longest ; first += Stride)
+	{
+		for (SetConstantBatch& batch : rd->SetConstantBatches)
+		{
+			SetConstant* sets[ast::BatchWidth];
+			u32 count = 0;
+			u32 last = min(first + Stride, batch.Sets.Count);
+			for (u32 i = first ; i < last ; ++i)
+			{
+				SetConstant* set = batch.Sets[i];
+				if (set->Value.CacheValid)
+					continue;
+				sets[count++] = set;
+				if (count == ast::BatchWidth)
+				{
+					ExecuteSetConstantBatch(ec, sets, count);
+					count = 0;
+				}
+			}
+			if (count > 0)
+				ExecuteSetConstantBatch(ec, sets, count);
+		}
+	}
+}
+
+void Invalidate(Array<ast::Expression*> users)
+{
+	for (ast::Expression* expr : users)
+		expr->CacheValid = false;
+}
+
+void MarkChanged(RenderDescription* rd, const ast::EvaluationContext& ec)
+{
+	if (ec.ChangedThisFrameFlags & ast::VariesBy_Time)
+		Invalidate(rd->TimeUsers);
+	if (ec.ChangedThisFrameFlags & ast::VariesBy_DisplaySize)
+		Invalidate(rd->DisplaySizeUsers);
+	for (u32 i = 0 ; i < ec.ChangedTuneables.Count ; ++i)
+		Invalidate(ec.ChangedTuneables.Data[i]->Users);
+}
+
+bool DependsOnChanges(const ast::Expression& expr, const ast::EvaluationContext& ec)
+{
+	if (expr.Dep.VariesByFlags & ec.ChangedThisFrameFlags & ~ast::VariesBy_Tuneable)
+		return true;
+	for (u32 i = 0 ; i < ec.ChangedTuneables.Count ; ++i)
+	{
+		for (u32 j = 0 ; j < expr.Dep.Tuneables.Count ; ++j)
+		{
+			if (expr.Dep.Tuneables.Data[j] == ec.ChangedTuneables.Data[i])
+				return true;
+		}
+	}
+	return false;
+}
 
-	bool is_compressed = IsCompressedFormat(origMeta.format);
+bool ResourcesDependOnChanges(RenderDescription* rd, const ast::EvaluationContext& ec)
+{
+	for (Texture* tex : rd->Textures)
+	{
+		if (!tex->FromFile && DependsOnChanges(tex->SizeExpr, ec))
+			return true;
+	}
+	for (Buffer* buf : rd->Buffers)
+	{
+		if (DependsOnChanges(buf->ElementSizeExpr, ec) ||
+			DependsOnChanges(buf->ElementCountExpr, ec))
+			return true;
+	}
+	return false;
+}
 
-	DirectX::ScratchImage decompressed;
-	if (is_compressed)
+void EvaluateConstants(ast::EvaluationContext& ec, Array<Constant*> cnsts)
+{
+	for (Constant* cnst : cnsts)
 	{
-		HRESULT hr = DirectX::Decompress(orig.GetImages(), orig.GetImageCount(), 
-			origMeta, DXGI_FORMAT_UNKNOWN, decompressed);
-		Assert(hr == S_OK, "Failed to decompress, hr=%x", hr);
+		if (cnst->Expr.CacheValid)
+		{
+#if RLF_EXPRESSION_PROFILER
+			if (ec.Profile)
+				ast::RecordCacheHit(*ec.Profile, cnst->Expr);
+#endif
+			continue;
+		}
+		ast::Result res;
+		EvaluateExpression(ec, cnst->Expr, res, cnst->Type, cnst->Name);
+		// Users are invalid until their first evaluation, so it doesn't matter
+		//	if this one happens to match the undefined value before it.
+		if (memcmp(&cnst->Value, &res.Value, ast::ValueSize(cnst->Type)) != 0)
+		{
+			cnst->Value = res.Value;
+			Invalidate(cnst->Users);
+		}
 	}
+}
 
-	DirectX::ScratchImage* toMip = is_compressed ? &decompressed : &orig;
-	DirectX::ScratchImage mipped;
-	HRESULT hr = DirectX::GenerateMipMaps( toMip->GetImages(), toMip->GetImageCount(),
-		toMip->GetMetadata(), DirectX::TEX_FILTER_DEFAULT, 0, 
-		is_compressed ? mipped : *out );
-	Assert(hr == S_OK, "Failed to create mips, hr=%x", hr);
+#undef EvaluateAstAssert
 
-	if (is_compressed)
+
+void InitFrameArena(FrameArena* fa)
+{
+	for (alloc::LinAlloc& fAlloc : fa->Allocs)
 	{
-		hr = DirectX::Compress(mipped.GetImages(), mipped.GetImageCount(), 
-			mipped.GetMetadata(),origMeta.format, DirectX::TEX_COMPRESS_DEFAULT, 
-			DirectX::TEX_THRESHOLD_DEFAULT, *out);
-		Assert(hr == S_OK, "Failed to recompress, hr=%x", hr);
+		fAlloc = {};
+		alloc::Init(&fAlloc);
 	}
+	fa->Current = 0;
 }
 
+void ReleaseFrameArena(FrameArena* fa)
+{
+	for (alloc::LinAlloc& fAlloc : fa->Allocs)
+		alloc::FreeAll(&fAlloc);
+}
 
-#undef EvaluateAstAssert
+void AdvanceFrameArena(FrameArena* fa)
+{
+	fa->Current = (fa->Current + 1) % FrameArena::FrameCount;
+	alloc::Reset(&fa->Allocs[fa->Current]);
+}
 
+alloc::LinAlloc* GetFrameAlloc(FrameArena* fa)
+{
+	return &fa->Allocs[fa->Current];
+}
 
 void InitD3D(
 	gfx::Context* ctx,
@@ -146,7 +270,13 @@ void InitD3D(
 	errorState->Success = true;
 	errorState->Warning = false;
 	try {
+		alloc::Init(&rd->ConstantPool);
 		InitMain(ctx, rd, displaySize, workingDirectory, errorState);
+
+		alloc::LinAlloc scratch = {};
+		alloc::Init(&scratch);
+		rd->Commands = LowerPasses(rd, &rd->Alloc, &scratch);
+		alloc::FreeAll(&scratch);
 	}
 	catch (ErrorInfo ie)
 	{
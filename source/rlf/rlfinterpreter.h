@@ -19,21 +19,60 @@ namespace rlf
 		gfx::Context* ctx,
 		RenderDescription* rd);
 
+	// Scratch memory for whatever a frame needs only until it has been
+	//	submitted. Each frame allocates from the next of FrameCount allocators,
+	//	so what was allocated is kept for FrameCount frames, longer than any
+	//	backend keeps a frame in flight.
+	struct FrameArena
+	{
+		static constexpr u32 FrameCount = 3;
+		alloc::LinAlloc Allocs[FrameCount];
+		u32 Current;
+	};
+
+	void InitFrameArena(FrameArena* fa);
+	void ReleaseFrameArena(FrameArena* fa);
+	// Moves on to the next frame's allocator and frees what it held.
+	void AdvanceFrameArena(FrameArena* fa);
+	alloc::LinAlloc* GetFrameAlloc(FrameArena* fa);
+
 	struct ExecuteContext
 	{
 		gfx::Context* GfxCtx;
 		ExecuteResources Res;
 		ast::EvaluationContext EvCtx;
+		// For temporaries of the frame being executed, instead of the heap.
+		alloc::LinAlloc* FrameAlloc;
 	};
 
 
 	void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::Result& res);
 	void EvaluateExpression(ast::EvaluationContext& ec, ast::Expression& expr, ast::Result& res, 
 		VariableType expect, const char* name);
+	// Invalidates the expressions reading what ec says changed since the last
+	//	frame, call it once per frame before evaluating anything.
+	void MarkChanged(RenderDescription* rd, const ast::EvaluationContext& ec);
+	// Whether what ec says changed since the last frame can change the value
+	//	of expr, going by the tuneables it depends on rather than just the
+	//	VariesBy_Tuneable flag.
+	bool DependsOnChanges(const ast::Expression& expr, const ast::EvaluationContext& ec);
+	// Whether any texture or buffer size depends on the changes, which
+	//	HandleTextureParametersChanged would then have to apply.
+	bool ResourcesDependOnChanges(RenderDescription* rd, const ast::EvaluationContext& ec);
+	// cnsts are in dependency order, only the ones which were invalidated are
+	//	evaluated. The expressions using a constant are invalidated in turn only
+	//	if its value changed.
 	void EvaluateConstants(ast::EvaluationContext& ec, Array<Constant*> cnsts);
-
-	void GenerateTextureResource(const char* texMem, u32 memSize, const char* ext, 
-		DirectX::ScratchImage* out);
+	// Evaluates the invalidated SetConstants of rd->SetConstantBatches together
+	//	and writes them to their constant buffers. Every evaluation of a
+	//	SetConstant writes its buffer, so the ones still cached don't need to be
+	//	written again.
+	void EvaluateSetConstantBatches(ast::EvaluationContext& ec, RenderDescription* rd);
+	// Copies the evaluated value of set into the backing memory of its buffer.
+	void WriteSetConstant(const SetConstant& set, const ast::Result& res);
+	// Evaluates and writes the SetConstants of sets which aren't cached, what
+	//	the buffers hold for the others is still current.
+	void EvaluateSetConstants(ast::EvaluationContext& ec, Array<SetConstant> sets);
 
 	void HandleTextureParametersChanged(
 		RenderDescription* rd,
@@ -17,250 +17,6 @@ namespace rlf
 	ParseState to be cleaned up after parsing completion, regardless of failure. 
 *******************************************************************************/
 
-#define RLF_TOKEN_TUPLE \
-	RLF_TOKEN_ENTRY(Invalid) \
-	RLF_TOKEN_ENTRY(LParen) \
-	RLF_TOKEN_ENTRY(RParen) \
-	RLF_TOKEN_ENTRY(LBrace) \
-	RLF_TOKEN_ENTRY(RBrace) \
-	RLF_TOKEN_ENTRY(LBracket) \
-	RLF_TOKEN_ENTRY(RBracket) \
-	RLF_TOKEN_ENTRY(Comma) \
-	RLF_TOKEN_ENTRY(Equals) \
-	RLF_TOKEN_ENTRY(Plus) \
-	RLF_TOKEN_ENTRY(Minus) \
-	RLF_TOKEN_ENTRY(Semicolon) \
-	RLF_TOKEN_ENTRY(Period) \
-	RLF_TOKEN_ENTRY(ForwardSlash) \
-	RLF_TOKEN_ENTRY(Asterisk) \
-	RLF_TOKEN_ENTRY(IntegerLiteral) \
-	RLF_TOKEN_ENTRY(FloatLiteral) \
-	RLF_TOKEN_ENTRY(Identifier) \
-	RLF_TOKEN_ENTRY(String) \
-
-#define RLF_TOKEN_ENTRY(name) name,
-enum class TokenType
-{
-	RLF_TOKEN_TUPLE
-};
-#undef RLF_TOKEN_ENTRY
-
-struct Token
-{
-	TokenType Type;
-	const char* Location;
-	union {
-		const char* String;
-		double FloatLiteral;
-		u32 IntegerLiteral;
-	};
-};
-
-#define RLF_TOKEN_ENTRY(name) #name,
-const char* TokenNames[] =
-{
-	RLF_TOKEN_TUPLE
-};
-#undef RLF_TOKEN_ENTRY
-
-#undef RLF_TOKEN_TUPLE
-
-
-void TokenizerError(const char* loc, const char* str, ...)
-{
-	char buf[512];
-	va_list ptr;
-	va_start(ptr,str);
-	vsprintf_s(buf,512,str,ptr);
-	va_end(ptr);
-
-	ErrorInfo pe = {};
-	pe.Location = loc;
-	pe.Message = buf;
-
-	throw pe;
-}
-
-#define TokenizerAssert(expression, loc, message, ...) 	\
-do {													\
-	if (!(expression)) {								\
-		TokenizerError(loc, message, ##__VA_ARGS__);	\
-	}													\
-} while (0);											\
-
-struct TokenizerState {
-	std::vector<Token> tokens;
-	std::unordered_set<std::string> tokenStrings;
-	TokenType fcLUT[128];
-};
-
-void TokenizerStateInit(TokenizerState& ts)
-{
-	TokenType* fcLUT = ts.fcLUT;
-	for (u32 fc = 0 ; fc < 128 ; ++fc)
-		fcLUT[fc] = TokenType::Invalid;
-	fcLUT['('] = TokenType::LParen;
-	fcLUT[')'] = TokenType::RParen;
-	fcLUT['{'] = TokenType::LBrace;
-	fcLUT['}'] = TokenType::RBrace;
-	fcLUT['['] = TokenType::LBracket;
-	fcLUT[']'] = TokenType::RBracket;
-	fcLUT[','] = TokenType::Comma;
-	fcLUT['='] = TokenType::Equals;
-	fcLUT['+'] = TokenType::Plus;
-	fcLUT['-'] = TokenType::Minus;
-	fcLUT[';'] = TokenType::Semicolon;
-	fcLUT['.'] = TokenType::Period;
-	fcLUT['/'] = TokenType::ForwardSlash;
-	fcLUT['*'] = TokenType::Asterisk;
-	fcLUT['"'] = TokenType::String;
-	for (u32 fc = 0 ; fc < 128 ; ++fc)
-	{
-		if (isalpha(fc))
-			fcLUT[fc] = TokenType::Identifier;
-		else if (isdigit(fc))
-			fcLUT[fc] = TokenType::IntegerLiteral;
-	} 
-	fcLUT['_'] = TokenType::Identifier;
-}
-
-const char* SkipWhitespace(const char* next, const char* end)
-{
-	bool checkAgain;
-	do {
-		checkAgain = false;
-		while (next < end && isspace(*next))
-		{
-			++next;
-		}
-		if (next + 1 < end && next[0] == '/')
-		{
-			if (next[1] == '/')
-			{
-				next += 2;
-				while (next < end && *next != '\n')
-					++next;
-				checkAgain = true;
-			}
-			else if (next[1] == '*')
-			{
-				next += 2;
-				while (next + 1 < end)
-				{
-					if (next[0] == '*' && next[1] == '/')
-						break;
-					++next;
-				}
-				TokenizerAssert(next[0] == '*' && next[1] == '/', next,
-					"Closing of comment block was not found before end of file");
-				next += 2;
-				checkAgain = true;
-			}
-		}
-	}
-	while (checkAgain);
-	return next;
-}
-
-void Tokenize(const char* start, const char* end, TokenizerState& ts)
-{
-	const char* next = SkipWhitespace(start, end);
-
-	while (next < end)
-	{
-		char firstChar = *next;
-
-		TokenType tok = ts.fcLUT[firstChar];
-
-		Token token;
-		token.Location = next;
-
-		switch (tok)
-		{
-		case TokenType::LParen:
-		case TokenType::RParen:
-		case TokenType::LBrace:
-		case TokenType::RBrace:
-		case TokenType::LBracket:
-		case TokenType::RBracket:
-		case TokenType::Comma:
-		case TokenType::Equals:
-		case TokenType::Plus:
-		case TokenType::Minus:
-		case TokenType::Semicolon:
-		case TokenType::Period:
-		case TokenType::ForwardSlash:
-		case TokenType::Asterisk:
-			++next;
-			break;
-		case TokenType::IntegerLiteral:
-		{
-			u32 val = 0;
-			while(next < end && isdigit(*next)) {
-				val *= 10;
-				val += (*next - '0');
-				++next;
-			}
-			token.IntegerLiteral = val;
-			if (next < end && *next == '.') {
-				++next;
-				tok = TokenType::FloatLiteral;
-				double floatVal = val;
-				double sub = 0.1;
-				while(next < end && isdigit(*next)) {
-					floatVal += (*next - '0') * sub;
-					sub *= 0.1;
-					++next;
-				}
-				token.FloatLiteral = floatVal;
-			}
-			break;
-		}
-		case TokenType::Identifier:
-		{
-			// identifiers have to start with a letter, but can contain numbers
-			const char* id_begin = next;
-			while (next < end && (isalpha(*next) || isdigit(*next) || 
-				*next == '_')) 
-			{
-				++next;
-			}
-			const char* id_end = next;
-			std::string id = std::string(id_begin, id_end);
-			auto insrt = ts.tokenStrings.insert(id);
-			token.String = insrt.first->c_str();
-			break;
-		}
-		case TokenType::String:
-		{
-			++next; // skip over opening quotes
-			const char* str_begin = next;
-			while (next < end && *next != '"') {
-				++next;
-			}
-			TokenizerAssert(next < end, next, "End-of-buffer before closing parenthesis.");
-			const char* str_end = next;
-			++next; // pass the closing quotes
-			std::string str = std::string(str_begin, str_end);
-			auto insrt = ts.tokenStrings.insert(str);
-			token.String = insrt.first->c_str();
-			break;
-		}
-		case TokenType::Invalid:
-		default:
-			TokenizerError(next, "unexpected character when parsing token: %c", firstChar);
-			break;
-		}
-
-		token.Type = tok;
-		ts.tokens.push_back(token);
-
-		next = SkipWhitespace(next, end);
-	}
-	Assert(next == end, "Internal inconsistency, passed the end of the buffer");
-}
-
-
 #define RLF_KEYWORD_TUPLE \
 	RLF_KEYWORD_ENTRY(ComputeShader) \
 	RLF_KEYWORD_ENTRY(VertexShader) \
@@ -479,7 +235,7 @@ enum class Keyword
 #undef RLF_KEYWORD_ENTRY
 
 #define RLF_KEYWORD_ENTRY(name) #name,
-const char* KeywordString[] = 
+constexpr const char* KeywordString[] = 
 {
 	"<Invalid>",
 	RLF_KEYWORD_TUPLE
@@ -488,39 +244,54 @@ const char* KeywordString[] =
 
 #undef RLF_KEYWORD_TUPLE
 
-u32 Hash(const char* str)
-{
-	unsigned long h = 5381;
-	unsigned const char* us = (unsigned const char *) str;
-	while(*us != '\0') {
-		h = ((h << 5) + h) + *us;
-		us++;
-	}
-	return h; 
-}
-
-u32 LowerHash(const char* str)
-{
-	unsigned long h = 5381;
-	unsigned const char* us = (unsigned const char *) str;
-	while(*us != '\0') {
-		h = ((h << 5) + h) + tolower(*us);
-		us++;
-	}
-	return h; 
-}
+// Keywords and format names are case-insensitive in RLF.
+constexpr auto KeywordTable = phash::Build<512, 128>(KeywordString, true);
+static_assert(KeywordTable.Valid, "Keyword perfect hash failed, grow the table");
+constexpr auto TextureFormatTable = phash::Build<256, 64>(TextureFormatName, true);
+static_assert(TextureFormatTable.Valid, "Format perfect hash failed, grow the table");
+
+#define RLF_SYMBOL_KIND_TUPLE \
+	RLF_SYMBOL_KIND_ENTRY(None) \
+	RLF_SYMBOL_KIND_ENTRY(Pass) \
+	RLF_SYMBOL_KIND_ENTRY(ComputeShader) \
+	RLF_SYMBOL_KIND_ENTRY(VertexShader) \
+	RLF_SYMBOL_KIND_ENTRY(PixelShader) \
+	RLF_SYMBOL_KIND_ENTRY(Buffer) \
+	RLF_SYMBOL_KIND_ENTRY(Texture) \
+	RLF_SYMBOL_KIND_ENTRY(Sampler) \
+	RLF_SYMBOL_KIND_ENTRY(View) \
+	RLF_SYMBOL_KIND_ENTRY(RasterizerState) \
+	RLF_SYMBOL_KIND_ENTRY(DepthStencilState) \
+	RLF_SYMBOL_KIND_ENTRY(Viewport) \
+	RLF_SYMBOL_KIND_ENTRY(BlendState) \
+	RLF_SYMBOL_KIND_ENTRY(ObjImport) \
+	RLF_SYMBOL_KIND_ENTRY(Tuneable) \
+	RLF_SYMBOL_KIND_ENTRY(Constant) \
+
+enum class SymbolKind : u32
+{
+#define RLF_SYMBOL_KIND_ENTRY(name) name,
+	RLF_SYMBOL_KIND_TUPLE
+#undef RLF_SYMBOL_KIND_ENTRY
+};
 
-struct CharHasher
+static const char* SymbolKindNames[] =
 {
-	size_t operator()(const char* str) const
-	{
-		return Hash(str);
-	}
+#define RLF_SYMBOL_KIND_ENTRY(name) #name,
+	RLF_SYMBOL_KIND_TUPLE
+#undef RLF_SYMBOL_KIND_ENTRY
 };
 
-struct CharComparer
+#undef RLF_SYMBOL_KIND_TUPLE
+
+// Everything in an RLF that can be referred to by name shares one namespace.
+//	Symbols are indexed by the intern id of their name: ids are dense and all 
+//	of them are handed out by the lexer before parsing starts, so the table 
+//	is sized once and a lookup is a single load.
+struct Symbol
 {
-	bool operator()(const char* l, const char* r) const { return strcmp(l,r) == 0; }
+	SymbolKind Kind; // None if the name isn't defined (yet)
+	void* M; // Pass* for passes, otherwise the object itself
 };
 
 struct TokenIter
@@ -533,58 +304,36 @@ struct ParseState
 {
 	TokenIter t;
 	RenderDescription* rd;
-	std::unordered_map<const char*, Pass, CharHasher, CharComparer> passMap;
-	std::unordered_map<const char*, ComputeShader*, CharHasher, CharComparer> csMap;
-	std::unordered_map<const char*, VertexShader*, CharHasher, CharComparer> vsMap;
-	std::unordered_map<const char*, PixelShader*, CharHasher, CharComparer> psMap;
-	enum class ResType {
-		Sampler,
-		Buffer,
-		Texture,
-		View,
-	};
-	struct Resource {
-		ResType type;
-		void* m;
-	};
-	std::unordered_map<const char*, Resource, CharHasher, CharComparer> resMap;
-	std::unordered_map<u32, TextureFormat> fmtMap;
-	std::unordered_map<const char*, RasterizerState*, CharHasher, CharComparer> rsMap;
-	std::unordered_map<const char*, DepthStencilState*, CharHasher, CharComparer> dssMap;
-	std::unordered_map<const char*, Viewport*, CharHasher, CharComparer> vpMap;
-	std::unordered_map<const char*, BlendState*, CharHasher, CharComparer> bsMap;
-	std::unordered_map<const char*, ObjImport*, CharHasher, CharComparer> objMap;
-	struct Var {
-		bool tuneable;
-		void* m;
-	};
-	std::unordered_map<const char*, Var, CharHasher, CharComparer> varMap;
-	std::unordered_map<u32, Keyword> keyMap;
+	Array<Symbol> symbols = {};
 
-	std::unordered_map<u32, const char*> strStorageMap;
+	InternTable* strings;
 
 	const char* workingDirectory;
 
-	std::vector<Dispatch*> Dispatches;
-	std::vector<Draw*> Draws;
-	std::vector<ObjDraw*> ObjDraws;
-	std::vector<ComputeShader*> CShaders;
-	std::vector<VertexShader*> VShaders;
-	std::vector<PixelShader*> PShaders;
-	std::vector<SizeOfRequest> SizeOfRequests;
-	std::vector<Buffer*> Buffers;
-	std::vector<Texture*> Textures;
-	std::vector<Sampler*> Samplers;
-	std::vector<View*> Views;
-	std::vector<RasterizerState*> RasterizerStates;
-	std::vector<DepthStencilState*> DepthStencilStates;
-	std::vector<Constant*> Constants;
-	std::vector<Tuneable*> Tuneables;
+	alloc::List<Dispatch*> Dispatches = {};
+	alloc::List<Draw*> Draws = {};
+	alloc::List<ObjDraw*> ObjDraws = {};
+	alloc::List<ComputeShader*> CShaders = {};
+	alloc::List<VertexShader*> VShaders = {};
+	alloc::List<PixelShader*> PShaders = {};
+	alloc::List<SizeOfRequest> SizeOfRequests = {};
+	alloc::List<Buffer*> Buffers = {};
+	alloc::List<Texture*> Textures = {};
+	alloc::List<Sampler*> Samplers = {};
+	alloc::List<View*> Views = {};
+	alloc::List<RasterizerState*> RasterizerStates = {};
+	alloc::List<DepthStencilState*> DepthStencilStates = {};
+	alloc::List<Constant*> Constants = {};
+	alloc::List<Tuneable*> Tuneables = {};
+	alloc::List<const char*> Dependencies = {};
 
 	alloc::LinAlloc* alloc;
-} *GPS;
+	// Temporaries which only live until the end of the parse.
+	alloc::LinAlloc scratch = {};
+};
 
-void ParserError(const char* str, ...)
+// Errors are reported at the next token of t.
+void ParserError(const TokenIter& t, const char* str, ...)
 {
 	char buf[512];
 	va_list ptr;
@@ -592,55 +341,36 @@ void ParserError(const char* str, ...)
 	vsprintf_s(buf,512,str,ptr);
 	va_end(ptr);
 
-	ParseState* ps = GPS;
 	ErrorInfo pe = {};
-	pe.Location = ps->t.next < ps->t.end ? ps->t.next->Location : nullptr;
+	pe.Location = t.next < t.end ? t.next->Location : nullptr;
 	pe.Message = buf;
 
 	throw pe;
 }
 
-#define ParserAssert(expression, message, ...) 	\
-do {											\
-	if (!(expression)) {						\
-		ParserError(message, ##__VA_ARGS__);	\
-	}											\
-} while (0);									\
+#define ParserAssert(t, expression, message, ...) 	\
+do {												\
+	if (!(expression)) {							\
+		ParserError(t, message, ##__VA_ARGS__);		\
+	}												\
+} while (0);										\
 
 Keyword LookupKeyword(
 	const char* str)
 {
-	u32 hash = LowerHash(str);
-	if (GPS->keyMap.count(hash) > 0)
-		return GPS->keyMap[hash];
-	else
-		return Keyword::Invalid;
+	return (Keyword)phash::Find(KeywordTable, KeywordString, str, true);
 }
 
-void ParseStateInit(ParseState* ps)
+TextureFormat LookupTextureFormat(
+	const char* str)
 {
-	for (u32 i = (u32)TextureFormat::Invalid+1 ; i < (u32)TextureFormat::_Count ; ++i)
-	{
-		TextureFormat fmt = (TextureFormat)i;
-		const char* str = TextureFormatName[i];
-		u32 hash = LowerHash(str);
-		Assert(ps->fmtMap.count(hash) == 0, "hash collision");
-		ps->fmtMap[hash] = fmt;
-	}
-	for (u32 i = 0 ; i < (u32)Keyword::_Count ; ++i)
-	{
-		Keyword key = (Keyword)i;
-		const char* str = KeywordString[i];
-		u32 hash = LowerHash(str);
-		Assert(ps->keyMap.count(hash) == 0, "hash collision");
-		ps->keyMap[hash] = key;
-	}
+	return (TextureFormat)phash::Find(TextureFormatTable, TextureFormatName, str, true);
 }
 
 TokenType PeekNextToken(
 	const TokenIter& t)
 {
-	ParserAssert(t.next != t.end, "unexpected end-of-buffer")
+	ParserAssert(t, t.next != t.end, "unexpected end-of-buffer")
 	TokenType type = t.next->Type;
 	return type;
 }
@@ -650,7 +380,7 @@ void ConsumeToken(
 	TokenIter& t)
 {
 	TokenType foundTok = PeekNextToken(t);
-	ParserAssert(foundTok == tok, "unexpected token, expected %s but found %s",
+	ParserAssert(t, foundTok == tok, "unexpected token, expected %s but found %s",
 		TokenNames[(u32)tok], TokenNames[(u32)foundTok]);
 	++t.next;
 }
@@ -670,7 +400,7 @@ const char* ConsumeIdentifier(
 	TokenIter& t)
 {
 	TokenType tok = PeekNextToken(t);
-	ParserAssert(tok == TokenType::Identifier, "unexpected %s (wanted identifier)", 
+	ParserAssert(t, tok == TokenType::Identifier, "unexpected %s (wanted identifier)", 
 		TokenNames[(u32)tok]);
 
 	const char* str = t.next->String;
@@ -678,11 +408,20 @@ const char* ConsumeIdentifier(
 	return str;
 }
 
+const char* ConsumeIdentifier(
+	TokenIter& t,
+	u32& id)
+{
+	const char* str = ConsumeIdentifier(t);
+	id = (t.next-1)->Id;
+	return str;
+}
+
 const char* ConsumeString(
 	TokenIter& t)
 {
 	TokenType tok = PeekNextToken(t);
-	ParserAssert(tok == TokenType::String, "unexpected %s (wanted string)", 
+	ParserAssert(t, tok == TokenType::String, "unexpected %s (wanted string)", 
 		TokenNames[(u32)tok]);
 
 	const char* str = t.next->String;
@@ -701,7 +440,7 @@ bool ConsumeBool(
 	else if (key == Keyword::False)
 		ret = false;
 	else
-		ParserError("Expected bool (true/false), got: %s", value);
+		ParserError(t, "Expected bool (true/false), got: %s", value);
 
 	return ret;
 }
@@ -711,7 +450,7 @@ i32 ConsumeIntLiteral(
 {
 	bool negative = TryConsumeToken(TokenType::Minus, t);
 	TokenType tok = PeekNextToken(t);
-	ParserAssert(tok == TokenType::IntegerLiteral, "unexpected %s (wanted integer literal)",
+	ParserAssert(t, tok == TokenType::IntegerLiteral, "unexpected %s (wanted integer literal)",
 		TokenNames[(u32)tok]);
 	i32 val = t.next->IntegerLiteral;
 	++t.next;
@@ -722,9 +461,9 @@ u32 ConsumeUintLiteral(
 	TokenIter& t)
 {
 	if (TryConsumeToken(TokenType::Minus, t))
-		ParserError("Unsigned int expected, '-' invalid here");
+		ParserError(t, "Unsigned int expected, '-' invalid here");
 	TokenType tok = PeekNextToken(t);
-	ParserAssert(tok == TokenType::IntegerLiteral, "unexpected %s (wanted integer literal)",
+	ParserAssert(t, tok == TokenType::IntegerLiteral, "unexpected %s (wanted integer literal)",
 		TokenNames[(u32)tok]);
 
 	u32 val = t.next->IntegerLiteral;
@@ -736,7 +475,7 @@ u8 ConsumeUcharLiteral(
 	TokenIter& t)
 {
 	u32 u = ConsumeUintLiteral(t);
-	ParserAssert(u < 256, "Uchar value too large to fit: %u", u);
+	ParserAssert(t, u < 256, "Uchar value too large to fit: %u", u);
 	return (u8)u;
 }
 
@@ -745,7 +484,7 @@ float ConsumeFloatLiteral(
 {
 	bool negative = TryConsumeToken(TokenType::Minus, t);
 	TokenType tok = PeekNextToken(t);
-	ParserAssert(tok == TokenType::IntegerLiteral || tok == TokenType::FloatLiteral, 
+	ParserAssert(t, tok == TokenType::IntegerLiteral || tok == TokenType::FloatLiteral, 
 		"unexpected %s (wanted float literal)", TokenNames[(u32)tok]);
 
 	bool fracPart = (tok == TokenType::FloatLiteral);
@@ -753,23 +492,33 @@ float ConsumeFloatLiteral(
 	++t.next;
 
 	double result = negative ? -val : val;
-	ParserAssert(result >= -FLT_MAX && result < FLT_MAX, 
+	ParserAssert(t, result >= -FLT_MAX && result < FLT_MAX, 
 		"Given literal is outside of representable range.");
 	return (float)(result);
 }
 
 const char* AddStringToDescriptionData(const char* str, ParseState& ps)
 {
-	u32 hash = Hash(str);
-	auto s = ps.strStorageMap.find(hash);
-	if (s != ps.strStorageMap.end())
-		return s->second;
-	u32 len = (u32)strlen(str) + 1;
-	char* dest = (char*)Allocate(ps.alloc, len);
-	strcpy(dest, str);
-	dest[len] = '\0';
-	ps.strStorageMap[hash] = dest;
-	return dest;
+	u32 len = (u32)strlen(str);
+	u32 id = Intern(*ps.strings, str, len);
+	InternEntry& entry = ps.strings->Entries[id];
+	if (entry.Persistent == nullptr)
+	{
+		char* dest = (char*)alloc::Allocate(ps.alloc, len + 1, 1);
+		memcpy(dest, entry.String, len + 1);
+		entry.Persistent = dest;
+	}
+	return entry.Persistent;
+}
+
+// Fails if the name is already in use, by any kind of symbol.
+void DefineSymbol(const TokenIter& t, ParseState& ps, u32 id, SymbolKind kind, void* m)
+{
+	Symbol& sym = ps.symbols[id];
+	ParserAssert(t, sym.Kind == SymbolKind::None, "%s already defined as %s", 
+		ps.strings->Entries[id].String, SymbolKindNames[(u32)sym.Kind]);
+	sym.Kind = kind;
+	sym.M = m;
 }
 
 template <typename AstType>
@@ -791,26 +540,26 @@ struct EnumEntry
 	T Value;
 };
 template <typename T, size_t DefSize>
-T ConsumeEnum(TokenIter& ti, EnumEntry<T> (&def)[DefSize], const char* name)
+T ConsumeEnum(TokenIter& ti, const EnumEntry<T> (&def)[DefSize], const char* name)
 {
 	const char* id = ConsumeIdentifier(ti);
 	Keyword key = LookupKeyword(id);
-	T t = T::Invalid;
+	T value = T::Invalid;
 	for (size_t i = 0 ; i < DefSize ; ++i)
 	{
 		if (key == def[i].Key)
 		{
-			t = def[i].Value;
+			value = def[i].Value;
 			break;
 		}
 	}
-	ParserAssert(t != T::Invalid, "Invalid %s enum value: %s", name, id);
-	return t;
+	ParserAssert(ti, value != T::Invalid, "Invalid %s enum value: %s", name, id);
+	return value;
 }
 
 Filter ConsumeFilter(TokenIter& t)
 {
-	static EnumEntry<Filter> def[] = {
+	static const EnumEntry<Filter> def[] = {
 		Keyword::Point,		Filter::Point,
 		Keyword::Linear,	Filter::Linear,
 		Keyword::Aniso,		Filter::Aniso,
@@ -820,7 +569,7 @@ Filter ConsumeFilter(TokenIter& t)
 
 AddressMode ConsumeAddressMode(TokenIter& t)
 {
-	static EnumEntry<AddressMode> def[] = {
+	static const EnumEntry<AddressMode> def[] = {
 		Keyword::Wrap,			AddressMode::Wrap,
 		Keyword::Mirror,		AddressMode::Mirror,
 		Keyword::MirrorOnce,	AddressMode::MirrorOnce,
@@ -832,7 +581,7 @@ AddressMode ConsumeAddressMode(TokenIter& t)
 
 Topology ConsumeTopology(TokenIter& t)
 {
-	static EnumEntry<Topology> def[] = {
+	static const EnumEntry<Topology> def[] = {
 		Keyword::PointList,		Topology::PointList,
 		Keyword::LineList,		Topology::LineList,
 		Keyword::LineStrip,		Topology::LineStrip,
@@ -844,7 +593,7 @@ Topology ConsumeTopology(TokenIter& t)
 
 CullMode ConsumeCullMode(TokenIter& t)
 {
-	static EnumEntry<CullMode> def[] = {
+	static const EnumEntry<CullMode> def[] = {
 		Keyword::None,	CullMode::None,
 		Keyword::Front,	CullMode::Front,
 		Keyword::Back,	CullMode::Back,
@@ -854,7 +603,7 @@ CullMode ConsumeCullMode(TokenIter& t)
 
 ComparisonFunc ConsumeComparisonFunc(TokenIter& t)
 {
-	static EnumEntry<ComparisonFunc> def[] = {
+	static const EnumEntry<ComparisonFunc> def[] = {
 		Keyword::Never,			ComparisonFunc::Never,
 		Keyword::Less,			ComparisonFunc::Less,
 		Keyword::Equal,			ComparisonFunc::Equal,
@@ -869,7 +618,7 @@ ComparisonFunc ConsumeComparisonFunc(TokenIter& t)
 
 StencilOp ConsumeStencilOp(TokenIter& t)
 {
-	static EnumEntry<StencilOp> def[] = {
+	static const EnumEntry<StencilOp> def[] = {
 		Keyword::Keep,		StencilOp::Keep,
 		Keyword::Zero,		StencilOp::Zero,
 		Keyword::Replace,	StencilOp::Replace,
@@ -884,7 +633,7 @@ StencilOp ConsumeStencilOp(TokenIter& t)
 
 Blend ConsumeBlend(TokenIter& t)
 {
-	static EnumEntry<Blend> def[] = {
+	static const EnumEntry<Blend> def[] = {
 		Keyword::Zero,				Blend::Zero,
 		Keyword::One,				Blend::One,
 		Keyword::SrcColor,			Blend::SrcColor,
@@ -908,7 +657,7 @@ Blend ConsumeBlend(TokenIter& t)
 
 BlendOp ConsumeBlendOp(TokenIter& t)
 {
-	static EnumEntry<BlendOp> def[] = {
+	static const EnumEntry<BlendOp> def[] = {
 		Keyword::Add,			BlendOp::Add,
 		Keyword::Subtract,		BlendOp::Subtract,
 		Keyword::RevSubtract,	BlendOp::RevSubtract,
@@ -920,7 +669,7 @@ BlendOp ConsumeBlendOp(TokenIter& t)
 
 InputClassification ConsumeInputClassification(TokenIter& t)
 {
-	static EnumEntry<InputClassification> def[] = {
+	static const EnumEntry<InputClassification> def[] = {
 		Keyword::PerVertex,		InputClassification::PerVertex,
 		Keyword::PerInstance,	InputClassification::PerInstance,
 	};
@@ -938,7 +687,7 @@ struct FlagsEntry
 	T Value;
 };
 template <typename T, size_t DefSize>
-T ConsumeFlags(TokenIter& t, FlagsEntry<T> (&def)[DefSize], const char* name)
+T ConsumeFlags(TokenIter& t, const FlagsEntry<T> (&def)[DefSize], const char* name)
 {
 	ConsumeToken(TokenType::LBrace, t);
 
@@ -960,7 +709,7 @@ T ConsumeFlags(TokenIter& t, FlagsEntry<T> (&def)[DefSize], const char* name)
 				break;
 			}
 		}
-		ParserAssert(found, "Unexpected %s flag: %s", name, id)
+		ParserAssert(t, found, "Unexpected %s flag: %s", name, id)
 
 		if (TryConsumeToken(TokenType::RBrace, t))
 			break;
@@ -973,7 +722,7 @@ T ConsumeFlags(TokenIter& t, FlagsEntry<T> (&def)[DefSize], const char* name)
 
 BufferFlag ConsumeBufferFlag(TokenIter& t)
 {
-	static FlagsEntry<BufferFlag> def[] = {
+	static const FlagsEntry<BufferFlag> def[] = {
 		Keyword::Vertex,		BufferFlag_Vertex,
 		Keyword::Index,			BufferFlag_Index,
 		Keyword::Structured,	BufferFlag_Structured,
@@ -984,7 +733,7 @@ BufferFlag ConsumeBufferFlag(TokenIter& t)
 }
 TextureFlag ConsumeTextureFlag(TokenIter& t)
 {
-	static FlagsEntry<TextureFlag> def[] = {
+	static const FlagsEntry<TextureFlag> def[] = {
 		Keyword::SRV,	TextureFlag_SRV,
 		Keyword::UAV,	TextureFlag_UAV,
 		Keyword::RTV,	TextureFlag_RTV,
@@ -1022,7 +771,7 @@ FilterMode ConsumeFilterMode(TokenIter& t)
 			fm.Mip = ConsumeFilter(t);
 			break;
 		default:
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		if (TryConsumeToken(TokenType::RBrace, t))
@@ -1047,7 +796,7 @@ AddressModeUVW ConsumeAddressModeUVW(TokenIter& t)
 		ConsumeToken(TokenType::Equals, t);
 		AddressMode mode = ConsumeAddressMode(t);
 
-		ParserAssert(strlen(fieldId) <= 3, "Invalid [U?V?W?], %s", fieldId);
+		ParserAssert(t, strlen(fieldId) <= 3, "Invalid [U?V?W?], %s", fieldId);
 
 		const char* curr = fieldId;
 		while (*curr != '\0')
@@ -1059,7 +808,7 @@ AddressModeUVW ConsumeAddressModeUVW(TokenIter& t)
 			else if (*curr == 'W')
 				addr.W = mode;
 			else
-				ParserError("unexpected %c, wanted [U|V|W]", *curr);
+				ParserError(t, "unexpected %c, wanted [U|V|W]", *curr);
 			++curr;
 		}
 
@@ -1074,7 +823,7 @@ AddressModeUVW ConsumeAddressModeUVW(TokenIter& t)
 View* ConsumeViewDef(TokenIter& t, ParseState& ps, ViewType vt)
 {
 	View* v = alloc::Allocate<View>(ps.alloc);
-	ps.Views.push_back(v);
+	alloc::PushBack(&ps.scratch, &ps.Views, v);
 	v->Type = vt;
 	ConsumeToken(TokenType::LBrace, t);
 	while (true)
@@ -1087,33 +836,32 @@ View* ConsumeViewDef(TokenIter& t, ParseState& ps, ViewType vt)
 		ConsumeToken(TokenType::Equals, t);
 		if (key == Keyword::Resource)
 		{
-			const char* rid = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(rid) != 0, "Couldn't find resource %s", 
-				rid);
-			ParseState::Resource& res = ps.resMap[rid];
-			if (res.type == ParseState::ResType::Buffer)
+			u32 symId;
+			const char* rid = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", rid);
+			if (sym.Kind == SymbolKind::Buffer)
 			{
 				v->ResourceType = ResourceType::Buffer;
-				v->Buffer = (Buffer*)res.m;
+				v->Buffer = (Buffer*)sym.M;
 			}
-			else if (res.type == ParseState::ResType::Texture)
+			else if (sym.Kind == SymbolKind::Texture)
 			{
 				v->ResourceType = ResourceType::Texture;
-				v->Texture = (Texture*)res.m;
+				v->Texture = (Texture*)sym.M;
 			}
 			else
 			{
-				ParserError("Referenced resource (%s) must be Texture or Buffer.", 
+				ParserError(t, "Referenced resource (%s) must be Texture or Buffer.", 
 					rid);
 			}
 		}
 		else if (key == Keyword::Format)
 		{
 			const char* formatId = ConsumeIdentifier(t);
-			u32 hash = LowerHash(formatId);
-			ParserAssert(GPS->fmtMap.count(hash) != 0, "Couldn't find format %s", 
+			v->Format = LookupTextureFormat(formatId);
+			ParserAssert(t, v->Format != TextureFormat::Invalid, "Couldn't find format %s", 
 				formatId);
-			v->Format = GPS->fmtMap[hash];
 		}
 		else if (key == Keyword::NumElements)
 		{
@@ -1121,17 +869,17 @@ View* ConsumeViewDef(TokenIter& t, ParseState& ps, ViewType vt)
 		}
 		else 
 		{
-			ParserError("Unexpected field (%s)", id);
+			ParserError(t, "Unexpected field (%s)", id);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
 	}
-	ParserAssert(v->ResourceType != ResourceType::Invalid, 
+	ParserAssert(t, v->ResourceType != ResourceType::Invalid, 
 		"Resource on View must be set.");
 	return v;
 }
 
-View* ConsumeViewRefOrDef(TokenIter& t, ParseState& ps, const char* id)
+View* ConsumeViewRefOrDef(TokenIter& t, ParseState& ps, const char* id, u32 symId)
 {
 	View* v = nullptr;
 
@@ -1154,31 +902,31 @@ View* ConsumeViewRefOrDef(TokenIter& t, ParseState& ps, const char* id)
 	}
 	else
 	{
-		ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-		ParseState::Resource& res = ps.resMap[id];
-		if (res.type == ParseState::ResType::View)
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+		if (sym.Kind == SymbolKind::View)
 		{
-			v = (View*)res.m;
+			v = (View*)sym.M;
 		}
-		else if (res.type == ParseState::ResType::Buffer)
+		else if (sym.Kind == SymbolKind::Buffer)
 		{
 			v = alloc::Allocate<View>(ps.alloc);
-			ps.Views.push_back(v);
+			alloc::PushBack(&ps.scratch, &ps.Views, v);
 			v->Type = ViewType::Auto;
 			v->ResourceType = ResourceType::Buffer;
-			v->Buffer = (Buffer*)res.m;
+			v->Buffer = (Buffer*)sym.M;
 			v->Format = TextureFormat::Invalid;
 		}
-		else if (res.type == ParseState::ResType::Texture)
+		else if (sym.Kind == SymbolKind::Texture)
 		{
 			v = alloc::Allocate<View>(ps.alloc);
-			ps.Views.push_back(v);
+			alloc::PushBack(&ps.scratch, &ps.Views, v);
 			v->Type = ViewType::Auto;
 			v->ResourceType = ResourceType::Texture;
-			v->Texture = (Texture*)res.m;
+			v->Texture = (Texture*)sym.M;
 			v->Format = TextureFormat::Invalid;
 		}
-		else if (res.type == ParseState::ResType::Sampler)
+		else if (sym.Kind == SymbolKind::Sampler)
 		{
 			// NOTE: Valid but not handled here.
 		}
@@ -1197,11 +945,12 @@ Bind ConsumeBind(TokenIter& t, ParseState& ps)
 	ConsumeToken(TokenType::Equals, t);
 	Bind bind;
 	bind.BindTarget = AddStringToDescriptionData(bindName, ps);
-	const char* id = ConsumeIdentifier(t);
-	View* v = ConsumeViewRefOrDef(t, ps, id);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
+	View* v = ConsumeViewRefOrDef(t, ps, id, symId);
 	if (v)
 	{
-		ParserAssert(v->Type == ViewType::SRV || v->Type == ViewType::UAV ||
+		ParserAssert(t, v->Type == ViewType::SRV || v->Type == ViewType::UAV ||
 			v->Type == ViewType::Auto, "Referenced view (%s) must be SRV/UAV/Auto.",
 			id);
 		bind.Type = BindType::View;
@@ -1209,34 +958,32 @@ Bind ConsumeBind(TokenIter& t, ParseState& ps)
 	}
 	else
 	{
-		ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-		ParseState::Resource& res = ps.resMap[id];
-		if (res.type == ParseState::ResType::Sampler)
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+		if (sym.Kind == SymbolKind::Sampler)
 		{
 			bind.Type = BindType::Sampler;
-			bind.SamplerBind = (Sampler*)res.m;
+			bind.SamplerBind = (Sampler*)sym.M;
 		}
 		else
 		{
-			ParserError("Referenced resource (%s) must be SRV/UAV/Auto, or sampler.", 
+			ParserError(t, "Referenced resource (%s) must be SRV/UAV/Auto, or sampler.", 
 				id);
 		}
 	}
 	return bind;
 }
 
-CommonShader* LookupShader(const char* name, ParseState& ps)
+CommonShader* LookupShader(const char* name, u32 symId, ParseState& ps)
 {
-	auto s1 = ps.csMap.find(name);
-	if (s1 != ps.csMap.end())
-		return &s1->second->Common;
-	auto s2 = ps.vsMap.find(name);
-	if (s2 != ps.vsMap.end())
-		return &s2->second->Common;
-	auto s3 = ps.psMap.find(name);
-	if (s3 != ps.psMap.end())
-		return &s3->second->Common;
-	ParserError("No shader named %s found.", name);
+	const Symbol& sym = ps.symbols[symId];
+	if (sym.Kind == SymbolKind::ComputeShader)
+		return &((ComputeShader*)sym.M)->Common;
+	if (sym.Kind == SymbolKind::VertexShader)
+		return &((VertexShader*)sym.M)->Common;
+	if (sym.Kind == SymbolKind::PixelShader)
+		return &((PixelShader*)sym.M)->Common;
+	ParserError(ps.t, "No shader named %s found.", name);
 	return nullptr;
 }
 
@@ -1256,13 +1003,15 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 	if (tok == TokenType::Identifier)
 	{
 		const char* loc = t.next->Location;
-		const char* id = ConsumeIdentifier(t);
+		u32 symId;
+		const char* id = ConsumeIdentifier(t, symId);
 		if (TryConsumeToken(TokenType::LParen, t))
 		{
 			if (LookupKeyword(id) == Keyword::SizeOf)
 			{
-				const char* shaderName = ConsumeIdentifier(t);
-				CommonShader* shader = LookupShader(shaderName, ps);
+				u32 shaderSym;
+				const char* shaderName = ConsumeIdentifier(t, shaderSym);
+				CommonShader* shader = LookupShader(shaderName, shaderSym, ps);
 				ConsumeToken(TokenType::Comma, t);
 				const char* structName = ConsumeString(t);
 				ast::SizeOf* sizeOf = AllocateAst<ast::SizeOf>(ps);
@@ -1271,7 +1020,7 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 				SizeOfRequest req;
 				req.Shader = shader;
 				req.Dest = sizeOf;
-				ps.SizeOfRequests.push_back(req);
+				alloc::PushBack(&ps.scratch, &ps.SizeOfRequests, req);
 				ConsumeToken(TokenType::RParen, t);
 				ast = &sizeOf->Common;
 			}
@@ -1279,13 +1028,13 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 			{
 				ast::Function* func = AllocateAst<ast::Function>(ps);
 				func->Name = AddStringToDescriptionData(id, ps);
-				std::vector<ast::Node*> args;
+				alloc::List<ast::Node*> args = {};
 				if (!TryConsumeToken(TokenType::RParen, t))
 				{
 					while (true)
 					{
 						ast::Node* arg = ConsumeAstRecurse(t, ps, OpPrecedence_Start);
-						args.push_back(arg);
+						alloc::PushBack(&ps.scratch, &args, arg);
 						if (!TryConsumeToken(TokenType::Comma, t))
 							break;
 					}
@@ -1297,11 +1046,12 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 		}
 		else
 		{
-			ParserAssert(ps.varMap.count(id) == 1, "Variable %s not defined.", id);
-			ParseState::Var& v = ps.varMap[id];
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind == SymbolKind::Tuneable || sym.Kind == SymbolKind::Constant, 
+				"Variable %s not defined.", id);
 			ast::VariableRef* vr = AllocateAst<ast::VariableRef>(ps);
-			vr->IsTuneable = v.tuneable;
-			vr->M = v.m;
+			vr->IsTuneable = sym.Kind == SymbolKind::Tuneable;
+			vr->M = sym.M;
 			ast = &vr->Common;
 		}
 		ast->Location = loc;
@@ -1372,11 +1122,11 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 		const char* loc = t.next->Location;
 		ConsumeToken(TokenType::LBrace, t);
 		ast::Join* join = AllocateAst<ast::Join>(ps);
-		std::vector<ast::Node*> comps;
+		alloc::List<ast::Node*> comps = {};
 		while (true)
 		{
 			ast::Node* arg = ConsumeAstRecurse(t, ps, OpPrecedence_Start);
-			comps.push_back(arg);
+			alloc::PushBack(&ps.scratch, &comps, arg);
 			if (!TryConsumeToken(TokenType::Comma, t))
 				break;
 		}
@@ -1387,7 +1137,7 @@ ast::Node* ConsumeAstLeaf(TokenIter& t, ParseState& ps)
 	}
 	else
 	{
-		ParserError("Unexpected token when parsing leaf expression: %s");
+		ParserError(t, "Unexpected token when parsing leaf expression: %s", TokenNames[(u32)tok]);
 	}
 	
 	return ast;
@@ -1422,7 +1172,7 @@ ast::Node* ConsumeAstIncreasingPrec(TokenIter& t, ParseState& ps, ast::Node* lef
 			else if (s == 'w' || s == 'a')
 				sub->Index[i] = 4;
 			else
-				ParserError("Unexpected subscript: %s", ss);
+				ParserError(t, "Unexpected subscript: %s", ss);
 		}
 		return &sub->Common;
 	}
@@ -1472,7 +1222,7 @@ ast::Node* ConsumeAstIncreasingPrec(TokenIter& t, ParseState& ps, ast::Node* lef
 	}
 	else
 	{
-		ParserError("Unexpected token given: %s", TokenNames[(u32)tok]);
+		ParserError(t, "Unexpected token given: %s", TokenNames[(u32)tok]);
 	}
 	return nullptr;
 }
@@ -1489,7 +1239,7 @@ ast::Node* ConsumeAstRecurse(TokenIter& t, ParseState& ps, OpPrecedence min_prec
 		left = next;
 	}
 
-	ParserAssert(left, "No expression given.");
+	ParserAssert(t, left, "No expression given.");
 	return left;
 }
 
@@ -1505,8 +1255,12 @@ ast::Expression ConsumeExpression(TokenIter& t, ParseState& ps)
 	//	about how easy precedence is..." and it is significantly better than the
 	//	code I used to have to achieve the same effect. 
 	//	Link, for as long as that lasts: https://www.youtube.com/watch?v=fIPO4G42wYE
-	expr.TopNode = ConsumeAstRecurse(t, ps, OpPrecedence_Start);
+	ast::Node* top = ConsumeAstRecurse(t, ps, OpPrecedence_Start);
+	ast::TypeCheck(top, ps.alloc);
+	ps.rd->ExprStats.FoldedNodes += ast::Fold(top, ps.alloc);
+	expr.TopNode = top;
 	ast::GetDependency(expr.TopNode, expr.Dep);
+	// Compiled by ShareExpressions once every expression has been parsed.
 	return expr;
 }
 
@@ -1547,7 +1301,7 @@ void ConsumeVariable(VariableType type, Variable& var, TokenIter& t)
 	}
 }
 
-VariableType LookupVariableType(const char* id)
+VariableType LookupVariableType(const TokenIter& t, const char* id)
 {
 	VariableType type = BoolType;
 	Keyword key = LookupKeyword(id);
@@ -1596,7 +1350,7 @@ VariableType LookupVariableType(const char* id)
 		type = Float4x4Type;
 		break;
 	default:
-		ParserError("Unexpected type: %s", id);
+		ParserError(t, "Unexpected type: %s", id);
 	}
 	return type;
 }
@@ -1604,19 +1358,15 @@ VariableType LookupVariableType(const char* id)
 Tuneable* ConsumeTuneable(TokenIter& t, ParseState& ps)
 {
 	Tuneable* tune = alloc::Allocate<Tuneable>(ps.alloc);
-	ps.Tuneables.push_back(tune);
+	alloc::PushBack(&ps.scratch, &ps.Tuneables, tune);
 
 	const char* typeId = ConsumeIdentifier(t);
-	tune->Type = LookupVariableType(typeId);
+	tune->Type = LookupVariableType(t, typeId);
 
-	const char* nameId = ConsumeIdentifier(t);
+	u32 symId;
+	const char* nameId = ConsumeIdentifier(t, symId);
 	tune->Name = AddStringToDescriptionData(nameId, ps);
-	ParserAssert(ps.varMap.count(nameId) == 0, "Variable %s already defined", 
-		nameId);
-	ParseState::Var v;
-	v.tuneable = true;
-	v.m = tune;
-	ps.varMap[nameId] = v;
+	DefineSymbol(t, ps, symId, SymbolKind::Tuneable, tune);
 
 	bool hasRange = false;
 
@@ -1639,7 +1389,7 @@ Tuneable* ConsumeTuneable(TokenIter& t, ParseState& ps)
 		switch (tune->Type.Fmt)
 		{
 		case VariableFormat::Float:
-			ParserAssert(tune->Min.FloatVal < tune->Max.FloatVal && 
+			ParserAssert(t, tune->Min.FloatVal < tune->Max.FloatVal && 
 				tune->Min.FloatVal <= tune->Value.FloatVal && 
 				tune->Value.FloatVal <= tune->Max.FloatVal, 
 				"Invalid tuneable range and default, %f <= %f <= %f",
@@ -1648,14 +1398,14 @@ Tuneable* ConsumeTuneable(TokenIter& t, ParseState& ps)
 		case VariableFormat::Bool:
 			break;
 		case VariableFormat::Int:
-			ParserAssert(tune->Min.IntVal < tune->Max.IntVal && 
+			ParserAssert(t, tune->Min.IntVal < tune->Max.IntVal && 
 				tune->Min.IntVal <= tune->Value.IntVal && 
 				tune->Value.IntVal <= tune->Max.IntVal, 
 				"Invalid tuneable range and default, %d <= %d <= %d",
 				tune->Min.IntVal, tune->Value.IntVal, tune->Max.IntVal);
 			break;
 		case VariableFormat::Uint:
-			ParserAssert(tune->Min.UintVal < tune->Max.UintVal && 
+			ParserAssert(t, tune->Min.UintVal < tune->Max.UintVal && 
 				tune->Min.UintVal <= tune->Value.UintVal && 
 				tune->Value.UintVal <= tune->Max.UintVal, 
 				"Invalid tuneable range and default, %u <= %u <= %u",
@@ -1674,22 +1424,22 @@ Tuneable* ConsumeTuneable(TokenIter& t, ParseState& ps)
 Constant* ConsumeConstant(TokenIter& t, ParseState& ps)
 {
 	Constant* cnst = alloc::Allocate<Constant>(ps.alloc);
-	ps.Constants.push_back(cnst);
+	alloc::PushBack(&ps.scratch, &ps.Constants, cnst);
 
 	const char* typeId = ConsumeIdentifier(t);
-	cnst->Type = LookupVariableType(typeId);
+	cnst->Type = LookupVariableType(t, typeId);
 
-	const char* nameId = ConsumeIdentifier(t);
+	u32 symId;
+	const char* nameId = ConsumeIdentifier(t, symId);
 	cnst->Name = AddStringToDescriptionData(nameId, ps);
-	ParserAssert(ps.varMap.count(nameId) == 0, "Variable %s already defined", nameId);
+	TokenIter nameEnd = t;
 
 	ConsumeToken(TokenType::Equals, t);
 	cnst->Expr = ConsumeExpression(t,ps);
 	
-	ParseState::Var v;
-	v.tuneable = false;
-	v.m = cnst;
-	ps.varMap[nameId] = v;
+	// Not visible to its own expression. A conflicting name is still reported
+	//	at the name rather than after the expression.
+	DefineSymbol(nameEnd, ps, symId, SymbolKind::Constant, cnst);
 
 	ConsumeToken(TokenType::Semicolon, t);
 
@@ -1734,7 +1484,7 @@ struct StructEntry
 #define StructEntryDefEx(struc, type, name, field) Keyword::name, ConsumeType::type, offsetof(struc, field)
 
 StencilOpDesc ConsumeStencilOpDesc(TokenIter& t, ParseState& ps);
-void ConsumeInputLayout(TokenIter& t, ParseState& ps, Array<InputElementDesc>& outDescs);
+void ConsumeInputLayout(TokenIter& t, ParseState& ps, Array<InputElementDesc>* outDescs);
 
 template <typename T>
 void ConsumeField(TokenIter& t, ParseState& ps, T* s, ConsumeType type, size_t offset)
@@ -1811,11 +1561,12 @@ void ConsumeField(TokenIter& t, ParseState& ps, T* s, ConsumeType type, size_t o
 		break;
 	case ConsumeType::Texture:
 	{
-		const char* id = ConsumeIdentifier(t);
-		ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-		ParseState::Resource& res = ps.resMap[id];
-		ParserAssert(res.type == ParseState::ResType::Texture, "Resource must be texture");
-		*(Texture**)p = reinterpret_cast<Texture*>(res.m);
+		u32 symId;
+		const char* id = ConsumeIdentifier(t, symId);
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+		ParserAssert(t, sym.Kind == SymbolKind::Texture, "Resource must be texture");
+		*(Texture**)p = reinterpret_cast<Texture*>(sym.M);
 		break;
 	}
 	case ConsumeType::TextureFlag:
@@ -1824,10 +1575,10 @@ void ConsumeField(TokenIter& t, ParseState& ps, T* s, ConsumeType type, size_t o
 	case ConsumeType::TextureFormat:
 	{
 		const char* formatId = ConsumeIdentifier(t);
-		u32 hash = LowerHash(formatId);
-		ParserAssert(ps.fmtMap.count(hash) != 0, "Couldn't find format %s", 
+		TextureFormat fmt = LookupTextureFormat(formatId);
+		ParserAssert(t, fmt != TextureFormat::Invalid, "Couldn't find format %s", 
 			formatId);
-		*(TextureFormat*)p = ps.fmtMap[hash];
+		*(TextureFormat*)p = fmt;
 		break;
 	}
 	case ConsumeType::Blend:
@@ -1850,7 +1601,7 @@ void ConsumeField(TokenIter& t, ParseState& ps, T* s, ConsumeType type, size_t o
 	}
 }
 template <TokenType Delim, bool TrailingRequired, typename T, size_t DefSize>
-void ConsumeStruct(TokenIter& t, ParseState& ps, T* s, StructEntry (&def)[DefSize], 
+void ConsumeStruct(TokenIter& t, ParseState& ps, T* s, const StructEntry (&def)[DefSize], 
 	const char* name)
 {
 	ConsumeToken(TokenType::LBrace, t);
@@ -1873,7 +1624,7 @@ void ConsumeStruct(TokenIter& t, ParseState& ps, T* s, StructEntry (&def)[DefSiz
 				break;
 			}
 		}
-		ParserAssert(found, "Unexpected field (%s) in struct %s", id, name)
+		ParserAssert(t, found, "Unexpected field (%s) in struct %s", id, name)
 
 		if (TrailingRequired)
 		{
@@ -1893,14 +1644,14 @@ RasterizerState* ConsumeRasterizerStateDef(
 	ParseState& ps)
 {
 	RasterizerState* rs = alloc::Allocate<RasterizerState>(ps.alloc);
-	ps.RasterizerStates.push_back(rs);
+	alloc::PushBack(&ps.scratch, &ps.RasterizerStates, rs);
 
 	// non-zero defaults
 	rs->Fill = true;
 	rs->CullMode = CullMode::None;
 	rs->DepthClipEnable = true;
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(RasterizerState, Bool, Fill),
 		StructEntryDef(RasterizerState, CullMode, CullMode),
 		StructEntryDef(RasterizerState, Bool, FrontCCW),
@@ -1923,7 +1674,8 @@ RasterizerState* ConsumeRasterizerStateRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::RasterizerState)
 	{
@@ -1931,8 +1683,9 @@ RasterizerState* ConsumeRasterizerStateRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.rsMap.count(id) != 0, "couldn't find rasterizer state %s", id);
-		return ps.rsMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::RasterizerState, "couldn't find rasterizer state %s", id);
+		return (RasterizerState*)sym.M;
 	}
 }
 
@@ -1944,7 +1697,7 @@ StencilOpDesc ConsumeStencilOpDesc(TokenIter& t, ParseState& ps)
 	desc.StencilDepthFailOp = StencilOp::Keep;
 	desc.StencilPassOp = StencilOp::Keep;
 	desc.StencilFunc = ComparisonFunc::Always;
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(StencilOpDesc, StencilOp, StencilFailOp),
 		StructEntryDef(StencilOpDesc, StencilOp, StencilDepthFailOp),
 		StructEntryDef(StencilOpDesc, StencilOp, StencilPassOp),
@@ -1962,7 +1715,7 @@ DepthStencilState* ConsumeDepthStencilStateDef(
 	ParseState& ps)
 {
 	DepthStencilState* dss = alloc::Allocate<DepthStencilState>(ps.alloc);
-	ps.DepthStencilStates.push_back(dss);
+	alloc::PushBack(&ps.scratch, &ps.DepthStencilStates, dss);
 
 	// non-zero defaults
 	dss->DepthEnable = true;
@@ -1976,7 +1729,7 @@ DepthStencilState* ConsumeDepthStencilStateDef(
 	dss->FrontFace.StencilPassOp = dss->BackFace.StencilPassOp = StencilOp::Keep;
 	dss->FrontFace.StencilFunc = dss->BackFace.StencilFunc = ComparisonFunc::Always;
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(DepthStencilState, Bool, DepthEnable),
 		StructEntryDef(DepthStencilState, Bool, DepthWrite),
 		StructEntryDef(DepthStencilState, ComparisonFunc, DepthFunc),
@@ -1997,7 +1750,8 @@ DepthStencilState* ConsumeDepthStencilStateRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::DepthStencilState)
 	{
@@ -2005,8 +1759,9 @@ DepthStencilState* ConsumeDepthStencilStateRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.dssMap.count(id) != 0, "couldn't find depthstencil state %s", id);
-		return ps.dssMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::DepthStencilState, "couldn't find depthstencil state %s", id);
+		return (DepthStencilState*)sym.M;
 	}
 }
 
@@ -2016,7 +1771,7 @@ Viewport* ConsumeViewportDef(
 {
 	Viewport* vp = alloc::Allocate<Viewport>(ps.alloc);
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(Viewport, Ast, TopLeft),
 		StructEntryDef(Viewport, Ast, Size),
 		StructEntryDef(Viewport, Ast, DepthRange),
@@ -2032,7 +1787,8 @@ Viewport* ConsumeViewportRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::Viewport)
 	{
@@ -2040,8 +1796,9 @@ Viewport* ConsumeViewportRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.vpMap.count(id) != 0, "couldn't find viewport %s", id);
-		return ps.vpMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::Viewport, "couldn't find viewport %s", id);
+		return (Viewport*)sym.M;
 	}
 }
 
@@ -2058,9 +1815,9 @@ BlendState* ConsumeBlendStateDef(
 	bs->SrcAlpha = Blend::One;
 	bs->DestAlpha = Blend::Zero;
 	bs->OpAlpha = BlendOp::Add;
-	bs->RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	bs->RenderTargetWriteMask = BlendState::WRITE_ENABLE_ALL;
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(BlendState, Bool, Enable),
 		StructEntryDef(BlendState, Blend, Src),
 		StructEntryDef(BlendState, Blend, Dest),
@@ -2081,7 +1838,8 @@ BlendState* ConsumeBlendStateRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::BlendState)
 	{
@@ -2089,8 +1847,9 @@ BlendState* ConsumeBlendStateRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.bsMap.count(id) != 0, "couldn't find blend state %s", id);
-		return ps.bsMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::BlendState, "couldn't find blend state %s", id);
+		return (BlendState*)sym.M;
 	}
 }
 
@@ -2099,9 +1858,9 @@ InputElementDesc ConsumeInputElementDesc(TokenIter& t, ParseState& ps)
 	InputElementDesc ied = {};
 
 	// non-zero defaults
-	ied.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	ied.AlignedByteOffset = InputElementDesc::APPEND_ALIGNED;
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(InputElementDesc, String, SemanticName),
 		StructEntryDef(InputElementDesc, Uint, SemanticIndex),
 		StructEntryDef(InputElementDesc, TextureFormat, Format),
@@ -2120,7 +1879,7 @@ InputElementDesc ConsumeInputElementDesc(TokenIter& t, ParseState& ps)
 void ConsumeInputLayout(TokenIter& t, ParseState& ps, Array<InputElementDesc>* outDescs)
 {
 	ConsumeToken(TokenType::LBrace, t);
-	std::vector<InputElementDesc> descs;
+	alloc::List<InputElementDesc> descs = {};
 	while (true)
 	{
 		if (TryConsumeToken(TokenType::RBrace, t))
@@ -2128,9 +1887,9 @@ void ConsumeInputLayout(TokenIter& t, ParseState& ps, Array<InputElementDesc>* o
 
 		const char* id = ConsumeIdentifier(t);
 		Keyword key = LookupKeyword(id);
-		ParserAssert(key == Keyword::InputElementDesc, "expected InputElementDesc");
+		ParserAssert(t, key == Keyword::InputElementDesc, "expected InputElementDesc");
 		InputElementDesc ied = ConsumeInputElementDesc(t, ps);
-		descs.push_back(ied);
+		alloc::PushBack(&ps.scratch, &descs, ied);
 
 		if (TryConsumeToken(TokenType::RBrace, t))
 			break;
@@ -2146,9 +1905,9 @@ ComputeShader* ConsumeComputeShaderDef(
 	ParseState& ps)
 {
 	ComputeShader* cs = alloc::Allocate<ComputeShader>(ps.alloc);
-	ps.CShaders.push_back(cs);
+	alloc::PushBack(&ps.scratch, &ps.CShaders, cs);
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDefEx(ComputeShader, String, ShaderPath, Common.ShaderPath),
 		StructEntryDefEx(ComputeShader, String, EntryPoint, Common.EntryPoint),
 	};
@@ -2163,7 +1922,8 @@ ComputeShader* ConsumeComputeShaderRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::ComputeShader)
 	{
@@ -2171,8 +1931,9 @@ ComputeShader* ConsumeComputeShaderRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.csMap.count(id) != 0, "couldn't find shader %s", id);
-		return ps.csMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::ComputeShader, "couldn't find shader %s", id);
+		return (ComputeShader*)sym.M;
 	}
 }
 
@@ -2181,9 +1942,9 @@ VertexShader* ConsumeVertexShaderDef(
 	ParseState& ps)
 {
 	VertexShader* vs = alloc::Allocate<VertexShader>(ps.alloc);
-	ps.VShaders.push_back(vs);
+	alloc::PushBack(&ps.scratch, &ps.VShaders, vs);
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDefEx(VertexShader, String, ShaderPath, Common.ShaderPath),
 		StructEntryDefEx(VertexShader, String, EntryPoint, Common.EntryPoint),
 		StructEntryDef(VertexShader, InputLayout, InputLayout),
@@ -2199,7 +1960,8 @@ VertexShader* ConsumeVertexShaderRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::VertexShader)
 	{
@@ -2207,8 +1969,9 @@ VertexShader* ConsumeVertexShaderRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.vsMap.count(id) != 0, "couldn't find shader %*s", id);
-		return ps.vsMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::VertexShader, "couldn't find shader %s", id);
+		return (VertexShader*)sym.M;
 	}
 }
 
@@ -2217,9 +1980,9 @@ PixelShader* ConsumePixelShaderDef(
 	ParseState& state)
 {
 	PixelShader* ps = alloc::Allocate<PixelShader>(state.alloc);
-	state.PShaders.push_back(ps);
+	alloc::PushBack(&state.scratch, &state.PShaders, ps);
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDefEx(PixelShader, String, ShaderPath, Common.ShaderPath),
 		StructEntryDefEx(PixelShader, String, EntryPoint, Common.EntryPoint),
 	};
@@ -2234,7 +1997,8 @@ PixelShader* ConsumePixelShaderRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	if (key == Keyword::PixelShader)
 	{
@@ -2242,8 +2006,53 @@ PixelShader* ConsumePixelShaderRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.psMap.count(id) != 0, "couldn't find shader %s", id);
-		return ps.psMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::PixelShader, "couldn't find shader %s", id);
+		return (PixelShader*)sym.M;
+	}
+}
+
+// The vertices made for the obj index triplets of a mesh so far. Lives in the
+//	scratch alloc, sized to be at most half full with every index a new vertex.
+struct ObjVertexMap
+{
+	struct Entry
+	{
+		tinyobj::index_t Idx;
+		// U32_MAX while the entry is unused.
+		u32 Vertex;
+	};
+	Entry* Entries;
+	u32 Mask;
+	u32 Shift;
+};
+
+void InitObjVertexMap(ObjVertexMap& map, u32 indexCount, ParseState& ps)
+{
+	u32 bits = 4;
+	while ((1ull << bits) < (u64)indexCount * 2)
+		++bits;
+	size_t size = sizeof(ObjVertexMap::Entry) << bits;
+	map.Entries = (ObjVertexMap::Entry*)alloc::Allocate(&ps.scratch, size);
+	memset(map.Entries, 0xff, size);
+	map.Mask = (1u << bits) - 1;
+	map.Shift = 32 - bits;
+}
+
+// The entry for idx, or the unused one it can be added to.
+ObjVertexMap::Entry& FindObjVertex(ObjVertexMap& map, const tinyobj::index_t& idx)
+{
+	u32 h = 5381;
+	h = ((h << 5) + h) + idx.vertex_index;
+	h = ((h << 5) + h) + idx.normal_index;
+	h = ((h << 5) + h) + idx.texcoord_index;
+	for (u32 i = (h * 2654435769u) >> map.Shift ; ; i = (i + 1) & map.Mask)
+	{
+		ObjVertexMap::Entry& entry = map.Entries[i];
+		if (entry.Vertex == U32_MAX || (entry.Idx.vertex_index == idx.vertex_index &&
+			entry.Idx.normal_index == idx.normal_index &&
+			entry.Idx.texcoord_index == idx.texcoord_index))
+			return entry;
 	}
 }
 
@@ -2256,61 +2065,48 @@ void ParseOBJ(ObjImport* import, ParseState& ps)
 
 	std::string path = ps.workingDirectory;
 	path += import->ObjPath;
+	alloc::PushBack(&ps.scratch, &ps.Dependencies, import->ObjPath);
 
 	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str(),
 		"./", true);
-	ParserAssert(ret, "failed to load obj file: %s", err.c_str());
+	ParserAssert(ps.t, ret, "failed to load obj file: %s", err.c_str());
 
-	struct IndexEqual
-	{
-		bool operator()(const tinyobj::index_t& l, const tinyobj::index_t& r) const
-		{
-			if (l.vertex_index != r.vertex_index)
-				return false;
-			if (l.normal_index != r.normal_index)
-				return false;
-			if (l.texcoord_index != r.texcoord_index)
-				return false;
-			return true;
-		}
-	};
-	struct IndexHash
-	{
-		size_t operator()(const tinyobj::index_t& i) const
-		{
-			size_t h = 5381;
-			h = ((h << 5) + h) + i.vertex_index;
-			h = ((h << 5) + h) + i.normal_index;
-			h = ((h << 5) + h) + i.texcoord_index;
-			return h; 
-		}
-	};
-	std::unordered_map<tinyobj::index_t, size_t, IndexHash, IndexEqual> map;
+	// Only the copies made below outlive the dedup.
+	alloc::Marker dedup = alloc::Mark(&ps.scratch);
 
 	struct Vertex {
 		float3 v;
 		float3 vn;
 		float2 vt;
 	};
-	std::vector<Vertex> verts;
-	std::vector<u32> indices;
+	alloc::List<Vertex> verts = {};
+	alloc::List<u32> indices = {};
 	bool isU16 = true;
 
+	// Every index may be a new vertex.
+	u32 indexTotal = 0;
+	for (tinyobj::shape_t& shape : shapes)
+		indexTotal += (u32)shape.mesh.indices.size();
+	alloc::Reserve(&ps.scratch, &verts, indexTotal);
+	alloc::Reserve(&ps.scratch, &indices, indexTotal);
+	ObjVertexMap map;
+	InitObjVertexMap(map, indexTotal, ps);
+
 	for (tinyobj::shape_t& shape : shapes)
 	{
 		size_t indexOffset = 0;
 		tinyobj::mesh_t& mesh = shape.mesh;
 		for (size_t fv : mesh.num_face_vertices)
 		{
-			ParserAssert(fv == 3, "un-triangulated faces not supported.");
+			ParserAssert(ps.t, fv == 3, "un-triangulated faces not supported.");
 			for (size_t v = 0 ; v < fv ; ++v)
 			{
 				tinyobj::index_t idx = mesh.indices[indexOffset + v];
 
-				auto search = map.find(idx);
-				if (search != map.end())
+				ObjVertexMap::Entry& entry = FindObjVertex(map, idx);
+				if (entry.Vertex != U32_MAX)
 				{
-					indices.push_back((u32)search->second);
+					alloc::PushBack(&ps.scratch, &indices, entry.Vertex);
 					continue;
 				}
 
@@ -2337,31 +2133,32 @@ void ParseOBJ(ObjImport* import, ParseState& ps)
 					vert.vt = {tx, ty};
 				}
 
-				size_t index = verts.size();
+				size_t index = verts.Count;
 				if (index > USHRT_MAX)
 					isU16 = false;
-				verts.push_back(vert);
-				indices.push_back((u32)index);
-				map[idx] = index;
+				alloc::PushBack(&ps.scratch, &verts, vert);
+				alloc::PushBack(&ps.scratch, &indices, (u32)index);
+				entry.Idx = idx;
+				entry.Vertex = (u32)index;
 			}
 			indexOffset += fv;
 		}
 	}
 
 	import->U16 = isU16;
-	import->VertexCount = (u32)verts.size();
-	import->IndexCount = (u32)indices.size();
+	import->VertexCount = (u32)verts.Count;
+	import->IndexCount = (u32)indices.Count;
 
-	size_t vertsSize = sizeof(Vertex) * verts.size();
+	size_t vertsSize = sizeof(Vertex) * verts.Count;
 	import->Vertices = alloc::Allocate(ps.alloc, vertsSize);
-	memcpy(import->Vertices, verts.data(), vertsSize);
+	memcpy(import->Vertices, verts.Data, vertsSize);
 
-	size_t indicesSize = (isU16 ? 2 : 4) * indices.size();
+	size_t indicesSize = (isU16 ? 2 : 4) * indices.Count;
 	import->Indices = alloc::Allocate(ps.alloc, indicesSize);
 	if (isU16)
 	{
 		u16* shorts = (u16*)import->Indices;
-		for (size_t i = 0 ; i < indices.size() ; ++i)
+		for (size_t i = 0 ; i < indices.Count ; ++i)
 		{
 			u32 val = indices[i];
 			Assert(val <= USHRT_MAX, "mismatch in expected size");
@@ -2370,8 +2167,9 @@ void ParseOBJ(ObjImport* import, ParseState& ps)
 	}
 	else
 	{
-		memcpy(import->Indices, indices.data(), indicesSize);
+		memcpy(import->Indices, indices.Data, indicesSize);
 	}
+	alloc::Rollback(&ps.scratch, dedup);
 }
 
 ObjImport* ConsumeObjImportDef(
@@ -2399,6 +2197,22 @@ ObjImport* ConsumeObjImportDef(
 }
 
 
+// Copies init data collected in the scratch alloc to the description, and
+//	rolls the scratch back to before it was collected.
+template <typename T>
+void StoreInitData(const alloc::List<T>& data, alloc::Marker staging, ParseState& ps,
+	void*& outData, size_t& outSize)
+{
+	outSize = data.Count * sizeof(T);
+	outData = nullptr;
+	if (outSize > 0)
+	{
+		outData = alloc::Allocate(ps.alloc, outSize);
+		memcpy(outData, data.Data, outSize);
+	}
+	alloc::Rollback(&ps.scratch, staging);
+}
+
 Buffer* ConsumeBufferDef(
 	TokenIter& t,
 	ParseState& ps)
@@ -2406,11 +2220,10 @@ Buffer* ConsumeBufferDef(
 	ConsumeToken(TokenType::LBrace, t);
 
 	Buffer* buf = alloc::Allocate<Buffer>(ps.alloc);
-	ps.Buffers.push_back(buf);
+	alloc::PushBack(&ps.scratch, &ps.Buffers, buf);
 
-	std::vector<u16> initDataU16;
-	std::vector<u32> initDataU32;
-	std::vector<float> initDataFloat;
+	void* initData = nullptr;
+	size_t initDataSize = 0;
 
 	ObjImport* obj = nullptr;
 	bool objVerts = false;
@@ -2447,10 +2260,13 @@ Buffer* ConsumeBufferDef(
 		case Keyword::InitData:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
 			Keyword key = LookupKeyword(id);
+			alloc::Marker staging = alloc::Mark(&ps.scratch);
 			if (key == Keyword::Float)
 			{
+				alloc::List<float> data = {};
 				ConsumeToken(TokenType::LBrace, t);
 
 				while (true)
@@ -2459,16 +2275,18 @@ Buffer* ConsumeBufferDef(
 						break;
 
 					float f = ConsumeFloatLiteral(t);
-					initDataFloat.push_back(f);
+					alloc::PushBack(&ps.scratch, &data, f);
 
 					if (TryConsumeToken(TokenType::RBrace, t))
 						break;
 					else 
 						ConsumeToken(TokenType::Comma, t);
 				}
+				StoreInitData(data, staging, ps, initData, initDataSize);
 			}
 			else if (key == Keyword::U16)
 			{
+				alloc::List<u16> data = {};
 				ConsumeToken(TokenType::LBrace, t);
 
 				while (true)
@@ -2477,18 +2295,20 @@ Buffer* ConsumeBufferDef(
 						break;
 
 					u32 val = ConsumeUintLiteral(t);
-					ParserAssert(val < 65536, "Given literal is outside of u16 range.");
+					ParserAssert(t, val < 65536, "Given literal is outside of u16 range.");
 					u16 l = (u16)val;
-					initDataU16.push_back(l);
+					alloc::PushBack(&ps.scratch, &data, l);
 
 					if (TryConsumeToken(TokenType::RBrace, t))
 						break;
 					else 
 						ConsumeToken(TokenType::Comma, t);
 				}
+				StoreInitData(data, staging, ps, initData, initDataSize);
 			}
 			else if (key == Keyword::U32)
 			{
+				alloc::List<u32> data = {};
 				ConsumeToken(TokenType::LBrace, t);
 
 				while (true)
@@ -2497,17 +2317,18 @@ Buffer* ConsumeBufferDef(
 						break;
 					
 					u32 val = ConsumeUintLiteral(t);
-					initDataU32.push_back(val);
+					alloc::PushBack(&ps.scratch, &data, val);
 
 					if (TryConsumeToken(TokenType::RBrace, t))
 						break;
 					else 
 						ConsumeToken(TokenType::Comma, t);
 				}
+				StoreInitData(data, staging, ps, initData, initDataSize);
 			}
-			else if (ps.objMap.count(id) > 0)
+			else if (ps.symbols[symId].Kind == SymbolKind::ObjImport)
 			{
-				obj = ps.objMap[id];
+				obj = (ObjImport*)ps.symbols[symId].M;
 				ConsumeToken(TokenType::Period, t);
 				const char* sub = ConsumeIdentifier(t);
 				Keyword subkey = LookupKeyword(sub);
@@ -2521,17 +2342,17 @@ Buffer* ConsumeBufferDef(
 				}
 				else
 				{
-					ParserError("unexpected obj subscript %s", id);
+					ParserError(t, "unexpected obj subscript %s", id);
 				}
 			}
 			else
 			{
-				ParserError("unexpected data type or obj import %s", id);
+				ParserError(t, "unexpected data type or obj import %s", id);
 			}
 			break;
 		}
 		default:
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -2559,33 +2380,18 @@ Buffer* ConsumeBufferDef(
 	}
 	else
 	{
-		ParserAssert(buf->ElementSizeExpr.TopNode && buf->ElementCountExpr.TopNode, 
+		ParserAssert(t, buf->ElementSizeExpr.TopNode && buf->ElementCountExpr.TopNode, 
 			"ElementSize and ElementCount must be defined for buffer");
-		ParserAssert(!buf->ElementSizeExpr.VariesByTime() && 
+		ParserAssert(t, !buf->ElementSizeExpr.VariesByTime() && 
 			!buf->ElementCountExpr.VariesByTime(), "Buffer size/count may not depend on time.");
 
-		size_t bufSize = max(
-			max(
-				initDataU16.size() * sizeof(u16), 
-				initDataU32.size() * sizeof(u32)
-			),
-			initDataFloat.size() * sizeof(float)
-		);
-		if (bufSize > 0)
+		if (initDataSize > 0)
 		{
-			ParserAssert(buf->ElementSizeExpr.Constant() && buf->ElementCountExpr.Constant(),
+			ParserAssert(t, buf->ElementSizeExpr.Constant() && buf->ElementCountExpr.Constant(),
 				"Buffer having InitData is not compatible with non-constant buffer size/count");
-			void* data = alloc::Allocate(ps.alloc, bufSize);
-			buf->InitData = data;
-			buf->InitDataSize = (u32)bufSize;
+			buf->InitData = initData;
+			buf->InitDataSize = (u32)initDataSize;
 		}
-
-		if (initDataFloat.size() > 0)
-			memcpy(buf->InitData, initDataFloat.data(), bufSize);
-		else if (initDataU16.size() > 0)
-			memcpy(buf->InitData, initDataU16.data(), bufSize);
-		else if (initDataU32.size() > 0)
-			memcpy(buf->InitData, initDataU32.data(), bufSize);
 	}
 
 	return buf;
@@ -2596,13 +2402,13 @@ Texture* ConsumeTextureDef(
 	ParseState& ps)
 {
 	Texture* tex = alloc::Allocate<Texture>(ps.alloc);
-	ps.Textures.push_back(tex);
+	alloc::PushBack(&ps.scratch, &ps.Textures, tex);
 
 	// non-zero defaults
 	tex->Format = TextureFormat::R8G8B8A8_UNORM;
 	tex->SampleCount = 1;
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(Texture, TextureFlag, Flags),
 		StructEntryDefEx(Texture, Ast, Size, SizeExpr),
 		StructEntryDef(Texture, TextureFormat, Format),
@@ -2614,9 +2420,9 @@ Texture* ConsumeTextureDef(
 	ConsumeStruct<Delim, TrailingRequired>(
 		t, ps, tex, def, "Texture");
 
-	ParserAssert(tex->FromFile || tex->SizeExpr.IsValid(), 
+	ParserAssert(t, tex->FromFile || tex->SizeExpr.IsValid(), 
 		"Texture size must be provided if not populated from DDS");
-	ParserAssert(!tex->SizeExpr.IsValid() || !tex->SizeExpr.VariesByTime(), 
+	ParserAssert(t, !tex->SizeExpr.IsValid() || !tex->SizeExpr.VariesByTime(), 
 		"Texture size may not vary by time.");
 
 	return tex;
@@ -2627,7 +2433,7 @@ Sampler* ConsumeSamplerDef(
 	ParseState& ps)
 {
 	Sampler* s = alloc::Allocate<Sampler>(ps.alloc);
-	ps.Samplers.push_back(s);
+	alloc::PushBack(&ps.scratch, &ps.Samplers, s);
 
 	// non-zero defaults
 	s->MinLOD = -FLT_MAX;
@@ -2635,7 +2441,7 @@ Sampler* ConsumeSamplerDef(
 	s->MaxAnisotropy = 1;
 	s->BorderColor = {1,1,1,1};
 
-	static StructEntry def[] = {
+	static const StructEntry def[] = {
 		StructEntryDef(Sampler, FilterMode, Filter),
 		StructEntryDef(Sampler, AddressModeUVW, AddressMode),
 		StructEntryDef(Sampler, Float, MipLODBias),
@@ -2658,10 +2464,10 @@ Dispatch* ConsumeDispatchDef(
 	ConsumeToken(TokenType::LBrace, t);
 
 	Dispatch* dc = alloc::Allocate<Dispatch>(ps.alloc);
-	ps.Dispatches.push_back(dc);
+	alloc::PushBack(&ps.scratch, &ps.Dispatches, dc);
 
-	std::vector<Bind> binds;
-	std::vector<SetConstant> constants;
+	alloc::List<Bind> binds = {};
+	alloc::List<SetConstant> constants = {};
 
 	while (true)
 	{
@@ -2691,12 +2497,13 @@ Dispatch* ConsumeDispatchDef(
 		case Keyword::IndirectArgs:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-			ParseState::Resource& res = ps.resMap[id];
-			ParserAssert(res.type == ParseState::ResType::Buffer, 
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+			ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 				"Resource (%s) must be a buffer", id);
-			dc->IndirectArgs = reinterpret_cast<Buffer*>(res.m);
+			dc->IndirectArgs = reinterpret_cast<Buffer*>(sym.M);
 			break;
 		}
 		case Keyword::IndirectArgsOffset:
@@ -2708,17 +2515,17 @@ Dispatch* ConsumeDispatchDef(
 		case Keyword::Bind:
 		{
 			Bind bind = ConsumeBind(t, ps);
-			binds.push_back(bind);
+			alloc::PushBack(&ps.scratch, &binds, bind);
 			break;
 		}
 		case Keyword::SetConstant:
 		{
 			SetConstant sc = ConsumeSetConstant(t,ps);
-			constants.push_back(sc);
+			alloc::PushBack(&ps.scratch, &constants, sc);
 			break;
 		}
 		default:
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		if (key != Keyword::SetConstant)
@@ -2741,19 +2548,19 @@ Draw* ConsumeDrawDef(
 	ConsumeToken(TokenType::LBrace, t);
 
 	Draw* draw = alloc::Allocate<Draw>(ps.alloc);
-	ps.Draws.push_back(draw);
+	alloc::PushBack(&ps.scratch, &ps.Draws, draw);
 
 	// non-zero defaults
 	draw->Topology = Topology::TriList;
 
-	std::vector<Buffer*> vertexBuffers;
-	std::vector<View*> renderTargets;
-	std::vector<Viewport*> viewports;
-	std::vector<BlendState*> blendStates;
-	std::vector<Bind> vsBinds;
-	std::vector<Bind> psBinds;
-	std::vector<SetConstant> vsConstants;
-	std::vector<SetConstant> psConstants;
+	alloc::List<Buffer*> vertexBuffers = {};
+	alloc::List<View*> renderTargets = {};
+	alloc::List<Viewport*> viewports = {};
+	alloc::List<BlendState*> blendStates = {};
+	alloc::List<Bind> vsBinds = {};
+	alloc::List<Bind> psBinds = {};
+	alloc::List<SetConstant> vsConstants = {};
+	alloc::List<SetConstant> psConstants = {};
 
 	while (true)
 	{
@@ -2793,29 +2600,31 @@ Draw* ConsumeDrawDef(
 		}
 		case Keyword::VertexBuffer:
 		{
-			vertexBuffers.clear();
+			vertexBuffers.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-			ParseState::Resource& res = ps.resMap[id];
-			ParserAssert(res.type == ParseState::ResType::Buffer, 
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+			ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 				"Resource (%s) must be a buffer", id);
-			vertexBuffers.push_back(reinterpret_cast<Buffer*>(res.m));
+			alloc::PushBack(&ps.scratch, &vertexBuffers, reinterpret_cast<Buffer*>(sym.M));
 			break;
 		}
 		case Keyword::VertexBuffers:
 		{
-			vertexBuffers.clear();
+			vertexBuffers.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
 			ConsumeToken(TokenType::LBrace, t);
 			while (true)
 			{
-				const char* id = ConsumeIdentifier(t);
-				ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-				ParseState::Resource& res = ps.resMap[id];
-				ParserAssert(res.type == ParseState::ResType::Buffer, 
+				u32 symId;
+				const char* id = ConsumeIdentifier(t, symId);
+				const Symbol& sym = ps.symbols[symId];
+				ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+				ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 					"Resource (%s) must be a buffer", id);
-				vertexBuffers.push_back(reinterpret_cast<Buffer*>(res.m));
+				alloc::PushBack(&ps.scratch, &vertexBuffers, reinterpret_cast<Buffer*>(sym.M));
 				if (!TryConsumeToken(TokenType::Comma, t))
 				{
 					ConsumeToken(TokenType::RBrace, t);
@@ -2827,35 +2636,37 @@ Draw* ConsumeDrawDef(
 		case Keyword::IndexBuffer:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", 
-				id);
-			ParseState::Resource& res = ps.resMap[id];
-			ParserAssert(res.type == ParseState::ResType::Buffer, 
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+			ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 				"Resource (%s) must be a buffer", id);
-			draw->IndexBuffer = reinterpret_cast<Buffer*>(res.m);
+			draw->IndexBuffer = reinterpret_cast<Buffer*>(sym.M);
 			break;
 		}
 		case Keyword::InstancedIndirectArgs:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-			ParseState::Resource& res = ps.resMap[id];
-			ParserAssert(res.type == ParseState::ResType::Buffer, 
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+			ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 				"Resource (%s) must be a buffer", id);
-			draw->InstancedIndirectArgs = reinterpret_cast<Buffer*>(res.m);
+			draw->InstancedIndirectArgs = reinterpret_cast<Buffer*>(sym.M);
 			break;
 		}
 		case Keyword::IndexedInstancedIndirectArgs:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(id) != 0, "Couldn't find resource %s", id);
-			ParseState::Resource& res = ps.resMap[id];
-			ParserAssert(res.type == ParseState::ResType::Buffer, 
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", id);
+			ParserAssert(t, sym.Kind == SymbolKind::Buffer, 
 				"Resource (%s) must be a buffer", id);
-			draw->IndexedInstancedIndirectArgs = reinterpret_cast<Buffer*>(res.m);
+			draw->IndexedInstancedIndirectArgs = reinterpret_cast<Buffer*>(sym.M);
 			break;
 		}
 		case Keyword::IndirectArgsOffset:
@@ -2884,33 +2695,35 @@ Draw* ConsumeDrawDef(
 		}
 		case Keyword::RenderTarget:
 		{
-			renderTargets.clear();
+			renderTargets.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			View* v = ConsumeViewRefOrDef(t, ps, id);
-			ParserAssert(v, "RenderTarget must be a RTV.");
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+			ParserAssert(t, v, "RenderTarget must be a RTV.");
 			if (v->Type == ViewType::Auto)
 				v->Type = ViewType::RTV;
-			ParserAssert(v->Type == ViewType::RTV, "RenderTarget must be a RTV.");
-			renderTargets.push_back(v);
+			ParserAssert(t, v->Type == ViewType::RTV, "RenderTarget must be a RTV.");
+			alloc::PushBack(&ps.scratch, &renderTargets, v);
 			break;
 		}
 		case Keyword::RenderTargets:
 		{
-			renderTargets.clear();
+			renderTargets.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
 			ConsumeToken(TokenType::LBrace, t);
 			while (true)
 			{
 				if (TryConsumeToken(TokenType::RBrace, t))
 					break;
-				const char* id = ConsumeIdentifier(t);
-				View* v = ConsumeViewRefOrDef(t, ps, id);
-				ParserAssert(v, "RenderTarget must be a RTV.");
+				u32 symId;
+				const char* id = ConsumeIdentifier(t, symId);
+				View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+				ParserAssert(t, v, "RenderTarget must be a RTV.");
 				if (v->Type == ViewType::Auto)
 					v->Type = ViewType::RTV;
-				ParserAssert(v->Type == ViewType::RTV, "RenderTarget must be a RTV.");
-				renderTargets.push_back(v);
+				ParserAssert(t, v->Type == ViewType::RTV, "RenderTarget must be a RTV.");
+				alloc::PushBack(&ps.scratch, &renderTargets, v);
 				if (!TryConsumeToken(TokenType::Comma, t))
 				{
 					ConsumeToken(TokenType::RBrace, t);
@@ -2921,7 +2734,7 @@ Draw* ConsumeDrawDef(
 		}
 		case Keyword::Viewports:
 		{
-			viewports.clear();
+			viewports.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
 			ConsumeToken(TokenType::LBrace, t);
 			while (true)
@@ -2929,7 +2742,7 @@ Draw* ConsumeDrawDef(
 				if (TryConsumeToken(TokenType::RBrace, t))
 					break;
 				Viewport* vp = ConsumeViewportRefOrDef(t, ps);
-				viewports.push_back(vp);
+				alloc::PushBack(&ps.scratch, &viewports, vp);
 				if (!TryConsumeToken(TokenType::Comma, t))
 				{
 					ConsumeToken(TokenType::RBrace, t);
@@ -2940,7 +2753,7 @@ Draw* ConsumeDrawDef(
 		}
 		case Keyword::BlendStates:
 		{
-			blendStates.clear();
+			blendStates.Count = 0;
 			ConsumeToken(TokenType::Equals, t);
 			ConsumeToken(TokenType::LBrace, t);
 			while (true)
@@ -2948,7 +2761,7 @@ Draw* ConsumeDrawDef(
 				if (TryConsumeToken(TokenType::RBrace, t))
 					break;
 				BlendState* bs = ConsumeBlendStateRefOrDef(t, ps);
-				blendStates.push_back(bs);
+				alloc::PushBack(&ps.scratch, &blendStates, bs);
 				if (!TryConsumeToken(TokenType::Comma, t))
 				{
 					ConsumeToken(TokenType::RBrace, t);
@@ -2960,41 +2773,42 @@ Draw* ConsumeDrawDef(
 		case Keyword::DepthStencil:
 		{
 			ConsumeToken(TokenType::Equals, t);
-			const char* id = ConsumeIdentifier(t);
-			View* v = ConsumeViewRefOrDef(t, ps, id);
-			ParserAssert(v, "DepthStencil must be a DSV.");
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+			ParserAssert(t, v, "DepthStencil must be a DSV.");
 			if (v->Type == ViewType::Auto)
 				v->Type = ViewType::DSV;
-			ParserAssert(v->Type == ViewType::DSV, "DepthStencil must be a DSV.");
+			ParserAssert(t, v->Type == ViewType::DSV, "DepthStencil must be a DSV.");
 			draw->DepthStencil = v;
 			break;
 		}
 		case Keyword::BindVS:
 		{
 			Bind bind = ConsumeBind(t, ps);
-			vsBinds.push_back(bind);
+			alloc::PushBack(&ps.scratch, &vsBinds, bind);
 			break;
 		}
 		case Keyword::BindPS:
 		{
 			Bind bind = ConsumeBind(t, ps);
-			psBinds.push_back(bind);
+			alloc::PushBack(&ps.scratch, &psBinds, bind);
 			break;
 		}
 		case Keyword::SetConstantVS:
 		{
 			SetConstant sc = ConsumeSetConstant(t,ps);
-			vsConstants.push_back(sc);
+			alloc::PushBack(&ps.scratch, &vsConstants, sc);
 			break;
 		}
 		case Keyword::SetConstantPS:
 		{
 			SetConstant sc = ConsumeSetConstant(t,ps);
-			psConstants.push_back(sc);
+			alloc::PushBack(&ps.scratch, &psConstants, sc);
 			break;
 		}
 		default:
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		if (key != Keyword::SetConstantVS && key != Keyword::SetConstantPS)
@@ -3032,12 +2846,13 @@ ClearColor* ConsumeClearColorDef(
 
 		if (key == Keyword::Target)
 		{
-			const char* id = ConsumeIdentifier(t);
-			View* v = ConsumeViewRefOrDef(t, ps, id);
-			ParserAssert(v, "Target must be a RTV.");
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+			ParserAssert(t, v, "Target must be a RTV.");
 			if (v->Type == ViewType::Auto)
 				v->Type = ViewType::RTV;
-			ParserAssert(v->Type == ViewType::RTV, "Target must be a RTV.");
+			ParserAssert(t, v->Type == ViewType::RTV, "Target must be a RTV.");
 			clear->Target = v;
 		}
 		else if (key == Keyword::Color)
@@ -3054,7 +2869,7 @@ ClearColor* ConsumeClearColorDef(
 		}
 		else 
 		{
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -3062,7 +2877,7 @@ ClearColor* ConsumeClearColorDef(
 			break;
 	}
 
-	ParserAssert(clear->Target, "Target must be set.");
+	ParserAssert(t, clear->Target, "Target must be set.");
 	return clear;
 }
 
@@ -3082,12 +2897,13 @@ ClearDepth* ConsumeClearDepthDef(
 
 		if (key == Keyword::Target)
 		{
-			const char* id = ConsumeIdentifier(t);
-			View* v = ConsumeViewRefOrDef(t, ps, id);
-			ParserAssert(v, "Target must be a DSV.");
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+			ParserAssert(t, v, "Target must be a DSV.");
 			if (v->Type == ViewType::Auto)
 				v->Type = ViewType::DSV;
-			ParserAssert(v->Type == ViewType::DSV, "Target must be a DSV.");
+			ParserAssert(t, v->Type == ViewType::DSV, "Target must be a DSV.");
 			clear->Target = v;
 		}
 		else if (key == Keyword::Depth)
@@ -3096,7 +2912,7 @@ ClearDepth* ConsumeClearDepthDef(
 		}
 		else 
 		{
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -3104,7 +2920,7 @@ ClearDepth* ConsumeClearDepthDef(
 			break;
 	}
 
-	ParserAssert(clear->Target, "Target must be set.");
+	ParserAssert(t, clear->Target, "Target must be set.");
 	return clear;
 }
 
@@ -3124,12 +2940,13 @@ ClearStencil* ConsumeClearStencilDef(
 
 		if (key == Keyword::Target)
 		{
-			const char* id = ConsumeIdentifier(t);
-			View* v = ConsumeViewRefOrDef(t, ps, id);
-			ParserAssert(v, "Target must be a DSV.");
+			u32 symId;
+			const char* id = ConsumeIdentifier(t, symId);
+			View* v = ConsumeViewRefOrDef(t, ps, id, symId);
+			ParserAssert(t, v, "Target must be a DSV.");
 			if (v->Type == ViewType::Auto)
 				v->Type = ViewType::DSV;
-			ParserAssert(v->Type == ViewType::DSV, "Target must be a DSV.");
+			ParserAssert(t, v->Type == ViewType::DSV, "Target must be a DSV.");
 			clear->Target = v;
 		}
 		else if (key == Keyword::Stencil)
@@ -3138,7 +2955,7 @@ ClearStencil* ConsumeClearStencilDef(
 		}
 		else 
 		{
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -3146,7 +2963,7 @@ ClearStencil* ConsumeClearStencilDef(
 			break;
 	}
 
-	ParserAssert(clear->Target, "Target must be set.");
+	ParserAssert(t, clear->Target, "Target must be set.");
 	return clear;
 }
 
@@ -3166,20 +2983,20 @@ Resolve* ConsumeResolveDef(
 
 		if (key == Keyword::Src || key == Keyword::Dst)
 		{
-			const char* rid = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(rid) != 0, "Couldn't find resource %s", 
-				rid);
-			ParseState::Resource& res = ps.resMap[rid];
-			ParserAssert(res.type == ParseState::ResType::Texture, 
+			u32 symId;
+			const char* rid = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", rid);
+			ParserAssert(t, sym.Kind == SymbolKind::Texture, 
 				"Referenced resource (%s) must be Texture.", rid);
 			if (key == Keyword::Src)
-				resolve->Src = (Texture*)res.m;
+				resolve->Src = (Texture*)sym.M;
 			else
-				resolve->Dst = (Texture*)res.m;
+				resolve->Dst = (Texture*)sym.M;
 		}
 		else 
 		{
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -3187,8 +3004,8 @@ Resolve* ConsumeResolveDef(
 			break;
 	}
 
-	ParserAssert(resolve->Src, "Target must be set.");
-	ParserAssert(resolve->Dst, "Target must be set.");
+	ParserAssert(t, resolve->Src, "Target must be set.");
+	ParserAssert(t, resolve->Dst, "Target must be set.");
 	return resolve;
 }
 
@@ -3219,7 +3036,7 @@ ObjDraw* ConsumeObjDrawDef(
 	ConsumeToken(TokenType::LBrace, t);
 
 	ObjDraw* objDraw = alloc::Allocate<ObjDraw>(ps.alloc);
-	ps.ObjDraws.push_back(objDraw);
+	alloc::PushBack(&ps.scratch, &ps.ObjDraws, objDraw);
 
 	Draw* templ = nullptr;
 	const char* objPath = nullptr;
@@ -3237,12 +3054,12 @@ ObjDraw* ConsumeObjDrawDef(
 		else if (key == Keyword::Template)
 		{
 			Pass pass = ConsumePassRefOrDef(t, ps);
-			ParserAssert(pass.Type == PassType::Draw, "Invalid Template, must be draw.");
+			ParserAssert(t, pass.Type == PassType::Draw, "Invalid Template, must be draw.");
 			templ = pass.Draw;
 		}
 		else
 		{
-			ParserError("unexpected field %s", fieldId);
+			ParserError(t, "unexpected field %s", fieldId);
 		}
 
 		ConsumeToken(TokenType::Semicolon, t);
@@ -3250,8 +3067,8 @@ ObjDraw* ConsumeObjDrawDef(
 			break;
 	}
 
-	ParserAssert(templ, "Template not set");
-	ParserAssert(objPath, "ObjPath not set");
+	ParserAssert(t, templ, "Template not set");
+	ParserAssert(t, objPath, "ObjPath not set");
 
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
@@ -3260,37 +3077,13 @@ ObjDraw* ConsumeObjDrawDef(
 
 	std::string path = ps.workingDirectory;
 	path += objPath;
+	alloc::PushBack(&ps.scratch, &ps.Dependencies, objPath);
 
 	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str(),
 		ps.workingDirectory, true);
-	ParserAssert(ret, "failed to load obj file: %s", err.c_str());
-
-	struct IndexEqual
-	{
-		bool operator()(const tinyobj::index_t& l, const tinyobj::index_t& r) const
-		{
-			if (l.vertex_index != r.vertex_index)
-				return false;
-			if (l.normal_index != r.normal_index)
-				return false;
-			if (l.texcoord_index != r.texcoord_index)
-				return false;
-			return true;
-		}
-	};
-	struct IndexHash
-	{
-		size_t operator()(const tinyobj::index_t& i) const
-		{
-			size_t h = 5381;
-			h = ((h << 5) + h) + i.vertex_index;
-			h = ((h << 5) + h) + i.normal_index;
-			h = ((h << 5) + h) + i.texcoord_index;
-			return h; 
-		}
-	};
+	ParserAssert(t, ret, "failed to load obj file: %s", err.c_str());
 
-	std::vector<Draw*> perMeshDraws;
+	alloc::List<Draw*> perMeshDraws = {};
 	std::unordered_map<std::string, View*> materialViews;
 
 	for (size_t shape_idx = 0 ; shape_idx < shapes.size() ; ++shape_idx)
@@ -3298,8 +3091,8 @@ ObjDraw* ConsumeObjDrawDef(
 		tinyobj::shape_t& shape = shapes[shape_idx];
 
 		Draw* sub_draw = alloc::Allocate<Draw>(ps.alloc);
-		ps.Draws.push_back(sub_draw);
-		perMeshDraws.push_back(sub_draw);
+		alloc::PushBack(&ps.scratch, &ps.Draws, sub_draw);
+		alloc::PushBack(&ps.scratch, &perMeshDraws, sub_draw);
 		// copy state to the sub draw
 		*sub_draw = *templ;
 		// The arrays which will be updated by the D3D init phase need to be cloned 
@@ -3309,31 +3102,37 @@ ObjDraw* ConsumeObjDrawDef(
 		sub_draw->VSConstants = DuplicateArray(templ->VSConstants, ps);
 		sub_draw->PSConstants = DuplicateArray(templ->PSConstants, ps);
 
-		std::unordered_map<tinyobj::index_t, size_t, IndexHash, IndexEqual> map;
+		// Only the copies made below outlive the dedup.
+		alloc::Marker dedup = alloc::Mark(&ps.scratch);
 
 		struct Vertex {
 			float3 v;
 			float3 vn;
 			float2 vt;
 		};
-		std::vector<Vertex> verts;
-		std::vector<u32> idxs;
+		alloc::List<Vertex> verts = {};
+		alloc::List<u32> idxs = {};
 		bool isU16 = true;
 
 		tinyobj::mesh_t& mesh = shape.mesh;
+		// Every index may be a new vertex.
+		alloc::Reserve(&ps.scratch, &verts, (u32)mesh.indices.size());
+		alloc::Reserve(&ps.scratch, &idxs, (u32)mesh.indices.size());
+		ObjVertexMap map;
+		InitObjVertexMap(map, (u32)mesh.indices.size(), ps);
 		size_t indexOffset = 0;
 		int material_id = mesh.material_ids[0];
 		for (size_t fv : mesh.num_face_vertices)
 		{
-			ParserAssert(fv == 3, "un-triangulated faces not supported.");
+			ParserAssert(t, fv == 3, "un-triangulated faces not supported.");
 			for (size_t v = 0 ; v < fv ; ++v)
 			{
 				tinyobj::index_t idx = mesh.indices[indexOffset + v];
 
-				auto search = map.find(idx);
-				if (search != map.end())
+				ObjVertexMap::Entry& entry = FindObjVertex(map, idx);
+				if (entry.Vertex != U32_MAX)
 				{
-					idxs.push_back((u32)search->second);
+					alloc::PushBack(&ps.scratch, &idxs, entry.Vertex);
 					continue;
 				}
 
@@ -3360,22 +3159,23 @@ ObjDraw* ConsumeObjDrawDef(
 					vert.vt = {tx, ty};
 				}
 
-				size_t index = verts.size();
+				size_t index = verts.Count;
 				if (index > USHRT_MAX)
 					isU16 = false;
-				verts.push_back(vert);
-				idxs.push_back((u32)index);
-				map[idx] = index;
+				alloc::PushBack(&ps.scratch, &verts, vert);
+				alloc::PushBack(&ps.scratch, &idxs, (u32)index);
+				entry.Idx = idx;
+				entry.Vertex = (u32)index;
 			}
 			indexOffset += fv;
 		}
 
-		u32 vertexCount = (u32)verts.size();
-		u32 indexCount = (u32)idxs.size();
+		u32 vertexCount = (u32)verts.Count;
+		u32 indexCount = (u32)idxs.Count;
 
 		size_t vertsSize = sizeof(Vertex) * vertexCount;
 		void* vertices = alloc::Allocate(ps.alloc, vertsSize);
-		memcpy(vertices, verts.data(), vertsSize);
+		memcpy(vertices, verts.Data, vertsSize);
 
 		size_t indicesSize = (isU16 ? 2 : 4) * indexCount;
 		void* indices = alloc::Allocate(ps.alloc, indicesSize);
@@ -3391,11 +3191,12 @@ ObjDraw* ConsumeObjDrawDef(
 		}
 		else
 		{
-			memcpy(indices, idxs.data(), indicesSize);
+			memcpy(indices, idxs.Data, indicesSize);
 		}
+		alloc::Rollback(&ps.scratch, dedup);
 
 		Buffer* vbuf = alloc::Allocate<Buffer>(ps.alloc);
-		ps.Buffers.push_back(vbuf);
+		alloc::PushBack(&ps.scratch, &ps.Buffers, vbuf);
 		vbuf->InitData = vertices;
 		vbuf->ElementSize = sizeof(Vertex);
 		vbuf->ElementCount = vertexCount;
@@ -3403,15 +3204,14 @@ ObjDraw* ConsumeObjDrawDef(
 		vbuf->Flags = BufferFlag_Vertex;
 
 		Buffer* ibuf = alloc::Allocate<Buffer>(ps.alloc);
-		ps.Buffers.push_back(ibuf);
+		alloc::PushBack(&ps.scratch, &ps.Buffers, ibuf);
 		ibuf->InitData = indices;
 		ibuf->ElementSize = isU16 ? 2 : 4;
 		ibuf->ElementCount = indexCount;
 		ibuf->InitDataSize = ibuf->ElementSize * ibuf->ElementCount;
 		ibuf->Flags = BufferFlag_Index;
 
-		std::vector<Buffer*> vertexBuffers(1, vbuf);
-		sub_draw->VertexBuffers = alloc::MakeCopy(ps.alloc, vertexBuffers);
+		sub_draw->VertexBuffers = alloc::MakeCopy(ps.alloc, &vbuf, 1);
 		sub_draw->IndexBuffer = ibuf;
 
 		tinyobj::material_t& material = materials[material_id];
@@ -3426,12 +3226,12 @@ ObjDraw* ConsumeObjDrawDef(
 			else
 			{
 				Texture* alb_tex = alloc::Allocate<Texture>(ps.alloc);
-				ps.Textures.push_back(alb_tex);
+				alloc::PushBack(&ps.scratch, &ps.Textures, alb_tex);
 				alb_tex->FromFile = AddStringToDescriptionData(
 					material.ambient_texname.c_str(), ps);
 
 				alb_view = alloc::Allocate<View>(ps.alloc);
-				ps.Views.push_back(alb_view);
+				alloc::PushBack(&ps.scratch, &ps.Views, alb_view);
 				alb_view->Type = ViewType::SRV;
 				alb_view->ResourceType = ResourceType::Texture;
 				alb_view->Texture = alb_tex;
@@ -3444,9 +3244,13 @@ ObjDraw* ConsumeObjDrawDef(
 			bind.BindTarget = AddStringToDescriptionData("map_Ka", ps);
 			bind.Type = BindType::View;
 			bind.ViewBind = alb_view;
-			std::vector<Bind> binds(templ->PSBinds.Data, templ->PSBinds.Data+templ->PSBinds.Count);
-			binds.push_back(bind);
-			sub_draw->PSBinds = alloc::MakeCopy(ps.alloc, binds);
+			u32 templCount = templ->PSBinds.Count;
+			sub_draw->PSBinds.Count = templCount + 1;
+			sub_draw->PSBinds.Data = (Bind*)alloc::Allocate(ps.alloc, 
+				sub_draw->PSBinds.Count * sizeof(Bind));
+			if (templCount > 0)
+				memcpy(sub_draw->PSBinds.Data, templ->PSBinds.Data, templCount * sizeof(Bind));
+			sub_draw->PSBinds.Data[templCount] = bind;
 		}
 	}
 
@@ -3459,7 +3263,8 @@ Pass ConsumePassRefOrDef(
 	TokenIter& t,
 	ParseState& ps)
 {
-	const char* id = ConsumeIdentifier(t);
+	u32 symId;
+	const char* id = ConsumeIdentifier(t, symId);
 	Keyword key = LookupKeyword(id);
 	Pass pass;
 	pass.Name = nullptr; // Default to no name for the anonymous passes
@@ -3500,13 +3305,14 @@ Pass ConsumePassRefOrDef(
 	}
 	else
 	{
-		ParserAssert(ps.passMap.count(id) != 0, "couldn't find pass %s", id);
-		pass = ps.passMap[id];
+		const Symbol& sym = ps.symbols[symId];
+		ParserAssert(t, sym.Kind == SymbolKind::Pass, "couldn't find pass %s", id);
+		pass = *(Pass*)sym.M;
 	}
 	return pass;
 }
 
-void CheckPassName(const char* name)
+void CheckPassName(const TokenIter& t, const char* name)
 {
 	Keyword key = LookupKeyword(name);
 	switch (key) {
@@ -3517,20 +3323,19 @@ void CheckPassName(const char* name)
 		case Keyword::ClearStencil:
 		case Keyword::Resolve:
 		case Keyword::ObjDraw:
-			ParserError("Pass types may not be used as identifiers: %s", name);
+			ParserError(t, "Pass types may not be used as identifiers: %s", name);
 			break;
 		default:
 			break;
 	} 
 }
 
-void ParseMain()
+void ParseMain(ParseState& ps)
 {
-	ParseState& ps = *GPS;
 	RenderDescription* rd = ps.rd;
 	TokenIter& t = ps.t;
 
-	std::vector<Texture*> outputs;
+	alloc::List<Texture*> outputs = {};
 
 	while (t.next != t.end)
 	{
@@ -3541,242 +3346,210 @@ void ParseMain()
 		case Keyword::ComputeShader:
 		{
 			ComputeShader* cs = ConsumeComputeShaderDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.csMap.count(nameId) == 0, "Shader %s already defined", nameId);
-			ps.csMap[nameId] = cs;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::ComputeShader, cs);
 			break;
 		}
 		case Keyword::VertexShader:
 		{
 			VertexShader* vs = ConsumeVertexShaderDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.vsMap.count(nameId) == 0, "Shader %s already defined", nameId);
-			ps.vsMap[nameId] = vs;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::VertexShader, vs);
 			break;
 		}
 		case Keyword::PixelShader:
 		{
 			PixelShader* pis = ConsumePixelShaderDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.psMap.count(nameId) == 0, "Shader %s already defined", nameId);
-			ps.psMap[nameId] = pis;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::PixelShader, pis);
 			break;
 		}
 		case Keyword::Buffer:
 		{
 			Buffer* buf = ConsumeBufferDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined", 
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::Buffer;
-			res.m = buf;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::Buffer, buf);
 			break;
 		}
 		case Keyword::Texture:
 		{
 			Texture* tex = ConsumeTextureDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::Texture;
-			res.m = tex;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::Texture, tex);
 			break;
 		}
 		case Keyword::Sampler:
 		{
 			Sampler* s = ConsumeSamplerDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::Sampler;
-			res.m = s;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::Sampler, s);
 			break;
 		}
 		case Keyword::SRV:
 		{
 			View* v = ConsumeViewDef(t,ps, ViewType::SRV);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::View;
-			res.m = v;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::View, v);
 			break;
 		}
 		case Keyword::UAV:
 		{
 			View* v = ConsumeViewDef(t,ps, ViewType::UAV);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::View;
-			res.m = v;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::View, v);
 			break;
 		}
 		case Keyword::RTV:
 		{
 			View* v = ConsumeViewDef(t,ps, ViewType::RTV);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::View;
-			res.m = v;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::View, v);
 			break;
 		}
 		case Keyword::DSV:
 		{
 			View* v = ConsumeViewDef(t,ps, ViewType::DSV);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(nameId) == 0, "Resource %s already defined",
-				nameId);
-			ParseState::Resource& res = ps.resMap[nameId];
-			res.type = ParseState::ResType::View;
-			res.m = v;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::View, v);
 			break;
 		}
 		case Keyword::RasterizerState:
 		{
 			RasterizerState* rs = ConsumeRasterizerStateDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.rsMap.count(nameId) == 0, "RasterizerState %s already defined",
-				nameId);
-			ps.rsMap[nameId] = rs;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::RasterizerState, rs);
 			break;
 		}
 		case Keyword::DepthStencilState:
 		{
 			DepthStencilState* rs = ConsumeDepthStencilStateDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.dssMap.count(nameId) == 0, "DepthStencilState %s already defined",
-				nameId);
-			ps.dssMap[nameId] = rs;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::DepthStencilState, rs);
 			break;
 		}
 		case Keyword::Viewport:
 		{
 			Viewport* vp = ConsumeViewportDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.vpMap.count(nameId) == 0, "Viewport %s already defined",
-				nameId);
-			ps.vpMap[nameId] = vp;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::Viewport, vp);
 			break;
 		}
 		case Keyword::BlendState:
 		{
 			BlendState* bs = ConsumeBlendStateDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.bsMap.count(nameId) == 0, "BlendState %s already defined",
-				nameId);
-			ps.bsMap[nameId] = bs;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::BlendState, bs);
 			break;
 		}
 		case Keyword::ObjImport:
 		{
 			ObjImport* obj = ConsumeObjImportDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			ParserAssert(ps.objMap.count(nameId) == 0, "Obj import %s already defined",
-				nameId);
-			ps.objMap[nameId] = obj;
+			u32 symId;
+			ConsumeIdentifier(t, symId);
+			DefineSymbol(t, ps, symId, SymbolKind::ObjImport, obj);
 			break;
 		}
 		case Keyword::Dispatch:
 		{
 			Dispatch* dc = ConsumeDispatchDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined", 
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::Dispatch;
-			pass.Dispatch = dc;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::Dispatch;
+			pass->Dispatch = dc;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::Draw:
 		{
 			Draw* draw = ConsumeDrawDef(t, ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined", 
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::Draw;
-			pass.Draw = draw;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::Draw;
+			pass->Draw = draw;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::ClearColor:
 		{
 			ClearColor* clear = ConsumeClearColorDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined", 
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::ClearColor;
-			pass.ClearColor = clear;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::ClearColor;
+			pass->ClearColor = clear;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::ClearDepth:
 		{
 			ClearDepth* clear = ConsumeClearDepthDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined", 
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::ClearDepth;
-			pass.ClearDepth = clear;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::ClearDepth;
+			pass->ClearDepth = clear;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::ClearStencil:
 		{
 			ClearStencil* clear = ConsumeClearStencilDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined", 
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::ClearStencil;
-			pass.ClearStencil = clear;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::ClearStencil;
+			pass->ClearStencil = clear;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::ObjDraw:
 		{
 			ObjDraw* objDraw = ConsumeObjDrawDef(t,ps);
-			const char* nameId = ConsumeIdentifier(t);
-			CheckPassName(nameId);
-			ParserAssert(ps.passMap.count(nameId) == 0, "Pass %s already defined",
-				nameId);
-			Pass pass;
-			pass.Name = AddStringToDescriptionData(nameId, ps);
-			pass.Type = PassType::ObjDraw;
-			pass.ObjDraw = objDraw;
-			ps.passMap[nameId] = pass;
+			u32 symId;
+			const char* nameId = ConsumeIdentifier(t, symId);
+			CheckPassName(t, nameId);
+			Pass* pass = alloc::Allocate<Pass>(&ps.scratch);
+			pass->Name = AddStringToDescriptionData(nameId, ps);
+			pass->Type = PassType::ObjDraw;
+			pass->ObjDraw = objDraw;
+			DefineSymbol(t, ps, symId, SymbolKind::Pass, pass);
 			break;
 		}
 		case Keyword::Passes:
 		{
 			ConsumeToken(TokenType::LBrace, t);
 
-			std::vector<Pass> passes;
+			alloc::List<Pass> passes = {};
 			while (true)
 			{
 				Pass pass = ConsumePassRefOrDef(t, ps);
-				passes.push_back(pass);
+				alloc::PushBack(&ps.scratch, &passes, pass);
 
 				if (TryConsumeToken(TokenType::RBrace, t))
 					break;
@@ -3798,24 +3571,25 @@ void ParseMain()
 		}
 		case Keyword::Output:
 		{
-			const char* tex_name = ConsumeIdentifier(t);
-			ParserAssert(ps.resMap.count(tex_name) != 0, "Couldn't find resource %s", 
+			u32 symId;
+			const char* tex_name = ConsumeIdentifier(t, symId);
+			const Symbol& sym = ps.symbols[symId];
+			ParserAssert(t, sym.Kind != SymbolKind::None, "Couldn't find resource %s", 
 				tex_name);
-			ParseState::Resource& res = ps.resMap[tex_name];
-			ParserAssert(res.type == ParseState::ResType::Texture, 
+			ParserAssert(t, sym.Kind == SymbolKind::Texture, 
 				"Referenced resource (%s) for output must be Texture.", tex_name);
-			outputs.push_back((Texture*)res.m);
+			alloc::PushBack(&ps.scratch, &outputs, (Texture*)sym.M);
 			break;
 		}
 		default:
-			ParserError("Unexpected structure: %s", id);
+			ParserError(t, "Unexpected structure: %s", id);
 		}
 	}
 
-	ParserAssert(outputs.size() > 0, "RLF must have at least one output.");
+	ParserAssert(t, outputs.Count > 0, "RLF must have at least one output.");
 	for (Texture* tex : outputs)
 	{
-		ParserAssert(tex->Flags & TextureFlag_SRV, "Outputs must be SRV-flagged");
+		ParserAssert(t, tex->Flags & TextureFlag_SRV, "Outputs must be SRV-flagged");
 	}
 
 	rd->Dispatches = alloc::MakeCopy(ps.alloc, ps.Dispatches);
@@ -3834,43 +3608,103 @@ void ParseMain()
 	rd->Constants = alloc::MakeCopy(ps.alloc, ps.Constants);
 	rd->Tuneables = alloc::MakeCopy(ps.alloc, ps.Tuneables);
 	rd->Outputs = alloc::MakeCopy(ps.alloc, outputs);
+	rd->Dependencies = alloc::MakeCopy(ps.alloc, ps.Dependencies);
+
+	ShareExpressions(rd, ps.alloc, &ps.scratch);
+	LinkExpressions(rd, ps.alloc);
+	BatchSetConstants(rd, ps.alloc);
 }
 
 
+struct ParseCache
+{
+	TokenizerState ts;
+	// A copy of the last buffer parsed, the tokens point into it between
+	//	parses so the next buffer can be diffed against it.
+	char* source;
+	u32 sourceSize;
+	bool valid;
+};
+
+ParseCache* CreateParseCache()
+{
+	ParseCache* cache = new ParseCache();
+	cache->source = nullptr;
+	cache->sourceSize = 0;
+	cache->valid = false;
+	return cache;
+}
+
+void DestroyParseCache(ParseCache* cache)
+{
+	Assert(cache, "Invalid pointer.");
+	if (cache->valid)
+		TokenizerStateRelease(cache->ts);
+	free(cache->source);
+	delete cache;
+}
+
+void MoveTokens(std::vector<Token>& tokens, const char* from, const char* to)
+{
+	for (Token& token : tokens)
+		token.Location = to + (token.Location - from);
+}
+
 RenderDescription* ParseBuffer(
 	const char* buffer,
 	u32 bufferSize,
 	const char* workingDir,
+	ParseCache* cache,
 	ErrorState* es)
 {
 	es->Success = true;
 
-	TokenizerState ts;
-	TokenizerStateInit(ts);
+	TokenizerState localTs;
+	TokenizerState& ts = cache ? cache->ts : localTs;
 	try {
-		Tokenize(buffer, buffer+bufferSize, ts);
+		if (cache && cache->valid)
+		{
+			Retokenize(cache->source, cache->source + cache->sourceSize, 
+				buffer, buffer+bufferSize, ts);
+			CompactStrings(ts);
+		}
+		else
+		{
+			TokenizerStateInit(ts);
+			Tokenize(buffer, buffer+bufferSize, ts);
+		}
 	}
 	catch (ErrorInfo pe)
 	{
 		es->Success = false;
 		es->Info = pe;
+		TokenizerStateRelease(ts);
+		if (cache)
+			cache->valid = false;
 		return nullptr;
 	}
 
+	// Copies made for the previous description went away with it.
+	for (u32 i = 0 ; i < ts.strings.EntryCount ; ++i)
+		ts.strings.Entries[i].Persistent = nullptr;
+
 	ParseState ps;
 	ps.rd = new RenderDescription();
 	alloc::Init(&ps.rd->Alloc);
 	ps.workingDirectory = workingDir;
 	ps.alloc = &ps.rd->Alloc;
-	ParseStateInit(&ps);
-
-	GPS = &ps;
+	ps.strings = &ts.strings;
+	alloc::Init(&ps.scratch);
+	ps.symbols.Count = ts.strings.EntryCount;
+	ps.symbols.Data = (Symbol*)alloc::Allocate(&ps.scratch, 
+		ps.symbols.Count * sizeof(Symbol));
+	ZeroMemory(ps.symbols.Data, ps.symbols.Count * sizeof(Symbol));
 
 	if (es->Success)
 	{
-		ps.t = { &ts.tokens[0], &ts.tokens[0] + ts.tokens.size() };
+		ps.t = { ts.tokens.data(), ts.tokens.data() + ts.tokens.size() };
 		try {
-			ParseMain();
+			ParseMain(ps);
 		}
 		catch (ErrorInfo pe)
 		{
@@ -3879,7 +3713,28 @@ RenderDescription* ParseBuffer(
 		}
 	}
 
-	GPS = nullptr;
+	ps.rd->ScratchStats = alloc::GetStats(&ps.scratch);
+	alloc::FreeAll(&ps.scratch);
+
+	if (cache)
+	{
+		// The caller's buffer doesn't outlive the description, keep a copy for
+		//	the next parse to diff against.
+		if (cache->sourceSize != bufferSize)
+		{
+			free(cache->source);
+			cache->source = (char*)malloc(bufferSize);
+			Assert(cache->source != nullptr || bufferSize == 0, "failed to alloc");
+			cache->sourceSize = bufferSize;
+		}
+		memcpy(cache->source, buffer, bufferSize);
+		MoveTokens(ts.tokens, buffer, cache->source);
+		cache->valid = true;
+	}
+	else
+	{
+		TokenizerStateRelease(ts);
+	}
 
 	if (es->Success == false)
 	{
@@ -3898,7 +3753,11 @@ void ReleaseData(RenderDescription* data)
 	Assert(data, "Invalid pointer.");
 	alloc::FreeAll(&data->Alloc);
 	
-	delete data;
+	// A compiled description is part of its own mapping.
+	if (data->MappedFile)
+		fileio::UnmapFile(data->MappedFile);
+	else
+		delete data;
 }
 
 #undef ParserAssert
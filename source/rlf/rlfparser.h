@@ -1,10 +1,19 @@
 
 namespace rlf
 {
+	// Holds on to the token stream between parses, so that re-parsing an edited
+	//	buffer only has to lex the part of it which changed.
+	struct ParseCache;
+
+	ParseCache* CreateParseCache();
+	void DestroyParseCache(ParseCache* cache);
+
+	// cache is optional, pass nullptr to parse from scratch.
 	RenderDescription* ParseBuffer(
 		const char* buffer,
 		u32 bufferSize,
 		const char* workingDir,
+		ParseCache* cache,
 		ErrorState* es);
 
 	void ReleaseData(RenderDescription* data);
@@ -0,0 +1,105 @@
+namespace rlf
+{
+
+u32 AddSourceFile(SourceMap& sm, const char* name, const char* start, u32 size)
+{
+	Assert(sm.Files.size() < U32_MAX, "too many files");
+	u32 id = (u32)sm.Files.size();
+	sm.Files.emplace_back();
+	SourceFile& file = sm.Files.back();
+	file.Name = name;
+	file.Start = start;
+	file.Size = size;
+
+	file.LineStarts.push_back(0);
+	const char* end = start + size;
+	for (const char* c = start ; c < end ; ++c)
+	{
+		c = (const char*)memchr(c, '\n', (size_t)(end - c));
+		if (!c)
+			break;
+		file.LineStarts.push_back((u32)(c + 1 - start));
+	}
+
+	auto pos = std::upper_bound(sm.ByAddress.begin(), sm.ByAddress.end(), start,
+		[&sm](const char* s, u32 f) {
+			return (uintptr_t)s < (uintptr_t)sm.Files[f].Start;
+		});
+	sm.ByAddress.insert(pos, id);
+	return id;
+}
+
+void ClearSourceMap(SourceMap& sm)
+{
+	sm.Files.clear();
+	sm.ByAddress.clear();
+}
+
+bool FindSourceLocation(const SourceMap& sm, const char* location,
+	SourceLocation* outLoc)
+{
+	if (!location)
+		return false;
+
+	// Last file starting at or before location.
+	auto pos = std::upper_bound(sm.ByAddress.begin(), sm.ByAddress.end(), location,
+		[&sm](const char* s, u32 f) {
+			return (uintptr_t)s < (uintptr_t)sm.Files[f].Start;
+		});
+	if (pos == sm.ByAddress.begin())
+		return false;
+	u32 id = *(pos - 1);
+	const SourceFile& file = sm.Files[id];
+	// A location can be one past the last character, for errors at the end.
+	uintptr_t offset = (uintptr_t)location - (uintptr_t)file.Start;
+	if (offset > file.Size)
+		return false;
+
+	auto line = std::upper_bound(file.LineStarts.begin(), file.LineStarts.end(),
+		(u32)offset);
+	u32 lineIndex = (u32)(line - file.LineStarts.begin()) - 1;
+	u32 lineOffset = file.LineStarts[lineIndex];
+	u32 lineEnd = lineIndex + 1 < file.LineStarts.size() ?
+		file.LineStarts[lineIndex + 1] - 1 : file.Size;
+
+	u32 column = (u32)offset - lineOffset;
+	const char* lineEndPtr = file.Start + offset;
+	for (const char* c = file.Start + lineOffset ; c < lineEndPtr ; ++c)
+	{
+		c = (const char*)memchr(c, '\t', (size_t)(lineEndPtr - c));
+		if (!c)
+			break;
+		column += 3;
+	}
+
+	outLoc->File = id;
+	outLoc->Line = lineIndex + 1;
+	outLoc->Column = column;
+	outLoc->LineStart = file.Start + lineOffset;
+	outLoc->LineLength = lineEnd - lineOffset;
+	return true;
+}
+
+std::string FormatSourceLocation(const SourceMap& sm, const char* location)
+{
+	SourceLocation loc;
+	if (!FindSourceLocation(sm, location, &loc))
+		return "";
+
+	// Very long lines are cut off rather than overflowing the buffer.
+	char buf[512];
+	sprintf_s(buf, 512, "%.256s(%u,%u):\n%.*s \n", sm.Files[loc.File].Name.c_str(),
+		loc.Line, loc.Column, min(loc.LineLength, 200u), loc.LineStart);
+	std::string str = buf;
+	if (loc.Column + 2 < 512)
+	{
+		for (u32 i = 0 ; i < loc.Column ; ++i)
+			buf[i] = ' ';
+		buf[loc.Column] = '^';
+		buf[loc.Column+1] = '\0';
+		str += buf;
+	}
+	return str;
+}
+
+}
@@ -0,0 +1,46 @@
+
+namespace rlf
+{
+	// Resolves pointers into loaded source buffers (the rlf, shaders, ...) to
+	//	file, line and column. Each file gets a table of line starts when it's
+	//	added, after which a lookup is a binary search over the files and one
+	//	over the lines of the file.
+	struct SourceFile
+	{
+		std::string Name;
+		const char* Start;
+		u32 Size;
+		// Offset of the first character of every line, starting with 0.
+		std::vector<u32> LineStarts;
+	};
+
+	struct SourceMap
+	{
+		// Indexed by file id.
+		std::vector<SourceFile> Files;
+		// File ids ordered by Start.
+		std::vector<u32> ByAddress;
+	};
+
+	struct SourceLocation
+	{
+		u32 File;
+		u32 Line; // 1-based
+		u32 Column; // 0-based, tabs count as 4
+		const char* LineStart;
+		u32 LineLength;
+	};
+
+	// The buffer must stay alive and unchanged until the map is cleared.
+	//	Returns the file id.
+	u32 AddSourceFile(SourceMap& sm, const char* name, const char* start, u32 size);
+	void ClearSourceMap(SourceMap& sm);
+
+	// Returns false if location isn't within any of the files.
+	bool FindSourceLocation(const SourceMap& sm, const char* location,
+		SourceLocation* outLoc);
+
+	// "file(line,col):" followed by the line and a caret under the column, or
+	//	an empty string if location isn't within any of the files.
+	std::string FormatSourceLocation(const SourceMap& sm, const char* location);
+}
@@ -114,17 +114,10 @@ enum class TextureFormat
 #undef RLF_TEXTUREFORMAT_ENTRY
 
 #define RLF_TEXTUREFORMAT_ENTRY(name) #name,
-static const char* TextureFormatName[] = {
+static constexpr const char* TextureFormatName[] = {
 	"<Invalid>",
 	RLF_TEXTUREFORMAT_TUPLE
 };
 #undef RLF_TEXTUREFORMAT_ENTRY
 
-#define RLF_TEXTUREFORMAT_ENTRY(name) DXGI_FORMAT_##name,
-static DXGI_FORMAT D3DTextureFormat[] = {
-	DXGI_FORMAT_UNKNOWN,
-	RLF_TEXTUREFORMAT_TUPLE
-};
-#undef RLF_TEXTUREFORMAT_ENTRY
-
 } // namespace rlf
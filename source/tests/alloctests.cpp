@@ -0,0 +1,380 @@
+namespace test
+{
+
+bool IsAligned(const void* p, u32 alignment)
+{
+	return ((size_t)p & (alignment - 1)) == 0;
+}
+
+// Allocations are aligned and keep their contents, the most recent one grows
+//	in place, blocks only double in number as usage does, and rolling back or
+//	resetting gives the memory back.
+void TestLinAlloc(State* t)
+{
+	using namespace rlf;
+	alloc::LinAlloc a = {};
+	alloc::Init(&a);
+	Random r = { 31 };
+	std::vector<std::pair<u8*, u32>> allocations;
+	for (u32 i = 0 ; i < 10000 ; ++i)
+	{
+		u32 size = 1 + NextU32(r) % 100;
+		u32 alignment = 1u << (NextU32(r) % 7);
+		u8* p = (u8*)alloc::Allocate(&a, size, alignment);
+		Check(t, IsAligned(p, alignment), "%u bytes aligned to %u", size, alignment);
+		memset(p, (u8)i, size);
+		allocations.push_back(std::make_pair(p, size));
+	}
+	for (u32 i = 0 ; i < (u32)allocations.size() ; ++i)
+	{
+		u8* p = allocations[i].first;
+		bool same = true;
+		for (u32 j = 0 ; j < allocations[i].second ; ++j)
+			same = same && p[j] == (u8)i;
+		Check(t, same, "allocation %u was overwritten", i);
+	}
+
+	alloc::Allocate(&a, 1u, 1);
+	float4x4* m = alloc::Allocate<float4x4>(&a);
+	Check(t, IsAligned(m, 16), "float4x4 after an odd size");
+
+	u8* last = (u8*)alloc::Allocate(&a, 16u);
+	memset(last, 7, 16);
+	Check(t, alloc::Resize(&a, last, 16, 4096) == last, "most recent allocation grows in place");
+	Check(t, alloc::Resize(&a, last, 4096, 8) == last, "most recent allocation shrinks in place");
+	alloc::Allocate(&a, 1u);
+	u8* moved = (u8*)alloc::Resize(&a, last, 8, 64);
+	Check(t, moved != last && moved[0] == 7 && moved[7] == 7, "older allocation moves");
+
+	alloc::Marker mark = alloc::Mark(&a);
+	alloc::Stats before = alloc::GetStats(&a);
+	alloc::Allocate(&a, 1000u);
+	alloc::Allocate(&a, 100u * 1024 * 1024);
+	Check(t, alloc::GetStats(&a).BlockCount == before.BlockCount + 1,
+		"a large allocation starts a block");
+	alloc::Rollback(&a, mark);
+	alloc::Stats after = alloc::GetStats(&a);
+	Check(t, after.UsedSize == before.UsedSize && after.BlockCount == before.BlockCount,
+		"rollback: %llu of %llu bytes used", after.UsedSize, before.UsedSize);
+	alloc::FreeAll(&a);
+
+	alloc::Init(&a);
+	alloc::Marker empty = alloc::Mark(&a);
+	u8* first = (u8*)alloc::Allocate(&a, 100u);
+	alloc::Rollback(&a, empty);
+	Check(t, alloc::GetStats(&a).BlockCount == 1 && alloc::Allocate(&a, 100u) == first,
+		"rolling back to empty keeps the block");
+	alloc::FreeAll(&a);
+
+	// Reservations double, so 1 GB of 1 MB allocations takes a handful of
+	//	blocks. Pages are committed but never touched.
+	alloc::Init(&a);
+	for (u32 i = 0 ; i < 1024 ; ++i)
+		alloc::Allocate(&a, 1024u * 1024, 4096);
+	alloc::Stats s = alloc::GetStats(&a);
+	Check(t, s.BlockCount <= 5, "%u blocks for 1 GB", s.BlockCount);
+	Check(t, s.UsedSize >= 1024ull * 1024 * 1024 && s.WastedSize < s.UsedSize / 4,
+		"%llu used, %llu wasted", s.UsedSize, s.WastedSize);
+	alloc::Reset(&a);
+	s = alloc::GetStats(&a);
+	Check(t, s.BlockCount == 1 && s.UsedSize < 4096, "reset to %u blocks, %llu bytes",
+		s.BlockCount, s.UsedSize);
+	alloc::FreeAll(&a);
+}
+
+// A size and alignment like those of the parser's allocations: mostly small
+//	nodes, with a few larger arrays.
+void RandomAllocation(Random& r, u32& size, u32& alignment)
+{
+	u32 pick = NextU32(r) % 16;
+	size = pick < 12 ? 8 + NextU32(r) % 56 : 64 + NextU32(r) % 960;
+	alignment = pick % 4 == 0 ? 16 : 8;
+}
+
+// Floats collected in a scratch list and copied to the description, as
+//	StoreInitData does.
+float* StoreFloats(rlf::alloc::LinAlloc* desc, rlf::alloc::LinAlloc* scratch, u32 count)
+{
+	using namespace rlf;
+	alloc::Marker staging = alloc::Mark(scratch);
+	alloc::List<float> data = {};
+	for (u32 i = 0 ; i < count ; ++i)
+		alloc::PushBack(scratch, &data, (float)i);
+	Array<float> copy = alloc::MakeCopy(desc, data);
+	alloc::Rollback(scratch, staging);
+	return copy.Data;
+}
+
+// The same with a vector, copied to the heap.
+float* StoreFloatsOnHeap(u32 count)
+{
+	std::vector<float> data;
+	for (u32 i = 0 ; i < count ; ++i)
+		data.push_back((float)i);
+	float* copy = (float*)malloc(count * sizeof(float));
+	memcpy(copy, data.data(), count * sizeof(float));
+	return copy;
+}
+
+// Many small allocations against malloc, then InitData of growing sizes
+//	collected in a scratch list and copied out as StoreInitData does, against
+//	a vector copied to the heap.
+void BenchLinAlloc(const BenchArgs& args)
+{
+	using namespace rlf;
+	u32 count = args.Count > 0 ? (u32)atoi(args.Values[0]) : 1000000;
+	std::vector<u32> sizes(count);
+	std::vector<u32> alignments(count);
+	Random r = { 32 };
+	for (u32 i = 0 ; i < count ; ++i)
+		RandomAllocation(r, sizes[i], alignments[i]);
+	std::vector<void*> pointers(count);
+
+	alloc::Stats stats = {};
+	double linMs = MinTimeMs(5, [&]() {
+		alloc::LinAlloc a = {};
+		alloc::Init(&a);
+		for (u32 i = 0 ; i < count ; ++i)
+			pointers[i] = alloc::Allocate(&a, sizes[i], alignments[i]);
+		stats = alloc::GetStats(&a);
+		alloc::FreeAll(&a);
+	});
+	double heapMs = MinTimeMs(5, [&]() {
+		for (u32 i = 0 ; i < count ; ++i)
+			pointers[i] = malloc(sizes[i]);
+		for (u32 i = 0 ; i < count ; ++i)
+			free(pointers[i]);
+	});
+	printf("%u small allocations, %.1f MB in %u blocks, %.1f MB committed\n", count,
+		(double)stats.UsedSize / (1024.0 * 1024.0), stats.BlockCount,
+		(double)stats.CommittedSize / (1024.0 * 1024.0));
+	printf("LinAlloc      %8.2f ms %6.2f ns/allocation\n", linMs, linMs * 1e6 / count);
+	printf("malloc, free  %8.2f ms %6.2f ns/allocation\n\n", heapMs, heapMs * 1e6 / count);
+
+	printf("%-12s %12s %12s %7s %7s\n", "InitData", "LinAlloc ms", "heap ms", "blocks",
+		"wasted");
+	// The allocators are reset rather than made again for each run, like the
+	//	heap their pages stay committed, so neither pays for faulting them in.
+	const u32 buffers = 20;
+	volatile float sink = 0.0f;
+	alloc::LinAlloc desc = {};
+	alloc::LinAlloc scratch = {};
+	alloc::Init(&desc);
+	alloc::Init(&scratch);
+	for (u32 floats = 1024 ; floats <= 4 * 1024 * 1024 ; floats *= 4)
+	{
+		double linCopyMs = MinTimeMs(5, [&]() {
+			alloc::Reset(&desc);
+			alloc::Reset(&scratch);
+			for (u32 b = 0 ; b < buffers ; ++b)
+				sink = sink + StoreFloats(&desc, &scratch, floats)[b];
+			stats = alloc::GetStats(&desc);
+		});
+		double heapCopyMs = MinTimeMs(5, [&]() {
+			std::vector<float*> copies;
+			for (u32 b = 0 ; b < buffers ; ++b)
+			{
+				copies.push_back(StoreFloatsOnHeap(floats));
+				sink = sink + copies.back()[b];
+			}
+			for (float* copy : copies)
+				free(copy);
+		});
+		char row[32];
+		sprintf_s(row, 32, "%u x %uk", buffers, floats / 1024);
+		printf("%-12s %12.2f %12.2f %7u %6.1f%%\n", row, linCopyMs, heapCopyMs,
+			stats.BlockCount, 100.0 * (double)stats.WastedSize / (double)stats.UsedSize);
+	}
+	alloc::FreeAll(&scratch);
+	alloc::FreeAll(&desc);
+}
+
+// Blocks are aligned to the granularity and keep their contents, a freed
+//	block is the next one given out for its class, and freeing and allocating
+//	the same sizes again doesn't grow the slabs.
+void TestPool(State* t)
+{
+	using namespace rlf;
+	alloc::Pool p = {};
+	alloc::Init(&p);
+	Random r = { 33 };
+	std::vector<std::pair<u8*, u32>> blocks;
+	for (u32 i = 0 ; i < 2000 ; ++i)
+	{
+		u32 size = 1 + NextU32(r) % (NextU32(r) % 8 == 0 ? alloc::PoolMaxSize : 512);
+		u8* b = (u8*)alloc::Allocate(&p, size);
+		Check(t, IsAligned(b, alloc::PoolGranularity), "%u bytes aligned", size);
+		memset(b, (u8)i, size);
+		blocks.push_back(std::make_pair(b, size));
+	}
+	for (u32 i = 0 ; i < (u32)blocks.size() ; ++i)
+	{
+		u8* b = blocks[i].first;
+		bool same = true;
+		for (u32 j = 0 ; j < blocks[i].second ; ++j)
+			same = same && b[j] == (u8)i;
+		Check(t, same, "block %u was overwritten", i);
+	}
+
+	alloc::Free(&p, blocks[5].first, blocks[5].second);
+	Check(t, alloc::Allocate(&p, blocks[5].second) == blocks[5].first, "freed block reused");
+	u8* small = (u8*)alloc::Allocate(&p, 1u);
+	alloc::Free(&p, small, 1u);
+	Check(t, alloc::Allocate(&p, alloc::PoolGranularity) == small,
+		"sizes in the same class share blocks");
+
+	alloc::Stats before = alloc::GetStats(&p);
+	for (u32 round = 0 ; round < 10 ; ++round)
+	{
+		for (auto& b : blocks)
+			alloc::Free(&p, b.first, b.second);
+		for (auto& b : blocks)
+			b.first = (u8*)alloc::Allocate(&p, b.second);
+	}
+	alloc::Stats after = alloc::GetStats(&p);
+	Check(t, after.UsedSize == before.UsedSize && after.BlockCount == before.BlockCount,
+		"churn grew the slabs from %llu to %llu bytes", before.UsedSize, after.UsedSize);
+	alloc::FreeAll(&p);
+	Check(t, alloc::GetStats(&p).BlockCount == 0, "FreeAll releases the slabs");
+}
+
+// Address range the backing stores are spread over.
+u64 BackingSpan(const std::vector<rlf::ConstantBuffer*>& cbs)
+{
+	size_t lo = SIZE_MAX, hi = 0;
+	for (rlf::ConstantBuffer* cb : cbs)
+	{
+		lo = min(lo, (size_t)cb->BackingMemory);
+		hi = max(hi, (size_t)cb->BackingMemory + cb->Size);
+	}
+	return hi - lo;
+}
+
+// What recreating every constant buffer does to their backing stores, while
+//	the rest of the program allocates too, as setting resources up again does.
+//	The clutter stays allocated, like the objects it stands for.
+void ChurnPool(rlf::alloc::Pool* p, std::vector<rlf::ConstantBuffer*>& cbs,
+	std::vector<void*>& clutter, Random& r)
+{
+	for (rlf::ConstantBuffer* cb : cbs)
+		rlf::alloc::Free(p, cb->BackingMemory, cb->Size);
+	for (rlf::ConstantBuffer* cb : cbs)
+	{
+		cb->BackingMemory = (u8*)rlf::alloc::Allocate(p, cb->Size);
+		clutter.push_back(malloc(16 + NextU32(r) % 256));
+	}
+}
+
+void ChurnHeap(std::vector<rlf::ConstantBuffer*>& cbs, std::vector<void*>& clutter, Random& r)
+{
+	for (rlf::ConstantBuffer* cb : cbs)
+		free(cb->BackingMemory);
+	for (rlf::ConstantBuffer* cb : cbs)
+	{
+		cb->BackingMemory = (u8*)malloc(cb->Size);
+		clutter.push_back(malloc(16 + NextU32(r) % 256));
+	}
+}
+
+// A frame's constant writes and the copies of every buffer to the GPU's, as
+//	UpdateConstants does.
+void WriteConstants(rlf::ast::EvaluationContext& ec, rlf::RenderDescription* rd,
+	const std::vector<rlf::ConstantBuffer*>& cbs, u8* upload)
+{
+	using namespace rlf;
+	for (Draw* draw : rd->Draws)
+	{
+		EvaluateSetConstants(ec, draw->VSConstants);
+		EvaluateSetConstants(ec, draw->PSConstants);
+	}
+	for (ConstantBuffer* cb : cbs)
+	{
+		memcpy(upload, cb->BackingMemory, cb->Size);
+		upload += cb->Size;
+	}
+}
+
+void FreeClutter(std::vector<void*>& clutter)
+{
+	for (void* c : clutter)
+		free(c);
+	clutter.clear();
+}
+
+// Window resizes or reloads that recreate the constant buffers of a
+//	description of many draws, with their backing stores in the pool against
+//	malloc'd, then frames of constant writes with them where the churn left
+//	them.
+void BenchPool(const BenchArgs& args)
+{
+	using namespace rlf;
+	u32 drawCount = args.Count > 0 ? (u32)atoi(args.Values[0]) : 2000;
+	u32 resizes = args.Count > 1 ? (u32)atoi(args.Values[1]) : 50;
+	RenderDescription* rd = ParseForEvaluation(nullptr, "synthetic draws",
+		SyntheticDraws(drawCount));
+	if (!rd)
+		return;
+	ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	InitNull(rd, ec);
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+	std::vector<ConstantBuffer*> cbs;
+	u32 totalSize = 0;
+	for (Draw* draw : rd->Draws)
+	{
+		for (ConstantBuffer& cb : draw->VSCBs)
+			cbs.push_back(&cb);
+		for (ConstantBuffer& cb : draw->PSCBs)
+			cbs.push_back(&cb);
+	}
+	for (ConstantBuffer* cb : cbs)
+		totalSize += cb->Size;
+	std::vector<u8> upload(totalSize);
+	std::vector<void*> clutter;
+	Random r = { 34 };
+	u32 frame = 0;
+	auto frames = [&]() {
+		for (u32 i = 0 ; i < 100 ; ++i)
+		{
+			NextFrame(ec, rd, frame++, tuneables);
+			WriteConstants(ec, rd, cbs, upload.data());
+		}
+	};
+
+	alloc::Stats first = alloc::GetStats(&rd->ConstantPool);
+	double poolChurnMs = MinTimeMs(5, [&]() {
+		FreeClutter(clutter);
+		for (u32 i = 0 ; i < resizes ; ++i)
+			ChurnPool(&rd->ConstantPool, cbs, clutter, r);
+	});
+	alloc::Stats churned = alloc::GetStats(&rd->ConstantPool);
+	u64 poolSpan = BackingSpan(cbs);
+	double poolFrameMs = MinTimeMs(5, frames) / 100.0;
+
+	for (ConstantBuffer* cb : cbs)
+		cb->BackingMemory = (u8*)malloc(cb->Size);
+	double heapChurnMs = MinTimeMs(5, [&]() {
+		FreeClutter(clutter);
+		for (u32 i = 0 ; i < resizes ; ++i)
+			ChurnHeap(cbs, clutter, r);
+	});
+	u64 heapSpan = BackingSpan(cbs);
+	double heapFrameMs = MinTimeMs(5, frames) / 100.0;
+	for (ConstantBuffer* cb : cbs)
+		free(cb->BackingMemory);
+	FreeClutter(clutter);
+
+	printf("%u constant buffers, %.1f KB, %u resizes\n", (u32)cbs.size(),
+		totalSize / 1024.0, resizes);
+	printf("pool slabs %.1f KB after setup, %.1f KB after churn\n",
+		(double)first.UsedSize / 1024.0, (double)churned.UsedSize / 1024.0);
+	printf("%-8s %14s %12s %12s\n", "", "ms/resize", "spread KB", "ms/frame");
+	printf("%-8s %14.3f %12.1f %12.3f\n", "pool", poolChurnMs / resizes,
+		(double)poolSpan / 1024.0, poolFrameMs);
+	printf("%-8s %14.3f %12.1f %12.3f\n", "malloc", heapChurnMs / resizes,
+		(double)heapSpan / 1024.0, heapFrameMs);
+
+	ReleaseNull(rd);
+}
+
+}
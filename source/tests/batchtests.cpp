@@ -0,0 +1,223 @@
+namespace test
+{
+
+// Runs count programs as a batch and one at a time. If the batch succeeds
+//	each of them has to on its own, with the same result, and if it fails one
+//	of them has to.
+void CheckBatch(State* t, const char* name, const rlf::ast::Program* const* progs,
+	u32 count, const rlf::ast::EvaluationContext& ec, u32 round)
+{
+	using namespace rlf;
+	ast::Result batched[ast::BatchWidth];
+	bool batchOk = ast::ExecuteBatch(progs, count, ec, batched);
+	bool allOk = true;
+	for (u32 i = 0 ; i < count ; ++i)
+	{
+		ast::Result res;
+		ast::EvaluationError err;
+		bool ok = ast::Execute(*progs[i], ec, res, err);
+		allOk = allOk && ok;
+		if (batchOk)
+		{
+			Check(t, ok && SameResult(res, batched[i]),
+				"%s, round %u: lane %u of %u differs", name, round, i, count);
+		}
+	}
+	Check(t, batchOk == allOk, "%s, round %u: batch of %u %s", name, round, count,
+		batchOk ? "succeeded" : "failed");
+}
+
+// Each group of programs in batches of every size, under several contexts
+//	and tuneable values.
+void CompareBatches(State* t, const char* name, rlf::RenderDescription* rd,
+	const std::vector<std::vector<const rlf::ast::Program*>>& groups)
+{
+	using namespace rlf;
+	Random r = { 4321 };
+	for (u32 round = 0 ; round < 8 ; ++round)
+	{
+		ast::EvaluationContext ec = TestContext(round);
+		if (round > 0)
+			RandomizeTuneables(rd, r);
+		WalkConstants(rd, ec);
+		for (const std::vector<const ast::Program*>& group : groups)
+		{
+			u32 size = (u32)group.size();
+			for (u32 start = 0, count = 1 ; start < size ; start += count)
+			{
+				count = min(1 + (start + round) % ast::BatchWidth, size - start);
+				CheckBatch(t, name, group.data() + start, count, ec, round);
+			}
+		}
+	}
+}
+
+// The batches the parser made of the SetConstants.
+void CompareSetConstantBatches(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	std::vector<std::vector<const ast::Program*>> groups;
+	for (SetConstantBatch& batch : rd->SetConstantBatches)
+	{
+		groups.push_back(std::vector<const ast::Program*>());
+		for (const SetConstant* set : batch.Sets)
+			groups.back().push_back(set->Value.Code);
+	}
+	CompareBatches(t, name, rd, groups);
+	ReleaseData(rd);
+}
+
+// Random expressions grouped by their code, the way BatchSetConstants groups
+//	SetConstants, for the instructions the samples don't use.
+void CompareExpressionBatches(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	std::vector<ast::Expression*> exprs;
+	CollectExpressions(rd, exprs);
+	std::unordered_map<std::string, u32> indices;
+	std::vector<std::vector<const ast::Program*>> groups;
+	for (ast::Expression* expr : exprs)
+	{
+		const ast::Program* prog = expr->Code;
+		if (!prog)
+			continue;
+		std::string key((const char*)prog->Code.Data,
+			prog->Code.Count * sizeof(ast::Instruction));
+		key.append((const char*)&prog->ResultType, sizeof(prog->ResultType));
+		auto it = indices.insert(std::make_pair(key, (u32)groups.size()));
+		if (it.second)
+			groups.push_back(std::vector<const ast::Program*>());
+		groups[it.first->second].push_back(prog);
+	}
+	CompareBatches(t, name, rd, groups);
+	ReleaseData(rd);
+}
+
+void TestBatch(State* t)
+{
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		CompareSetConstantBatches(t, SamplePaths[i], buffer);
+	}
+	CompareSetConstantBatches(t, "synthetic draws", SyntheticDraws(50));
+	for (u64 seed = 1 ; seed <= 4 ; ++seed)
+		CompareExpressionBatches(t, "synthetic expressions", SyntheticExpressions(2000, seed));
+}
+
+// The SetConstants of each draw and dispatch, one list for each stage.
+void CollectSetConstantLists(rlf::RenderDescription* rd,
+	std::vector<rlf::Array<rlf::SetConstant>*>& out)
+{
+	for (rlf::Draw* draw : rd->Draws)
+	{
+		out.push_back(&draw->VSConstants);
+		out.push_back(&draw->PSConstants);
+	}
+	for (rlf::Dispatch* dc : rd->Dispatches)
+		out.push_back(&dc->Constants);
+}
+
+// Stands in for the constant buffers InitD3D would make, one for each list
+//	of SetConstants, packed into memory.
+void BindFakeConstantBuffers(rlf::RenderDescription* rd,
+	std::vector<rlf::ConstantBuffer>& cbs, std::vector<u8>& memory)
+{
+	using namespace rlf;
+	std::vector<Array<SetConstant>*> lists;
+	CollectSetConstantLists(rd, lists);
+	u32 total = 0;
+	for (Array<SetConstant>* sets : lists)
+	{
+		for (SetConstant& set : *sets)
+		{
+			set.Type = set.Value.TopNode->ResultType;
+			set.Size = set.Type.Dim * 4;
+			set.Offset = total;
+			total += set.Size;
+		}
+	}
+	memory.assign(max(total, 1u), 0);
+	cbs.assign(lists.size(), ConstantBuffer());
+	for (size_t i = 0 ; i < lists.size() ; ++i)
+	{
+		ConstantBuffer& cb = cbs[i];
+		cb.BackingMemory = memory.data();
+		cb.Size = total;
+		for (SetConstant& set : *lists[i])
+			set.CB = &cb;
+	}
+}
+
+// Frames of a scene of many draws whose constants all change with time, with
+//	their SetConstants evaluated one at a time as the draws are executed, and
+//	in batches up front.
+void BenchBatch(const BenchArgs& args)
+{
+	using namespace rlf;
+	u32 drawCount = args.Count > 0 ? (u32)atoi(args.Values[0]) : 10000;
+	std::string buffer = SyntheticDraws(drawCount);
+	RenderDescription* rd = ParseForEvaluation(nullptr, "synthetic draws", buffer);
+	if (!rd)
+	{
+		printf("synthetic draws: failed to parse\n");
+		return;
+	}
+	std::vector<ConstantBuffer> cbs;
+	std::vector<u8> memory;
+	BindFakeConstantBuffers(rd, cbs, memory);
+
+	u32 setCount = 0;
+	u32 batchedCount = 0;
+	for (Draw* draw : rd->Draws)
+		setCount += draw->VSConstants.Count + draw->PSConstants.Count;
+	for (const SetConstantBatch& batch : rd->SetConstantBatches)
+		batchedCount += batch.Sets.Count;
+
+	ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	ec.ChangedThisFrameFlags = ast::VariesBy_Time;
+	const u32 frames = 20;
+	auto frame = [&](bool batch) {
+		ec.Time += 1.0f / 60.0f;
+		MarkChanged(rd, ec);
+		EvaluateConstants(ec, rd->Constants);
+		if (batch)
+			EvaluateSetConstantBatches(ec, rd);
+		for (Draw* draw : rd->Draws)
+		{
+			EvaluateSetConstants(ec, draw->VSConstants);
+			EvaluateSetConstants(ec, draw->PSConstants);
+		}
+	};
+	ast::EvaluationCounters counters = {};
+	ec.Counters = &counters;
+	frame(true);
+	ec.Counters = nullptr;
+	double scalarMs = MinTimeMs(5, [&]() {
+		for (u32 i = 0 ; i < frames ; ++i)
+			frame(false);
+	}) / frames;
+	double batchMs = MinTimeMs(5, [&]() {
+		for (u32 i = 0 ; i < frames ; ++i)
+			frame(true);
+	}) / frames;
+
+	printf("%u draws, %u SetConstants, %u of them in %u batches\n", drawCount, setCount,
+		batchedCount, rd->SetConstantBatches.Count);
+	printf("%u expressions evaluated per frame\n", counters.Expressions);
+	printf("one at a time %8.3f ms/frame %6.1f ns/set\n", scalarMs,
+		scalarMs * 1e6 / setCount);
+	printf("batched       %8.3f ms/frame %6.1f ns/set %7.2fx\n", batchMs,
+		batchMs * 1e6 / setCount, scalarMs / batchMs);
+	ReleaseData(rd);
+}
+
+}
@@ -0,0 +1,250 @@
+namespace test
+{
+
+// Only the null backend's log is in it.
+static gfx::Context NullCtx;
+
+// InitD3D through the null backend, at the display size of ec.
+void InitNull(rlf::RenderDescription* rd, const rlf::ast::EvaluationContext& ec)
+{
+	using namespace rlf;
+	ErrorState es;
+	InitD3D(&NullCtx, rd, ec.DisplaySize, "", &es);
+	if (!es.Success)
+		throw es.Info;
+}
+
+void ReleaseNull(rlf::RenderDescription* rd)
+{
+	rlf::ReleaseD3D(&NullCtx, rd);
+	rlf::ReleaseData(rd);
+}
+
+// Frame number frame of a run in which time changes every frame, and the
+//	display size and the tuneables now and then.
+void NextFrame(rlf::ast::EvaluationContext& ec, rlf::RenderDescription* rd, u32 frame,
+	std::vector<rlf::Tuneable*>& tuneables)
+{
+	using namespace rlf;
+	ec.Time = (float)frame / 60.0f;
+	ec.ChangedThisFrameFlags = ast::VariesBy_Time;
+	ec.ChangedTuneables = {};
+	if (frame % 10 == 5)
+	{
+		ec.ChangedThisFrameFlags |= ast::VariesBy_Tuneable;
+		ec.ChangedTuneables.Count = (u32)tuneables.size();
+		ec.ChangedTuneables.Data = tuneables.data();
+	}
+	if (frame % 20 == 10)
+	{
+		ec.DisplaySize = ec.DisplaySize.x == 1280 ? uint2{ 1920, 1080 } : uint2{ 1280, 720 };
+		ec.ChangedThisFrameFlags |= ast::VariesBy_DisplaySize;
+	}
+	MarkChanged(rd, ec);
+}
+
+// Replaying the commands of a description every frame, through the null
+//	backend into a log with room for them, makes no heap allocations once the
+//	first frame has been.
+void CheckReplayAllocations(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	InitNull(rd, ec);
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+
+	std::string log;
+	NextFrame(ec, rd, 0, tuneables);
+	RecordCommands(ec, rd, log);
+	log.reserve(log.size() * 2 + 4096);
+	u64 before = AllocationCount();
+	for (u32 frame = 1 ; frame <= 60 ; ++frame)
+	{
+		NextFrame(ec, rd, frame, tuneables);
+		log.clear();
+		RecordCommands(ec, rd, log);
+	}
+	u64 allocations = AllocationCount() - before;
+	Check(t, allocations == 0, "%s: %u allocations in 60 frames", name, (u32)allocations);
+	ReleaseNull(rd);
+}
+
+void TestReplayAllocations(State* t)
+{
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		CheckReplayAllocations(t, SamplePaths[i], buffer);
+	}
+	CheckReplayAllocations(t, "synthetic draws", SyntheticDraws(200));
+}
+
+const char SimpleSamples[] = "samples/simple/";
+
+// samples/simple/draw/main.rlf is logged to source/tests/commands/draw_main.log.
+std::string CommandLogPath(const char* samplePath)
+{
+	std::string name = samplePath + sizeof(SimpleSamples) - 1;
+	name = name.substr(0, name.find_last_of('.'));
+	std::replace(name.begin(), name.end(), '/', '_');
+	return "source/tests/commands/" + name + ".log";
+}
+
+// Frames 0, 5 and 10 of a run of NextFrame: the first, one in which the
+//	tuneables change and one in which the display size does.
+bool RecordFrames(State* t, const char* name, const std::string& buffer, std::string& out)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return false;
+	ExecuteContext exc = {};
+	exc.GfxCtx = &NullCtx;
+	exc.EvCtx.DisplaySize = { 1280, 720 };
+	InitNull(rd, exc.EvCtx);
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+	for (u32 frame = 0 ; frame <= 10 ; ++frame)
+	{
+		NextFrame(exc.EvCtx, rd, frame, tuneables);
+		ErrorState es;
+		Execute(&exc, rd, &es);
+		if (!es.Success)
+			throw es.Info;
+		if (frame % 5 == 0)
+		{
+			char header[32];
+			sprintf_s(header, 32, "frame %u\n", frame);
+			out += header;
+			out += NullCtx.Log;
+		}
+	}
+	ReleaseNull(rd);
+	return true;
+}
+
+u32 FirstDifferentLine(const std::string& a, const std::string& b)
+{
+	u32 line = 1;
+	for (size_t i = 0 ; i < a.size() && i < b.size() && a[i] == b[i] ; ++i)
+	{
+		if (a[i] == '\n')
+			++line;
+	}
+	return line;
+}
+
+// The simple samples each use a feature or two, their logs show what it
+//	lowers to. When a change to lowering or to the null backend is intended,
+//	the log made is written next to the expected one as .actual, to look over
+//	and copy on top of it.
+void TestCommandLogs(State* t)
+{
+	std::string buffer;
+	std::string expected;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		const char* path = SamplePaths[i];
+		if (strncmp(path, SimpleSamples, sizeof(SimpleSamples) - 1) != 0)
+			continue;
+		Check(t, ReadWholeFile(path, buffer), "%s", path);
+		std::string actual;
+		if (!RecordFrames(t, path, buffer, actual))
+			continue;
+		std::string logPath = CommandLogPath(path);
+		expected.clear();
+		bool found = ReadWholeFile(logPath.c_str(), expected);
+		Check(t, found, "%s: no log", logPath.c_str());
+		// Checked out with Windows line endings or not.
+		expected.erase(std::remove(expected.begin(), expected.end(), '\r'), expected.end());
+		Check(t, !found || expected == actual, "%s differs from line %u", logPath.c_str(),
+			FirstDifferentLine(expected, actual));
+		if (expected == actual)
+			continue;
+		std::string actualPath = logPath + ".actual";
+		FILE* f = fopen(actualPath.c_str(), "wb");
+		if (f)
+		{
+			fwrite(actual.data(), 1, actual.size(), f);
+			fclose(f);
+		}
+	}
+}
+
+
+// How long lowering the passes takes, done once per load, and recording the
+//	commands of a frame through the null backend, which is what is left of
+//	Execute without a device. Over the samples and synthetic draws, as many
+//	as the argument says.
+void BenchCommandsOf(const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(nullptr, name, buffer);
+	if (!rd)
+	{
+		printf("%s: failed to parse\n", name);
+		return;
+	}
+	ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	InitNull(rd, ec);
+
+	alloc::LinAlloc commands = {};
+	alloc::LinAlloc scratch = {};
+	alloc::Init(&commands);
+	alloc::Init(&scratch);
+	const u32 lowerings = 20;
+	double lowerMs = MinTimeMs(5, [&]() {
+		for (u32 i = 0 ; i < lowerings ; ++i)
+		{
+			alloc::Reset(&commands);
+			alloc::Reset(&scratch);
+			LowerPasses(rd, &commands, &scratch);
+		}
+	}) / lowerings;
+	alloc::FreeAll(&commands);
+	alloc::FreeAll(&scratch);
+
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+	std::string log;
+	NextFrame(ec, rd, 0, tuneables);
+	RecordCommands(ec, rd, log);
+	log.reserve(log.size() * 2 + 4096);
+	const u32 frames = 20;
+	u32 frame = 0;
+	double recordMs = MinTimeMs(5, [&]() {
+		for (u32 i = 0 ; i < frames ; ++i)
+		{
+			NextFrame(ec, rd, ++frame, tuneables);
+			log.clear();
+			RecordCommands(ec, rd, log);
+		}
+	}) / frames;
+
+	u32 count = max(rd->Commands.Count, 1u);
+	printf("%-44s %6u %10.4f %7.1f %10.4f %7.1f\n", name, rd->Commands.Count,
+		lowerMs, lowerMs * 1e6 / count, recordMs, recordMs * 1e6 / count);
+	ReleaseNull(rd);
+}
+
+void BenchCommands(const BenchArgs& args)
+{
+	u32 drawCount = args.Count > 0 ? (u32)atoi(args.Values[0]) : 10000;
+	printf("%-44s %6s %10s %7s %10s %7s\n", "", "cmds", "lower ms", "ns/cmd",
+		"record ms", "ns/cmd");
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		if (ReadWholeFile(SamplePaths[i], buffer))
+			BenchCommandsOf(SamplePaths[i], buffer);
+	}
+	char name[64];
+	sprintf_s(name, 64, "%u synthetic draws", drawCount);
+	BenchCommandsOf(name, SyntheticDraws(drawCount));
+}
+
+}
@@ -0,0 +1,94 @@
+namespace test
+{
+
+// Loading a description the way LoadRlf does, from the rlf text or from the
+//	.rlfc next to it. The first load of each is what starting the viewer
+//	costs, the process hasn't touched any of it yet (the OS may still have the
+//	files cached). The best of the loads after that is there for comparison.
+void BenchColdStart(const BenchArgs& args)
+{
+	const char* path = args.Count > 0 ? args.Values[0] : "samples/Sponza/main.rlf";
+	std::string dir = DirectoryOf(path);
+	std::string compiledPath = std::string(path) + "c";
+	const u32 reps = 5;
+
+	std::string text;
+	std::string compiled;
+	double textFirst = 0.0;
+	double textBest = 1e30;
+	for (u32 i = 0 ; i <= reps ; ++i)
+	{
+		std::string source;
+		i64 start = ReadCounter();
+		if (!ReadWholeFile(path, source))
+		{
+			printf("Couldn't read %s\n", path);
+			return;
+		}
+		rlf::ErrorState es = {};
+		rlf::RenderDescription* rd = rlf::ParseBuffer(source.data(), (u32)source.size(),
+			dir.c_str(), nullptr, &es);
+		double ms = ElapsedMs(start, ReadCounter());
+		if (!rd)
+		{
+			printf("Failed to parse %s: %s\n", path, es.Info.Message.c_str());
+			if (args.Count == 0)
+				printf("Sponza's model isn't checked in, put sponza.obj in %s or "
+					"name another rlf after ColdStart.\n", dir.c_str());
+			return;
+		}
+		if (i == 0)
+		{
+			textFirst = ms;
+			Describe(rd, text);
+			rlf::ErrorState saveEs = {};
+			if (!rlf::SaveCompiled(compiledPath.c_str(), rd, source.data(),
+				(u32)source.size(), dir.c_str(), &saveEs))
+			{
+				printf("Couldn't write %s: %s\n", compiledPath.c_str(),
+					saveEs.Info.Message.c_str());
+				rlf::ReleaseData(rd);
+				return;
+			}
+		}
+		else
+			textBest = min(textBest, ms);
+		rlf::ReleaseData(rd);
+	}
+
+	double compiledFirst = 0.0;
+	double compiledBest = 1e30;
+	for (u32 i = 0 ; i <= reps ; ++i)
+	{
+		// The description points into the source, as it does in the viewer.
+		std::string source;
+		i64 start = ReadCounter();
+		ReadWholeFile(path, source);
+		rlf::RenderDescription* rd = rlf::LoadCompiled(compiledPath.c_str(),
+			source.data(), (u32)source.size(), dir.c_str());
+		double ms = ElapsedMs(start, ReadCounter());
+		if (!rd)
+		{
+			printf("Couldn't load %s\n", compiledPath.c_str());
+			return;
+		}
+		if (i == 0)
+		{
+			compiledFirst = ms;
+			Describe(rd, compiled);
+		}
+		else
+			compiledBest = min(compiledBest, ms);
+		rlf::ReleaseData(rd);
+	}
+
+	printf("%s\n", path);
+	printf("%-10s %12s %12s\n", "", "first load", "best after");
+	printf("%-10s %9.3f ms %9.3f ms\n", "text", textFirst, textBest);
+	printf("%-10s %9.3f ms %9.3f ms%s\n", "compiled", compiledFirst, compiledBest,
+		text == compiled ? "" : " (loaded a different description)");
+	printf("speedup    %11.1fx %11.1fx\n", textFirst / compiledFirst,
+		textBest / compiledBest);
+}
+
+}
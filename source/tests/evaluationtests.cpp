@@ -0,0 +1,120 @@
+namespace test
+{
+
+// What _Execute evaluates in a frame, less the gfx calls: the constants,
+//	the SetConstants of every draw and dispatch, and every other expression.
+void EvaluateFrame(rlf::ast::EvaluationContext& ec, rlf::RenderDescription* rd,
+	const std::vector<rlf::Array<rlf::SetConstant>*>& lists,
+	const std::vector<rlf::ast::Expression*>& exprs)
+{
+	using namespace rlf;
+	MarkChanged(rd, ec);
+	EvaluateConstants(ec, rd->Constants);
+	EvaluateSetConstantBatches(ec, rd);
+	for (Array<SetConstant>* sets : lists)
+		EvaluateSetConstants(ec, *sets);
+	for (ast::Expression* expr : exprs)
+	{
+		ast::Result res;
+		ast::EvaluationError err;
+		ast::Evaluate(ec, *expr, res, err);
+	}
+}
+
+// Frames of a description in which time changes every frame, and the display
+//	size and the tuneables now and then, have to make no heap allocations.
+void CheckFrameAllocations(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	std::vector<ConstantBuffer> cbs;
+	std::vector<u8> memory;
+	BindFakeConstantBuffers(rd, cbs, memory);
+	std::vector<Array<SetConstant>*> lists;
+	CollectSetConstantLists(rd, lists);
+	std::vector<ast::Expression*> exprs;
+	CollectExpressions(rd, exprs);
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+
+	ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	u64 before = AllocationCount();
+	for (u32 frame = 0 ; frame < 60 ; ++frame)
+	{
+		ec.Time = (float)frame / 60.0f;
+		ec.ChangedThisFrameFlags = ast::VariesBy_Time;
+		ec.ChangedTuneables = {};
+		if (frame % 10 == 5)
+		{
+			ec.ChangedThisFrameFlags |= ast::VariesBy_Tuneable;
+			ec.ChangedTuneables.Count = (u32)tuneables.size();
+			ec.ChangedTuneables.Data = tuneables.data();
+		}
+		if (frame == 30)
+		{
+			ec.DisplaySize = { 1920, 1080 };
+			ec.ChangedThisFrameFlags |= ast::VariesBy_DisplaySize;
+		}
+		EvaluateFrame(ec, rd, lists, exprs);
+	}
+	u64 allocations = AllocationCount() - before;
+	Check(t, allocations == 0, "%s: %u allocations in 60 frames", name, (u32)allocations);
+	ReleaseData(rd);
+}
+
+// Expressions which fail, most of them dividing by a tuneable set to zero,
+//	don't allocate either: the error isn't formatted until it's shown.
+void CheckErrorAllocations(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	std::vector<ast::Expression*> exprs;
+	CollectExpressions(rd, exprs);
+	std::vector<Tuneable*> tuneables(rd->Tuneables.begin(), rd->Tuneables.end());
+
+	Random r = { 99 };
+	u32 errors = 0;
+	u64 allocations = 0;
+	for (u32 round = 0 ; round < 8 ; ++round)
+	{
+		ast::EvaluationContext ec = TestContext(round);
+		RandomizeTuneables(rd, r);
+		ec.ChangedThisFrameFlags = ast::VariesBy_Time | ast::VariesBy_DisplaySize |
+			ast::VariesBy_Tuneable;
+		ec.ChangedTuneables.Count = (u32)tuneables.size();
+		ec.ChangedTuneables.Data = tuneables.data();
+		MarkChanged(rd, ec);
+
+		u64 before = AllocationCount();
+		for (ast::Expression* expr : exprs)
+		{
+			ast::Result res;
+			ast::EvaluationError err;
+			if (!ast::Evaluate(ec, *expr, res, err))
+				++errors;
+		}
+		allocations += AllocationCount() - before;
+	}
+	Check(t, errors > 0, "%s: nothing failed", name);
+	Check(t, allocations == 0, "%s: %u allocations evaluating, %u errors", name,
+		(u32)allocations, errors);
+	ReleaseData(rd);
+}
+
+void TestEvaluationAllocations(State* t)
+{
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		CheckFrameAllocations(t, SamplePaths[i], buffer);
+	}
+	CheckFrameAllocations(t, "synthetic draws", SyntheticDraws(200));
+	CheckErrorAllocations(t, "synthetic expressions", SyntheticExpressions(2000, 7));
+}
+
+}
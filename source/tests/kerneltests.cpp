@@ -0,0 +1,294 @@
+namespace test
+{
+
+const rlf::VariableFormat KernelFormats[] = {
+	rlf::VariableFormat::Bool, rlf::VariableFormat::Int, rlf::VariableFormat::Uint,
+	rlf::VariableFormat::Float,
+};
+const char* KernelFormatNames[] = { "bool", "int", "uint", "float" };
+const char* KernelOpNames[] = { "add", "subtract", "multiply", "divide" };
+
+// Lanes of fmt from values operators are likely to go wrong on, with noise in
+//	the rest of the Variable. Floats stay in the range of an int when they're
+//	to be converted, casting one which isn't is undefined.
+void RandomLanes(Random& r, rlf::VariableFormat fmt, rlf::Variable& v, bool allowZero,
+	bool inRange)
+{
+	using rlf::VariableFormat;
+	static const i32 ints[] = { 0, 1, -1, 3, -7, INT_MAX, INT_MIN, 256 };
+	static const u32 uints[] = { 0, 1, 2, 3, 100, 0xffffffffu, 0x80000000u, 256 };
+	static const float floats[] = { 0.0f, 1.0f, -1.0f, 0.5f, 3.25f, 1e20f, -0.0f, 256.0f };
+	for (u32 i = 0 ; i < 16 ; ++i)
+		((u32*)&v)[i] = NextU32(r);
+	for (u32 i = 0 ; i < 4 ; ++i)
+	{
+		u32 pick = NextU32(r) % 8;
+		bool random = NextU32(r) % 2 == 0;
+		switch (fmt)
+		{
+		case VariableFormat::Bool:
+			v.Bool4Val.m[i] = NextU32(r) % 2 == 0;
+			break;
+		case VariableFormat::Int:
+			v.Int4Val.m[i] = random ? (i32)NextU32(r) : ints[pick];
+			if (!allowZero && v.Int4Val.m[i] == 0)
+				v.Int4Val.m[i] = 1;
+			break;
+		case VariableFormat::Uint:
+			v.Uint4Val.m[i] = random ? NextU32(r) : uints[pick];
+			if (!allowZero && v.Uint4Val.m[i] == 0)
+				v.Uint4Val.m[i] = 1;
+			break;
+		case VariableFormat::Float:
+			v.Float4Val.m[i] = random ? NextFloat(r, -1e6f, 1e6f) : floats[pick];
+			if (inRange && fabsf(v.Float4Val.m[i]) > 1e9f)
+				v.Float4Val.m[i] = 0.5f;
+			if (!allowZero && v.Float4Val.m[i] == 0.0f)
+				v.Float4Val.m[i] = 1.0f;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// Operands of op for a type, with a zero divisor now and then and no
+//	INT_MIN / -1, which traps.
+void RandomOperands(Random& r, rlf::ast::BinaryOp::Type op, rlf::VariableType type,
+	rlf::ast::Result& a, rlf::ast::Result& b)
+{
+	using namespace rlf;
+	a.Type = b.Type = type;
+	if (type.Fmt == VariableFormat::Float4x4)
+	{
+		for (u32 i = 0 ; i < 16 ; ++i)
+		{
+			a.Value.Float4x4Val.m[i / 4][i % 4] = NextFloat(r, -10.0f, 10.0f);
+			b.Value.Float4x4Val.m[i / 4][i % 4] = NextFloat(r, -10.0f, 10.0f);
+		}
+		return;
+	}
+	RandomLanes(r, type.Fmt, a.Value, true, false);
+	RandomLanes(r, type.Fmt, b.Value, op != ast::BinaryOp::Type::Divide ||
+		NextU32(r) % 8 == 0, false);
+	if (type.Fmt == VariableFormat::Int)
+	{
+		for (u32 i = 0 ; i < 4 ; ++i)
+		{
+			if (a.Value.Int4Val.m[i] == INT_MIN && b.Value.Int4Val.m[i] == -1)
+				b.Value.Int4Val.m[i] = 1;
+		}
+	}
+}
+
+// Every operator kernel against the switch it replaced, which have to fail on
+//	the same operands and otherwise give the same bits. Matrix products are
+//	let off by a few ulps, /fp:fast may sum them in a different order.
+void TestKernels(State* t)
+{
+	using namespace rlf;
+	Random r = { 777 };
+	ast::Node node = {};
+	for (u32 op = 0 ; op < 4 ; ++op)
+	{
+		for (u32 f = 1 ; f < 5 ; ++f)
+		{
+			for (u32 dim = 1 ; dim <= 4 ; ++dim)
+			{
+				VariableType type = f == 4 ? Float4x4Type : VariableType{ KernelFormats[f], dim };
+				if (type.Fmt == VariableFormat::Float4x4 &&
+					((ast::BinaryOp::Type)op != ast::BinaryOp::Type::Multiply || dim > 1))
+					continue;
+				ast::BinaryKernel kernel =
+					ast::BinaryKernels[ast::BinaryKernelIndex((ast::BinaryOp::Type)op, type)];
+				const char* typeName = f == 4 ? "float4x4" : KernelFormatNames[f];
+				for (u32 i = 0 ; i < 1000 ; ++i)
+				{
+					ast::Result a;
+					ast::Result b;
+					RandomOperands(r, (ast::BinaryOp::Type)op, type, a, b);
+					ast::Result expected;
+					ast::Result actual;
+					expected.Type = actual.Type = type;
+					ast::EvaluationError expectedErr;
+					ast::EvaluationError actualErr;
+					reference::Operator((ast::BinaryOp::Type)op, &node, a, b, expected,
+						expectedErr);
+					kernel(&node, a.Value, b.Value, actual.Value, actualErr);
+					bool same = expectedErr.Code == actualErr.Code;
+					if (same && expectedErr.Code == ast::EvaluationErrorCode::None)
+					{
+						same = type.Fmt == VariableFormat::Float4x4 ?
+							SameResult(expected, actual) :
+							memcmp(&expected.Value, &actual.Value, dim * 4) == 0;
+					}
+					Check(t, same, "%s %s%u, case %u", KernelOpNames[op], typeName, dim, i);
+				}
+			}
+		}
+	}
+
+	for (VariableFormat from : KernelFormats)
+	{
+		for (VariableFormat to : KernelFormats)
+		{
+			if (from == to)
+				continue;
+			for (u32 dim = 1 ; dim <= 4 ; ++dim)
+			{
+				for (u32 splat = 0 ; splat < (dim > 1 ? 2u : 1u) ; ++splat)
+				{
+					VariableType fromType = { from, splat ? 1 : dim };
+					VariableType toType = { to, dim };
+					ast::ConversionKernel kernel =
+						ast::ConversionKernels[ast::ConversionKernelIndex(fromType, toType)];
+					u32 bytes = to == VariableFormat::Bool ? dim : dim * 4;
+					for (u32 i = 0 ; i < 1000 ; ++i)
+					{
+						ast::Result expected;
+						expected.Type = fromType;
+						RandomLanes(r, from, expected.Value, true, true);
+						ast::Result actual = expected;
+						reference::Expand(expected);
+						reference::Convert(expected, to);
+						kernel(actual.Value);
+						Check(t, memcmp(&expected.Value, &actual.Value, bytes) == 0,
+							"%s%u to %s%u, case %u", KernelFormatNames[(u32)from],
+							fromType.Dim, KernelFormatNames[(u32)to], dim, i);
+					}
+				}
+			}
+		}
+	}
+}
+
+// ns per operation through each kernel and through the switch, for every
+//	operator and conversion by format and size.
+void BenchKernels(const BenchArgs&)
+{
+	using namespace rlf;
+	const u32 count = 256;
+	const u32 reps = 200;
+	Random r = { 778 };
+	ast::Node node = {};
+	std::vector<ast::Result> as(count);
+	std::vector<ast::Result> bs(count);
+	volatile u32 sink = 0;
+	double referenceTotal = 0.0;
+	double kernelTotal = 0.0;
+
+	printf("%-16s %17s %17s %17s %17s\n", "ns, switch/kernel", "1", "2", "3", "4");
+	for (u32 op = 0 ; op < 4 ; ++op)
+	{
+		for (u32 f = 1 ; f < 4 ; ++f)
+		{
+			char row[32];
+			sprintf_s(row, 32, "%s %s", KernelOpNames[op], KernelFormatNames[f]);
+			printf("%-16s", row);
+			for (u32 dim = 1 ; dim <= 4 ; ++dim)
+			{
+				ast::BinaryOp::Type type = (ast::BinaryOp::Type)op;
+				VariableType vt = { KernelFormats[f], dim };
+				for (u32 i = 0 ; i < count ; ++i)
+					RandomOperands(r, type, vt, as[i], bs[i]);
+				ast::BinaryKernel kernel = ast::BinaryKernels[ast::BinaryKernelIndex(type, vt)];
+				double referenceMs = MinTimeMs(5, [&]() {
+					for (u32 rep = 0 ; rep < reps ; ++rep)
+					{
+						for (u32 i = 0 ; i < count ; ++i)
+						{
+							ast::Result res;
+							ast::EvaluationError err;
+							res.Type = vt;
+							reference::Operator(type, &node, as[i], bs[i], res, err);
+							sink = res.Value.UintVal;
+						}
+					}
+				});
+				double kernelMs = MinTimeMs(5, [&]() {
+					for (u32 rep = 0 ; rep < reps ; ++rep)
+					{
+						for (u32 i = 0 ; i < count ; ++i)
+						{
+							ast::Result res;
+							ast::EvaluationError err;
+							kernel(&node, as[i].Value, bs[i].Value, res.Value, err);
+							sink = res.Value.UintVal;
+						}
+					}
+				});
+				double referenceNs = referenceMs * 1e6 / (reps * count);
+				double kernelNs = kernelMs * 1e6 / (reps * count);
+				referenceTotal += referenceNs;
+				kernelTotal += kernelNs;
+				printf("     %5.2f / %5.2f", referenceNs, kernelNs);
+			}
+			printf("\n");
+		}
+	}
+	printf("operators total: switch %.1f ns, kernels %.1f ns\n\n", referenceTotal, kernelTotal);
+
+	referenceTotal = kernelTotal = 0.0;
+	printf("%-16s %17s %17s %17s %17s %17s %17s %17s\n", "ns, switch/kernel", "1", "2",
+		"3", "4", "splat 2", "splat 3", "splat 4");
+	for (VariableFormat from : KernelFormats)
+	{
+		for (VariableFormat to : KernelFormats)
+		{
+			if (from == to)
+				continue;
+			char row[32];
+			sprintf_s(row, 32, "%s to %s", KernelFormatNames[(u32)from],
+				KernelFormatNames[(u32)to]);
+			printf("%-16s", row);
+			for (u32 splat = 0 ; splat < 2 ; ++splat)
+			{
+				for (u32 dim = splat ? 2 : 1 ; dim <= 4 ; ++dim)
+				{
+					VariableType fromType = { from, splat ? 1 : dim };
+					VariableType toType = { to, dim };
+					for (u32 i = 0 ; i < count ; ++i)
+					{
+						as[i].Type = fromType;
+						RandomLanes(r, from, as[i].Value, true, true);
+					}
+					ast::ConversionKernel kernel =
+						ast::ConversionKernels[ast::ConversionKernelIndex(fromType, toType)];
+					double referenceMs = MinTimeMs(5, [&]() {
+						for (u32 rep = 0 ; rep < reps ; ++rep)
+						{
+							for (u32 i = 0 ; i < count ; ++i)
+							{
+								ast::Result res = as[i];
+								reference::Expand(res);
+								reference::Convert(res, to);
+								sink = res.Value.UintVal;
+							}
+						}
+					});
+					double kernelMs = MinTimeMs(5, [&]() {
+						for (u32 rep = 0 ; rep < reps ; ++rep)
+						{
+							for (u32 i = 0 ; i < count ; ++i)
+							{
+								ast::Result res = as[i];
+								kernel(res.Value);
+								sink = res.Value.UintVal;
+							}
+						}
+					});
+					double referenceNs = referenceMs * 1e6 / (reps * count);
+					double kernelNs = kernelMs * 1e6 / (reps * count);
+					referenceTotal += referenceNs;
+					kernelTotal += kernelNs;
+					printf("     %5.2f / %5.2f", referenceNs, kernelNs);
+				}
+			}
+			printf("\n");
+		}
+	}
+	printf("conversions total: switch %.1f ns, kernels %.1f ns\n", referenceTotal,
+		kernelTotal);
+}
+
+}
@@ -0,0 +1,184 @@
+namespace test
+{
+
+// Tokens from the shared lexer against the reference tokenizer, with the RLF
+//	or the shader set of punctuation. Float values aren't compared, the
+//	reference rounds them differently.
+void CompareTokens(State* t, const char* name, const std::string& buffer, bool shader)
+{
+	const char* start = buffer.data();
+	const char* end = start + buffer.size();
+
+	reference::TokenizerState ref;
+	reference::TokenizerStateInit(ref);
+	rlf::TokenizerState ts;
+	rlf::TokenizerStateInit(ts);
+	if (shader)
+	{
+		EnableShaderTokens(ref.fcLUT);
+		EnableShaderTokens(ts.fcLUT);
+	}
+	// Shaders are only parsed for sizeof, any others can have operators the
+	//	tokenizers don't take. They should both fail on the same one then.
+	const char* refError = nullptr;
+	const char* error = nullptr;
+	try {
+		reference::Tokenize(start, end, ref);
+	}
+	catch (rlf::ErrorInfo ie)
+	{
+		refError = ie.Location;
+	}
+	try {
+		rlf::Tokenize(start, end, ts);
+	}
+	catch (rlf::ErrorInfo ie)
+	{
+		error = ie.Location;
+	}
+	Check(t, refError == error, "%s: failed at offset %d, expected %d", name,
+		error ? (int)(error - start) : -1, refError ? (int)(refError - start) : -1);
+
+	Check(t, ref.tokens.size() == ts.tokens.size(), "%s: %u tokens, expected %u",
+		name, (u32)ts.tokens.size(), (u32)ref.tokens.size());
+	size_t count = min(ref.tokens.size(), ts.tokens.size());
+	for (size_t i = 0 ; i < count ; ++i)
+	{
+		const reference::Token& a = ref.tokens[i];
+		const rlf::Token& b = ts.tokens[i];
+		u32 offset = (u32)(a.Location - start);
+		if (a.Type != b.Type || a.Location != b.Location)
+		{
+			Check(t, false, "%s: %s at offset %u, got %s at offset %u", name,
+				rlf::TokenNames[(u32)a.Type], offset, rlf::TokenNames[(u32)b.Type],
+				(u32)(b.Location - start));
+			break;
+		}
+		if (a.Type == rlf::TokenType::Identifier || a.Type == rlf::TokenType::String)
+		{
+			Check(t, strcmp(a.String, b.String) == 0, "%s: %s, got %s at offset %u",
+				name, a.String, b.String, offset);
+		}
+		else if (a.Type == rlf::TokenType::IntegerLiteral)
+		{
+			Check(t, a.IntegerLiteral == b.IntegerLiteral, "%s: %u, got %u at offset %u",
+				name, a.IntegerLiteral, b.IntegerLiteral, offset);
+		}
+	}
+	rlf::TokenizerStateRelease(ts);
+}
+
+void TestLexer(State* t)
+{
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		CompareTokens(t, SamplePaths[i], buffer, false);
+	}
+	for (u32 i = 0 ; i < ShaderCount ; ++i)
+	{
+		Check(t, ReadWholeFile(ShaderPaths[i], buffer), "%s", ShaderPaths[i]);
+		CompareTokens(t, ShaderPaths[i], buffer, true);
+	}
+	CompareTokens(t, "synthetic comments", SyntheticComments(1000), false);
+	CompareTokens(t, "synthetic constants", SyntheticConstants(1000), false);
+}
+
+struct LexerInput
+{
+	BenchInput Input;
+	bool Shader;
+};
+
+// Bytes per second of the reference tokenizer and the shared lexer, on the
+//	files given (.hlsl ones as shaders) or on generated inputs which each
+//	stress one part of it.
+void BenchLexer(const BenchArgs& args)
+{
+	std::vector<LexerInput> inputs;
+	LexerInput in;
+	if (args.Count > 0)
+	{
+		std::vector<BenchInput> files;
+		GetBenchInputs(args, files);
+		for (const BenchInput& file : files)
+		{
+			size_t dot = file.Name.find_last_of('.');
+			in.Input = file;
+			in.Shader = dot != std::string::npos && file.Name.substr(dot) == ".hlsl";
+			inputs.push_back(in);
+		}
+	}
+	else
+	{
+		in.Shader = false;
+		in.Input.Name = "synthetic: comments";
+		in.Input.Buffer = SyntheticComments(200000);
+		inputs.push_back(in);
+		in.Input.Name = "synthetic: identifiers";
+		in.Input.Buffer = SyntheticConstants(30000);
+		inputs.push_back(in);
+		in.Input.Name = "synthetic: float literals";
+		in.Input.Buffer = SyntheticInitData(20, 20000);
+		inputs.push_back(in);
+		in.Shader = true;
+		in.Input.Name = "synthetic: sample shaders";
+		in.Input.Buffer = SyntheticShaders(4 * 1024 * 1024);
+		inputs.push_back(in);
+	}
+
+	const u32 reps = 10;
+	printf("%-32s %10s %11s %11s %8s\n", "", "size", "reference", "lexer", "speedup");
+	for (const LexerInput& input : inputs)
+	{
+		const std::string& buffer = input.Input.Buffer;
+		const char* start = buffer.data();
+		const char* end = start + buffer.size();
+		double mb = (double)buffer.size() / (1024.0 * 1024.0);
+
+		double refMs = 0.0;
+		try {
+			refMs = MinTimeMs(reps, [&]() {
+				reference::TokenizerState ts;
+				reference::TokenizerStateInit(ts);
+				if (input.Shader)
+					EnableShaderTokens(ts.fcLUT);
+				reference::Tokenize(start, end, ts);
+			});
+		}
+		catch (rlf::ErrorInfo)
+		{
+			// Uses syntax which was added since.
+		}
+
+		double lexMs = 0.0;
+		try {
+			lexMs = MinTimeMs(reps, [&]() {
+				rlf::TokenizerState ts;
+				rlf::TokenizerStateInit(ts);
+				if (input.Shader)
+					EnableShaderTokens(ts.fcLUT);
+				rlf::Tokenize(start, end, ts);
+				rlf::TokenizerStateRelease(ts);
+			});
+		}
+		catch (rlf::ErrorInfo ie)
+		{
+			printf("%s: %s\n", input.Input.Name.c_str(), ie.Message.c_str());
+			continue;
+		}
+
+		char refResult[32] = "-";
+		char speedup[32] = "-";
+		if (refMs > 0.0)
+		{
+			sprintf_s(refResult, 32, "%6.0f MB/s", mb * 1000.0 / refMs);
+			sprintf_s(speedup, 32, "%7.2fx", refMs / lexMs);
+		}
+		printf("%-32.32s %7.0f KB %11s %6.0f MB/s %8s\n", input.Input.Name.c_str(),
+			mb * 1024.0, refResult, mb * 1000.0 / lexMs, speedup);
+	}
+}
+
+}
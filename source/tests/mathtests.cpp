@@ -0,0 +1,399 @@
+namespace test
+{
+
+// The values of the tuneables the math functions are given, as doubles for
+//	the reference math.
+struct MathInputs
+{
+	double A[4];
+	double B[4];
+	double T;
+	i32 I[4];
+	i32 J[4];
+	u32 U[4];
+	u32 V[4];
+};
+
+// Matrices are column major like float4x4, m[column][row].
+typedef double MathMatrix[4][4];
+
+void RefIdentity(MathMatrix m, double diagonal)
+{
+	for (u32 c = 0 ; c < 4 ; ++c)
+	{
+		for (u32 r = 0 ; r < 4 ; ++r)
+			m[c][r] = c == r ? diagonal : 0.0;
+	}
+}
+
+double RefDot(const double* a, const double* b, u32 dim)
+{
+	double sum = 0.0;
+	for (u32 i = 0 ; i < dim ; ++i)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+void RefNormalize(const double* v, u32 dim, double* out)
+{
+	double length = sqrt(RefDot(v, v, dim));
+	for (u32 i = 0 ; i < dim ; ++i)
+		out[i] = v[i] / length;
+}
+
+void RefCross(const double* a, const double* b, double* out)
+{
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+void RefLookAt(const double* from, const double* to, MathMatrix m)
+{
+	const double up[3] = { 0.0, 1.0, 0.0 };
+	double dir[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+	double z[3];
+	double x[3];
+	double y[3];
+	double side[3];
+	RefNormalize(dir, 3, z);
+	RefCross(up, z, side);
+	RefNormalize(side, 3, x);
+	RefCross(z, x, y);
+	const double* axes[3] = { x, y, z };
+	RefIdentity(m, 1.0);
+	for (u32 r = 0 ; r < 3 ; ++r)
+	{
+		for (u32 c = 0 ; c < 3 ; ++c)
+			m[c][r] = axes[r][c];
+		m[3][r] = -RefDot(axes[r], from, 3);
+	}
+}
+
+void RefProjection(double fov, double aspect, double zn, double zf, MathMatrix m)
+{
+	RefIdentity(m, 0.0);
+	double yScale = 1.0 / tan(fov * 0.5);
+	m[0][0] = yScale / aspect;
+	m[1][1] = yScale;
+	m[2][2] = zf / (zf - zn);
+	m[3][2] = -zn * zf / (zf - zn);
+	m[2][3] = 1.0;
+}
+
+void RefOrthographic(double width, double height, double zn, double zf, MathMatrix m)
+{
+	RefIdentity(m, 1.0);
+	m[0][0] = 2.0 / width;
+	m[1][1] = 2.0 / height;
+	m[2][2] = 1.0 / (zf - zn);
+	m[3][2] = -zn / (zf - zn);
+}
+
+void RefMultiply(const MathMatrix a, const MathMatrix b, MathMatrix out)
+{
+	for (u32 c = 0 ; c < 4 ; ++c)
+	{
+		for (u32 r = 0 ; r < 4 ; ++r)
+		{
+			out[c][r] = 0.0;
+			for (u32 k = 0 ; k < 4 ; ++k)
+				out[c][r] += a[k][r] * b[c][k];
+		}
+	}
+}
+
+void RefStore(const MathMatrix m, double* out)
+{
+	for (u32 c = 0 ; c < 4 ; ++c)
+	{
+		for (u32 r = 0 ; r < 4 ; ++r)
+			out[c * 4 + r] = m[c][r];
+	}
+}
+
+template <typename T>
+double RefDivRoundUp(T a, T b)
+{
+	return ceil((double)a / (double)b);
+}
+
+struct MathCase
+{
+	const char* Type;
+	const char* Expr;
+	void (*Reference)(const MathInputs& in, double* out);
+};
+
+const MathCase MathCases[] = {
+	{ "float4", "Clamp(A, -1, B.x)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 4 ; ++i)
+			out[i] = min(max(in.A[i], -1.0), in.B[0]);
+	} },
+	{ "int4", "Clamp(I, -100, 100)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 4 ; ++i)
+			out[i] = min(max(in.I[i], -100), 100);
+	} },
+	{ "float3", "Saturate(A.xyz * 0.1)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 3 ; ++i)
+			out[i] = min(max(in.A[i] * 0.1, 0.0), 1.0);
+	} },
+	{ "float4", "Lerp(A, B, T)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 4 ; ++i)
+			out[i] = in.A[i] + (in.B[i] - in.A[i]) * in.T;
+	} },
+	{ "float", "Dot(A, B)", [](const MathInputs& in, double* out) {
+		out[0] = RefDot(in.A, in.B, 4);
+	} },
+	{ "float", "Dot(A.xy, B.zw)", [](const MathInputs& in, double* out) {
+		out[0] = RefDot(in.A, in.B + 2, 2);
+	} },
+	{ "float3", "Cross(A.xyz, B.xyz)", [](const MathInputs& in, double* out) {
+		RefCross(in.A, in.B, out);
+	} },
+	{ "float", "Length(A)", [](const MathInputs& in, double* out) {
+		out[0] = sqrt(RefDot(in.A, in.A, 4));
+	} },
+	{ "float", "Length(B.xyz)", [](const MathInputs& in, double* out) {
+		out[0] = sqrt(RefDot(in.B, in.B, 3));
+	} },
+	{ "float4", "Normalize(A)", [](const MathInputs& in, double* out) {
+		RefNormalize(in.A, 4, out);
+	} },
+	{ "float2", "Normalize(B.xz)", [](const MathInputs& in, double* out) {
+		double v[2] = { in.B[0], in.B[2] };
+		RefNormalize(v, 2, out);
+	} },
+	{ "int4", "DivRoundUp(I, J)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 4 ; ++i)
+			out[i] = RefDivRoundUp(in.I[i], in.J[i]);
+	} },
+	{ "uint4", "DivRoundUp(U, V)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 4 ; ++i)
+			out[i] = RefDivRoundUp(in.U[i], in.V[i]);
+	} },
+	{ "uint2", "DivRoundUp(U.xy, 64)", [](const MathInputs& in, double* out) {
+		for (u32 i = 0 ; i < 2 ; ++i)
+			out[i] = RefDivRoundUp(in.U[i], 64u);
+	} },
+	{ "float4x4", "LookAt(A.xyz, B.xyz)", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefLookAt(in.A, in.B, m);
+		RefStore(m, out);
+	} },
+	{ "float4x4", "Transpose(LookAt(A.xyz, B.xyz))", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefLookAt(in.A, in.B, m);
+		for (u32 c = 0 ; c < 4 ; ++c)
+		{
+			for (u32 r = 0 ; r < 4 ; ++r)
+				out[c * 4 + r] = m[r][c];
+		}
+	} },
+	{ "float4", "Mul(LookAt(A.xyz, B.xyz), B)", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefLookAt(in.A, in.B, m);
+		for (u32 r = 0 ; r < 4 ; ++r)
+		{
+			out[r] = 0.0;
+			for (u32 c = 0 ; c < 4 ; ++c)
+				out[r] += m[c][r] * in.B[c];
+		}
+	} },
+	{ "float4", "Mul(B, LookAt(A.xyz, B.xyz))", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefLookAt(in.A, in.B, m);
+		for (u32 c = 0 ; c < 4 ; ++c)
+			out[c] = RefDot(in.B, m[c], 4);
+	} },
+	{ "float4x4", "Mul(Projection(T, 1.5, 0.1, 100), LookAt(A.xyz, B.xyz))",
+		[](const MathInputs& in, double* out) {
+		MathMatrix proj;
+		MathMatrix view;
+		MathMatrix m;
+		RefProjection(in.T, 1.5, 0.1, 100.0, proj);
+		RefLookAt(in.A, in.B, view);
+		RefMultiply(proj, view, m);
+		RefStore(m, out);
+	} },
+	{ "float4x4", "Projection(T, 1.5, 0.1, 100)", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefProjection(in.T, 1.5, 0.1, 100.0, m);
+		RefStore(m, out);
+	} },
+	{ "float4x4", "ProjectionReverseZ(T, 1.5, 0.1, 100)", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefProjection(in.T, 1.5, 100.0, 0.1, m);
+		RefStore(m, out);
+	} },
+	{ "float4x4", "Orthographic(T * 20, T * 10, 0.5, 50)", [](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefOrthographic(in.T * 20.0, in.T * 10.0, 0.5, 50.0, m);
+		RefStore(m, out);
+	} },
+	{ "float4x4", "OrthographicReverseZ(T * 20, T * 10, 0.5, 50)",
+		[](const MathInputs& in, double* out) {
+		MathMatrix m;
+		RefOrthographic(in.T * 20.0, in.T * 10.0, 50.0, 0.5, m);
+		RefStore(m, out);
+	} },
+};
+const u32 MathCaseCount = sizeof(MathCases) / sizeof(MathCases[0]);
+
+// Random inputs which keep the functions away from where they're undefined:
+//	no zero divisors, and an eye and target apart and not above each other.
+void RandomMathInputs(Random& r, MathInputs& in)
+{
+	do
+	{
+		for (u32 i = 0 ; i < 4 ; ++i)
+		{
+			float range = i == 1 ? 1.0f : 10.0f;
+			in.A[i] = NextFloat(r, -range, range);
+			in.B[i] = NextFloat(r, -range, range);
+		}
+	}
+	while (fabs(in.A[0] - in.B[0]) + fabs(in.A[2] - in.B[2]) < 1.0);
+	in.T = NextFloat(r, 0.5f, 2.0f);
+	for (u32 i = 0 ; i < 4 ; ++i)
+	{
+		in.I[i] = (i32)(NextU32(r) % 2 ? NextU32(r) : NextU32(r) % 200) - 100;
+		in.J[i] = (i32)(NextU32(r) % 2000) - 1000;
+		in.U[i] = NextU32(r) % 2 ? NextU32(r) : NextU32(r) % 200;
+		in.V[i] = 1 + NextU32(r) % 1000;
+		if (in.I[i] == INT_MIN)
+			in.I[i] = 0;
+		if (in.J[i] == 0)
+			in.J[i] = 1;
+	}
+}
+
+void SetMathTuneables(rlf::RenderDescription* rd, const MathInputs& in)
+{
+	using namespace rlf;
+	for (Tuneable* tune : rd->Tuneables)
+	{
+		for (u32 i = 0 ; i < 4 ; ++i)
+		{
+			switch (tune->Name[0])
+			{
+			case 'A': tune->Value.Float4Val.m[i] = (float)in.A[i]; break;
+			case 'B': tune->Value.Float4Val.m[i] = (float)in.B[i]; break;
+			case 'T': tune->Value.FloatVal = (float)in.T; break;
+			case 'I': tune->Value.Int4Val.m[i] = in.I[i]; break;
+			case 'J': tune->Value.Int4Val.m[i] = in.J[i]; break;
+			case 'U': tune->Value.Uint4Val.m[i] = in.U[i]; break;
+			case 'V': tune->Value.Uint4Val.m[i] = in.V[i]; break;
+			}
+		}
+	}
+}
+
+// Within float precision of the reference, relative to its size.
+bool NearReference(const rlf::ast::Result& res, const double* expected)
+{
+	using rlf::VariableFormat;
+	u32 count = res.Type.Fmt == VariableFormat::Float4x4 ? 16 : res.Type.Dim;
+	for (u32 i = 0 ; i < count ; ++i)
+	{
+		double actual;
+		if (res.Type.Fmt == VariableFormat::Int)
+			actual = res.Value.Int4Val.m[i];
+		else if (res.Type.Fmt == VariableFormat::Uint)
+			actual = res.Value.Uint4Val.m[i];
+		else
+			actual = ((const float*)&res.Value)[i];
+		double tolerance = res.Type.Fmt == VariableFormat::Int ||
+			res.Type.Fmt == VariableFormat::Uint ? 0.0 : 1e-4 * max(1.0, fabs(expected[i]));
+		if (!(fabs(actual - expected[i]) <= tolerance))
+			return false;
+	}
+	return true;
+}
+
+// Each function through the tree walker, the VM and a batch against the same
+//	math in doubles, and the errors they report.
+void TestMath(State* t)
+{
+	using namespace rlf;
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	rlf +=
+		"tuneable float4 A = 1, 0, 3, 4;\n"
+		"tuneable float4 B = 5, 1, 7, 8;\n"
+		"tuneable float T = 1;\n"
+		"tuneable int4 I = 1, 2, 3, 4;\n"
+		"tuneable int4 J = 1, 2, 3, 4;\n"
+		"tuneable uint4 U = 1, 2, 3, 4;\n"
+		"tuneable uint4 V = 1, 2, 3, 4;\n"
+		"constant float4 NormalizeZero = Normalize(A * 0);\n"
+		"constant uint4 DivideByZero = DivRoundUp(U, V * 0);\n";
+	char buf[256];
+	for (u32 i = 0 ; i < MathCaseCount ; ++i)
+	{
+		sprintf_s(buf, 256, "constant %s C%u = %s;\n", MathCases[i].Type, i,
+			MathCases[i].Expr);
+		rlf += buf;
+	}
+	RenderDescription* rd = ParseForEvaluation(t, "math", rlf);
+	if (!rd)
+		return;
+	std::unordered_map<std::string, ast::Expression*> exprs;
+	for (Constant* cnst : rd->Constants)
+		exprs[cnst->Name] = &cnst->Expr;
+
+	Random r = { 2718 };
+	ast::EvaluationContext ec = {};
+	MathInputs in;
+	for (u32 round = 0 ; round < 200 ; ++round)
+	{
+		RandomMathInputs(r, in);
+		SetMathTuneables(rd, in);
+		WalkConstants(rd, ec);
+		for (u32 i = 0 ; i < MathCaseCount ; ++i)
+		{
+			sprintf_s(buf, 256, "C%u", i);
+			ast::Expression* expr = exprs[buf];
+			double expected[16];
+			MathCases[i].Reference(in, expected);
+
+			ast::Result walked;
+			ast::EvaluationError err;
+			ast::Evaluate(expr->TopNode, ec, walked, err);
+			Check(t, err.Code == ast::EvaluationErrorCode::None &&
+				NearReference(walked, expected), "walker, %s, round %u", MathCases[i].Expr,
+				round);
+			if (!expr->Code)
+				continue;
+			ast::Result executed;
+			Check(t, ast::Execute(*expr->Code, ec, executed, err) &&
+				NearReference(executed, expected), "VM, %s, round %u", MathCases[i].Expr,
+				round);
+			ast::Result batched[ast::BatchWidth];
+			Check(t, ast::ExecuteBatch(&expr->Code, 1, ec, batched) &&
+				NearReference(batched[0], expected), "batch, %s, round %u",
+				MathCases[i].Expr, round);
+		}
+	}
+
+	const ast::EvaluationErrorCode codes[] = {
+		ast::EvaluationErrorCode::NormalizeZero, ast::EvaluationErrorCode::DivideByZero,
+	};
+	const char* names[] = { "NormalizeZero", "DivideByZero" };
+	for (u32 i = 0 ; i < 2 ; ++i)
+	{
+		ast::Expression* expr = exprs[names[i]];
+		ast::Result res;
+		ast::EvaluationError walkErr;
+		ast::Evaluate(expr->TopNode, ec, res, walkErr);
+		Check(t, walkErr.Code == codes[i], "walker, %s", names[i]);
+		if (!expr->Code)
+			continue;
+		ast::EvaluationError execErr;
+		Check(t, !ast::Execute(*expr->Code, ec, res, execErr) && execErr.Code == codes[i],
+			"VM, %s", names[i]);
+	}
+	ReleaseData(rd);
+}
+
+}
@@ -0,0 +1,149 @@
+namespace test
+{
+
+// The literal has to scan to the end of str, as a float bit-identical to what
+//	strtod makes of it.
+void CheckFloat(State* t, const char* str)
+{
+	size_t len = strlen(str);
+	rlf::Token token = {};
+	const char* next = rlf::ScanNumber(str, str + len, token);
+	double expected = strtod(str, nullptr);
+	Check(t, token.Type == rlf::TokenType::FloatLiteral && next == str + len &&
+		memcmp(&expected, &token.FloatLiteral, sizeof(double)) == 0,
+		"%s scanned %u characters to %.17g, expected %.17g", str,
+		(u32)(next - str), token.FloatLiteral, expected);
+}
+
+void TestNumbers(State* t)
+{
+	Random r = { 1 };
+	char buf[64];
+	for (u32 i = 0 ; i < 100000 ; ++i)
+	{
+		// Any finite double, at any precision.
+		u64 bits = ((u64)NextU32(r) << 32 | NextU32(r)) & ~(1ull << 63);
+		if ((bits >> 52) != 0x7ff)
+		{
+			double d;
+			memcpy(&d, &bits, sizeof(d));
+			sprintf_s(buf, 64, "%.*e", (int)(1 + NextU32(r) % 17), d);
+			CheckFloat(t, buf);
+		}
+
+		// The kind of value descriptions are full of.
+		double value = (double)(NextU32(r) % 100000000) / (double)(1 + NextU32(r) % 1000);
+		sprintf_s(buf, 64, "%.*f", (int)(1 + NextU32(r) % 12), value);
+		CheckFloat(t, buf);
+
+		// Up to 25 digits, so past what the mantissa holds, with the point
+		//	anywhere and maybe an exponent.
+		std::string digits;
+		u32 digitCount = 1 + NextU32(r) % 25;
+		for (u32 j = 0 ; j < digitCount ; ++j)
+			digits += (char)('0' + NextU32(r) % 10);
+		digits.insert(NextU32(r) % (digitCount + 1), ".");
+		if (NextU32(r) % 2)
+			digits += "e" + std::to_string((int)(NextU32(r) % 700) - 350);
+		CheckFloat(t, digits.c_str());
+	}
+
+	const char* edgeCases[] = {
+		"0.0", "0.", "7.e0", "1e400", "1e-400", "0.1", "1e22", "1e23", "3e37",
+		"2.2250738585072011e-308", "4.9e-324", "1.7976931348623157e308",
+		"9007199254740993.0", "123456789012345678901234567890.5",
+		"0.000000000000000000000000001",
+	};
+	for (const char* str : edgeCases)
+		CheckFloat(t, str);
+
+	struct IntegerCase
+	{
+		const char* String;
+		u32 Value;
+		u32 Length;
+	};
+	const IntegerCase integerCases[] = {
+		{ "0x1F", 31, 4 },
+		{ "0b101u", 5, 6 },
+		{ "4294967295", 4294967295u, 10 },
+		{ "0xffffffff", 0xffffffffu, 10 },
+		{ "12u", 12, 3 },
+		{ "2em", 2, 1 },
+		{ "007", 7, 3 },
+	};
+	for (const IntegerCase& ic : integerCases)
+	{
+		rlf::Token token = {};
+		const char* next = rlf::ScanNumber(ic.String, ic.String + strlen(ic.String), token);
+		Check(t, token.Type == rlf::TokenType::IntegerLiteral &&
+			token.IntegerLiteral == ic.Value && next == ic.String + ic.Length,
+			"%s scanned %u characters to %u", ic.String, (u32)(next - ic.String),
+			token.IntegerLiteral);
+	}
+
+	const char* suffixCases[] = { "1.5f", "2e3F", "0.5h", "1.0L" };
+	for (const char* str : suffixCases)
+	{
+		rlf::Token token = {};
+		size_t len = strlen(str);
+		const char* next = rlf::ScanNumber(str, str + len, token);
+		Check(t, token.Type == rlf::TokenType::FloatLiteral && next == str + len &&
+			token.FloatLiteral == strtod(str, nullptr), "%s", str);
+	}
+
+	const char* errorCases[] = { "4294967296", "0x100000000", "0x", "0b2" };
+	for (const char* str : errorCases)
+	{
+		bool threw = false;
+		try {
+			rlf::Token token = {};
+			rlf::ScanNumber(str, str + strlen(str), token);
+		}
+		catch (rlf::ErrorInfo)
+		{
+			threw = true;
+		}
+		Check(t, threw, "%s", str);
+	}
+}
+
+// Scanning a long list of float literals, like InitData, with ScanNumber and
+//	with strtod.
+void BenchNumbers(const BenchArgs&)
+{
+	Random r = { 1 };
+	std::string buffer;
+	char buf[64];
+	for (u32 i = 0 ; i < 2000000 ; ++i)
+	{
+		sprintf_s(buf, 64, "%.6f, ", (double)(NextU32(r) % 1000000) / 997.0);
+		buffer += buf;
+	}
+	const char* start = buffer.data();
+	const char* end = start + buffer.size();
+	double mb = (double)buffer.size() / (1024.0 * 1024.0);
+
+	double sum = 0.0;
+	double scanMs = MinTimeMs(5, [&]() {
+		for (const char* next = start ; next < end ; next += 2)
+		{
+			rlf::Token token;
+			next = rlf::ScanNumber(next, end, token);
+			sum += token.FloatLiteral;
+		}
+	});
+	double strtodMs = MinTimeMs(5, [&]() {
+		for (const char* next = start ; next < end ; next += 2)
+		{
+			char* numberEnd;
+			sum += strtod(next, &numberEnd);
+			next = numberEnd;
+		}
+	});
+	printf("%u float literals, %.0f KB (checksum %g)\n", 2000000, mb * 1024.0, sum);
+	printf("ScanNumber %8.3f ms %6.0f MB/s\n", scanMs, mb * 1000.0 / scanMs);
+	printf("strtod     %8.3f ms %6.0f MB/s\n", strtodMs, mb * 1000.0 / strtodMs);
+}
+
+}
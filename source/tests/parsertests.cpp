@@ -0,0 +1,241 @@
+namespace test
+{
+
+// Equal strings share an id and a copy, different ones don't.
+void TestInterning(State* t)
+{
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		std::string buffer;
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		rlf::TokenizerState ts;
+		rlf::TokenizerStateInit(ts);
+		rlf::Tokenize(buffer.data(), buffer.data() + buffer.size(), ts);
+
+		std::unordered_map<std::string, u32> ids;
+		for (const rlf::Token& tok : ts.tokens)
+		{
+			if (tok.Type != rlf::TokenType::Identifier &&
+				tok.Type != rlf::TokenType::String)
+				continue;
+			// Strings start after their opening quote.
+			const char* start = tok.Location +
+				(tok.Type == rlf::TokenType::String ? 1 : 0);
+			u32 len = ts.strings.Entries[tok.Id].Length;
+			Check(t, strncmp(tok.String, start, len) == 0 && tok.String[len] == '\0',
+				"%s: token at offset %u", SamplePaths[i], (u32)(tok.Location - buffer.data()));
+			auto it = ids.insert(std::make_pair(std::string(start, len), tok.Id));
+			Check(t, it.first->second == tok.Id, "%s: %s has ids %u and %u",
+				SamplePaths[i], tok.String, it.first->second, tok.Id);
+			Check(t, ts.strings.Entries[tok.Id].String == tok.String, "%s: %s",
+				SamplePaths[i], tok.String);
+		}
+		Check(t, ids.size() == ts.strings.EntryCount, "%s: %u strings, %u entries",
+			SamplePaths[i], (u32)ids.size(), ts.strings.EntryCount);
+		rlf::TokenizerStateRelease(ts);
+	}
+}
+
+// Tokens in a and b are the same, with locations relative to their buffers.
+bool SameTokens(const std::vector<rlf::Token>& a, const char* aStart,
+	const std::vector<rlf::Token>& b, const char* bStart)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0 ; i < a.size() ; ++i)
+	{
+		const rlf::Token& x = a[i];
+		const rlf::Token& y = b[i];
+		if (x.Type != y.Type || x.Location - aStart != y.Location - bStart)
+			return false;
+		if ((x.Type == rlf::TokenType::Identifier || x.Type == rlf::TokenType::String) &&
+			strcmp(x.String, y.String) != 0)
+			return false;
+		if (x.Type == rlf::TokenType::IntegerLiteral && x.IntegerLiteral != y.IntegerLiteral)
+			return false;
+		if (x.Type == rlf::TokenType::FloatLiteral &&
+			memcmp(&x.FloatLiteral, &y.FloatLiteral, sizeof(double)) != 0)
+			return false;
+	}
+	return true;
+}
+
+// Parses text with the cache and from scratch, each from its own copy of it
+//	as the buffer moves from one reload to the next. Both have to come out the
+//	same: the same error at the same place, or descriptions which describe
+//	the same. The cache has to hold the tokens a fresh tokenize gives, and no
+//	more than twice as many strings as those use.
+void CheckIncrementalParse(State* t, const char* path, const std::string& text,
+	rlf::ParseCache* cache, u32 edit)
+{
+	std::string dir = DirectoryOf(path);
+	u32 size = (u32)text.size();
+	char* a = (char*)malloc(size + 1);
+	char* b = (char*)malloc(size + 1);
+	memcpy(a, text.data(), size);
+	memcpy(b, text.data(), size);
+
+	rlf::ErrorState esA = {};
+	rlf::ErrorState esB = {};
+	rlf::RenderDescription* rdA = rlf::ParseBuffer(a, size, dir.c_str(), cache, &esA);
+	rlf::RenderDescription* rdB = rlf::ParseBuffer(b, size, dir.c_str(), nullptr, &esB);
+
+	int errorA = esA.Info.Location ? (int)(esA.Info.Location - a) : -1;
+	int errorB = esB.Info.Location ? (int)(esB.Info.Location - b) : -1;
+	Check(t, esA.Success == esB.Success && esA.Info.Message == esB.Info.Message &&
+		errorA == errorB, "%s, edit %u: '%s' at %d, expected '%s' at %d", path, edit,
+		esA.Info.Message.c_str(), errorA, esB.Info.Message.c_str(), errorB);
+	if (rdA && rdB)
+	{
+		std::string descA;
+		std::string descB;
+		Describe(rdA, descA);
+		Describe(rdB, descB);
+		Check(t, descA == descB, "%s, edit %u: descriptions differ", path, edit);
+	}
+
+	if (cache->valid)
+	{
+		rlf::TokenizerState ts;
+		rlf::TokenizerStateInit(ts);
+		rlf::Tokenize(b, b + size, ts);
+		Check(t, SameTokens(cache->ts.tokens, cache->source, ts.tokens, b),
+			"%s, edit %u: tokens differ", path, edit);
+		rlf::TokenizerStateRelease(ts);
+
+		std::unordered_set<u32> live;
+		for (const rlf::Token& token : cache->ts.tokens)
+		{
+			if (token.Type == rlf::TokenType::Identifier ||
+				token.Type == rlf::TokenType::String)
+				live.insert(token.Id);
+		}
+		Check(t, cache->ts.strings.EntryCount <= 2 * live.size(),
+			"%s, edit %u: %u strings interned, %u in use", path, edit,
+			cache->ts.strings.EntryCount, (u32)live.size());
+	}
+
+	if (rdA)
+		rlf::ReleaseData(rdA);
+	if (rdB)
+		rlf::ReleaseData(rdB);
+	free(a);
+	free(b);
+}
+
+// Random edits to each sample, as typed during live editing: inserted
+//	snippets which start or end comments, strings, numbers and blocks,
+//	deletions and changed digits.
+void TestIncrementalParse(State* t)
+{
+	const char* snippets[] = {
+		" ", "\n", "// c\n", "/* x */", "/*", "*/", "1", ".5", "e+", "e-7", "\"", "a",
+		"}", "{", "0x1F", "2.", "//", "Foo", ";", ",",
+	};
+	const u32 snippetCount = sizeof(snippets) / sizeof(snippets[0]);
+	Random r = { 1234 };
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		std::string original;
+		Check(t, ReadWholeFile(SamplePaths[i], original), "%s", SamplePaths[i]);
+		std::string text = original;
+		rlf::ParseCache* cache = rlf::CreateParseCache();
+		for (u32 edit = 0 ; edit < 200 ; ++edit)
+		{
+			size_t pos = NextU32(r) % (text.size() + 1);
+			switch (NextU32(r) % 3)
+			{
+			case 0:
+				text.insert(pos, snippets[NextU32(r) % snippetCount]);
+				break;
+			case 1:
+				text.erase(pos, NextU32(r) % 20);
+				break;
+			default:
+				for (size_t j = pos ; j < text.size() ; ++j)
+				{
+					if (isdigit(text[j]))
+					{
+						text[j] = (char)('0' + NextU32(r) % 10);
+						break;
+					}
+				}
+				break;
+			}
+			if (NextU32(r) % 50 == 0)
+				text = original;
+			CheckIncrementalParse(t, SamplePaths[i], text, cache, edit);
+		}
+		rlf::DestroyParseCache(cache);
+	}
+
+	// Renaming the same constant over and over leaves a dead string behind
+	//	each time.
+	std::string original;
+	Check(t, ReadWholeFile(SamplePaths[0], original), "%s", SamplePaths[0]);
+	rlf::ParseCache* cache = rlf::CreateParseCache();
+	char buf[64];
+	for (u32 edit = 0 ; edit < 1000 ; ++edit)
+	{
+		sprintf_s(buf, 64, "\nconstant float renamed%u = 1.0;\n", edit);
+		CheckIncrementalParse(t, SamplePaths[0], original + buf, cache, edit);
+	}
+	Check(t, cache->ts.strings.EntryCount < 1000, "%u strings interned",
+		cache->ts.strings.EntryCount);
+	rlf::DestroyParseCache(cache);
+}
+
+// Tokenizing with the interned tokenizer against the reference one, and the
+//	whole parse.
+void BenchParse(const BenchArgs& args)
+{
+	std::vector<BenchInput> inputs;
+	GetBenchInputs(args, inputs);
+	const u32 reps = 10;
+	printf("%-40s %10s %22s %22s %11s\n", "", "size", "reference tokenize",
+		"tokenize", "parse");
+	for (const BenchInput& in : inputs)
+	{
+		const char* start = in.Buffer.data();
+		const char* end = start + in.Buffer.size();
+		double mb = (double)in.Buffer.size() / (1024.0 * 1024.0);
+
+		char refResult[32] = "-";
+		try {
+			double refMs = MinTimeMs(reps, [&]() {
+				reference::TokenizerState ts;
+				reference::TokenizerStateInit(ts);
+				reference::Tokenize(start, end, ts);
+			});
+			sprintf_s(refResult, 32, "%8.3f ms %5.0f MB/s", refMs, mb * 1000.0 / refMs);
+		}
+		catch (rlf::ErrorInfo)
+		{
+			// Uses syntax which was added since.
+		}
+
+		double tokMs = MinTimeMs(reps, [&]() {
+			rlf::TokenizerState ts;
+			rlf::TokenizerStateInit(ts);
+			rlf::Tokenize(start, end, ts);
+			rlf::TokenizerStateRelease(ts);
+		});
+
+		std::string dir = DirectoryOf(in.Name.c_str());
+		bool parsed = true;
+		double parseMs = MinTimeMs(reps, [&]() {
+			rlf::ErrorState es = {};
+			rlf::RenderDescription* rd = rlf::ParseBuffer(start, (u32)in.Buffer.size(),
+				dir.c_str(), nullptr, &es);
+			parsed = es.Success;
+			if (rd)
+				rlf::ReleaseData(rd);
+		});
+
+		printf("%-40.40s %7.0f KB %22s %8.3f ms %5.0f MB/s %8.3f ms%s\n", in.Name.c_str(),
+			mb * 1024.0, refResult, tokMs, mb * 1000.0 / tokMs, parseMs,
+			parsed ? "" : " (failed)");
+	}
+}
+
+}
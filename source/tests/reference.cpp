@@ -0,0 +1,417 @@
+namespace reference
+{
+
+// The RLF tokenizer as it was before the shared lexer: it walks one character
+//	at a time, copies every identifier and string into a std::string kept in an
+//	unordered_set and accumulates floats digit by digit. The shader parser had
+//	a copy of it which also took the HLSL punctuation. The lexer benchmarks
+//	compare against it, it isn't expected to agree on anything but the token
+//	types, locations and strings.
+struct Token
+{
+	rlf::TokenType Type;
+	const char* Location;
+	union {
+		const char* String;
+		double FloatLiteral;
+		u32 IntegerLiteral;
+	};
+};
+
+struct TokenizerState {
+	std::vector<Token> tokens;
+	std::unordered_set<std::string> tokenStrings;
+	rlf::TokenType fcLUT[128];
+};
+
+void TokenizerError(const char* loc, const char* str, ...)
+{
+	char buf[512];
+	va_list ptr;
+	va_start(ptr,str);
+	vsprintf_s(buf,512,str,ptr);
+	va_end(ptr);
+
+	rlf::ErrorInfo pe = {};
+	pe.Location = loc;
+	pe.Message = buf;
+
+	throw pe;
+}
+
+#define TokenizerAssert(expression, loc, message, ...) 	\
+do {													\
+	if (!(expression)) {								\
+		TokenizerError(loc, message, ##__VA_ARGS__);	\
+	}													\
+} while (0);											\
+
+void TokenizerStateInit(TokenizerState& ts)
+{
+	using rlf::TokenType;
+	TokenType* fcLUT = ts.fcLUT;
+	for (u32 fc = 0 ; fc < 128 ; ++fc)
+		fcLUT[fc] = TokenType::Invalid;
+	fcLUT['('] = TokenType::LParen;
+	fcLUT[')'] = TokenType::RParen;
+	fcLUT['{'] = TokenType::LBrace;
+	fcLUT['}'] = TokenType::RBrace;
+	fcLUT['['] = TokenType::LBracket;
+	fcLUT[']'] = TokenType::RBracket;
+	fcLUT[','] = TokenType::Comma;
+	fcLUT['='] = TokenType::Equals;
+	fcLUT['+'] = TokenType::Plus;
+	fcLUT['-'] = TokenType::Minus;
+	fcLUT[';'] = TokenType::Semicolon;
+	fcLUT['.'] = TokenType::Period;
+	fcLUT['/'] = TokenType::ForwardSlash;
+	fcLUT['*'] = TokenType::Asterisk;
+	fcLUT['"'] = TokenType::String;
+	for (u32 fc = 0 ; fc < 128 ; ++fc)
+	{
+		if (isalpha(fc))
+			fcLUT[fc] = TokenType::Identifier;
+		else if (isdigit(fc))
+			fcLUT[fc] = TokenType::IntegerLiteral;
+	}
+	fcLUT['_'] = TokenType::Identifier;
+}
+
+const char* SkipWhitespace(const char* next, const char* end)
+{
+	bool checkAgain;
+	do {
+		checkAgain = false;
+		while (next < end && isspace(*next))
+		{
+			++next;
+		}
+		if (next + 1 < end && next[0] == '/')
+		{
+			if (next[1] == '/')
+			{
+				next += 2;
+				while (next < end && *next != '\n')
+					++next;
+				checkAgain = true;
+			}
+			else if (next[1] == '*')
+			{
+				next += 2;
+				while (next + 1 < end)
+				{
+					if (next[0] == '*' && next[1] == '/')
+						break;
+					++next;
+				}
+				TokenizerAssert(next[0] == '*' && next[1] == '/', next,
+					"Closing of comment block was not found before end of file");
+				next += 2;
+				checkAgain = true;
+			}
+		}
+	}
+	while (checkAgain);
+	return next;
+}
+
+void Tokenize(const char* start, const char* end, TokenizerState& ts)
+{
+	using rlf::TokenType;
+	const char* next = SkipWhitespace(start, end);
+
+	while (next < end)
+	{
+		char firstChar = *next;
+
+		TokenType tok = (u8)firstChar < 128 ? ts.fcLUT[(u8)firstChar] :
+			TokenType::Invalid;
+
+		Token token;
+		token.Location = next;
+
+		switch (tok)
+		{
+		case TokenType::LParen:
+		case TokenType::RParen:
+		case TokenType::LBrace:
+		case TokenType::RBrace:
+		case TokenType::LBracket:
+		case TokenType::RBracket:
+		case TokenType::LessThan:
+		case TokenType::GreaterThan:
+		case TokenType::Comma:
+		case TokenType::Equals:
+		case TokenType::Plus:
+		case TokenType::Minus:
+		case TokenType::Colon:
+		case TokenType::Semicolon:
+		case TokenType::At:
+		case TokenType::Period:
+		case TokenType::ForwardSlash:
+		case TokenType::Asterisk:
+		case TokenType::HashMark:
+		case TokenType::Percent:
+			++next;
+			break;
+		case TokenType::IntegerLiteral:
+		{
+			u32 val = 0;
+			while(next < end && isdigit(*next)) {
+				val *= 10;
+				val += (*next - '0');
+				++next;
+			}
+			token.IntegerLiteral = val;
+			if (next < end && *next == '.') {
+				++next;
+				tok = TokenType::FloatLiteral;
+				double floatVal = val;
+				double sub = 0.1;
+				while(next < end && isdigit(*next)) {
+					floatVal += (*next - '0') * sub;
+					sub *= 0.1;
+					++next;
+				}
+				token.FloatLiteral = floatVal;
+			}
+			break;
+		}
+		case TokenType::Identifier:
+		{
+			// identifiers have to start with a letter, but can contain numbers
+			const char* id_begin = next;
+			while (next < end && (isalpha(*next) || isdigit(*next) ||
+				*next == '_'))
+			{
+				++next;
+			}
+			const char* id_end = next;
+			std::string id = std::string(id_begin, id_end);
+			auto insrt = ts.tokenStrings.insert(id);
+			token.String = insrt.first->c_str();
+			break;
+		}
+		case TokenType::String:
+		{
+			++next; // skip over opening quotes
+			const char* str_begin = next;
+			while (next < end && *next != '"') {
+				++next;
+			}
+			TokenizerAssert(next < end, next, "End-of-buffer before closing parenthesis.");
+			const char* str_end = next;
+			++next; // pass the closing quotes
+			std::string str = std::string(str_begin, str_end);
+			auto insrt = ts.tokenStrings.insert(str);
+			token.String = insrt.first->c_str();
+			break;
+		}
+		case TokenType::Invalid:
+		default:
+			TokenizerError(next, "unexpected character when parsing token: %c", firstChar);
+			break;
+		}
+
+		token.Type = tok;
+		ts.tokens.push_back(token);
+
+		next = SkipWhitespace(next, end);
+	}
+	Assert(next == end, "Internal inconsistency, passed the end of the buffer");
+}
+
+#undef TokenizerAssert
+
+// The expression operators and conversions as they were before the kernels:
+//	a switch on the format, over all four lanes. Two conversions are fixed
+//	here as they were in the kernels, int to bool read the bytes of the value
+//	and bools were overwritten by what they converted to before being read.
+void Expand(rlf::ast::Result& res)
+{
+	using rlf::VariableFormat;
+	Assert(res.Type.Fmt != VariableFormat::Float4x4, "Invalid type in expand");
+	if (res.Type.Dim != 1)
+		return;
+	switch (res.Type.Fmt)
+	{
+	case VariableFormat::Bool:
+		res.Value.Bool4Val.w = res.Value.Bool4Val.z = res.Value.Bool4Val.y =
+			res.Value.Bool4Val.x;
+		break;
+	case VariableFormat::Int:
+		res.Value.Int4Val.w = res.Value.Int4Val.z = res.Value.Int4Val.y =
+			res.Value.Int4Val.x;
+		break;
+	case VariableFormat::Uint:
+		res.Value.Uint4Val.w = res.Value.Uint4Val.z = res.Value.Uint4Val.y =
+			res.Value.Uint4Val.x;
+		break;
+	case VariableFormat::Float:
+		res.Value.Float4Val.w = res.Value.Float4Val.z = res.Value.Float4Val.y =
+			res.Value.Float4Val.x;
+		break;
+	default:
+		Unimplemented();
+	}
+}
+
+void Convert(rlf::ast::Result& res, rlf::VariableFormat fmt)
+{
+	using rlf::VariableFormat;
+	if (res.Type.Fmt == fmt)
+		return;
+	const rlf::Variable v = res.Value;
+	rlf::Variable& d = res.Value;
+	if (fmt == VariableFormat::Bool)
+	{
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Int:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Bool4Val.m[i] = v.Int4Val.m[i] != 0;
+			break;
+		case VariableFormat::Uint:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Bool4Val.m[i] = (i32)v.Uint4Val.m[i] != 0;
+			break;
+		case VariableFormat::Float:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Bool4Val.m[i] = (i32)v.Float4Val.m[i] != 0;
+			break;
+		default:
+			Unimplemented();
+		}
+	}
+	else if (fmt == VariableFormat::Int)
+	{
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Bool:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Int4Val.m[i] = v.Bool4Val.m[i] ? 1 : 0;
+			break;
+		case VariableFormat::Uint:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Int4Val.m[i] = (i32)v.Uint4Val.m[i];
+			break;
+		case VariableFormat::Float:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Int4Val.m[i] = (i32)v.Float4Val.m[i];
+			break;
+		default:
+			Unimplemented();
+		}
+	}
+	else if (fmt == VariableFormat::Uint)
+	{
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Bool:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Uint4Val.m[i] = v.Bool4Val.m[i] ? 1 : 0;
+			break;
+		case VariableFormat::Int:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Uint4Val.m[i] = (u32)v.Int4Val.m[i];
+			break;
+		case VariableFormat::Float:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Uint4Val.m[i] = (u32)v.Float4Val.m[i];
+			break;
+		default:
+			Unimplemented();
+		}
+	}
+	else if (fmt == VariableFormat::Float)
+	{
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Bool:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Float4Val.m[i] = v.Bool4Val.m[i] ? 1.f : 0.f;
+			break;
+		case VariableFormat::Int:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Float4Val.m[i] = (float)v.Int4Val.m[i];
+			break;
+		case VariableFormat::Uint:
+			for (u32 i = 0 ; i < 4 ; ++i)
+				d.Float4Val.m[i] = (float)v.Uint4Val.m[i];
+			break;
+		default:
+			Unimplemented();
+		}
+	}
+	res.Type.Fmt = fmt;
+}
+
+void Operator(rlf::ast::BinaryOp::Type op, const rlf::ast::Node* n,
+	const rlf::ast::Result& arg1, const rlf::ast::Result& arg2, rlf::ast::Result& res,
+	rlf::ast::EvaluationError& err)
+{
+	using rlf::VariableFormat;
+	using rlf::ast::BinaryOp;
+	const rlf::Variable& a = arg1.Value;
+	const rlf::Variable& b = arg2.Value;
+	switch (op)
+	{
+	case BinaryOp::Type::Add:
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Float: res.Value.Float4Val = a.Float4Val + b.Float4Val; break;
+		case VariableFormat::Int: res.Value.Int4Val = a.Int4Val + b.Int4Val; break;
+		case VariableFormat::Uint: res.Value.Uint4Val = a.Uint4Val + b.Uint4Val; break;
+		default: Unimplemented();
+		}
+		break;
+	case BinaryOp::Type::Subtract:
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Float: res.Value.Float4Val = a.Float4Val - b.Float4Val; break;
+		case VariableFormat::Int: res.Value.Int4Val = a.Int4Val - b.Int4Val; break;
+		case VariableFormat::Uint: res.Value.Uint4Val = a.Uint4Val - b.Uint4Val; break;
+		default: Unimplemented();
+		}
+		break;
+	case BinaryOp::Type::Multiply:
+		switch (res.Type.Fmt)
+		{
+		case VariableFormat::Float: res.Value.Float4Val = a.Float4Val * b.Float4Val; break;
+		case VariableFormat::Int: res.Value.Int4Val = a.Int4Val * b.Int4Val; break;
+		case VariableFormat::Uint: res.Value.Uint4Val = a.Uint4Val * b.Uint4Val; break;
+		case VariableFormat::Float4x4: res.Value.Float4x4Val = a.Float4x4Val * b.Float4x4Val; break;
+		default: Unimplemented();
+		}
+		break;
+	case BinaryOp::Type::Divide:
+		for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+		{
+			switch (res.Type.Fmt)
+			{
+			case VariableFormat::Int:
+				if (b.Int4Val.m[i] == 0)
+					rlf::ast::Fail(err, rlf::ast::EvaluationErrorCode::DivideByZero, n);
+				else
+					res.Value.Int4Val.m[i] = a.Int4Val.m[i] / b.Int4Val.m[i];
+				break;
+			case VariableFormat::Uint:
+				if (b.Uint4Val.m[i] == 0)
+					rlf::ast::Fail(err, rlf::ast::EvaluationErrorCode::DivideByZero, n);
+				else
+					res.Value.Uint4Val.m[i] = a.Uint4Val.m[i] / b.Uint4Val.m[i];
+				break;
+			case VariableFormat::Float:
+				if (b.Float4Val.m[i] == 0.f)
+					rlf::ast::Fail(err, rlf::ast::EvaluationErrorCode::DivideByZero, n);
+				res.Value.Float4Val.m[i] = a.Float4Val.m[i] / b.Float4Val.m[i];
+				break;
+			default:
+				Unimplemented();
+			}
+		}
+		break;
+	}
+}
+
+} // namespace reference
@@ -0,0 +1,116 @@
+namespace test
+{
+
+// Names share one table whatever they name, redefining one as anything is an
+//	error, and a file full of names parses to all of them.
+void TestSymbols(State* t)
+{
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	rlf += "Sampler {\n\tFilter = { All = Point };\n} twice\n"
+		"Buffer {\n\tElementSize = 4;\n\tElementCount = 4;\n} twice\n";
+	rlf::ErrorState es = {};
+	rlf::RenderDescription* rd = rlf::ParseBuffer(rlf.data(), (u32)rlf.size(), "",
+		nullptr, &es);
+	Check(t, !rd && es.Info.Message == "twice already defined as Sampler", "%s",
+		es.Info.Message.c_str());
+	if (rd)
+		rlf::ReleaseData(rd);
+
+	const u32 groupCount = 2000;
+	std::string named = SyntheticNamedObjects(groupCount);
+	rd = Parse(t, "synthetic", named);
+	if (rd)
+	{
+		// The output texture is one more.
+		Check(t, rd->Textures.Count == groupCount + 1, "%u textures", rd->Textures.Count);
+		Check(t, rd->Views.Count == groupCount, "%u views", rd->Views.Count);
+		Check(t, rd->Samplers.Count == groupCount, "%u samplers", rd->Samplers.Count);
+		Check(t, rd->Buffers.Count == groupCount, "%u buffers", rd->Buffers.Count);
+		Check(t, rd->Constants.Count == groupCount, "%u constants", rd->Constants.Count);
+		for (u32 i = 0 ; i < rd->Views.Count ; ++i)
+		{
+			rlf::View* view = rd->Views.Data[i];
+			Check(t, view->Type == rlf::ViewType::SRV &&
+				view->ResourceType == rlf::ResourceType::Texture &&
+				view->Texture == rd->Textures.Data[i + 1], "view %u", i);
+		}
+		rlf::ReleaseData(rd);
+	}
+}
+
+// The per-kind tables the parser had before the symbol table were keyed on
+//	the string itself.
+struct StringHasher
+{
+	size_t operator()(const char* str) const
+	{
+		return rlf::HashRange(str, (u32)strlen(str));
+	}
+};
+
+struct StringComparer
+{
+	bool operator()(const char* l, const char* r) const { return strcmp(l,r) == 0; }
+};
+
+// Parsing a description with 10000 named objects, and the lookups alone:
+//	every identifier in it resolved through the symbol array indexed by intern
+//	id, against hashing its string into a map as the per-kind tables did.
+void BenchSymbols(const BenchArgs&)
+{
+	const u32 groupCount = 2000;
+	std::string named = SyntheticNamedObjects(groupCount);
+	const char* start = named.data();
+	const char* end = start + named.size();
+
+	bool parsed = true;
+	double parseMs = MinTimeMs(10, [&]() {
+		rlf::ErrorState es = {};
+		rlf::RenderDescription* rd = rlf::ParseBuffer(start, (u32)named.size(), "",
+			nullptr, &es);
+		parsed = es.Success;
+		if (rd)
+			rlf::ReleaseData(rd);
+	});
+
+	rlf::TokenizerState ts;
+	rlf::TokenizerStateInit(ts);
+	rlf::Tokenize(start, end, ts);
+	std::vector<const rlf::Token*> identifiers;
+	for (const rlf::Token& token : ts.tokens)
+	{
+		if (token.Type == rlf::TokenType::Identifier)
+			identifiers.push_back(&token);
+	}
+	std::vector<rlf::Symbol> symbols(ts.strings.EntryCount);
+	std::unordered_map<const char*, rlf::Symbol, StringHasher, StringComparer> map;
+	for (u32 i = 0 ; i < ts.strings.EntryCount ; ++i)
+	{
+		symbols[i].Kind = rlf::SymbolKind::Constant;
+		symbols[i].M = &symbols[i];
+		map[ts.strings.Entries[i].String] = symbols[i];
+	}
+
+	uintptr_t checksum = 0;
+	const u32 reps = 10;
+	double arrayMs = MinTimeMs(reps, [&]() {
+		for (const rlf::Token* token : identifiers)
+			checksum += (uintptr_t)symbols[token->Id].M;
+	});
+	double mapMs = MinTimeMs(reps, [&]() {
+		for (const rlf::Token* token : identifiers)
+			checksum += (uintptr_t)map.find(token->String)->second.M;
+	});
+	rlf::TokenizerStateRelease(ts);
+
+	u32 lookups = (u32)identifiers.size();
+	printf("%u named objects, %.0f KB: parse %.3f ms%s (checksum %llx)\n",
+		groupCount * 5, (double)named.size() / 1024.0, parseMs,
+		parsed ? "" : " (failed)", (unsigned long long)checksum);
+	printf("%u identifier lookups\n", lookups);
+	printf("by intern id   %8.3f ms %6.1f ns each\n", arrayMs, arrayMs * 1e6 / lookups);
+	printf("by string hash %8.3f ms %6.1f ns each\n", mapMs, mapMs * 1e6 / lookups);
+}
+
+}
@@ -0,0 +1,380 @@
+namespace test
+{
+
+// Generated descriptions for the benchmarks, larger than any of the samples.
+//	Each also declares the texture it outputs so it's a complete description.
+
+void AppendOutputTexture(std::string& rlf)
+{
+	rlf +=
+		"Texture {\n"
+		"\tFormat = R8G8B8A8_UNORM;\n"
+		"\tSize = DisplaySize();\n"
+		"\tFlags = { UAV, SRV };\n"
+		"} RT\n\n"
+		"output RT\n\n";
+}
+
+// bufferCount vertex buffers with floatCount floats of InitData each, almost
+//	all of it float literals.
+std::string SyntheticInitData(u32 bufferCount, u32 floatCount)
+{
+	Random r = { 0x9e3779b97f4a7c15ull };
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	char buf[64];
+	for (u32 i = 0 ; i < bufferCount ; ++i)
+	{
+		sprintf_s(buf, 64, "Buffer {\n\tElementSize = 4;\n\tElementCount = %u;\n", floatCount);
+		rlf += buf;
+		rlf += "\tFlags = { Vertex };\n\tInitData = float { ";
+		for (u32 j = 0 ; j < floatCount ; ++j)
+		{
+			sprintf_s(buf, 64, j ? ", %f" : "%f", NextFloat(r, -100.0f, 100.0f));
+			rlf += buf;
+		}
+		sprintf_s(buf, 64, " };\n} buf%u\n\n", i);
+		rlf += buf;
+	}
+	return rlf;
+}
+
+// A chain of constantCount constants with long names, each using the ones
+//	before it, so it's mostly identifiers and expressions.
+std::string SyntheticConstants(u32 constantCount)
+{
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	rlf += "constant float someLongConstantName_0 = 1.0;\n";
+	char buf[256];
+	for (u32 i = 1 ; i < constantCount ; ++i)
+	{
+		sprintf_s(buf, 256, "constant float someLongConstantName_%u = "
+			"someLongConstantName_%u * 2.0 + max(someLongConstantName_%u, 1.0);\n",
+			i, i-1, i/2);
+		rlf += buf;
+	}
+	return rlf;
+}
+
+// lineCount lines of mostly comments and indentation, with a constant every
+//	few lines.
+std::string SyntheticComments(u32 lineCount)
+{
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	char buf[128];
+	for (u32 i = 0 ; i < lineCount ; i += 4)
+	{
+		rlf += "\t\t// What the constant below is for, at about the length of a line.\n";
+		rlf += "\t\t/* And a block comment which\n\t\t   carries on for a second line. */\n";
+		sprintf_s(buf, 128, "constant float commented_%u = %u.5;\n\n", i, i);
+		rlf += buf;
+	}
+	return rlf;
+}
+
+// The shaders the samples use, repeated until there are at least byteCount
+//	bytes of them. Only the ones the shader parser can tokenize are used, it
+//	doesn't take all of HLSL.
+std::string SyntheticShaders(u32 byteCount)
+{
+	std::string shaders;
+	std::string file;
+	for (u32 i = 0 ; i < ShaderCount ; ++i)
+	{
+		if (!ReadWholeFile(ShaderPaths[i], file))
+			continue;
+		rlf::TokenizerState ts;
+		rlf::TokenizerStateInit(ts);
+		EnableShaderTokens(ts.fcLUT);
+		try {
+			rlf::Tokenize(file.data(), file.data() + file.size(), ts);
+			shaders += file + "\n";
+		}
+		catch (rlf::ErrorInfo)
+		{
+		}
+		rlf::TokenizerStateRelease(ts);
+	}
+	std::string hlsl;
+	while (!shaders.empty() && hlsl.size() < byteCount)
+		hlsl += shaders;
+	return hlsl;
+}
+
+// groupCount each of textures, views of them, samplers, buffers and the
+//	constants the buffers are sized by, so five named objects per group, all
+//	referring to each other by name.
+std::string SyntheticNamedObjects(u32 groupCount)
+{
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	char buf[512];
+	for (u32 i = 0 ; i < groupCount ; ++i)
+	{
+		sprintf_s(buf, 512,
+			"constant uint count_%u = %u;\n"
+			"Texture {\n\tFormat = R8G8B8A8_UNORM;\n\tSize = { 64, 64 };\n"
+			"\tFlags = { SRV };\n} tex_%u\n"
+			"SRV {\n\tResource = tex_%u;\n\tFormat = R8G8B8A8_UNORM;\n} srv_%u\n"
+			"Sampler {\n\tFilter = { All = Point };\n\tAddressMode = { UVW = Clamp };\n"
+			"} sampler_%u\n"
+			"Buffer {\n\tElementSize = 4;\n\tElementCount = count_%u;\n"
+			"\tFlags = { Structured };\n} buffer_%u\n\n",
+			i, 16 + i, i, i, i, i, i, i);
+		rlf += buf;
+	}
+	return rlf;
+}
+
+// drawCount draws of the same shaders, each setting a few constants which
+//	animate with time from its own starting values, as a scene of many
+//	objects would.
+std::string SyntheticDraws(u32 drawCount)
+{
+	Random r = { 0x2545f4914f6cdd1dull };
+	std::string rlf;
+	AppendOutputTexture(rlf);
+	rlf +=
+		"tuneable float Speed = 1.5;\n"
+		"tuneable float4 Tint = 1, 0.5, 0.25, 1;\n"
+		"VertexShader {\n\tShaderPath = \"vertex.hlsl\";\n\tEntryPoint = \"VSMain\";\n} vs\n"
+		"PixelShader {\n\tShaderPath = \"pixel.hlsl\";\n\tEntryPoint = \"PSMain\";\n} ps\n\n";
+	char buf[1024];
+	for (u32 i = 0 ; i < drawCount ; ++i)
+	{
+		float phase = NextFloat(r, 0.0f, 6.28f);
+		float x = NextFloat(r, -50.0f, 50.0f);
+		float z = NextFloat(r, -50.0f, 50.0f);
+		sprintf_s(buf, 1024,
+			"Draw {\n\tTopology = TriList;\n\tVShader = vs;\n\tPShader = ps;\n"
+			"\tVertexCount = 36;\n\tRenderTarget = RT;\n"
+			"\tSetConstantVs Offset = { %f + Sin(Time() * Speed + %f), 0, %f, 1 };\n"
+			"\tSetConstantVs ViewProjection = Projection(0.9, DisplaySize().x / "
+			"Float(DisplaySize().y), 0.1, 100) * LookAt({ Sin(Time() + %f) * 3, 1, -3 }, "
+			"{ %f, 0, %f });\n"
+			"\tSetConstantPs Color = Lerp(Tint, { 1, 1, 1, 1 }, Saturate(Sin(Time() + %f)));\n"
+			"\tSetConstantPs Tiles = DivRoundUp(DisplaySize(), %u);\n"
+			"} draw_%u\n\n",
+			x, phase, z, phase, x, z, phase, 8 + NextU32(r) % 57, i);
+		rlf += buf;
+	}
+	rlf += "Passes {\n";
+	for (u32 i = 0 ; i < drawCount ; ++i)
+	{
+		sprintf_s(buf, 1024, i ? ",\n\tdraw_%u" : "\tdraw_%u", i);
+		rlf += buf;
+	}
+	rlf += "\n}\n";
+	return rlf;
+}
+
+// Random expressions over tuneables of every type, for comparing ways of
+//	evaluating them. They're generated without regard for types, so only the
+//	ones which parse on their own are kept.
+struct TuneableDef
+{
+	const char* Type;
+	const char* Name;
+	const char* Value;
+};
+
+const TuneableDef ExpressionTuneables[] = {
+	{ "int", "Ti", "3" },
+	{ "int2", "Ti2", "1, -2" },
+	{ "int3", "Ti3", "1, 2, 3" },
+	{ "int4", "Ti4", "4, 3, 2, 1" },
+	{ "uint", "Tu", "2" },
+	{ "uint2", "Tu2", "5, 6" },
+	{ "uint3", "Tu3", "1, 2, 0" },
+	{ "uint4", "Tu4", "1, 2, 3, 4" },
+	{ "float", "Tf", "1.5" },
+	{ "float2", "Tf2", "1, 2" },
+	{ "float3", "Tf3", "1, 2, 3" },
+	{ "float4", "Tf4", "1, 2, 3, 4" },
+	{ "bool", "Tb", "true" },
+};
+const u32 ExpressionTuneableCount = sizeof(ExpressionTuneables) / sizeof(ExpressionTuneables[0]);
+
+struct FunctionDef
+{
+	const char* Name;
+	u32 ArgCount;
+};
+
+const FunctionDef ExpressionFunctions[] = {
+	{ "Int", 1 }, { "Int2", 2 }, { "Int3", 3 }, { "Int4", 4 },
+	{ "Uint", 1 }, { "Uint2", 2 }, { "Uint3", 3 }, { "Uint4", 4 },
+	{ "Float", 1 }, { "Float2", 2 }, { "Float3", 3 }, { "Float4", 4 },
+	{ "Sin", 1 }, { "Cos", 1 }, { "Min", 2 }, { "Max", 2 }, { "Clamp", 3 },
+	{ "Saturate", 1 }, { "Lerp", 3 }, { "Dot", 2 }, { "Cross", 2 }, { "Length", 1 },
+	{ "Normalize", 1 }, { "DivRoundUp", 2 }, { "Inverse", 1 }, { "Transpose", 1 },
+	{ "Mul", 2 }, { "LookAt", 2 }, { "Projection", 4 }, { "ProjectionReverseZ", 4 },
+	{ "Orthographic", 4 }, { "OrthographicReverseZ", 4 },
+	// Function names aren't case sensitive.
+	{ "float", 1 }, { "FLOAT3", 3 }, { "mIn", 2 },
+};
+const u32 ExpressionFunctionCount = sizeof(ExpressionFunctions) / sizeof(ExpressionFunctions[0]);
+
+const char* ExpressionTypes[] = {
+	"int", "int2", "int3", "int4", "uint", "uint2", "uint3", "uint4",
+	"float", "float2", "float3", "float4", "float4x4", "bool",
+};
+const u32 ExpressionTypeCount = sizeof(ExpressionTypes) / sizeof(ExpressionTypes[0]);
+
+template <typename T, u32 N>
+const T& Pick(Random& r, const T (&values)[N])
+{
+	return values[NextU32(r) % N];
+}
+
+void AppendExpression(Random& r, u32 depth, std::string& out)
+{
+	u32 roll = NextU32(r) % 100;
+	if (depth == 0 || roll < 25)
+	{
+		static const char* leaves[] = {
+			"0", "1", "2", "3", "7", "100", "-1", "-5", "0.5", "1.0", "0.0", "2.25",
+			"3.14159", "-1.5", "1e10", "4294967295", "2147483647", "Time()",
+			"DisplaySize()", "PV",
+		};
+		if (NextU32(r) % 2)
+			out += Pick(r, leaves);
+		else
+			out += ExpressionTuneables[NextU32(r) % ExpressionTuneableCount].Name;
+		return;
+	}
+	roll = NextU32(r) % 100;
+	if (roll < 35)
+	{
+		static const char* ops[] = { " + ", " - ", " * ", " / " };
+		AppendExpression(r, depth - 1, out);
+		out += Pick(r, ops);
+		AppendExpression(r, depth - 1, out);
+	}
+	else if (roll < 45)
+	{
+		out += "(";
+		AppendExpression(r, depth - 1, out);
+		out += ")";
+	}
+	else if (roll < 50)
+	{
+		out += "-";
+		AppendExpression(r, depth - 1, out);
+	}
+	else if (roll < 55)
+	{
+		out += "(";
+		AppendExpression(r, depth - 1, out);
+		out += ").";
+		u32 lanes = 1 + NextU32(r) % 4;
+		for (u32 i = 0 ; i < lanes ; ++i)
+			out += "xyzwrgba"[NextU32(r) % 8];
+	}
+	else if (roll < 65)
+	{
+		out += "{ ";
+		u32 count = 1 + NextU32(r) % 4;
+		for (u32 i = 0 ; i < count ; ++i)
+		{
+			if (i)
+				out += ", ";
+			AppendExpression(r, depth - 1, out);
+		}
+		out += " }";
+	}
+	else
+	{
+		const FunctionDef& func = ExpressionFunctions[NextU32(r) % ExpressionFunctionCount];
+		u32 argCount = func.ArgCount;
+		// Now and then the wrong number of them.
+		if (NextU32(r) % 20 == 0)
+			argCount = NextU32(r) % 2 ? argCount + 1 : argCount - 1;
+		out += func.Name;
+		out += "(";
+		for (u32 i = 0 ; i < argCount ; ++i)
+		{
+			if (i)
+				out += ", ";
+			AppendExpression(r, depth - 1, out);
+		}
+		out += ")";
+	}
+}
+
+// count constants with random expressions, each of which type checks.
+std::string SyntheticExpressions(u32 count, u64 seed)
+{
+	std::string header;
+	AppendOutputTexture(header);
+	for (const TuneableDef& tune : ExpressionTuneables)
+		header += std::string("tuneable ") + tune.Type + " " + tune.Name + " = " +
+			tune.Value + ";\n";
+	header += "constant float4x4 PV = Projection(0.9, 1.7, 0.1, 100) * "
+		"LookAt({ 0, 1, -3 }, { 0, 0, 0 });\n";
+
+	Random r = { seed };
+	std::string rlf = header;
+	std::string candidate;
+	char buf[64];
+	for (u32 i = 0 ; i < count ; )
+	{
+		sprintf_s(buf, 64, "constant %s C%u = ", Pick(r, ExpressionTypes), i);
+		candidate = buf;
+		AppendExpression(r, 1 + NextU32(r) % 5, candidate);
+		candidate += ";\n";
+
+		std::string probe = header + candidate;
+		rlf::ErrorState es = {};
+		rlf::RenderDescription* rd = rlf::ParseBuffer(probe.data(), (u32)probe.size(),
+			"", nullptr, &es);
+		if (rd)
+		{
+			rlf::ReleaseData(rd);
+			rlf += candidate;
+			++i;
+		}
+	}
+	return rlf;
+}
+
+struct BenchInput
+{
+	std::string Name;
+	std::string Buffer;
+};
+
+// The files named in args, or all of the samples followed by large synthetic
+//	descriptions.
+void GetBenchInputs(const BenchArgs& args, std::vector<BenchInput>& out)
+{
+	BenchInput in;
+	if (args.Count > 0)
+	{
+		for (int i = 0 ; i < args.Count ; ++i)
+		{
+			in.Name = args.Values[i];
+			if (ReadWholeFile(args.Values[i], in.Buffer))
+				out.push_back(in);
+			else
+				printf("Couldn't read %s\n", args.Values[i]);
+		}
+		return;
+	}
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		in.Name = SamplePaths[i];
+		if (ReadWholeFile(SamplePaths[i], in.Buffer))
+			out.push_back(in);
+	}
+	in.Name = "synthetic: 20 x 20000 InitData floats";
+	in.Buffer = SyntheticInitData(20, 20000);
+	out.push_back(in);
+	in.Name = "synthetic: 30000 constants";
+	in.Buffer = SyntheticConstants(30000);
+	out.push_back(in);
+}
+
+}
@@ -0,0 +1,350 @@
+// Counted before the CRT sees them, they all end up in malloc.
+static std::atomic<u64> GNewCount;
+
+void* operator new(size_t size)
+{
+	++GNewCount;
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace test
+{
+
+#if defined(_DEBUG) && defined(_MSC_VER)
+static std::atomic<u64> GCrtAllocCount;
+
+int CountCrtAllocation(int allocType, void*, size_t, int, long,
+	const unsigned char*, int)
+{
+	if (allocType != _HOOK_FREE)
+		++GCrtAllocCount;
+	return TRUE;
+}
+#endif
+
+void InitAllocationCount()
+{
+#if defined(_DEBUG) && defined(_MSC_VER)
+	_CrtSetAllocHook(CountCrtAllocation);
+#endif
+}
+
+u64 AllocationCount()
+{
+#if defined(_DEBUG) && defined(_MSC_VER)
+	return GCrtAllocCount;
+#else
+	return GNewCount;
+#endif
+}
+
+void CheckFailed(State* t, const char* file, int line, const char* str, ...)
+{
+	char buf[1024];
+	va_list ptr;
+	va_start(ptr,str);
+	vsprintf_s(buf,1024,str,ptr);
+	va_end(ptr);
+
+	++t->Failures;
+	printf("%s@%d: [%s] %s\n", file, line, t->Name, buf);
+}
+
+i64 ReadCounter()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+double ElapsedMs(i64 start, i64 end)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return (double)(end - start) * 1000.0 / (double)frequency.QuadPart;
+}
+
+bool ReadWholeFile(const char* path, std::string& out)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	out.resize((size_t)size);
+	size_t read = size > 0 ? fread(&out[0], 1, (size_t)size, f) : 0;
+	fclose(f);
+	return read == (size_t)size;
+}
+
+std::string DirectoryOf(const char* path)
+{
+	std::string str = path;
+	size_t pos = str.find_last_of("/\\");
+	return pos == std::string::npos ? std::string() : str.substr(0, pos+1);
+}
+
+rlf::RenderDescription* Parse(State* t, const char* path, const std::string& buffer)
+{
+	std::string dir = DirectoryOf(path);
+	rlf::ErrorState es = {};
+	rlf::RenderDescription* rd = rlf::ParseBuffer(buffer.data(), (u32)buffer.size(),
+		dir.c_str(), nullptr, &es);
+	if (t)
+		Check(t, es.Success, "%s: %s", path, es.Info.Message.c_str());
+	return es.Success ? rd : nullptr;
+}
+
+void Appendf(std::string& out, const char* str, ...)
+{
+	char buf[1024];
+	va_list ptr;
+	va_start(ptr,str);
+	vsprintf_s(buf,1024,str,ptr);
+	va_end(ptr);
+	out += buf;
+}
+
+void DescribeResult(const rlf::ast::Result& res, std::string& out)
+{
+	Appendf(out, "%s%u[", rlf::TypeFmtToString(res.Type.Fmt), res.Type.Dim);
+	const u8* bytes = (const u8*)&res.Value;
+	for (u32 i = 0 ; i < res.Type.Dim ; ++i)
+	{
+		if (res.Type.Fmt == rlf::VariableFormat::Bool)
+			Appendf(out, " %u", bytes[i]);
+		else if (res.Type.Fmt == rlf::VariableFormat::Float ||
+				res.Type.Fmt == rlf::VariableFormat::Float4x4)
+			Appendf(out, " %g", ((const float*)bytes)[i]);
+		else
+			Appendf(out, " %u", ((const u32*)bytes)[i]);
+	}
+	out += " ]";
+}
+
+void DescribeExpression(const char* name, rlf::ast::Expression& expr, std::string& out)
+{
+	if (!expr.IsValid())
+	{
+		Appendf(out, "  %s: none\n", name);
+		return;
+	}
+	rlf::ast::EvaluationContext ec = {};
+	ec.DisplaySize = { 1280, 720 };
+	ec.Time = 1.5f;
+	rlf::ast::Result res;
+	rlf::ast::EvaluationError err;
+	Appendf(out, "  %s varies by %u: ", name, expr.Dep.VariesByFlags);
+	if (rlf::ast::Evaluate(ec, expr, res, err))
+		DescribeResult(res, out);
+	else
+		Appendf(out, "error %s", rlf::ast::FormatError(err).Message.c_str());
+	out += "\n";
+}
+
+void DescribeSetConstants(rlf::Array<rlf::SetConstant>& sets, std::string& out)
+{
+	for (rlf::SetConstant& sc : sets)
+		DescribeExpression(sc.VariableName, sc.Value, out);
+}
+
+void Describe(rlf::RenderDescription* rd, std::string& out)
+{
+	using namespace rlf;
+	for (Tuneable* tune : rd->Tuneables)
+	{
+		ast::Result res;
+		res.Type = tune->Type;
+		res.Value = tune->Value;
+		Appendf(out, "tuneable %s ", tune->Name);
+		DescribeResult(res, out);
+		out += "\n";
+	}
+	for (Constant* cnst : rd->Constants)
+		DescribeExpression(cnst->Name, cnst->Expr, out);
+	for (Pass& pass : rd->Passes)
+		Appendf(out, "pass %s %d\n", pass.Name ? pass.Name : "-", (int)pass.Type);
+	for (Buffer* buf : rd->Buffers)
+	{
+		u32 sum = 0;
+		for (u32 i = 0 ; i < buf->InitDataSize ; ++i)
+			sum = sum * 31 + ((const u8*)buf->InitData)[i];
+		Appendf(out, "buffer %u x %u, %u bytes of init data summing to %08x, flags %d\n",
+			buf->ElementSize, buf->ElementCount, buf->InitDataSize, sum, buf->Flags);
+		DescribeExpression("ElementSize", buf->ElementSizeExpr, out);
+		DescribeExpression("ElementCount", buf->ElementCountExpr, out);
+	}
+	for (Texture* tex : rd->Textures)
+	{
+		Appendf(out, "texture format %d from %s, flags %d\n", (int)tex->Format,
+			tex->FromFile ? tex->FromFile : "-", tex->Flags);
+		DescribeExpression("Size", tex->SizeExpr, out);
+	}
+	for (Sampler* s : rd->Samplers)
+		Appendf(out, "sampler %g %g %g %u\n", s->MipLODBias, s->MinLOD, s->MaxLOD,
+			s->MaxAnisotropy);
+	for (RasterizerState* rs : rd->RasterizerStates)
+		Appendf(out, "rasterizer state %g %g %d\n", rs->SlopeScaledDepthBias,
+			rs->DepthBiasClamp, rs->DepthBias);
+	for (Dispatch* dc : rd->Dispatches)
+	{
+		Appendf(out, "dispatch %s %s\n", dc->Shader->Common.ShaderPath,
+			dc->Shader->Common.EntryPoint);
+		DescribeExpression("Groups", dc->Groups, out);
+		for (Bind& bind : dc->Binds)
+			Appendf(out, "  bind %s\n", bind.BindTarget);
+		DescribeSetConstants(dc->Constants, out);
+	}
+	for (Draw* dc : rd->Draws)
+	{
+		Appendf(out, "draw %u vertices %u instances %s %s\n", dc->VertexCount,
+			dc->InstanceCount, dc->VShader ? dc->VShader->Common.EntryPoint : "-",
+			dc->PShader ? dc->PShader->Common.EntryPoint : "-");
+		for (Viewport* vp : dc->Viewports)
+		{
+			DescribeExpression("TopLeft", vp->TopLeft, out);
+			DescribeExpression("Size", vp->Size, out);
+			DescribeExpression("DepthRange", vp->DepthRange, out);
+		}
+		for (Bind& bind : dc->VSBinds)
+			Appendf(out, "  vs bind %s\n", bind.BindTarget);
+		for (Bind& bind : dc->PSBinds)
+			Appendf(out, "  ps bind %s\n", bind.BindTarget);
+		DescribeSetConstants(dc->VSConstants, out);
+		DescribeSetConstants(dc->PSConstants, out);
+	}
+	for (SizeOfRequest& req : rd->SizeOfRequests)
+		Appendf(out, "sizeof %s\n", req.Dest->StructName);
+}
+
+// Sponza isn't one of them, its model isn't checked in.
+const char* SamplePaths[] = {
+	"samples/ColorChecker/main.rlf",
+	"samples/ComputeToDraw/main.rlf",
+	"samples/FullScreenCompute/main.rlf",
+	"samples/ReverseZ/main.rlf",
+	"samples/ShadowSampling/main.rlf",
+	"samples/ShadowVolumes/main.rlf",
+	"samples/VertexCompute/main.rlf",
+	"samples/simple/blendstate/main.rlf",
+	"samples/simple/buffer/main.rlf",
+	"samples/simple/dispatchindirect/alt_raw.rlf",
+	"samples/simple/dispatchindirect/main.rlf",
+	"samples/simple/draw/main.rlf",
+	"samples/simple/drawindexed/main.rlf",
+	"samples/simple/drawindirect/main.rlf",
+	"samples/simple/drawinstanced/main.rlf",
+	"samples/simple/model/main.rlf",
+	"samples/simple/mrt/main.rlf",
+	"samples/simple/msaa/alt.rlf",
+	"samples/simple/msaa/main.rlf",
+	"samples/simple/obj/main.rlf",
+	"samples/simple/sampler/main.rlf",
+	"samples/simple/stencil/main.rlf",
+	"samples/simple/texture/main.rlf",
+	"samples/simple/viewport/main.rlf",
+};
+const u32 SampleCount = sizeof(SamplePaths) / sizeof(SamplePaths[0]);
+
+const char* ShaderPaths[] = {
+	"samples/ColorChecker/shader.hlsl",
+	"samples/ComputeToDraw/pixel.hlsl",
+	"samples/ComputeToDraw/producer.hlsl",
+	"samples/ComputeToDraw/vertex.hlsl",
+	"samples/FullScreenCompute/shader.hlsl",
+	"samples/ReverseZ/shader.hlsl",
+	"samples/ShadowSampling/shaders.hlsl",
+	"samples/ShadowVolumes/shaders.hlsl",
+	"samples/Sponza/main.hlsl",
+	"samples/Sponza/shadow.hlsl",
+	"samples/VertexCompute/pixel.hlsl",
+	"samples/VertexCompute/shaders.hlsl",
+	"samples/VertexCompute/vertex.hlsl",
+	"samples/simple/blendstate/pixel.hlsl",
+	"samples/simple/blendstate/vertex.hlsl",
+	"samples/simple/buffer/consumer.hlsl",
+	"samples/simple/buffer/producer.hlsl",
+	"samples/simple/dispatchindirect/alt_raw.hlsl",
+	"samples/simple/dispatchindirect/main.hlsl",
+	"samples/simple/draw/pixel.hlsl",
+	"samples/simple/draw/vertex.hlsl",
+	"samples/simple/drawindexed/pixel.hlsl",
+	"samples/simple/drawindexed/vertex.hlsl",
+	"samples/simple/drawindirect/shaders.hlsl",
+	"samples/simple/drawinstanced/pixel.hlsl",
+	"samples/simple/drawinstanced/vertex.hlsl",
+	"samples/simple/model/pixel.hlsl",
+	"samples/simple/model/vertex.hlsl",
+	"samples/simple/mrt/copytexture.hlsl",
+	"samples/simple/mrt/pixel.hlsl",
+	"samples/simple/mrt/vertex.hlsl",
+	"samples/simple/msaa/copytexture.hlsl",
+	"samples/simple/msaa/pixel.hlsl",
+	"samples/simple/msaa/vertex.hlsl",
+	"samples/simple/obj/pixel.hlsl",
+	"samples/simple/obj/vertex.hlsl",
+	"samples/simple/sampler/consumer.hlsl",
+	"samples/simple/sampler/producer.hlsl",
+	"samples/simple/stencil/other.hlsl",
+	"samples/simple/stencil/vertex.hlsl",
+	"samples/simple/texture/consumer.hlsl",
+	"samples/simple/texture/producer.hlsl",
+	"samples/simple/viewport/pixel.hlsl",
+	"samples/simple/viewport/vertex.hlsl",
+};
+const u32 ShaderCount = sizeof(ShaderPaths) / sizeof(ShaderPaths[0]);
+
+void EnableShaderTokens(rlf::TokenType* fcLUT)
+{
+	fcLUT['<'] = rlf::TokenType::LessThan;
+	fcLUT['>'] = rlf::TokenType::GreaterThan;
+	fcLUT[':'] = rlf::TokenType::Colon;
+	fcLUT['@'] = rlf::TokenType::At;
+	fcLUT['#'] = rlf::TokenType::HashMark;
+	fcLUT['%'] = rlf::TokenType::Percent;
+}
+
+u32 NextU32(Random& r)
+{
+	// xorshift64*
+	r.Seed ^= r.Seed >> 12;
+	r.Seed ^= r.Seed << 25;
+	r.Seed ^= r.Seed >> 27;
+	return (u32)((r.Seed * 2685821657736338717ull) >> 32);
+}
+
+float NextFloat(Random& r, float lo, float hi)
+{
+	return lo + (hi - lo) * (float)(NextU32(r) >> 8) / (float)(1 << 24);
+}
+
+}
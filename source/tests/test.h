@@ -0,0 +1,92 @@
+namespace test
+{
+
+// Tests check what the rlf core produces and fail the run when a check does,
+//	benchmarks only report timings. Both are run from the repository root, the
+//	paths they default to are relative to it.
+struct State
+{
+	const char* Name;
+	u32 Checks;
+	u32 Failures;
+};
+
+void CheckFailed(State* t, const char* file, int line, const char* str, ...);
+
+#define Check(t, expression, message, ...) 					\
+do {														\
+	++(t)->Checks;											\
+	__pragma(warning(suppress:4127))						\
+	if (!(expression)) {									\
+		test::CheckFailed(t, __FILE__, __LINE__, 			\
+			"%s: " message, #expression, ##__VA_ARGS__);	\
+	}														\
+	__pragma(warning(default:4127))							\
+} while (0);												\
+
+// Arguments after the benchmark name, usually files to run it on.
+struct BenchArgs
+{
+	int Count;
+	char** Values;
+};
+
+// Performance counter readings.
+i64 ReadCounter();
+double ElapsedMs(i64 start, i64 end);
+
+// Runs f reps times and returns the fastest run in milliseconds, the one
+//	least disturbed by everything else going on.
+template <typename F>
+double MinTimeMs(u32 reps, F&& f)
+{
+	double best = 1e30;
+	for (u32 i = 0 ; i < reps ; ++i)
+	{
+		i64 start = ReadCounter();
+		f();
+		best = min(best, ElapsedMs(start, ReadCounter()));
+	}
+	return best;
+}
+
+// Heap allocations made since the process started, through operator new or,
+//	in debug builds which have the CRT allocation hook, malloc. Counting starts
+//	with InitAllocationCount.
+void InitAllocationCount();
+u64 AllocationCount();
+
+// The whole file, nul terminated, or false if it couldn't be opened.
+bool ReadWholeFile(const char* path, std::string& out);
+// Up to and including the last slash, what ParseBuffer takes as workingDir.
+std::string DirectoryOf(const char* path);
+
+// Parses from scratch, reporting a failed parse as a failed check when t is
+//	set. The description points into buffer, which has to outlive it.
+rlf::RenderDescription* Parse(State* t, const char* path, const std::string& buffer);
+
+// A listing of what a description holds and what its expressions evaluate
+//	to, for comparing descriptions which were made differently.
+void Describe(rlf::RenderDescription* rd, std::string& out);
+
+// The sample descriptions, in a fixed order.
+extern const char* SamplePaths[];
+extern const u32 SampleCount;
+// The shaders the samples use.
+extern const char* ShaderPaths[];
+extern const u32 ShaderCount;
+
+// Lets a tokenizer's first character table through the punctuation which
+//	HLSL has on top of RLF, as the shader parser does.
+void EnableShaderTokens(rlf::TokenType* fcLUT);
+
+// Deterministic, so synthetic inputs are the same from run to run. Seed
+//	mustn't be zero.
+struct Random
+{
+	u64 Seed;
+};
+u32 NextU32(Random& r);
+float NextFloat(Random& r, float lo, float hi);
+
+}
@@ -0,0 +1,85 @@
+namespace test
+{
+
+// What parsing a sample or shader came to, as text: the description or the
+//	struct sizes, or the error.
+std::string ParseToString(const char* path, const std::string& buffer, bool shader)
+{
+	std::string out;
+	rlf::ErrorState es = {};
+	if (shader)
+	{
+		std::unordered_map<std::string, u32> structSizes;
+		rlf::shader::ParseBuffer(buffer.data(), (u32)buffer.size(), structSizes, &es);
+		std::vector<std::pair<std::string, u32>> sorted(structSizes.begin(),
+			structSizes.end());
+		std::sort(sorted.begin(), sorted.end());
+		for (const auto& entry : sorted)
+			Appendf(out, "struct %s %u\n", entry.first.c_str(), entry.second);
+	}
+	else
+	{
+		std::string dir = DirectoryOf(path);
+		rlf::RenderDescription* rd = rlf::ParseBuffer(buffer.data(), (u32)buffer.size(),
+			dir.c_str(), nullptr, &es);
+		if (rd)
+		{
+			Describe(rd, out);
+			rlf::ReleaseData(rd);
+		}
+	}
+	if (!es.Success)
+	{
+		Appendf(out, "error at %d: %s\n", es.Info.Location ?
+			(int)(es.Info.Location - buffer.data()) : -1, es.Info.Message.c_str());
+	}
+	return out;
+}
+
+// Every sample and shader parsed on several threads at once, each thread
+//	starting at a different file, has to come out as it does on one.
+void TestThreadedParse(State* t)
+{
+	struct Input
+	{
+		const char* Path;
+		std::string Buffer;
+		bool Shader;
+		std::string Serial;
+	};
+	std::vector<Input> inputs;
+	Input in;
+	for (u32 i = 0 ; i < SampleCount + ShaderCount ; ++i)
+	{
+		in.Shader = i >= SampleCount;
+		in.Path = in.Shader ? ShaderPaths[i - SampleCount] : SamplePaths[i];
+		Check(t, ReadWholeFile(in.Path, in.Buffer), "%s", in.Path);
+		in.Serial = ParseToString(in.Path, in.Buffer, in.Shader);
+		inputs.push_back(in);
+	}
+
+	const u32 threadCount = 8;
+	const u32 iterations = 4;
+	std::vector<u32> mismatches(threadCount, 0);
+	std::vector<std::thread> threads;
+	for (u32 i = 0 ; i < threadCount ; ++i)
+	{
+		threads.emplace_back([&inputs, &mismatches, i]() {
+			for (u32 iter = 0 ; iter < iterations ; ++iter)
+			{
+				for (size_t k = 0 ; k < inputs.size() ; ++k)
+				{
+					const Input& input = inputs[(k + i) % inputs.size()];
+					if (ParseToString(input.Path, input.Buffer, input.Shader) != input.Serial)
+						++mismatches[i];
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	for (u32 i = 0 ; i < threadCount ; ++i)
+		Check(t, mismatches[i] == 0, "thread %u: %u parses differ from serial ones", i, mismatches[i]);
+}
+
+}
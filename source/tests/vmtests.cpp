@@ -0,0 +1,266 @@
+namespace test
+{
+
+// Parses a description to evaluate on its own, with the sizes InitD3D would
+//	get from the shaders filled in.
+rlf::RenderDescription* ParseForEvaluation(State* t, const char* name,
+	const std::string& buffer)
+{
+	rlf::RenderDescription* rd = Parse(t, name, buffer);
+	if (rd)
+	{
+		for (rlf::SizeOfRequest& req : rd->SizeOfRequests)
+			req.Dest->Size = 48;
+	}
+	return rd;
+}
+
+// Gives every constant its value from the tree walker, with the checks
+//	EvaluateExpression makes. The walker asserts on some of what isn't
+//	compiled, those are left zero.
+void WalkConstants(rlf::RenderDescription* rd, const rlf::ast::EvaluationContext& ec)
+{
+	using namespace rlf;
+	for (Constant* cnst : rd->Constants)
+	{
+		memset(&cnst->Value, 0, sizeof(cnst->Value));
+		if (!cnst->Expr.Code)
+			continue;
+		ast::Result res;
+		ast::EvaluationError err;
+		ast::Evaluate(cnst->Expr.TopNode, ec, res, err);
+		bool matrix = cnst->Type.Fmt == VariableFormat::Float4x4 ||
+			res.Type.Fmt == VariableFormat::Float4x4;
+		if (err.Code == ast::EvaluationErrorCode::None &&
+			(!matrix || cnst->Type.Fmt == res.Type.Fmt) && cnst->Type.Dim == res.Type.Dim)
+		{
+			ast::Convert(res, cnst->Type.Fmt);
+			cnst->Value = res.Value;
+		}
+	}
+}
+
+// Some tuneable values which are likely to end up at the edges of what an
+//	operation handles.
+void RandomizeTuneables(rlf::RenderDescription* rd, Random& r)
+{
+	using namespace rlf;
+	static const i32 ints[] = { 0, 1, -1, 3, -7, INT_MAX };
+	static const u32 uints[] = { 0, 1, 2, 3, 100, 0xffffffffu };
+	static const float floats[] = { 0.0f, 1.0f, -1.0f, 0.5f, 3.25f, 1e20f };
+	for (Tuneable* tune : rd->Tuneables)
+	{
+		for (u32 i = 0 ; i < 4 ; ++i)
+		{
+			u32 pick = NextU32(r) % 6;
+			switch (tune->Type.Fmt)
+			{
+			case VariableFormat::Bool:
+				tune->Value.Bool4Val.m[i] = (NextU32(r) & 1) != 0;
+				break;
+			case VariableFormat::Int:
+				tune->Value.Int4Val.m[i] = ints[pick];
+				break;
+			case VariableFormat::Uint:
+				tune->Value.Uint4Val.m[i] = uints[pick];
+				break;
+			case VariableFormat::Float:
+				tune->Value.Float4Val.m[i] = floats[pick];
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+// Frames at the usual size and time, at zero, at a tiny window and negative
+//	time, and far into a session.
+rlf::ast::EvaluationContext TestContext(u32 round)
+{
+	rlf::ast::EvaluationContext ec = {};
+	static const uint2 sizes[] = { { 1280, 720 }, { 0, 0 }, { 7, 3 }, { 1, 1 } };
+	static const float times[] = { 1.5f, 0.0f, -2.25f, 1e9f };
+	ec.DisplaySize = sizes[round % 4];
+	ec.Time = times[round % 4];
+	return ec;
+}
+
+// Floats are let off by a few ulps: /fp:fast leaves the compiler free to
+//	reassociate the walker's loops and the VM's lanes differently.
+bool SameFloat(float a, float b)
+{
+	if (a != a || b != b)
+		return a != a && b != b;
+	i32 ia;
+	i32 ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	if ((ia < 0) != (ib < 0))
+		return a == b;
+	return abs(ia - ib) <= 4;
+}
+
+bool SameResult(const rlf::ast::Result& a, const rlf::ast::Result& b)
+{
+	using namespace rlf;
+	if (a.Type != b.Type)
+		return false;
+	u32 count = a.Type.Fmt == VariableFormat::Float4x4 ? 16 : a.Type.Dim;
+	if (a.Type.Fmt != VariableFormat::Float && a.Type.Fmt != VariableFormat::Float4x4)
+		return memcmp(&a.Value, &b.Value, count * 4) == 0;
+	const float* fa = (const float*)&a.Value;
+	const float* fb = (const float*)&b.Value;
+	for (u32 i = 0 ; i < count ; ++i)
+	{
+		if (!SameFloat(fa[i], fb[i]))
+			return false;
+	}
+	return true;
+}
+
+// Every compiled expression run through the VM and the tree walker under
+//	several contexts and tuneable values, which have to agree on the result or
+//	on the error and where it happened.
+void CompareVM(State* t, const char* name, const std::string& buffer)
+{
+	using namespace rlf;
+	RenderDescription* rd = ParseForEvaluation(t, name, buffer);
+	if (!rd)
+		return;
+	std::vector<ast::Expression*> exprs;
+	rlf::CollectExpressions(rd, exprs);
+
+	Random r = { 1234 };
+	for (u32 round = 0 ; round < 8 ; ++round)
+	{
+		ast::EvaluationContext ec = TestContext(round);
+		if (round > 0)
+			RandomizeTuneables(rd, r);
+		WalkConstants(rd, ec);
+		for (ast::Expression* expr : exprs)
+		{
+			if (!expr->Code)
+				continue;
+			ast::Result walked;
+			ast::Result executed;
+			ast::EvaluationError walkErr;
+			ast::EvaluationError execErr;
+			ast::Evaluate(expr->TopNode, ec, walked, walkErr);
+			bool ok = ast::Execute(*expr->Code, ec, executed, execErr);
+			bool walkOk = walkErr.Code == ast::EvaluationErrorCode::None;
+			u32 offset = (u32)(expr->TopNode->Location - buffer.data());
+			Check(t, ok == walkOk && (ok ? SameResult(walked, executed) :
+				(walkErr.Code == execErr.Code && walkErr.At == execErr.At)),
+				"%s, round %u: expression at offset %u", name, round, offset);
+		}
+	}
+	ReleaseData(rd);
+}
+
+void TestVM(State* t)
+{
+	std::string buffer;
+	for (u32 i = 0 ; i < SampleCount ; ++i)
+	{
+		Check(t, ReadWholeFile(SamplePaths[i], buffer), "%s", SamplePaths[i]);
+		CompareVM(t, SamplePaths[i], buffer);
+	}
+	for (u64 seed = 1 ; seed <= 4 ; ++seed)
+		CompareVM(t, "synthetic expressions", SyntheticExpressions(500, seed));
+}
+
+// Nanoseconds per expression through the tree walker and the VM, over the
+//	expressions which evaluate without error.
+void BenchVM(const BenchArgs& args)
+{
+	using namespace rlf;
+	std::vector<BenchInput> inputs;
+	if (args.Count > 0)
+		GetBenchInputs(args, inputs);
+	else
+	{
+		BenchInput in;
+		for (u32 i = 0 ; i < SampleCount ; ++i)
+		{
+			in.Name = SamplePaths[i];
+			if (ReadWholeFile(SamplePaths[i], in.Buffer))
+				inputs.push_back(in);
+		}
+		in.Name = "synthetic: 10000 expressions";
+		in.Buffer = SyntheticExpressions(10000, 1);
+		inputs.push_back(in);
+	}
+
+	printf("%-40s %6s %11s %14s %14s %8s\n", "", "exprs", "instr/expr", "walker",
+		"vm", "speedup");
+	for (const BenchInput& in : inputs)
+	{
+		RenderDescription* rd = ParseForEvaluation(nullptr, in.Name.c_str(), in.Buffer);
+		if (!rd)
+		{
+			printf("%s: failed to parse\n", in.Name.c_str());
+			continue;
+		}
+		ast::EvaluationContext ec = TestContext(0);
+		WalkConstants(rd, ec);
+		std::vector<ast::Expression*> all;
+		std::vector<ast::Expression*> exprs;
+		CollectExpressions(rd, all);
+		u32 instructions = 0;
+		for (ast::Expression* expr : all)
+		{
+			ast::Result res;
+			ast::EvaluationError err;
+			if (!expr->Code)
+				continue;
+			ast::Evaluate(expr->TopNode, ec, res, err);
+			if (err.Code == ast::EvaluationErrorCode::None)
+			{
+				exprs.push_back(expr);
+				instructions += expr->Code->Code.Count;
+			}
+		}
+		if (exprs.empty())
+		{
+			ReleaseData(rd);
+			continue;
+		}
+
+		// Enough repetitions of the small ones to time them.
+		u32 reps = max(1u, 100000 / (u32)exprs.size());
+		u32 sink = 0;
+		double walkMs = MinTimeMs(5, [&]() {
+			for (u32 i = 0 ; i < reps ; ++i)
+			{
+				for (ast::Expression* expr : exprs)
+				{
+					ast::Result res;
+					ast::EvaluationError err;
+					ast::Evaluate(expr->TopNode, ec, res, err);
+					sink += res.Value.UintVal;
+				}
+			}
+		});
+		double vmMs = MinTimeMs(5, [&]() {
+			for (u32 i = 0 ; i < reps ; ++i)
+			{
+				for (ast::Expression* expr : exprs)
+				{
+					ast::Result res;
+					ast::EvaluationError err;
+					ast::Execute(*expr->Code, ec, res, err);
+					sink += res.Value.UintVal;
+				}
+			}
+		});
+		double evaluations = (double)reps * (double)exprs.size();
+		printf("%-40.40s %6u %11.1f %8.1f ns/ex %8.1f ns/ex %7.2fx%s\n", in.Name.c_str(),
+			(u32)exprs.size(), (double)instructions / (double)exprs.size(),
+			walkMs * 1e6 / evaluations, vmMs * 1e6 / evaluations, walkMs / vmMs,
+			sink == 0x12345678 ? " " : "");
+		ReleaseData(rd);
+	}
+}
+
+}
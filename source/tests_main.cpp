@@ -0,0 +1,204 @@
+// System headers
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <intrin.h>
+	#if defined(_DEBUG)
+		#include <crtdbg.h>
+	#endif
+#else
+	#include "posix.h"
+#endif
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <new>
+
+// Project headers
+#include "types.h"
+#include "math.h"
+#include "matrix.h"
+#include "assert.h"
+#include "fileio.h"
+#include "null/gfx.h"
+#include "rlf/rlf.h"
+#include "rlf/lexer.h"
+#include "rlf/sourcemap.h"
+#include "rlf/perfecthash.h"
+#include "rlf/rlfparser.h"
+#include "rlf/rlfcompiled.h"
+#include "rlf/rlfinterpreter.h"
+#include "rlf/profile.h"
+#include "rlf/shaderparser.h"
+#include "tests/test.h"
+
+// Tests and benchmarks for the rlf core, against the null backend. Built by
+//	build_tests.bat, or by CMakeLists.txt where there's no D3D. Run without
+//	arguments to run every test, with -test Name to run one, or -bench Name to
+//	run a benchmark followed by whatever arguments it takes.
+
+// The function of each is TestName or BenchName.
+#define TEST_TUPLE \
+	TEST_ENTRY(Interning) \
+	TEST_ENTRY(IncrementalParse) \
+	TEST_ENTRY(ThreadedParse) \
+	TEST_ENTRY(Symbols) \
+	TEST_ENTRY(VM) \
+	TEST_ENTRY(Batch) \
+	TEST_ENTRY(EvaluationAllocations) \
+	TEST_ENTRY(Kernels) \
+	TEST_ENTRY(Math) \
+	TEST_ENTRY(LinAlloc) \
+	TEST_ENTRY(Pool) \
+	TEST_ENTRY(ReplayAllocations) \
+	TEST_ENTRY(CommandLogs) \
+	TEST_ENTRY(Lexer) \
+	TEST_ENTRY(Numbers) \
+
+#define BENCH_TUPLE \
+	BENCH_ENTRY(Parse) \
+	BENCH_ENTRY(Lexer) \
+	BENCH_ENTRY(Numbers) \
+	BENCH_ENTRY(ColdStart) \
+	BENCH_ENTRY(Symbols) \
+	BENCH_ENTRY(VM) \
+	BENCH_ENTRY(Batch) \
+	BENCH_ENTRY(Commands) \
+	BENCH_ENTRY(Kernels) \
+	BENCH_ENTRY(LinAlloc) \
+	BENCH_ENTRY(Pool) \
+
+#include "fileio.cpp"
+#include "rlf/lexer.cpp"
+#include "rlf/sourcemap.cpp"
+#include "rlf/rlfparser.cpp"
+#include "rlf/rlfcompiled.cpp"
+#include "rlf/ast.cpp"
+#include "rlf/bytecode.cpp"
+#include "rlf/optimize.cpp"
+#include "rlf/shaderparser.cpp"
+#include "rlf/null/null_rlfinterpreter.cpp"
+#include "rlf/rlfinterpreter.cpp"
+#include "rlf/commands.cpp"
+#include "rlf/profile.cpp"
+#include "rlf/alloc.cpp"
+#include "tests/test.cpp"
+#include "tests/reference.cpp"
+#include "tests/synthetic.cpp"
+#include "tests/parsertests.cpp"
+#include "tests/lexertests.cpp"
+#include "tests/numbertests.cpp"
+#include "tests/compiledtests.cpp"
+#include "tests/threadtests.cpp"
+#include "tests/symboltests.cpp"
+#include "tests/vmtests.cpp"
+#include "tests/batchtests.cpp"
+#include "tests/evaluationtests.cpp"
+#include "tests/kerneltests.cpp"
+#include "tests/mathtests.cpp"
+#include "tests/commandtests.cpp"
+#include "tests/alloctests.cpp"
+
+struct TestEntry
+{
+	const char* Name;
+	void (*Run)(test::State* t);
+};
+
+struct BenchEntry
+{
+	const char* Name;
+	void (*Run)(const test::BenchArgs& args);
+};
+
+#define TEST_ENTRY(name) { #name, test::Test##name },
+const TestEntry Tests[] =
+{
+	TEST_TUPLE
+};
+#undef TEST_ENTRY
+
+#define BENCH_ENTRY(name) { #name, test::Bench##name },
+const BenchEntry Benches[] =
+{
+	BENCH_TUPLE
+};
+#undef BENCH_ENTRY
+
+#undef TEST_TUPLE
+#undef BENCH_TUPLE
+
+int RunTests(const char* only)
+{
+	u32 run = 0;
+	u32 failed = 0;
+	for (const TestEntry& entry : Tests)
+	{
+		if (only && strcmp(only, entry.Name) != 0)
+			continue;
+		test::State t = {};
+		t.Name = entry.Name;
+		i64 start = test::ReadCounter();
+		try {
+			entry.Run(&t);
+		}
+		catch (rlf::ErrorInfo ie)
+		{
+			test::CheckFailed(&t, __FILE__, __LINE__, "threw: %s", ie.Message.c_str());
+		}
+		printf("%-24s %s, %u checks, %.1f ms\n", entry.Name,
+			t.Failures ? "FAILED" : "passed", t.Checks,
+			test::ElapsedMs(start, test::ReadCounter()));
+		++run;
+		failed += t.Failures ? 1 : 0;
+	}
+	if (run == 0)
+	{
+		printf("No test named %s\n", only);
+		return 1;
+	}
+	printf("%u of %u tests passed\n", run - failed, run);
+	return failed ? 1 : 0;
+}
+
+int RunBench(const char* only, int argc, char** argv)
+{
+	test::BenchArgs args = { argc, argv };
+	bool found = false;
+	for (const BenchEntry& entry : Benches)
+	{
+		if (only && strcmp(only, entry.Name) != 0)
+			continue;
+		printf("== %s\n", entry.Name);
+		try {
+			entry.Run(args);
+		}
+		catch (rlf::ErrorInfo ie)
+		{
+			printf("threw: %s\n", ie.Message.c_str());
+		}
+		found = true;
+	}
+	if (!found)
+		printf("No benchmark named %s\n", only);
+	return found ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	test::InitAllocationCount();
+
+	if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+		return RunBench(argc > 2 ? argv[2] : nullptr, max(argc - 3, 0), argv + 3);
+	if (argc > 2 && strcmp(argv[1], "-test") == 0)
+		return RunTests(argv[2]);
+	if (argc > 1)
+	{
+		printf("usage: %s [-test Name | -bench [Name [args...]]]\n", argv[0]);
+		return 1;
+	}
+	return RunTests(nullptr);
+}
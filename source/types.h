@@ -17,6 +17,7 @@ static_assert(sizeof(u8) == 1, "Didn't get expected size.");
 static_assert(sizeof(i8) == 1, "Didn't get expected size.");
 
 static const u32 U32_MAX = (u32)-1;
+static const u16 U16_MAX = (u16)-1;
 
 #pragma warning(disable: 4201)
 
@@ -1,10 +1,12 @@
 
 // System headers
 #include <windows.h>
+#include <intrin.h>
 #include <stdio.h>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
 #include <dxgiformat.h>
 
 // External headers
@@ -34,8 +36,14 @@
 #include "fileio.h"
 #include "d3d11/gfx.h"
 #include "rlf/rlf.h"
+#include "rlf/lexer.h"
+#include "rlf/sourcemap.h"
+#include "rlf/perfecthash.h"
 #include "rlf/rlfparser.h"
+#include "rlf/rlfcompiled.h"
 #include "rlf/rlfinterpreter.h"
+#include "rlf/d3dtexture.h"
+#include "rlf/profile.h"
 #include "rlf/shaderparser.h"
 #include "gui.h"
 #include "main.h"
@@ -84,7 +92,8 @@ ImTextureID RetrieveDisplayTextureID(main::State* s)
 		return s->RlfDisplaySrv;
 }
 
-bool CheckD3DValidation(gfx::Context* ctx, std::string& outMessage)
+bool CheckD3DValidation(gfx::Context* ctx, rlf::alloc::LinAlloc* frameAlloc,
+	std::string& outMessage)
 {
 	UINT64 num = ctx->InfoQueue->GetNumStoredMessages();
 	for (u32 i = 0 ; i < num ; ++i)
@@ -92,11 +101,10 @@ bool CheckD3DValidation(gfx::Context* ctx, std::string& outMessage)
 		size_t messageLength;
 		HRESULT hr = ctx->InfoQueue->GetMessage(i, nullptr, &messageLength);
 		Assert(hr == S_FALSE, "Failed to get message, hr=%x", hr);
-		D3D11_MESSAGE* message = (D3D11_MESSAGE*)malloc(messageLength);
+		D3D11_MESSAGE* message = (D3D11_MESSAGE*)rlf::alloc::Allocate(frameAlloc, messageLength);
 		ctx->InfoQueue->GetMessage(i, message, &messageLength);
 		Assert(hr == S_FALSE, "Failed to get message, hr=%x", hr);
 		outMessage += message->pDescription;
-		free(message);
 	}
 	ctx->InfoQueue->ClearStoredMessages();
 
@@ -420,11 +428,19 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 // Project source
 #include "config.cpp"
 #include "fileio.cpp"
+#include "rlf/lexer.cpp"
+#include "rlf/sourcemap.cpp"
 #include "rlf/rlfparser.cpp"
+#include "rlf/rlfcompiled.cpp"
 #include "rlf/ast.cpp"
+#include "rlf/bytecode.cpp"
+#include "rlf/optimize.cpp"
 #include "rlf/shaderparser.cpp"
 #include "rlf/d3d11/d3d11_rlfinterpreter.cpp"
+#include "rlf/d3dtexture.cpp"
 #include "rlf/rlfinterpreter.cpp"
+#include "rlf/commands.cpp"
+#include "rlf/profile.cpp"
 #include "rlf/alloc.cpp"
 #include "gui.cpp"
 #include "main.cpp"
\ No newline at end of file